@@ -386,6 +386,18 @@ public final class TJ {
    * been shown to have a larger effect.
    */
   public static final int FLAG_ACCURATEDCT  =  4096;
+  /**
+   * When compressing, code each scan with whichever of several built-in sets
+   * of pre-trained Huffman tables (or the standard Huffman tables) codes a
+   * sample from the beginning of the scan in the fewest bits.  This usually
+   * produces a smaller JPEG image than the standard Huffman tables, at the
+   * same speed and without the second pass that Huffman table optimization
+   * requires.  This flag has no effect on progressive or arithmetic-coded JPEG
+   * images or if Huffman table optimization has been requested.  Setting the
+   * <code>turbojpeg.pretrained</code> system property to <code>1</code> has
+   * the same effect as this flag.
+   */
+  public static final int FLAG_PRETRAINED   = 32768;
 
 
   /**
@@ -65,7 +65,13 @@ METHODDEF(boolean) compress_first_pass
         (j_compress_ptr cinfo, JSAMPIMAGE input_buf);
 METHODDEF(boolean) compress_output
         (j_compress_ptr cinfo, JSAMPIMAGE input_buf);
+METHODDEF(boolean) compress_replay
+        (j_compress_ptr cinfo, JSAMPIMAGE input_buf);
 #endif
+METHODDEF(boolean) compress_ring_input
+        (j_compress_ptr cinfo, JSAMPIMAGE input_buf);
+METHODDEF(boolean) compress_ring_output
+        (j_compress_ptr cinfo, JSAMPIMAGE input_buf);
 
 
 LOCAL(void)
@@ -108,7 +114,11 @@ start_pass_coef (j_compress_ptr cinfo, J_BUF_MODE pass_mode)
   case JBUF_PASS_THRU:
     if (coef->whole_image[0] != NULL)
       ERREXIT(cinfo, JERR_BAD_BUFFER_MODE);
-    coef->pub.compress_data = compress_data;
+    if (cinfo->master->coef_ring_rows > 0)
+      coef->pub.compress_data = cinfo->master->coef_ring_fill ?
+                                compress_ring_input : compress_ring_output;
+    else
+      coef->pub.compress_data = compress_data;
     break;
 #ifdef FULL_COEF_BUFFER_SUPPORTED
   case JBUF_SAVE_AND_PASS:
@@ -117,9 +127,13 @@ start_pass_coef (j_compress_ptr cinfo, J_BUF_MODE pass_mode)
     coef->pub.compress_data = compress_first_pass;
     break;
   case JBUF_CRANK_DEST:
-    if (coef->whole_image[0] == NULL)
-      ERREXIT(cinfo, JERR_BAD_BUFFER_MODE);
-    coef->pub.compress_data = compress_output;
+    if (coef->whole_image[0] == NULL) {
+      /* The entropy encoder replays its symbol stream (see jpegint.h.) */
+      if (! cinfo->master->huff_symbol_stream)
+        ERREXIT(cinfo, JERR_BAD_BUFFER_MODE);
+      coef->pub.compress_data = compress_replay;
+    } else
+      coef->pub.compress_data = compress_output;
     break;
 #endif
   default:
@@ -218,31 +232,24 @@ compress_data (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
 }
 
 
-#ifdef FULL_COEF_BUFFER_SUPPORTED
-
 /*
- * Process some data in the first pass of a multi-pass case.
- * We process the equivalent of one fully interleaved MCU row ("iMCU" row)
- * per call, ie, v_samp_factor block rows for each component in the image.
- * This amount of data is read from the source buffer, DCT'd and quantized,
- * and saved into the virtual arrays.  We also generate suitable dummy blocks
- * as needed at the right and lower edges.  (The dummy blocks are constructed
- * in the virtual arrays, which have been padded appropriately.)  This makes
- * it possible for subsequent passes not to worry about real vs. dummy blocks.
+ * DCT and quantize one fully interleaved MCU row ("iMCU" row), ie,
+ * v_samp_factor block rows for each component in the image, and store the
+ * coefficients in buffer[], which contains v_samp_factor block rows for each
+ * component (indexed by the component's SOF position.)  We also generate
+ * suitable dummy blocks as needed at the right and lower edges.  (The buffer
+ * rows must be padded appropriately.)  This makes it possible for
+ * encode_iMCU_row() not to worry about real vs. dummy blocks.
  *
- * We must also emit the data to the entropy encoder.  This is conveniently
- * done by calling compress_output() after we've loaded the current strip
- * of the virtual arrays.
- *
- * NB: input_buf contains a plane for each component in image.  All
- * components are DCT'd and loaded into the virtual arrays in this pass.
- * However, it may be that only a subset of the components are emitted to
- * the entropy encoder during this first pass; be careful about looking
- * at the scan-dependent variables (MCU dimensions, etc).
+ * NB: All components are DCT'd and loaded into the buffer, but it may be that
+ * only a subset of the components are emitted to the entropy encoder during
+ * this pass; be careful about looking at the scan-dependent variables (MCU
+ * dimensions, etc).
  */
 
-METHODDEF(boolean)
-compress_first_pass (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
+LOCAL(void)
+transform_iMCU_row (j_compress_ptr cinfo, JSAMPIMAGE input_buf,
+                    JBLOCKARRAY *buffer)
 {
   my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
   JDIMENSION last_iMCU_row = cinfo->total_iMCU_rows - 1;
@@ -250,16 +257,10 @@ compress_first_pass (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
   int bi, ci, h_samp_factor, block_row, block_rows, ndummy;
   JCOEF lastDC;
   jpeg_component_info *compptr;
-  JBLOCKARRAY buffer;
   JBLOCKROW thisblockrow, lastblockrow;
 
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
-    /* Align the virtual buffer for this component. */
-    buffer = (*cinfo->mem->access_virt_barray)
-      ((j_common_ptr) cinfo, coef->whole_image[ci],
-       coef->iMCU_row_num * compptr->v_samp_factor,
-       (JDIMENSION) compptr->v_samp_factor, TRUE);
     /* Count non-dummy DCT block rows in this iMCU row. */
     if (coef->iMCU_row_num < last_iMCU_row)
       block_rows = compptr->v_samp_factor;
@@ -278,7 +279,7 @@ compress_first_pass (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
      * on forward_DCT processes a complete horizontal row of DCT blocks.
      */
     for (block_row = 0; block_row < block_rows; block_row++) {
-      thisblockrow = buffer[block_row];
+      thisblockrow = buffer[ci][block_row];
       (*cinfo->fdct->forward_DCT) (cinfo, compptr,
                                    input_buf[ci], thisblockrow,
                                    (JDIMENSION) (block_row * DCTSIZE),
@@ -303,8 +304,8 @@ compress_first_pass (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
       MCUs_across = blocks_across / h_samp_factor;
       for (block_row = block_rows; block_row < compptr->v_samp_factor;
            block_row++) {
-        thisblockrow = buffer[block_row];
-        lastblockrow = buffer[block_row-1];
+        thisblockrow = buffer[ci][block_row];
+        lastblockrow = buffer[ci][block_row-1];
         jzero_far((void *) thisblockrow,
                   (size_t) (blocks_across * sizeof(JBLOCK)));
         for (MCUindex = 0; MCUindex < MCUs_across; MCUindex++) {
@@ -318,6 +319,97 @@ compress_first_pass (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
       }
     }
   }
+}
+
+
+/*
+ * Emit one iMCU row, ie, v_samp_factor block rows for each component in the
+ * scan, to the entropy encoder.  buffer[] contains those block rows for each
+ * component in the scan (indexed by the component's position in the scan.)
+ * Returns TRUE if the iMCU row is completed, FALSE if suspended.
+ */
+
+LOCAL(boolean)
+encode_iMCU_row (j_compress_ptr cinfo, JBLOCKARRAY *buffer)
+{
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+  JDIMENSION MCU_col_num;       /* index of current MCU within row */
+  int blkn, ci, xindex, yindex, yoffset;
+  JDIMENSION start_col;
+  JBLOCKROW buffer_ptr;
+  jpeg_component_info *compptr;
+
+  /* Loop to process one whole iMCU row */
+  for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
+       yoffset++) {
+    for (MCU_col_num = coef->mcu_ctr; MCU_col_num < cinfo->MCUs_per_row;
+         MCU_col_num++) {
+      /* Construct list of pointers to DCT blocks belonging to this MCU */
+      blkn = 0;                 /* index of current DCT block within MCU */
+      for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+        compptr = cinfo->cur_comp_info[ci];
+        start_col = MCU_col_num * compptr->MCU_width;
+        for (yindex = 0; yindex < compptr->MCU_height; yindex++) {
+          buffer_ptr = buffer[ci][yindex+yoffset] + start_col;
+          for (xindex = 0; xindex < compptr->MCU_width; xindex++) {
+            coef->MCU_buffer[blkn++] = buffer_ptr++;
+          }
+        }
+      }
+      /* Try to write the MCU. */
+      if (! (*cinfo->entropy->encode_mcu) (cinfo, coef->MCU_buffer)) {
+        /* Suspension forced; update state counters and exit */
+        coef->MCU_vert_offset = yoffset;
+        coef->mcu_ctr = MCU_col_num;
+        return FALSE;
+      }
+    }
+    /* Completed an MCU row, but perhaps not an iMCU row */
+    coef->mcu_ctr = 0;
+  }
+  /* Completed the iMCU row, advance counters for next one */
+  coef->iMCU_row_num++;
+  start_iMCU_row(cinfo);
+  return TRUE;
+}
+
+
+#ifdef FULL_COEF_BUFFER_SUPPORTED
+
+/*
+ * Process some data in the first pass of a multi-pass case.
+ * We process the equivalent of one fully interleaved MCU row ("iMCU" row)
+ * per call, ie, v_samp_factor block rows for each component in the image.
+ * This amount of data is read from the source buffer, DCT'd and quantized,
+ * and saved into the virtual arrays, along with any dummy blocks needed at
+ * the right and lower edges.
+ *
+ * We must also emit the data to the entropy encoder.  This is conveniently
+ * done by calling compress_output() after we've loaded the current strip
+ * of the virtual arrays.
+ *
+ * NB: input_buf contains a plane for each component in image.  All
+ * components are DCT'd and loaded into the virtual arrays in this pass.
+ */
+
+METHODDEF(boolean)
+compress_first_pass (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
+{
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+  int ci;
+  jpeg_component_info *compptr;
+  JBLOCKARRAY buffer[MAX_COMPONENTS];
+
+  for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+       ci++, compptr++) {
+    /* Align the virtual buffer for this component. */
+    buffer[ci] = (*cinfo->mem->access_virt_barray)
+      ((j_common_ptr) cinfo, coef->whole_image[ci],
+       coef->iMCU_row_num * compptr->v_samp_factor,
+       (JDIMENSION) compptr->v_samp_factor, TRUE);
+  }
+  transform_iMCU_row(cinfo, input_buf, buffer);
+
   /* NB: compress_output will increment iMCU_row_num if successful.
    * A suspension return will result in redoing all the work above next time.
    */
@@ -341,11 +433,8 @@ METHODDEF(boolean)
 compress_output (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
 {
   my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
-  JDIMENSION MCU_col_num;       /* index of current MCU within row */
-  int blkn, ci, xindex, yindex, yoffset;
-  JDIMENSION start_col;
+  int ci;
   JBLOCKARRAY buffer[MAX_COMPS_IN_SCAN];
-  JBLOCKROW buffer_ptr;
   jpeg_component_info *compptr;
 
   /* Align the virtual buffers for the components used in this scan.
@@ -360,23 +449,96 @@ compress_output (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
        (JDIMENSION) compptr->v_samp_factor, FALSE);
   }
 
+  return encode_iMCU_row(cinfo, buffer);
+}
+
+#endif /* FULL_COEF_BUFFER_SUPPORTED */
+
+
+/*
+ * Process some data in the pipelined case (see jpegint.h.)  A compressor that
+ * fills the ring DCT's one iMCU row per call and stores it, along with any
+ * dummy blocks, in the ring.  This never suspends.
+ */
+
+METHODDEF(boolean)
+compress_ring_input (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
+{
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+  struct jpeg_comp_master *master = cinfo->master;
+  int ci, slot;
+  jpeg_component_info *compptr;
+  JBLOCKARRAY buffer[MAX_COMPONENTS];
+
+  slot = (int) ((master->coef_ring_start + coef->iMCU_row_num) %
+                master->coef_ring_rows);
+  for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+       ci++, compptr++)
+    buffer[ci] = master->coef_ring[ci] + slot * compptr->v_samp_factor;
+  transform_iMCU_row(cinfo, input_buf, buffer);
+
+  /* Completed the iMCU row, advance counters for next one */
+  coef->iMCU_row_num++;
+  start_iMCU_row(cinfo);
+  return TRUE;
+}
+
+
+/*
+ * A compressor that encodes the ring emits one iMCU row per call to the
+ * entropy encoder.  It suspends if the row has not been stored in the ring
+ * yet.
+ *
+ * NB: input_buf is ignored; it is likely to be a NULL pointer.
+ */
+
+METHODDEF(boolean)
+compress_ring_output (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
+{
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+  struct jpeg_comp_master *master = cinfo->master;
+  int ci, slot;
+  JBLOCKARRAY buffer[MAX_COMPS_IN_SCAN];
+  jpeg_component_info *compptr;
+
+  if (coef->iMCU_row_num >= master->coef_ring_avail)
+    return FALSE;
+
+  slot = (int) (coef->iMCU_row_num % master->coef_ring_rows);
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+    compptr = cinfo->cur_comp_info[ci];
+    buffer[ci] = master->coef_ring[compptr->component_index] +
+                 slot * compptr->v_samp_factor;
+  }
+
+  return encode_iMCU_row(cinfo, buffer);
+}
+
+
+#ifdef FULL_COEF_BUFFER_SUPPORTED
+
+/*
+ * Process some data in the output pass of a single-scan image that was
+ * optimized using the Huffman encoder's symbol stream.  The entropy encoder
+ * emits the symbols that it recorded during the first pass, so we need only
+ * tell it when to emit each MCU.
+ * Returns TRUE if the iMCU row is completed, FALSE if suspended.
+ *
+ * NB: input_buf is ignored; it is likely to be a NULL pointer.
+ */
+
+METHODDEF(boolean)
+compress_replay (j_compress_ptr cinfo, JSAMPIMAGE input_buf)
+{
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+  JDIMENSION MCU_col_num;       /* index of current MCU within row */
+  int yoffset;
+
   /* Loop to process one whole iMCU row */
   for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
        yoffset++) {
     for (MCU_col_num = coef->mcu_ctr; MCU_col_num < cinfo->MCUs_per_row;
          MCU_col_num++) {
-      /* Construct list of pointers to DCT blocks belonging to this MCU */
-      blkn = 0;                 /* index of current DCT block within MCU */
-      for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
-        compptr = cinfo->cur_comp_info[ci];
-        start_col = MCU_col_num * compptr->MCU_width;
-        for (yindex = 0; yindex < compptr->MCU_height; yindex++) {
-          buffer_ptr = buffer[ci][yindex+yoffset] + start_col;
-          for (xindex = 0; xindex < compptr->MCU_width; xindex++) {
-            coef->MCU_buffer[blkn++] = buffer_ptr++;
-          }
-        }
-      }
       /* Try to write the MCU. */
       if (! (*cinfo->entropy->encode_mcu) (cinfo, coef->MCU_buffer)) {
         /* Suspension forced; update state counters and exit */
@@ -433,6 +595,25 @@ jinit_c_coef_controller (j_compress_ptr cinfo, boolean need_full_buffer)
 #else
     ERREXIT(cinfo, JERR_BAD_BUFFER_MODE);
 #endif
+  } else if (cinfo->master->coef_ring_rows > 0) {
+    /* Allocate the ring, padded to a multiple of samp_factor DCT blocks in
+     * each direction, unless another compressor has already done so.
+     */
+    int ci;
+    jpeg_component_info *compptr;
+
+    if (cinfo->master->coef_ring[0] == NULL) {
+      for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+           ci++, compptr++) {
+        cinfo->master->coef_ring[ci] = (*cinfo->mem->alloc_barray)
+          ((j_common_ptr) cinfo, JPOOL_IMAGE,
+           (JDIMENSION) jround_up((long) compptr->width_in_blocks,
+                                  (long) compptr->h_samp_factor),
+           (JDIMENSION) (cinfo->master->coef_ring_rows *
+                         compptr->v_samp_factor));
+      }
+    }
+    coef->whole_image[0] = NULL; /* flag for no virtual arrays */
   } else {
     /* We only need a single-MCU buffer. */
     JBLOCKROW buffer;
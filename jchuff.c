@@ -21,8 +21,8 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
-#include "jsimd.h"
 #include "jconfigint.h"
+#include "jsimd.h"
 #include <limits.h>
 
 /*
@@ -92,6 +92,36 @@ typedef struct {
 #endif
 
 
+#ifdef ENTROPY_OPT_SUPPORTED
+
+/* Symbol stream for single-pass Huffman optimization (see jpegint.h.)  For
+ * each block, the statistics-gathering pass records the DC symbol and the AC
+ * symbols, each followed by its extra bits (one byte if there are 8 or fewer
+ * bits, two bytes big-endian otherwise.)  The stream is stored in a list of
+ * chunks, and a new chunk is started whenever the current one might not hold
+ * the next MCU, so an MCU never spans two chunks.
+ */
+
+typedef struct huff_symbol_chunk {
+  struct huff_symbol_chunk *next; /* next chunk in list, or NULL */
+  JOCTET *end;                  /* end of recorded data in this chunk */
+} huff_symbol_chunk;
+
+#define SYMBOL_CHUNK_SIZE  65536 /* bytes of symbol data in each chunk */
+#define SYMBOL_DATA(chunk)  ((JOCTET *) ((chunk) + 1))
+
+/* A block has at most 63 nonzero AC coefficients, and each ZRL symbol
+ * replaces 16 of them, so 3 bytes per coefficient is always enough.
+ */
+#define MAX_SYMBOL_BYTES  (3 * DCTSIZE2)
+
+/* Number of MCU rows at the start of each scan that are buffered and used to
+ * choose pre-trained Huffman tables (see jpegint.h.)
+ */
+#define SAMPLE_MCU_ROWS  8
+
+#endif
+
 typedef struct {
   struct jpeg_entropy_encoder pub; /* public fields */
 
@@ -108,6 +138,18 @@ typedef struct {
 #ifdef ENTROPY_OPT_SUPPORTED    /* Statistics tables for optimization */
   long *dc_count_ptrs[NUM_HUFF_TBLS];
   long *ac_count_ptrs[NUM_HUFF_TBLS];
+
+  /* Symbol stream, and current chunk and position within it */
+  huff_symbol_chunk *first_chunk;
+  huff_symbol_chunk *cur_chunk;
+  JOCTET *next_symbol;
+  boolean replay;               /* TRUE if next output pass replays stream */
+
+  /* Buffered MCUs used to choose pre-trained tables */
+  JBLOCKROW sample_buffer;      /* MCUs buffered so far, in order */
+  size_t sample_buffer_size;    /* # of blocks allocated in sample_buffer */
+  JDIMENSION sample_mcus;       /* # of MCUs to buffer in this scan */
+  JDIMENSION sampled_mcus;      /* # of MCUs buffered so far */
 #endif
 
   int simd;
@@ -133,6 +175,12 @@ METHODDEF(void) finish_pass_huff (j_compress_ptr cinfo);
 #ifdef ENTROPY_OPT_SUPPORTED
 METHODDEF(boolean) encode_mcu_gather (j_compress_ptr cinfo,
                                       JBLOCKROW *MCU_data);
+METHODDEF(boolean) encode_mcu_record (j_compress_ptr cinfo,
+                                      JBLOCKROW *MCU_data);
+METHODDEF(boolean) encode_mcu_replay (j_compress_ptr cinfo,
+                                      JBLOCKROW *MCU_data);
+METHODDEF(boolean) encode_mcu_sample (j_compress_ptr cinfo,
+                                      JBLOCKROW *MCU_data);
 METHODDEF(void) finish_pass_gather (j_compress_ptr cinfo);
 #endif
 
@@ -149,10 +197,26 @@ start_pass_huff (j_compress_ptr cinfo, boolean gather_statistics)
   huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
   int ci, dctbl, actbl;
   jpeg_component_info *compptr;
+  boolean sample = FALSE;
 
   if (gather_statistics) {
 #ifdef ENTROPY_OPT_SUPPORTED
-    entropy->pub.encode_mcu = encode_mcu_gather;
+    if (cinfo->master->huff_symbol_stream) {
+      entropy->pub.encode_mcu = encode_mcu_record;
+      if (entropy->first_chunk == NULL) {
+        entropy->first_chunk = (huff_symbol_chunk *)
+          (*cinfo->mem->alloc_large) ((j_common_ptr) cinfo, JPOOL_IMAGE,
+                                      sizeof(huff_symbol_chunk) +
+                                      SYMBOL_CHUNK_SIZE);
+        entropy->first_chunk->next = NULL;
+      }
+      entropy->cur_chunk = entropy->first_chunk;
+      entropy->next_symbol = SYMBOL_DATA(entropy->cur_chunk);
+      entropy->replay = TRUE;
+    } else {
+      entropy->pub.encode_mcu = encode_mcu_gather;
+      entropy->replay = FALSE;
+    }
     entropy->pub.finish_pass = finish_pass_gather;
 #else
     ERREXIT(cinfo, JERR_NOT_COMPILED);
@@ -160,6 +224,35 @@ start_pass_huff (j_compress_ptr cinfo, boolean gather_statistics)
   } else {
     entropy->pub.encode_mcu = encode_mcu_huff;
     entropy->pub.finish_pass = finish_pass_huff;
+#ifdef ENTROPY_OPT_SUPPORTED
+    /* Emit the symbols recorded during the preceding statistics-gathering
+     * pass rather than encoding the coefficients again.
+     */
+    if (entropy->replay) {
+      entropy->pub.encode_mcu = encode_mcu_replay;
+      entropy->cur_chunk = entropy->first_chunk;
+      entropy->next_symbol = SYMBOL_DATA(entropy->cur_chunk);
+      entropy->replay = FALSE;
+    } else if (cinfo->master->huff_pretrained && ! cinfo->optimize_coding) {
+      /* Buffer and count the first few MCU rows, and choose the tables when
+       * the sample is complete.
+       */
+      size_t blocks;
+
+      sample = TRUE;
+      entropy->pub.encode_mcu = encode_mcu_sample;
+      entropy->sample_mcus = cinfo->MCUs_per_row *
+                             min(cinfo->MCU_rows_in_scan, SAMPLE_MCU_ROWS);
+      entropy->sampled_mcus = 0;
+      blocks = (size_t) entropy->sample_mcus * cinfo->blocks_in_MCU;
+      if (blocks > entropy->sample_buffer_size) {
+        entropy->sample_buffer = (JBLOCKROW)
+          (*cinfo->mem->alloc_large) ((j_common_ptr) cinfo, JPOOL_IMAGE,
+                                      blocks * sizeof(JBLOCK));
+        entropy->sample_buffer_size = blocks;
+      }
+    }
+#endif
   }
 
   entropy->simd = jsimd_can_huff_encode_one_block();
@@ -168,7 +261,7 @@ start_pass_huff (j_compress_ptr cinfo, boolean gather_statistics)
     compptr = cinfo->cur_comp_info[ci];
     dctbl = compptr->dc_tbl_no;
     actbl = compptr->ac_tbl_no;
-    if (gather_statistics) {
+    if (gather_statistics || sample) {
 #ifdef ENTROPY_OPT_SUPPORTED
       /* Check for invalid table indexes */
       /* (make_c_derived_tbl does this in the other path) */
@@ -338,8 +431,8 @@ dump_buffer (working_state *state)
  * original libjpeg code.  In addition to reducing overhead by explicitly
  * inlining the code, additional performance is achieved by taking into
  * account the size of the bit buffer and waiting until it is almost full
- * before emptying it.  This mostly benefits 64-bit platforms, since 6
- * bytes can be stored in a 64-bit bit buffer before it has to be emptied.
+ * before emptying it.  This mostly benefits 64-bit platforms, on which the
+ * bit buffer is emptied 4 bytes at a time.
  */
 
 #define EMIT_BYTE() { \
@@ -363,40 +456,47 @@ dump_buffer (working_state *state)
   } \
 }
 
-#define CHECKBUF31() { \
-  if (put_bits > 31) { \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-  } \
-}
-
-#define CHECKBUF47() { \
-  if (put_bits > 47) { \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-    EMIT_BYTE() \
-  } \
-}
-
 #if !defined(_WIN32) && !defined(SIZEOF_SIZE_T)
 #error Cannot determine word size
 #endif
 
 #if SIZEOF_SIZE_T==8 || defined(_WIN64)
 
+/* Nonzero if any of the 4 low-order bytes of x is 0xFF (see jdhuff.h) */
+#define HAS_FF_BYTE(x) \
+  ((((x) & 0x7F7F7F7F) + 0x01010101) & (x) & 0x80808080)
+
+/* Empty 4 bytes from the bit buffer if it holds more than 31 bits.  Unless one
+ * of the bytes is 0xFF and must be followed by a stuffed zero byte, the bytes
+ * are stored all at once.
+ */
+#define FLUSH32() { \
+  if (put_bits > 31) { \
+    size_t c4 = (put_buffer >> (put_bits - 32)) & 0xFFFFFFFF; \
+    if (HAS_FF_BYTE(c4)) { \
+      EMIT_BYTE() \
+      EMIT_BYTE() \
+      EMIT_BYTE() \
+      EMIT_BYTE() \
+    } else { \
+      buffer[0] = (JOCTET) (c4 >> 24); \
+      buffer[1] = (JOCTET) (c4 >> 16); \
+      buffer[2] = (JOCTET) (c4 >> 8); \
+      buffer[3] = (JOCTET) c4; \
+      buffer += 4; \
+      put_bits -= 32; \
+    } \
+  } \
+}
+
 #define EMIT_BITS(code, size) { \
-  CHECKBUF47() \
+  FLUSH32() \
   PUT_BITS(code, size) \
 }
 
 #define EMIT_CODE(code, size) { \
   temp2 &= (((JLONG) 1)<<nbits) - 1; \
-  CHECKBUF31() \
+  FLUSH32() \
   PUT_BITS(code, size) \
   PUT_BITS(temp2, nbits) \
  }
@@ -511,6 +611,10 @@ encode_one_block (working_state *state, JCOEFPTR block, int last_dc_val,
   int r, code, size;
   JOCTET _buffer[BUFSIZE], *buffer;
   size_t put_buffer;  int put_bits;
+#ifdef JPEG_CTZ64
+  size_t mask;
+  int k;
+#endif
   int code_0xf0 = actbl->ehufco[0xf0], size_0xf0 = actbl->ehufsi[0xf0];
   size_t bytes, bytestocopy;  int localbuf = 0;
 
@@ -552,6 +656,71 @@ encode_one_block (working_state *state, JCOEFPTR block, int last_dc_val,
 
   /* Encode the AC coefficients per section F.1.2.2 */
 
+#ifdef JPEG_CTZ64
+
+  /* Build the mask of nonzero coefficients.  Bit k is set if the coefficient
+   * with zigzag index k is nonzero.
+   */
+  mask = 0;
+
+#define MASKBIT(k, jpeg_natural_order_of_k) \
+  mask |= (size_t) (block[jpeg_natural_order_of_k] != 0) << k;
+
+  MASKBIT( 1,  1);  MASKBIT( 2,  8);  MASKBIT( 3, 16);  MASKBIT( 4,  9);
+  MASKBIT( 5,  2);  MASKBIT( 6,  3);  MASKBIT( 7, 10);  MASKBIT( 8, 17);
+  MASKBIT( 9, 24);  MASKBIT(10, 32);  MASKBIT(11, 25);  MASKBIT(12, 18);
+  MASKBIT(13, 11);  MASKBIT(14,  4);  MASKBIT(15,  5);  MASKBIT(16, 12);
+  MASKBIT(17, 19);  MASKBIT(18, 26);  MASKBIT(19, 33);  MASKBIT(20, 40);
+  MASKBIT(21, 48);  MASKBIT(22, 41);  MASKBIT(23, 34);  MASKBIT(24, 27);
+  MASKBIT(25, 20);  MASKBIT(26, 13);  MASKBIT(27,  6);  MASKBIT(28,  7);
+  MASKBIT(29, 14);  MASKBIT(30, 21);  MASKBIT(31, 28);  MASKBIT(32, 35);
+  MASKBIT(33, 42);  MASKBIT(34, 49);  MASKBIT(35, 56);  MASKBIT(36, 57);
+  MASKBIT(37, 50);  MASKBIT(38, 43);  MASKBIT(39, 36);  MASKBIT(40, 29);
+  MASKBIT(41, 22);  MASKBIT(42, 15);  MASKBIT(43, 23);  MASKBIT(44, 30);
+  MASKBIT(45, 37);  MASKBIT(46, 44);  MASKBIT(47, 51);  MASKBIT(48, 58);
+  MASKBIT(49, 59);  MASKBIT(50, 52);  MASKBIT(51, 45);  MASKBIT(52, 38);
+  MASKBIT(53, 31);  MASKBIT(54, 39);  MASKBIT(55, 46);  MASKBIT(56, 53);
+  MASKBIT(57, 60);  MASKBIT(58, 61);  MASKBIT(59, 54);  MASKBIT(60, 47);
+  MASKBIT(61, 55);  MASKBIT(62, 62);  MASKBIT(63, 63);
+
+  /* Jump from one nonzero coefficient to the next.  The run length of zeros
+   * is the distance from the previous nonzero coefficient (or the DC
+   * coefficient) minus 1.
+   */
+  k = 0;
+  while (mask) {
+    r = JPEG_CTZ64(mask) - k - 1;
+    k += r + 1;
+    mask &= mask - 1;
+
+    temp = temp2 = block[jpeg_natural_order[k]];
+    /* Branch-less absolute value, bitwise complement, etc., same as above */
+    temp3 = temp >> (CHAR_BIT * sizeof(int) - 1);
+    temp ^= temp3;
+    temp -= temp3;
+    temp2 += temp3;
+    nbits = JPEG_NBITS_NONZERO(temp);
+    /* if run length > 15, must emit special run-length-16 codes (0xF0) */
+    while (r > 15) {
+      EMIT_BITS(code_0xf0, size_0xf0)
+      r -= 16;
+    }
+    /* Emit Huffman symbol for run length / number of bits */
+    temp3 = (r << 4) + nbits;
+    code = actbl->ehufco[temp3];
+    size = actbl->ehufsi[temp3];
+    EMIT_CODE(code, size)
+  }
+
+  /* If the last coef(s) were zero, emit an end-of-block code */
+  if (k < DCTSIZE2 - 1) {
+    code = actbl->ehufco[0];
+    size = actbl->ehufsi[0];
+    EMIT_BITS(code, size)
+  }
+
+#else
+
   r = 0;                        /* r = run length of zeros */
 
 /* Manually unroll the k loop to eliminate the counter variable.  This
@@ -603,6 +772,8 @@ encode_one_block (working_state *state, JCOEFPTR block, int last_dc_val,
     EMIT_BITS(code, size)
   }
 
+#endif
+
   state->cur.put_buffer = put_buffer;
   state->cur.put_bits = put_bits;
   STORE_BUFFER()
@@ -855,6 +1026,459 @@ encode_mcu_gather (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
 }
 
 
+/*
+ * Single-pass Huffman optimization.
+ *
+ * Rather than scanning the coefficients again in the output pass, we can
+ * record each Huffman symbol, along with the extra bits that follow it, while
+ * counting the symbols.  The output pass then emits the recorded symbols
+ * using the optimal tables, so the compressor does not need to keep the
+ * coefficients of the whole image (see jpegint.h.)
+ */
+
+#define RECORD_BITS(bits, nbits) { \
+  if (nbits > 8) \
+    *symbol++ = (JOCTET) ((bits) >> 8); \
+  *symbol++ = (JOCTET) (bits); \
+}
+
+#define READ_BITS(bits, nbits) { \
+  bits = *symbol++; \
+  if (nbits > 8) \
+    bits = (bits << 8) | *symbol++; \
+}
+
+
+/* Count the Huffman symbols for a single block's worth of coefficients, as
+ * htest_one_block() does, and append them to the symbol stream.  Returns the
+ * new end of the stream.
+ */
+
+LOCAL(JOCTET *)
+record_one_block (j_compress_ptr cinfo, JCOEFPTR block, int last_dc_val,
+                  long dc_counts[], long ac_counts[], JOCTET *symbol)
+{
+  register int temp, temp2, temp3;
+  register int nbits;
+  register int k, r;
+
+  /* Encode the DC coefficient difference per section F.1.2.1 */
+
+  temp = temp2 = block[0] - last_dc_val;
+
+  /* Branch-less absolute value, bitwise complement, etc., as in
+   * encode_one_block()
+   */
+  temp3 = temp >> (CHAR_BIT * sizeof(int) - 1);
+  temp ^= temp3;
+  temp -= temp3;
+  temp2 += temp3;
+
+  /* Find the number of bits needed for the magnitude of the coefficient */
+  nbits = JPEG_NBITS(temp);
+  /* Check for out-of-range coefficient values.
+   * Since we're encoding a difference, the range limit is twice as much.
+   */
+  if (nbits > MAX_COEF_BITS+1)
+    ERREXIT(cinfo, JERR_BAD_DCT_COEF);
+
+  /* Count and record the Huffman symbol for the number of bits, followed by
+   * that number of bits of the value
+   */
+  dc_counts[nbits]++;
+  *symbol++ = (JOCTET) nbits;
+  if (nbits) {
+    temp2 &= (1 << nbits) - 1;
+    RECORD_BITS(temp2, nbits)
+  }
+
+  /* Encode the AC coefficients per section F.1.2.2 */
+
+  r = 0;                        /* r = run length of zeros */
+
+  for (k = 1; k < DCTSIZE2; k++) {
+    if ((temp = block[jpeg_natural_order[k]]) == 0) {
+      r++;
+    } else {
+      temp2 = temp;
+      temp3 = temp >> (CHAR_BIT * sizeof(int) - 1);
+      temp ^= temp3;
+      temp -= temp3;
+      temp2 += temp3;
+      nbits = JPEG_NBITS_NONZERO(temp);
+      /* Check for out-of-range coefficient values */
+      if (nbits > MAX_COEF_BITS)
+        ERREXIT(cinfo, JERR_BAD_DCT_COEF);
+
+      /* if run length > 15, must emit special run-length-16 codes (0xF0) */
+      while (r > 15) {
+        ac_counts[0xF0]++;
+        *symbol++ = 0xF0;
+        r -= 16;
+      }
+
+      /* Count and record Huffman symbol for run length / number of bits */
+      temp3 = (r << 4) + nbits;
+      ac_counts[temp3]++;
+      *symbol++ = (JOCTET) temp3;
+      temp2 &= (1 << nbits) - 1;
+      RECORD_BITS(temp2, nbits)
+
+      r = 0;
+    }
+  }
+
+  /* If the last coef(s) were zero, emit an end-of-block code */
+  if (r > 0) {
+    ac_counts[0]++;
+    *symbol++ = 0;
+  }
+
+  return symbol;
+}
+
+
+/*
+ * Trial-encode one MCU's worth of Huffman-compressed coefficients, and record
+ * the symbols for the output pass.
+ * No data is actually output, so no suspension return is possible.
+ */
+
+METHODDEF(boolean)
+encode_mcu_record (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  huff_symbol_chunk *chunk = entropy->cur_chunk;
+  JOCTET *symbol = entropy->next_symbol;
+  int blkn, ci;
+  jpeg_component_info *compptr;
+
+  /* Take care of restart intervals if needed */
+  if (cinfo->restart_interval) {
+    if (entropy->restarts_to_go == 0) {
+      /* Re-initialize DC predictions to 0 */
+      for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+        entropy->saved.last_dc_val[ci] = 0;
+      /* Update restart state */
+      entropy->restarts_to_go = cinfo->restart_interval;
+    }
+    entropy->restarts_to_go--;
+  }
+
+  /* Start a new chunk if this MCU might not fit in the current one */
+  if ((size_t) (SYMBOL_DATA(chunk) + SYMBOL_CHUNK_SIZE - symbol) <
+      (size_t) cinfo->blocks_in_MCU * MAX_SYMBOL_BYTES) {
+    chunk->end = symbol;
+    if (chunk->next == NULL) {
+      chunk->next = (huff_symbol_chunk *)
+        (*cinfo->mem->alloc_large) ((j_common_ptr) cinfo, JPOOL_IMAGE,
+                                    sizeof(huff_symbol_chunk) +
+                                    SYMBOL_CHUNK_SIZE);
+      chunk->next->next = NULL;
+    }
+    chunk = entropy->cur_chunk = chunk->next;
+    symbol = SYMBOL_DATA(chunk);
+  }
+
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+    ci = cinfo->MCU_membership[blkn];
+    compptr = cinfo->cur_comp_info[ci];
+    symbol = record_one_block(cinfo, MCU_data[blkn][0],
+                              entropy->saved.last_dc_val[ci],
+                              entropy->dc_count_ptrs[compptr->dc_tbl_no],
+                              entropy->ac_count_ptrs[compptr->ac_tbl_no],
+                              symbol);
+    entropy->saved.last_dc_val[ci] = MCU_data[blkn][0][0];
+  }
+
+  entropy->next_symbol = symbol;
+
+  return TRUE;
+}
+
+
+/* Emit a single block's worth of recorded symbols */
+
+LOCAL(boolean)
+replay_one_block (working_state *state, const JOCTET **next_symbol,
+                  c_derived_tbl *dctbl, c_derived_tbl *actbl)
+{
+  const JOCTET *symbol = *next_symbol;
+  unsigned int bits;
+  int nbits, k, rs;
+  int code, size;
+  JOCTET _buffer[BUFSIZE], *buffer;
+  size_t put_buffer;  int put_bits;
+  size_t bytes, bytestocopy;  int localbuf = 0;
+
+  put_buffer = state->cur.put_buffer;
+  put_bits = state->cur.put_bits;
+  LOAD_BUFFER()
+
+  /* Emit the DC symbol and the bits of the difference */
+  nbits = *symbol++;
+  code = dctbl->ehufco[nbits];
+  size = dctbl->ehufsi[nbits];
+  EMIT_BITS(code, size)
+  if (nbits) {
+    READ_BITS(bits, nbits)
+    EMIT_BITS(bits, nbits)
+  }
+
+  /* Emit the AC symbols and bits, up to the end-of-block code or the last
+   * coefficient
+   */
+  for (k = 1; k < DCTSIZE2; ) {
+    rs = *symbol++;
+    code = actbl->ehufco[rs];
+    size = actbl->ehufsi[rs];
+    EMIT_BITS(code, size)
+    if (rs == 0)                /* end-of-block */
+      break;
+    nbits = rs & 15;
+    if (nbits) {
+      READ_BITS(bits, nbits)
+      EMIT_BITS(bits, nbits)
+      k += (rs >> 4) + 1;
+    } else
+      k += 16;                  /* ZRL */
+  }
+
+  *next_symbol = symbol;
+
+  state->cur.put_buffer = put_buffer;
+  state->cur.put_bits = put_bits;
+  STORE_BUFFER()
+
+  return TRUE;
+}
+
+
+/*
+ * Emit one MCU's worth of recorded symbols.  MCU_data is ignored.
+ */
+
+METHODDEF(boolean)
+encode_mcu_replay (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  huff_symbol_chunk *chunk = entropy->cur_chunk;
+  const JOCTET *symbol = entropy->next_symbol;
+  working_state state;
+  int blkn, ci;
+  jpeg_component_info *compptr;
+
+  /* Load up working state */
+  state.next_output_byte = cinfo->dest->next_output_byte;
+  state.free_in_buffer = cinfo->dest->free_in_buffer;
+  ASSIGN_STATE(state.cur, entropy->saved);
+  state.cinfo = cinfo;
+
+  /* Emit restart marker if needed */
+  if (cinfo->restart_interval) {
+    if (entropy->restarts_to_go == 0)
+      if (! emit_restart(&state, entropy->next_restart_num))
+        return FALSE;
+  }
+
+  /* Move to the next chunk if this MCU was recorded there */
+  if (symbol == chunk->end) {
+    chunk = chunk->next;
+    symbol = SYMBOL_DATA(chunk);
+  }
+
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+    ci = cinfo->MCU_membership[blkn];
+    compptr = cinfo->cur_comp_info[ci];
+    if (! replay_one_block(&state, &symbol,
+                           entropy->dc_derived_tbls[compptr->dc_tbl_no],
+                           entropy->ac_derived_tbls[compptr->ac_tbl_no]))
+      return FALSE;
+  }
+
+  /* Completed MCU, so update state */
+  cinfo->dest->next_output_byte = state.next_output_byte;
+  cinfo->dest->free_in_buffer = state.free_in_buffer;
+  ASSIGN_STATE(entropy->saved, state.cur);
+  entropy->cur_chunk = chunk;
+  entropy->next_symbol = (JOCTET *) symbol;
+
+  /* Update restart-interval state too */
+  if (cinfo->restart_interval) {
+    if (entropy->restarts_to_go == 0) {
+      entropy->restarts_to_go = cinfo->restart_interval;
+      entropy->next_restart_num++;
+      entropy->next_restart_num &= 7;
+    }
+    entropy->restarts_to_go--;
+  }
+
+  return TRUE;
+}
+
+
+/*
+ * Pre-trained Huffman tables.
+ *
+ * Rather than using the standard tables or gathering statistics for the
+ * whole image, we can count the Huffman symbols in the first few MCU rows of
+ * a scan and then choose, for each table used by the scan, whichever of the
+ * pre-trained tables in jchuffsets.c (or the table that is already set) would
+ * code those symbols in the fewest bits.  The sampled MCUs are buffered until
+ * the tables have been chosen, so the image is still compressed in a single
+ * pass.  Every pre-trained table assigns a code to every symbol that can occur
+ * in an 8-bit image, so the rest of the scan can always be encoded.
+ */
+
+#if BITS_IN_JSAMPLE == 8
+
+#include "jchuffsets.c"
+
+
+/* Compute the number of bits needed to code the counted symbols with the given
+ * table, or -1 if the table lacks a code for one of them.
+ */
+
+LOCAL(long)
+table_cost (const UINT8 *bits, const UINT8 *huffval, long counts[])
+{
+  char huffsize[256];
+  long cost = 0;
+  int l, i, p;
+
+  MEMZERO(huffsize, sizeof(huffsize));
+  for (l = 1, p = 0; l <= 16; l++) {
+    for (i = 0; i < (int) bits[l]; i++, p++)
+      huffsize[huffval[p]] = (char) l;
+  }
+
+  for (i = 0; i < 256; i++) {
+    if (counts[i]) {
+      if (huffsize[i] == 0)
+        return -1;
+      cost += counts[i] * huffsize[i];
+    }
+  }
+  return cost;
+}
+
+
+/* Replace the given Huffman table with the pre-trained table that best codes
+ * the counted symbols, unless the current table is at least as good.
+ */
+
+LOCAL(void)
+choose_table (j_compress_ptr cinfo, JHUFF_TBL **htblptr,
+              const huff_table_spec *specs, int num_specs, long counts[])
+{
+  long cost, best_cost = -1;
+  int i, nsymbols, best = -1;
+
+  if (*htblptr != NULL)
+    best_cost = table_cost((*htblptr)->bits, (*htblptr)->huffval, counts);
+
+  for (i = 0; i < num_specs; i++) {
+    cost = table_cost(specs[i].bits, specs[i].huffval, counts);
+    if (cost >= 0 && (best_cost < 0 || cost < best_cost)) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+  if (best < 0)
+    return;
+
+  if (*htblptr == NULL)
+    *htblptr = jpeg_alloc_huff_table((j_common_ptr) cinfo);
+  MEMCOPY((*htblptr)->bits, specs[best].bits, sizeof((*htblptr)->bits));
+  for (i = 1, nsymbols = 0; i <= 16; i++)
+    nsymbols += specs[best].bits[i];
+  MEMCOPY((*htblptr)->huffval, specs[best].huffval, nsymbols * sizeof(UINT8));
+  MEMZERO(&((*htblptr)->huffval[nsymbols]), (256 - nsymbols) * sizeof(UINT8));
+  /* Initialize sent_table FALSE so table will be written to JPEG file. */
+  (*htblptr)->sent_table = FALSE;
+}
+
+#endif /* BITS_IN_JSAMPLE == 8 */
+
+
+/* Choose the tables for the scan, write the scan header, and encode the
+ * buffered MCUs.  Since the sampled MCUs were already accepted, we cannot
+ * suspend here.  The pre-trained tables cannot code 12-bit data, so the
+ * current tables are kept in that case.
+ */
+
+LOCAL(void)
+emit_sample (j_compress_ptr cinfo)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  JBLOCKROW MCU_data[C_MAX_BLOCKS_IN_MCU];
+  JBLOCKROW block;
+  JDIMENSION MCU_num;
+  int ci, blkn;
+  jpeg_component_info *compptr;
+
+#if BITS_IN_JSAMPLE == 8
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+    compptr = cinfo->cur_comp_info[ci];
+    /* If two components share a table, then the second call keeps it. */
+    choose_table(cinfo, & cinfo->dc_huff_tbl_ptrs[compptr->dc_tbl_no],
+                 pretrained_dc_tables, NUM_PRETRAINED_DC_TABLES,
+                 entropy->dc_count_ptrs[compptr->dc_tbl_no]);
+    choose_table(cinfo, & cinfo->ac_huff_tbl_ptrs[compptr->ac_tbl_no],
+                 pretrained_ac_tables, NUM_PRETRAINED_AC_TABLES,
+                 entropy->ac_count_ptrs[compptr->ac_tbl_no]);
+  }
+#endif
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+    compptr = cinfo->cur_comp_info[ci];
+    jpeg_make_c_derived_tbl(cinfo, TRUE, compptr->dc_tbl_no,
+                            & entropy->dc_derived_tbls[compptr->dc_tbl_no]);
+    jpeg_make_c_derived_tbl(cinfo, FALSE, compptr->ac_tbl_no,
+                            & entropy->ac_derived_tbls[compptr->ac_tbl_no]);
+    entropy->saved.last_dc_val[ci] = 0;
+  }
+  entropy->restarts_to_go = cinfo->restart_interval;
+  entropy->next_restart_num = 0;
+
+  (*cinfo->marker->write_scan_header) (cinfo);
+
+  entropy->pub.encode_mcu = encode_mcu_huff;
+  block = entropy->sample_buffer;
+  for (MCU_num = 0; MCU_num < entropy->sampled_mcus; MCU_num++) {
+    for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++)
+      MCU_data[blkn] = block++;
+    if (! encode_mcu_huff(cinfo, MCU_data))
+      ERREXIT(cinfo, JERR_CANT_SUSPEND);
+  }
+}
+
+
+/*
+ * Count and buffer one MCU of the sample.  No data is output until the sample
+ * is complete, so no suspension return is possible.
+ */
+
+METHODDEF(boolean)
+encode_mcu_sample (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  JBLOCKROW block;
+  int blkn;
+
+  (void) encode_mcu_gather(cinfo, MCU_data);
+
+  block = entropy->sample_buffer +
+          (size_t) entropy->sampled_mcus * cinfo->blocks_in_MCU;
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++)
+    MEMCOPY(block[blkn], MCU_data[blkn][0], sizeof(JBLOCK));
+
+  if (++entropy->sampled_mcus == entropy->sample_mcus)
+    emit_sample(cinfo);
+
+  return TRUE;
+}
+
+
 /*
  * Generate the best Huffman code table for the given counts, fill htbl.
  * Note this is also used by jcphuff.c.
@@ -1034,6 +1658,10 @@ finish_pass_gather (j_compress_ptr cinfo)
   boolean did_dc[NUM_HUFF_TBLS];
   boolean did_ac[NUM_HUFF_TBLS];
 
+  /* Mark the end of the recorded symbols, if any */
+  if (entropy->replay)
+    entropy->cur_chunk->end = entropy->next_symbol;
+
   /* It's important not to apply jpeg_gen_optimal_table more than once
    * per table, because it clobbers the input frequency counts!
    */
@@ -1088,4 +1716,10 @@ jinit_huff_encoder (j_compress_ptr cinfo)
     entropy->dc_count_ptrs[i] = entropy->ac_count_ptrs[i] = NULL;
 #endif
   }
+#ifdef ENTROPY_OPT_SUPPORTED
+  entropy->first_chunk = NULL;
+  entropy->replay = FALSE;
+  entropy->sample_buffer = NULL;
+  entropy->sample_buffer_size = 0;
+#endif
 }
@@ -41,3 +41,28 @@ EXTERN(void) jpeg_make_c_derived_tbl
 /* Generate an optimal table definition given the specified counts */
 EXTERN(void) jpeg_gen_optimal_table
         (j_compress_ptr cinfo, JHUFF_TBL *htbl, long freq[]);
+
+/*
+ * On 64-bit platforms with a count-trailing-zeros intrinsic, the C Huffman
+ * encoders find the nonzero AC coefficients of a block using a 64-bit mask
+ * (one bit per coefficient, in zigzag order) rather than testing each
+ * coefficient in turn.  Most blocks have only a few nonzero AC coefficients,
+ * so this avoids many unpredictable branches.  SIZEOF_SIZE_T is defined in
+ * jconfigint.h, which must be included before this file.
+ */
+
+#if SIZEOF_SIZE_T==8 || defined(_WIN64)
+#if defined __GNUC__
+#define JPEG_CTZ64(x) __builtin_ctzll(x)
+#elif defined _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_BitScanForward64)
+static __forceinline int jpeg_ctz64 (unsigned __int64 x)
+{
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return (int) index;
+}
+#define JPEG_CTZ64(x) jpeg_ctz64(x)
+#endif
+#endif
@@ -0,0 +1,1060 @@
+/*
+ * jchuffsets.c
+ *
+ * Copyright (C) 2026, The libjpeg-turbo Project.
+ * For conditions of distribution and use, see the accompanying README.ijg
+ * file.
+ *
+ * This file contains the pre-trained Huffman tables from which the Huffman
+ * entropy encoder chooses when cinfo->master->huff_pretrained is set (see
+ * jchuff.c.)  Each set of four tables (DC and AC, luminance and chrominance)
+ * was generated by jpeg_gen_optimal_table() from the symbol counts of a
+ * corpus of photographs or of synthetic images (screenshots and diagrams),
+ * compressed as 4:2:0 with jpeg_set_quality() at the given quality.  Every
+ * symbol that can occur in an 8-bit image was given a count of at least 1, so
+ * each table can code any such image.  Any table can be chosen for any
+ * component.
+ * IMPORTANT: these are only valid for 8-bit data precision!
+ */
+
+typedef struct {
+  const UINT8 *bits;            /* bits[k] = # of symbols with codes of */
+                                /* length k bits; bits[0] is unused */
+  const UINT8 *huffval;         /* The symbols, in order of incr code length */
+} huff_table_spec;
+
+/* Photographic images, quality 95 */
+
+static const UINT8 bits_dc_luminance_photo_q95[] =
+  { /* 0-base */ 0, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q95[] =
+  {
+    0x06, 0x03, 0x04, 0x05, 0x07, 0x08, 0x02, 0x00, 0x09, 0x01, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q95[] =
+  { /* 0-base */ 0, 0, 0, 5, 2, 3, 5, 3, 7, 7, 5, 9, 10, 3, 0, 0, 103 };
+
+static const UINT8 val_ac_luminance_photo_q95[] =
+  {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x11, 0x00, 0x07, 0x12, 0x08, 0x13,
+    0x21, 0x22, 0x31, 0x14, 0x32, 0x41, 0x09, 0x15, 0x23, 0x42, 0x51, 0x52,
+    0x61, 0x16, 0x24, 0x33, 0x62, 0x71, 0x72, 0x81, 0x17, 0x43, 0x82, 0x91,
+    0xa1, 0x25, 0x34, 0x53, 0x63, 0x92, 0x93, 0xa2, 0xb1, 0xb2, 0x0a, 0x35,
+    0x44, 0x54, 0x55, 0x73, 0xc1, 0xc2, 0xd1, 0xd2, 0x18, 0x26, 0x64, 0x74,
+    0x83, 0x94, 0xe1, 0xf0, 0x36, 0x45, 0x84, 0xa3, 0xe2, 0xf1, 0x19, 0x27,
+    0x37, 0x56, 0x65, 0x75, 0x95, 0xb3, 0xc3, 0xc4, 0xd3, 0xd4, 0xf2, 0x76,
+    0xa4, 0xb4, 0xe3, 0x1a, 0x6a, 0x86, 0x96, 0xa5, 0xa8, 0xe4, 0x29, 0x46,
+    0x47, 0x57, 0x5a, 0x66, 0x85, 0x97, 0x28, 0x2a, 0x38, 0x39, 0x3a, 0x48,
+    0x49, 0x4a, 0x58, 0x59, 0x67, 0x68, 0x69, 0x77, 0x78, 0x79, 0x7a, 0x87,
+    0x88, 0x89, 0x8a, 0x98, 0x99, 0x9a, 0xa6, 0xa7, 0xa9, 0xaa, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd5, 0xd6,
+    0xd7, 0xd8, 0xd9, 0xda, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q95[] =
+  { /* 0-base */ 0, 0, 0, 7, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q95[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q95[] =
+  { /* 0-base */ 0, 0, 1, 3, 2, 4, 3, 4, 8, 3, 4, 7, 2, 0, 2, 0, 119 };
+
+static const UINT8 val_ac_chrominance_photo_q95[] =
+  {
+    0x01, 0x02, 0x03, 0x11, 0x00, 0x04, 0x05, 0x12, 0x21, 0x31, 0x06, 0x41,
+    0x51, 0x13, 0x22, 0x61, 0x71, 0x07, 0x14, 0x81, 0x91, 0xa1, 0xb1, 0xc1,
+    0xd1, 0x32, 0xe1, 0xf0, 0x15, 0x23, 0x42, 0x52, 0x16, 0x33, 0x62, 0x72,
+    0x92, 0xa2, 0xf1, 0x17, 0x34, 0x43, 0x53, 0x82, 0xd2, 0x24, 0xb2, 0xe2,
+    0x08, 0x25, 0x35, 0x44, 0x63, 0xc2, 0x54, 0x73, 0x93, 0x26, 0x83, 0xa3,
+    0x09, 0x0a, 0x18, 0x19, 0x1a, 0x27, 0x28, 0x29, 0x2a, 0x36, 0x37, 0x38,
+    0x39, 0x3a, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x74, 0x75, 0x76,
+    0x77, 0x78, 0x79, 0x7a, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x94,
+    0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9,
+    0xaa, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 90 */
+
+static const UINT8 bits_dc_luminance_photo_q90[] =
+  { /* 0-base */ 0, 0, 1, 4, 3, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q90[] =
+  {
+    0x06, 0x03, 0x04, 0x05, 0x07, 0x01, 0x02, 0x08, 0x00, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q90[] =
+  { /* 0-base */ 0, 0, 1, 3, 3, 2, 4, 4, 2, 6, 5, 7, 6, 1, 0, 1, 117 };
+
+static const UINT8 val_ac_luminance_photo_q90[] =
+  {
+    0x01, 0x02, 0x03, 0x04, 0x00, 0x05, 0x11, 0x06, 0x12, 0x07, 0x13, 0x21,
+    0x31, 0x14, 0x22, 0x41, 0x51, 0x32, 0x61, 0x08, 0x15, 0x23, 0x42, 0x71,
+    0x81, 0x16, 0x33, 0x52, 0x91, 0xa1, 0x24, 0x62, 0x72, 0x92, 0xb1, 0xc1,
+    0xd1, 0x09, 0x34, 0x43, 0x53, 0x73, 0x82, 0x17, 0x25, 0x54, 0x63, 0x93,
+    0xa2, 0xb2, 0xe1, 0xf0, 0x18, 0x35, 0x44, 0x83, 0xd2, 0x26, 0x36, 0x64,
+    0x74, 0xa3, 0xb3, 0xc2, 0xc3, 0xd3, 0xf1, 0x28, 0x45, 0x84, 0x94, 0xe2,
+    0xf2, 0x19, 0x27, 0x37, 0x55, 0x68, 0x75, 0x76, 0xa7, 0xe3, 0x58, 0x95,
+    0x0a, 0x1a, 0x29, 0x2a, 0x38, 0x39, 0x3a, 0x46, 0x47, 0x48, 0x49, 0x4a,
+    0x56, 0x57, 0x59, 0x5a, 0x65, 0x66, 0x67, 0x69, 0x6a, 0x77, 0x78, 0x79,
+    0x7a, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa4, 0xa5, 0xa6, 0xa8, 0xa9, 0xaa, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9,
+    0xba, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd4, 0xd5, 0xd6, 0xd7,
+    0xd8, 0xd9, 0xda, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q90[] =
+  { /* 0-base */ 0, 0, 1, 5, 1, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q90[] =
+  {
+    0x04, 0x00, 0x01, 0x02, 0x03, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q90[] =
+  { /* 0-base */ 0, 0, 1, 3, 2, 4, 3, 4, 8, 4, 4, 4, 0, 0, 0, 2, 123 };
+
+static const UINT8 val_ac_chrominance_photo_q90[] =
+  {
+    0x01, 0x00, 0x02, 0x03, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x13, 0x41,
+    0x51, 0x22, 0x61, 0x71, 0x81, 0x06, 0x14, 0x32, 0x91, 0xa1, 0xb1, 0xd1,
+    0xf0, 0x15, 0x23, 0xc1, 0xe1, 0x16, 0x33, 0x42, 0x52, 0x53, 0x62, 0x72,
+    0xf1, 0x24, 0x34, 0x43, 0x82, 0xa2, 0x07, 0x25, 0x92, 0xb2, 0x35, 0x63,
+    0xd2, 0x08, 0x09, 0x0a, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29,
+    0x2a, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x64, 0x65, 0x66, 0x67,
+    0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb3,
+    0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6,
+    0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 85 */
+
+static const UINT8 bits_dc_luminance_photo_q85[] =
+  { /* 0-base */ 0, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q85[] =
+  {
+    0x05, 0x02, 0x03, 0x04, 0x06, 0x07, 0x01, 0x00, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q85[] =
+  { /* 0-base */ 0, 0, 2, 1, 3, 3, 2, 4, 3, 4, 5, 8, 4, 0, 1, 1, 121 };
+
+static const UINT8 val_ac_luminance_photo_q85[] =
+  {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x11, 0x00, 0x12, 0x21, 0x06, 0x31, 0x13,
+    0x22, 0x41, 0x51, 0x07, 0x14, 0x61, 0x15, 0x32, 0x71, 0x81, 0x23, 0x42,
+    0x91, 0xa1, 0xb1, 0x16, 0x33, 0x52, 0x62, 0x72, 0x92, 0xc1, 0xd1, 0x08,
+    0x24, 0x43, 0x53, 0x82, 0x25, 0x34, 0x73, 0xa2, 0xb2, 0xe1, 0xf0, 0x17,
+    0x35, 0x63, 0x93, 0xd2, 0xf1, 0x36, 0x44, 0x54, 0x64, 0x74, 0xc2, 0x18,
+    0x26, 0x27, 0x45, 0x56, 0x75, 0x83, 0x84, 0x94, 0xc3, 0xe2, 0x55, 0x68,
+    0xa3, 0xa6, 0xb3, 0x37, 0x58, 0x95, 0xd3, 0xf2, 0x09, 0x0a, 0x19, 0x1a,
+    0x28, 0x29, 0x2a, 0x38, 0x39, 0x3a, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x57,
+    0x59, 0x5a, 0x65, 0x66, 0x67, 0x69, 0x6a, 0x76, 0x77, 0x78, 0x79, 0x7a,
+    0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa4,
+    0xa5, 0xa7, 0xa8, 0xa9, 0xaa, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
+    0xd9, 0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q85[] =
+  { /* 0-base */ 0, 0, 2, 3, 1, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q85[] =
+  {
+    0x02, 0x03, 0x00, 0x01, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q85[] =
+  { /* 0-base */ 0, 0, 1, 4, 1, 2, 4, 2, 7, 6, 5, 1, 2, 0, 0, 0, 127 };
+
+static const UINT8 val_ac_chrominance_photo_q85[] =
+  {
+    0x01, 0x00, 0x02, 0x03, 0x11, 0x04, 0x12, 0x21, 0x05, 0x13, 0x31, 0x41,
+    0x22, 0x51, 0x14, 0x32, 0x61, 0x71, 0x81, 0x91, 0xa1, 0x06, 0x15, 0x23,
+    0xb1, 0xd1, 0xf0, 0x16, 0x33, 0x42, 0x52, 0xc1, 0xe1, 0xf1, 0x24, 0x34,
+    0x53, 0x62, 0x63, 0x72, 0x82, 0x07, 0x25, 0xa2, 0xc2, 0xd2, 0x08, 0x09,
+    0x0a, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36,
+    0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a,
+    0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84,
+    0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2,
+    0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5, 0xc6,
+    0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 80 */
+
+static const UINT8 bits_dc_luminance_photo_q80[] =
+  { /* 0-base */ 0, 0, 1, 5, 1, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q80[] =
+  {
+    0x05, 0x01, 0x02, 0x03, 0x04, 0x06, 0x00, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q80[] =
+  { /* 0-base */ 0, 0, 2, 1, 3, 3, 2, 4, 3, 4, 6, 6, 4, 0, 1, 0, 123 };
+
+static const UINT8 val_ac_luminance_photo_q80[] =
+  {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x06, 0x31, 0x13,
+    0x41, 0x51, 0x61, 0x14, 0x22, 0x71, 0x07, 0x32, 0x81, 0x91, 0x15, 0x23,
+    0x42, 0xa1, 0xb1, 0xd1, 0x24, 0x33, 0x52, 0x72, 0x92, 0xc1, 0x16, 0x53,
+    0x62, 0xe1, 0xf0, 0x08, 0x25, 0x34, 0x43, 0x63, 0x73, 0x82, 0x93, 0x17,
+    0x35, 0xa2, 0xb2, 0xf1, 0x27, 0x44, 0x54, 0x83, 0xd2, 0x26, 0x36, 0x55,
+    0x74, 0x75, 0x94, 0xa3, 0xc2, 0xc3, 0xe2, 0x45, 0x67, 0xa6, 0x57, 0x64,
+    0xb3, 0x09, 0x0a, 0x18, 0x19, 0x1a, 0x28, 0x29, 0x2a, 0x37, 0x38, 0x39,
+    0x3a, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x56, 0x58, 0x59, 0x5a, 0x65, 0x66,
+    0x68, 0x69, 0x6a, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa4, 0xa5, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q80[] =
+  { /* 0-base */ 0, 0, 2, 3, 1, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q80[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q80[] =
+  { /* 0-base */ 0, 0, 1, 4, 1, 3, 2, 3, 6, 4, 5, 1, 1, 1, 1, 2, 127 };
+
+static const UINT8 val_ac_chrominance_photo_q80[] =
+  {
+    0x01, 0x00, 0x02, 0x03, 0x11, 0x04, 0x12, 0x21, 0x31, 0x13, 0x41, 0x05,
+    0x22, 0x51, 0x14, 0x32, 0x61, 0x71, 0x81, 0xa1, 0x15, 0x91, 0xb1, 0xf0,
+    0x23, 0x33, 0x52, 0xc1, 0xd1, 0xe1, 0x42, 0x06, 0x24, 0x62, 0xf1, 0x34,
+    0x72, 0x43, 0x53, 0xc2, 0xd2, 0xe2, 0x07, 0x08, 0x09, 0x0a, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x54, 0x55,
+    0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84,
+    0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 70 */
+
+static const UINT8 bits_dc_luminance_photo_q70[] =
+  { /* 0-base */ 0, 0, 1, 5, 1, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q70[] =
+  {
+    0x04, 0x00, 0x01, 0x02, 0x03, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q70[] =
+  { /* 0-base */ 0, 0, 2, 1, 3, 3, 1, 6, 3, 4, 5, 8, 4, 0, 1, 2, 119 };
+
+static const UINT8 val_ac_luminance_photo_q70[] =
+  {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x06, 0x13,
+    0x22, 0x41, 0x51, 0x61, 0x14, 0x32, 0x71, 0x23, 0x42, 0x81, 0x91, 0x15,
+    0x33, 0x52, 0xa1, 0xb1, 0x07, 0x24, 0x62, 0x72, 0x82, 0x92, 0xc1, 0xd1,
+    0x16, 0x34, 0x43, 0x53, 0xe1, 0xf0, 0x25, 0x63, 0x73, 0x93, 0xa2, 0xb2,
+    0xd2, 0x35, 0x44, 0x54, 0x83, 0xf1, 0x17, 0x26, 0x74, 0x36, 0x55, 0x67,
+    0xa3, 0xa5, 0x45, 0x57, 0x94, 0xc2, 0x08, 0x09, 0x0a, 0x18, 0x19, 0x1a,
+    0x27, 0x28, 0x29, 0x2a, 0x37, 0x38, 0x39, 0x3a, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x56, 0x58, 0x59, 0x5a, 0x64, 0x65, 0x66, 0x68, 0x69, 0x6a, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7a, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a,
+    0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa4, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5, 0xc6,
+    0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q70[] =
+  { /* 0-base */ 0, 0, 3, 1, 1, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q70[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q70[] =
+  { /* 0-base */ 0, 0, 2, 2, 1, 3, 3, 2, 4, 4, 5, 1, 1, 1, 0, 2, 131 };
+
+static const UINT8 val_ac_chrominance_photo_q70[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x12, 0x21, 0x31, 0x04, 0x13, 0x41, 0x22,
+    0x51, 0x14, 0x32, 0x61, 0x71, 0x05, 0x81, 0xa1, 0xf0, 0x15, 0x23, 0x33,
+    0x52, 0x91, 0xb1, 0x42, 0xc1, 0xd1, 0xe1, 0x62, 0xf1, 0x43, 0x24, 0x72,
+    0x06, 0x07, 0x08, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x44,
+    0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 60 */
+
+static const UINT8 bits_dc_luminance_photo_q60[] =
+  { /* 0-base */ 0, 0, 2, 3, 1, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q60[] =
+  {
+    0x03, 0x04, 0x01, 0x02, 0x05, 0x00, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q60[] =
+  { /* 0-base */ 0, 0, 2, 1, 3, 2, 4, 3, 5, 4, 6, 8, 0, 0, 1, 0, 123 };
+
+static const UINT8 val_ac_luminance_photo_q60[] =
+  {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x12, 0x21, 0x05, 0x13, 0x31, 0x41,
+    0x22, 0x51, 0x61, 0x06, 0x14, 0x32, 0x71, 0x91, 0x23, 0x42, 0x52, 0x81,
+    0x15, 0x33, 0x72, 0x92, 0xa1, 0xb1, 0x24, 0x34, 0x43, 0x53, 0x62, 0xc1,
+    0xd1, 0xe1, 0x16, 0x82, 0xf0, 0x07, 0x54, 0xf1, 0x25, 0x35, 0x44, 0x63,
+    0x73, 0x74, 0x93, 0xa2, 0xd2, 0x36, 0x83, 0xb2, 0x26, 0x64, 0x66, 0xa5,
+    0xc2, 0x56, 0x75, 0xa3, 0x08, 0x09, 0x0a, 0x17, 0x18, 0x19, 0x1a, 0x27,
+    0x28, 0x29, 0x2a, 0x37, 0x38, 0x39, 0x3a, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x55, 0x57, 0x58, 0x59, 0x5a, 0x65, 0x67, 0x68, 0x69, 0x6a, 0x76,
+    0x77, 0x78, 0x79, 0x7a, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x94,
+    0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa4, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5, 0xc6,
+    0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q60[] =
+  { /* 0-base */ 0, 0, 3, 1, 1, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q60[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q60[] =
+  { /* 0-base */ 0, 0, 2, 2, 1, 3, 3, 4, 1, 1, 7, 1, 1, 1, 0, 0, 135 };
+
+static const UINT8 val_ac_chrominance_photo_q60[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x12, 0x21, 0x31, 0x04, 0x13, 0x41, 0x14,
+    0x22, 0x32, 0x51, 0x61, 0x71, 0x23, 0x33, 0x42, 0x81, 0x91, 0xa1, 0xf0,
+    0x05, 0x52, 0x62, 0xb1, 0xd1, 0xe1, 0xc1, 0xf1, 0x43, 0x06, 0x07, 0x08,
+    0x09, 0x0a, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x24, 0x25, 0x26, 0x27,
+    0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x72, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 50 */
+
+static const UINT8 bits_dc_luminance_photo_q50[] =
+  { /* 0-base */ 0, 0, 2, 3, 1, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q50[] =
+  {
+    0x03, 0x04, 0x00, 0x01, 0x02, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q50[] =
+  { /* 0-base */ 0, 0, 2, 1, 3, 3, 2, 4, 4, 2, 6, 7, 2, 0, 0, 1, 125 };
+
+static const UINT8 val_ac_luminance_photo_q50[] =
+  {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x12, 0x21, 0x31, 0x05, 0x41, 0x13,
+    0x22, 0x51, 0x61, 0x14, 0x32, 0x71, 0x91, 0x23, 0x81, 0x06, 0x33, 0x42,
+    0x52, 0xa1, 0xb1, 0x15, 0x53, 0x62, 0x72, 0x92, 0xc1, 0xd1, 0x24, 0x34,
+    0x43, 0x82, 0xe1, 0xf0, 0x16, 0xa2, 0xf1, 0x54, 0x63, 0x73, 0x07, 0x25,
+    0x35, 0x36, 0x44, 0x74, 0x83, 0xb2, 0xd2, 0x56, 0x66, 0xa5, 0x93, 0x08,
+    0x09, 0x0a, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x37,
+    0x38, 0x39, 0x3a, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x55, 0x57, 0x58,
+    0x59, 0x5a, 0x64, 0x65, 0x67, 0x68, 0x69, 0x6a, 0x75, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x94, 0x95, 0x96,
+    0x97, 0x98, 0x99, 0x9a, 0xa3, 0xa4, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb3,
+    0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6,
+    0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q50[] =
+  { /* 0-base */ 0, 0, 3, 1, 1, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q50[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q50[] =
+  { /* 0-base */ 0, 0, 2, 2, 2, 2, 1, 4, 3, 0, 1, 1, 1, 0, 0, 0, 143 };
+
+static const UINT8 val_ac_chrominance_photo_q50[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x21, 0x12, 0x31, 0x41, 0x04, 0x13, 0x22,
+    0x51, 0x14, 0x32, 0x61, 0x71, 0x33, 0x42, 0x23, 0xa1, 0xb1, 0xc1, 0xf0,
+    0x52, 0x81, 0x91, 0xd1, 0x05, 0x15, 0xe1, 0xf1, 0x06, 0x07, 0x08, 0x09,
+    0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+    0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46,
+    0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
+    0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x72, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 40 */
+
+static const UINT8 bits_dc_luminance_photo_q40[] =
+  { /* 0-base */ 0, 0, 2, 3, 1, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q40[] =
+  {
+    0x02, 0x03, 0x00, 0x01, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q40[] =
+  { /* 0-base */ 0, 0, 2, 2, 1, 3, 2, 4, 4, 3, 5, 4, 3, 2, 0, 0, 127 };
+
+static const UINT8 val_ac_luminance_photo_q40[] =
+  {
+    0x01, 0x02, 0x00, 0x03, 0x11, 0x04, 0x12, 0x21, 0x31, 0x41, 0x05, 0x13,
+    0x22, 0x51, 0x32, 0x61, 0x71, 0x91, 0x14, 0x52, 0x81, 0x23, 0x33, 0x42,
+    0xa1, 0xb1, 0x06, 0x15, 0x53, 0x72, 0x24, 0x34, 0x43, 0x62, 0x82, 0x92,
+    0xc1, 0xd1, 0xe1, 0xf0, 0xa2, 0x54, 0x73, 0x16, 0x35, 0x63, 0xf1, 0xa4,
+    0x25, 0x44, 0x56, 0x66, 0x93, 0xb2, 0xc2, 0xd2, 0x07, 0x08, 0x09, 0x0a,
+    0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x36, 0x37, 0x38,
+    0x39, 0x3a, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x55, 0x57, 0x58, 0x59,
+    0x5a, 0x64, 0x65, 0x67, 0x68, 0x69, 0x6a, 0x74, 0x75, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x94, 0x95,
+    0x96, 0x97, 0x98, 0x99, 0x9a, 0xa3, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5, 0xc6,
+    0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q40[] =
+  { /* 0-base */ 0, 1, 1, 1, 1, 1, 1, 0, 1, 5, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q40[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q40[] =
+  { /* 0-base */ 0, 0, 2, 2, 2, 2, 1, 4, 3, 0, 1, 1, 1, 0, 0, 0, 143 };
+
+static const UINT8 val_ac_chrominance_photo_q40[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x21, 0x12, 0x31, 0x41, 0x13, 0x22, 0x32,
+    0x51, 0x04, 0x14, 0x61, 0x42, 0x71, 0x23, 0x81, 0xa1, 0xb1, 0xf0, 0x52,
+    0xc1, 0xd1, 0x33, 0x62, 0x91, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x15,
+    0x16, 0x17, 0x18, 0x19, 0x1a, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47,
+    0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63,
+    0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x72, 0x73, 0x74, 0x75, 0x76,
+    0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+    0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+    0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 30 */
+
+static const UINT8 bits_dc_luminance_photo_q30[] =
+  { /* 0-base */ 0, 0, 2, 3, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q30[] =
+  {
+    0x02, 0x03, 0x00, 0x01, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q30[] =
+  { /* 0-base */ 0, 0, 2, 2, 1, 3, 2, 4, 4, 4, 3, 5, 1, 1, 1, 2, 127 };
+
+static const UINT8 val_ac_luminance_photo_q30[] =
+  {
+    0x01, 0x02, 0x00, 0x11, 0x03, 0x12, 0x21, 0x31, 0x04, 0x41, 0x13, 0x22,
+    0x51, 0x61, 0x05, 0x32, 0x71, 0x91, 0x14, 0x52, 0x81, 0xa1, 0x23, 0x33,
+    0x42, 0x53, 0x72, 0xb1, 0xd1, 0xf0, 0x15, 0x34, 0x62, 0x92, 0xc1, 0xe1,
+    0x06, 0x43, 0x82, 0xf1, 0x24, 0x63, 0x73, 0xa2, 0x35, 0x65, 0xa4, 0x25,
+    0x44, 0x55, 0x93, 0x07, 0x08, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a,
+    0x26, 0x27, 0x28, 0x29, 0x2a, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x45, 0x46,
+    0x47, 0x48, 0x49, 0x4a, 0x54, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x64, 0x66,
+    0x67, 0x68, 0x69, 0x6a, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x94, 0x95, 0x96, 0x97, 0x98,
+    0x99, 0x9a, 0xa3, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q30[] =
+  { /* 0-base */ 0, 1, 1, 1, 1, 1, 1, 0, 1, 5, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q30[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q30[] =
+  { /* 0-base */ 0, 1, 1, 0, 2, 2, 2, 2, 3, 0, 1, 1, 0, 1, 1, 2, 143 };
+
+static const UINT8 val_ac_chrominance_photo_q30[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x12, 0x21, 0x03, 0x31, 0x13, 0x41, 0x22, 0x32,
+    0x51, 0x61, 0x42, 0x71, 0x04, 0x14, 0x81, 0xb1, 0x91, 0xc1, 0xf0, 0x05,
+    0x06, 0x07, 0x08, 0x09, 0x0a, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x23,
+    0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x33, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x52,
+    0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x62, 0x63, 0x64, 0x65,
+    0x66, 0x67, 0x68, 0x69, 0x6a, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92,
+    0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa1, 0xa2, 0xa3, 0xa4,
+    0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+    0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca,
+    0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Photographic images, quality 20 */
+
+static const UINT8 bits_dc_luminance_photo_q20[] =
+  { /* 0-base */ 0, 0, 3, 1, 1, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_photo_q20[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_photo_q20[] =
+  { /* 0-base */ 0, 0, 2, 2, 1, 3, 2, 4, 4, 4, 4, 3, 1, 1, 1, 1, 129 };
+
+static const UINT8 val_ac_luminance_photo_q20[] =
+  {
+    0x01, 0x02, 0x00, 0x11, 0x03, 0x12, 0x21, 0x31, 0x41, 0x51, 0x04, 0x13,
+    0x22, 0x61, 0x32, 0x71, 0x81, 0x91, 0x14, 0x42, 0x52, 0xa1, 0x05, 0x23,
+    0x33, 0xb1, 0x62, 0x72, 0xf0, 0x34, 0x43, 0x53, 0x82, 0xc1, 0xd1, 0xe1,
+    0x15, 0x92, 0xf1, 0x24, 0xa2, 0x63, 0x65, 0xa3, 0x44, 0x55, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x54, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x64, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84,
+    0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98,
+    0x99, 0x9a, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_photo_q20[] =
+  { /* 0-base */ 0, 1, 1, 1, 1, 1, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_photo_q20[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_photo_q20[] =
+  { /* 0-base */ 0, 1, 1, 1, 0, 2, 3, 0, 2, 2, 1, 1, 0, 1, 1, 1, 145 };
+
+static const UINT8 val_ac_chrominance_photo_q20[] =
+  {
+    0x00, 0x01, 0x11, 0x02, 0x21, 0x12, 0x31, 0x41, 0x03, 0x13, 0x32, 0x51,
+    0x61, 0x22, 0x42, 0x71, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x14,
+    0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+    0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57,
+    0x58, 0x59, 0x5a, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+    0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x81, 0x82, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x91, 0x92, 0x93, 0x94, 0x95,
+    0x96, 0x97, 0x98, 0x99, 0x9a, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9,
+    0xba, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd1,
+    0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3,
+    0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf0, 0xf1, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Synthetic images, quality 95 */
+
+static const UINT8 bits_dc_luminance_graphics_q95[] =
+  { /* 0-base */ 0, 1, 0, 1, 4, 3, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_graphics_q95[] =
+  {
+    0x00, 0x08, 0x05, 0x06, 0x07, 0x09, 0x01, 0x03, 0x04, 0x0a, 0x02, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_graphics_q95[] =
+  { /* 0-base */ 0, 0, 0, 5, 3, 2, 2, 4, 4, 6, 18, 23, 14, 15, 1, 2, 63 };
+
+static const UINT8 val_ac_luminance_graphics_q95[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x09, 0x12,
+    0x13, 0x14, 0x21, 0x31, 0x0a, 0x15, 0x22, 0x41, 0x16, 0x17, 0x51, 0x56,
+    0x61, 0xd1, 0x19, 0x23, 0x32, 0x36, 0x52, 0x55, 0x58, 0x59, 0x71, 0x81,
+    0x91, 0x93, 0x94, 0xa4, 0xb2, 0xd2, 0xd3, 0xd5, 0x18, 0x1a, 0x33, 0x38,
+    0x39, 0x42, 0x53, 0x54, 0x57, 0x73, 0x75, 0x77, 0x82, 0x92, 0x97, 0x98,
+    0xa1, 0xa7, 0xb1, 0xb3, 0xb4, 0xb5, 0xd4, 0x24, 0x35, 0x37, 0x62, 0x72,
+    0x74, 0x76, 0x78, 0x95, 0x96, 0xa3, 0xb6, 0xc1, 0xe5, 0x25, 0x34, 0x3a,
+    0x43, 0x65, 0x68, 0x69, 0x84, 0x86, 0xa2, 0xa5, 0xa6, 0xa8, 0xd6, 0xe1,
+    0xe2, 0xe4, 0x26, 0x48, 0x5a, 0x64, 0x87, 0xc4, 0xc5, 0xf0, 0x45, 0x63,
+    0x66, 0x83, 0x85, 0xc2, 0x27, 0x29, 0x2a, 0x44, 0x47, 0x49, 0xc3, 0xf1,
+    0x46, 0x67, 0xe3, 0x28, 0xb7, 0x4a, 0x6a, 0x79, 0x7a, 0x88, 0x89, 0x8a,
+    0x99, 0x9a, 0xa9, 0xaa, 0xb8, 0xb9, 0xba, 0xc6, 0xc7, 0xc8, 0xc9, 0xca,
+    0xd7, 0xd8, 0xd9, 0xda, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_graphics_q95[] =
+  { /* 0-base */ 0, 1, 0, 1, 5, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_graphics_q95[] =
+  {
+    0x00, 0x03, 0x01, 0x02, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_graphics_q95[] =
+  { /* 0-base */ 0, 1, 0, 1, 3, 2, 3, 5, 4, 5, 6, 8, 8, 1, 1, 1, 113 };
+
+static const UINT8 val_ac_chrominance_graphics_q95[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x21, 0x05, 0x12, 0x31, 0x06, 0x41,
+    0x51, 0x61, 0x71, 0x13, 0x22, 0x81, 0x91, 0x07, 0x14, 0x32, 0xa1, 0xb1,
+    0x23, 0x42, 0x52, 0xc1, 0xd1, 0xf0, 0x15, 0x16, 0x33, 0x62, 0x72, 0x82,
+    0x92, 0xe1, 0x08, 0x17, 0x34, 0x53, 0x54, 0xa2, 0xb2, 0xd2, 0xf1, 0x24,
+    0x35, 0x36, 0x43, 0x73, 0x93, 0x94, 0xc2, 0x25, 0x44, 0x63, 0x83, 0xb3,
+    0xd3, 0x55, 0x74, 0xd5, 0xe2, 0x18, 0x26, 0x45, 0x64, 0x65, 0xa3, 0xb4,
+    0xc3, 0x37, 0x56, 0xa4, 0xd4, 0x95, 0x09, 0x0a, 0x19, 0x38, 0x46, 0x75,
+    0x84, 0x1a, 0x27, 0x28, 0x29, 0x2a, 0x39, 0x3a, 0x47, 0x48, 0x49, 0x4a,
+    0x57, 0x58, 0x59, 0x5a, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x96, 0x97, 0x98, 0x99,
+    0x9a, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9,
+    0xba, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Synthetic images, quality 85 */
+
+static const UINT8 bits_dc_luminance_graphics_q85[] =
+  { /* 0-base */ 0, 1, 0, 2, 2, 3, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_graphics_q85[] =
+  {
+    0x00, 0x05, 0x07, 0x04, 0x06, 0x02, 0x03, 0x08, 0x01, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_graphics_q85[] =
+  { /* 0-base */ 0, 0, 1, 3, 3, 1, 3, 5, 5, 10, 20, 16, 6, 10, 0, 0, 79 };
+
+static const UINT8 val_ac_luminance_graphics_q85[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x11, 0x06, 0x07, 0x12, 0x21, 0x08,
+    0x13, 0x14, 0x31, 0x41, 0x15, 0x22, 0x51, 0x61, 0x71, 0x17, 0x32, 0x53,
+    0x54, 0x81, 0x91, 0x92, 0xa2, 0xb1, 0xd1, 0x09, 0x16, 0x18, 0x23, 0x33,
+    0x34, 0x35, 0x37, 0x42, 0x52, 0x55, 0x56, 0x57, 0x72, 0x93, 0x95, 0xa1,
+    0xb2, 0xd2, 0xd3, 0x24, 0x36, 0x38, 0x62, 0x74, 0x75, 0x76, 0x82, 0x94,
+    0x96, 0xa5, 0xb3, 0xb4, 0xc1, 0xd4, 0xe2, 0x63, 0x73, 0x84, 0xa3, 0xe1,
+    0xe3, 0x25, 0x43, 0x47, 0x58, 0x66, 0x67, 0x85, 0xa4, 0xa6, 0xb5, 0xc2,
+    0xc3, 0xc4, 0xd5, 0xe4, 0xf0, 0x39, 0x64, 0x83, 0xc5, 0x26, 0x27, 0xf1,
+    0x28, 0x44, 0x45, 0x46, 0x19, 0x65, 0x77, 0x29, 0x0a, 0x1a, 0x2a, 0x3a,
+    0x48, 0x49, 0x4a, 0x59, 0x5a, 0x68, 0x69, 0x6a, 0x78, 0x79, 0x7a, 0x86,
+    0x87, 0x88, 0x89, 0x8a, 0x97, 0x98, 0x99, 0x9a, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd6, 0xd7,
+    0xd8, 0xd9, 0xda, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_graphics_q85[] =
+  { /* 0-base */ 0, 1, 0, 3, 1, 1, 1, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_graphics_q85[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_graphics_q85[] =
+  { /* 0-base */ 0, 1, 0, 1, 3, 2, 3, 3, 10, 3, 5, 4, 4, 0, 1, 1, 121 };
+
+static const UINT8 val_ac_chrominance_graphics_q85[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x21, 0x12, 0x31, 0x41, 0x05, 0x51,
+    0x61, 0x13, 0x22, 0x71, 0x81, 0x91, 0xa1, 0xb1, 0xc1, 0xd1, 0xf0, 0x06,
+    0x14, 0x32, 0x15, 0x33, 0x42, 0x52, 0xe1, 0x23, 0x53, 0x92, 0xf1, 0x07,
+    0x16, 0x34, 0x62, 0x72, 0xb2, 0xc2, 0x24, 0x43, 0x54, 0x82, 0xa2, 0xd2,
+    0x25, 0xd3, 0x17, 0x35, 0x44, 0x63, 0x64, 0x83, 0x36, 0x73, 0x93, 0xb3,
+    0xe2, 0x45, 0xf2, 0x08, 0x09, 0x0a, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x37, 0x38, 0x39, 0x3a, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x55,
+    0x56, 0x57, 0x58, 0x59, 0x5a, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa3, 0xa4, 0xa5, 0xa6,
+    0xa7, 0xa8, 0xa9, 0xaa, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
+    0xd9, 0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Synthetic images, quality 75 */
+
+static const UINT8 bits_dc_luminance_graphics_q75[] =
+  { /* 0-base */ 0, 1, 0, 1, 5, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_graphics_q75[] =
+  {
+    0x00, 0x06, 0x02, 0x03, 0x04, 0x05, 0x07, 0x01, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_graphics_q75[] =
+  { /* 0-base */ 0, 0, 1, 3, 3, 1, 3, 5, 6, 10, 17, 16, 6, 0, 1, 1, 89 };
+
+static const UINT8 val_ac_luminance_graphics_q75[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x11, 0x06, 0x12, 0x21, 0x31, 0x07,
+    0x13, 0x14, 0x41, 0x51, 0x22, 0x53, 0x61, 0x71, 0x81, 0x91, 0x15, 0x16,
+    0x32, 0x34, 0x52, 0x56, 0x92, 0xa1, 0xb1, 0xd1, 0x08, 0x17, 0x23, 0x33,
+    0x36, 0x37, 0x42, 0x54, 0x55, 0x72, 0x73, 0x95, 0xa2, 0xb2, 0xd2, 0xd3,
+    0xe1, 0x18, 0x24, 0x35, 0x62, 0x66, 0x74, 0x75, 0x82, 0x93, 0x94, 0xa4,
+    0xa5, 0xb3, 0xc1, 0xe3, 0xf0, 0x63, 0x83, 0x84, 0xa3, 0xb4, 0xc2, 0x25,
+    0x38, 0x43, 0x46, 0x57, 0xc3, 0xd4, 0xe2, 0x27, 0x85, 0xc4, 0xf1, 0x26,
+    0x44, 0x45, 0x65, 0x28, 0x64, 0x76, 0x09, 0x0a, 0x19, 0x1a, 0x29, 0x2a,
+    0x39, 0x3a, 0x47, 0x48, 0x49, 0x4a, 0x58, 0x59, 0x5a, 0x67, 0x68, 0x69,
+    0x6a, 0x77, 0x78, 0x79, 0x7a, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb5, 0xb6, 0xb7, 0xb8,
+    0xb9, 0xba, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd5, 0xd6, 0xd7, 0xd8,
+    0xd9, 0xda, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_graphics_q75[] =
+  { /* 0-base */ 0, 1, 0, 3, 1, 1, 1, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_graphics_q75[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_graphics_q75[] =
+  { /* 0-base */ 0, 1, 0, 2, 1, 2, 4, 1, 9, 6, 4, 3, 2, 0, 0, 0, 127 };
+
+static const UINT8 val_ac_chrominance_graphics_q75[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x21, 0x04, 0x12, 0x31, 0x41, 0x51, 0x05,
+    0x13, 0x22, 0x32, 0x61, 0x71, 0x81, 0x91, 0xf0, 0x14, 0x52, 0xa1, 0xb1,
+    0xc1, 0xd1, 0x15, 0x33, 0x42, 0xe1, 0x06, 0x23, 0x53, 0xf1, 0x62, 0x92,
+    0xd2, 0x24, 0x34, 0x43, 0x72, 0x82, 0xa2, 0x16, 0x63, 0xb2, 0xc2, 0x35,
+    0x25, 0xe2, 0x44, 0x54, 0x93, 0x07, 0x08, 0x09, 0x0a, 0x17, 0x18, 0x19,
+    0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x64,
+    0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x94, 0x95,
+    0x96, 0x97, 0x98, 0x99, 0x9a, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9,
+    0xaa, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Synthetic images, quality 60 */
+
+static const UINT8 bits_dc_luminance_graphics_q60[] =
+  { /* 0-base */ 0, 1, 0, 2, 3, 1, 1, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_graphics_q60[] =
+  {
+    0x00, 0x04, 0x05, 0x02, 0x03, 0x06, 0x01, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_graphics_q60[] =
+  { /* 0-base */ 0, 0, 1, 3, 3, 1, 4, 3, 8, 10, 10, 13, 7, 1, 1, 2, 95 };
+
+static const UINT8 val_ac_luminance_graphics_q60[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x11, 0x12, 0x06, 0x13, 0x21, 0x31,
+    0x14, 0x41, 0x51, 0x07, 0x22, 0x52, 0x61, 0x71, 0x81, 0x91, 0xa1, 0x15,
+    0x16, 0x32, 0x33, 0x53, 0x55, 0xb1, 0xd1, 0xd2, 0xf0, 0x17, 0x23, 0x36,
+    0x42, 0x56, 0x72, 0x74, 0x94, 0xb2, 0xc1, 0x34, 0x35, 0x54, 0x62, 0x65,
+    0x73, 0x92, 0x93, 0xa2, 0xa4, 0xb3, 0xe1, 0xe2, 0x24, 0x37, 0x82, 0x83,
+    0x95, 0xa3, 0xc2, 0xc3, 0xd3, 0x43, 0x45, 0x64, 0x75, 0x84, 0xa5, 0xf1,
+    0x25, 0x26, 0x44, 0x63, 0x46, 0x27, 0x66, 0xb4, 0xd4, 0x08, 0x09, 0x0a,
+    0x18, 0x19, 0x1a, 0x28, 0x29, 0x2a, 0x38, 0x39, 0x3a, 0x47, 0x48, 0x49,
+    0x4a, 0x57, 0x58, 0x59, 0x5a, 0x67, 0x68, 0x69, 0x6a, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x96, 0x97, 0x98, 0x99,
+    0x9a, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_graphics_q60[] =
+  { /* 0-base */ 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_graphics_q60[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_graphics_q60[] =
+  { /* 0-base */ 0, 1, 0, 2, 1, 3, 2, 3, 4, 8, 5, 1, 1, 1, 1, 2, 127 };
+
+static const UINT8 val_ac_chrominance_graphics_q60[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x21, 0x31, 0x12, 0x41, 0x04, 0x13, 0x51,
+    0x22, 0x32, 0x61, 0x71, 0x05, 0x14, 0x81, 0x91, 0xa1, 0xb1, 0xd1, 0xf0,
+    0x33, 0x42, 0x52, 0xc1, 0xe1, 0x23, 0x15, 0x53, 0x82, 0xa2, 0xd2, 0xf1,
+    0x24, 0x62, 0x63, 0x34, 0x43, 0x72, 0x06, 0x16, 0x92, 0xe2, 0xb2, 0xc2,
+    0x07, 0x08, 0x09, 0x0a, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x44, 0x45, 0x46, 0x47,
+    0x48, 0x49, 0x4a, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x64, 0x65,
+    0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+    0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x93, 0x94, 0x95,
+    0x96, 0x97, 0x98, 0x99, 0x9a, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9,
+    0xaa, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Synthetic images, quality 45 */
+
+static const UINT8 bits_dc_luminance_graphics_q45[] =
+  { /* 0-base */ 0, 1, 0, 2, 3, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_graphics_q45[] =
+  {
+    0x00, 0x03, 0x05, 0x02, 0x04, 0x06, 0x01, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_graphics_q45[] =
+  { /* 0-base */ 0, 0, 1, 3, 2, 2, 5, 5, 8, 9, 16, 6, 5, 1, 1, 1, 97 };
+
+static const UINT8 val_ac_luminance_graphics_q45[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x11, 0x05, 0x12, 0x06, 0x13, 0x21, 0x31,
+    0x51, 0x41, 0x52, 0x61, 0x71, 0x91, 0x14, 0x15, 0x22, 0x32, 0x81, 0xa1,
+    0xb1, 0xd1, 0x07, 0x16, 0x33, 0x53, 0x54, 0x55, 0x72, 0xc1, 0xd2, 0x23,
+    0x34, 0x35, 0x36, 0x42, 0x62, 0x73, 0x74, 0x92, 0x93, 0x94, 0xa3, 0xb2,
+    0xe1, 0xe2, 0xf0, 0x17, 0x65, 0x82, 0xa2, 0xa4, 0xc2, 0x24, 0x63, 0x64,
+    0x83, 0xb3, 0xd3, 0xf1, 0x25, 0x37, 0x43, 0x44, 0x45, 0x56, 0x84, 0xc3,
+    0x26, 0x75, 0x27, 0x46, 0x08, 0x09, 0x0a, 0x18, 0x19, 0x1a, 0x28, 0x29,
+    0x2a, 0x38, 0x39, 0x3a, 0x47, 0x48, 0x49, 0x4a, 0x57, 0x58, 0x59, 0x5a,
+    0x66, 0x67, 0x68, 0x69, 0x6a, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x85, 0x86,
+    0x87, 0x88, 0x89, 0x8a, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa5, 0xa6,
+    0xa7, 0xa8, 0xa9, 0xaa, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc4,
+    0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_graphics_q45[] =
+  { /* 0-base */ 0, 1, 1, 1, 1, 1, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_graphics_q45[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_graphics_q45[] =
+  { /* 0-base */ 0, 1, 1, 0, 2, 0, 5, 2, 3, 5, 7, 1, 1, 1, 0, 2, 131 };
+
+static const UINT8 val_ac_chrominance_graphics_q45[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x03, 0x12, 0x21, 0x31, 0x41, 0x13, 0x51, 0x04,
+    0x32, 0x61, 0x14, 0x22, 0x71, 0x81, 0x91, 0x42, 0x52, 0xa1, 0xb1, 0xd1,
+    0xe1, 0xf0, 0x05, 0x23, 0x33, 0xc1, 0x15, 0x62, 0x34, 0xf1, 0x43, 0x24,
+    0x92, 0x53, 0x63, 0x72, 0xc2, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x54, 0x55,
+    0x56, 0x57, 0x58, 0x59, 0x5a, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+    0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85,
+    0x86, 0x87, 0x88, 0x89, 0x8a, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+    0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3,
+    0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+/* Synthetic images, quality 30 */
+
+static const UINT8 bits_dc_luminance_graphics_q30[] =
+  { /* 0-base */ 0, 1, 0, 2, 3, 1, 1, 0, 3, 1, 0, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_luminance_graphics_q30[] =
+  {
+    0x00, 0x03, 0x04, 0x01, 0x02, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_luminance_graphics_q30[] =
+  { /* 0-base */ 0, 0, 2, 1, 3, 1, 4, 3, 10, 7, 12, 7, 3, 0, 0, 2, 107 };
+
+static const UINT8 val_ac_luminance_graphics_q30[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x11, 0x12, 0x05, 0x13, 0x21, 0x31, 0x41,
+    0x51, 0x61, 0x06, 0x14, 0x15, 0x22, 0x32, 0x52, 0x71, 0x91, 0xa1, 0xd1,
+    0x35, 0x54, 0x72, 0x81, 0x93, 0xb1, 0xc1, 0x16, 0x23, 0x33, 0x34, 0x42,
+    0x53, 0x55, 0x73, 0x92, 0xa3, 0xb2, 0xe1, 0x64, 0x82, 0x94, 0xa2, 0xc2,
+    0xd2, 0xf0, 0x24, 0x36, 0x43, 0x62, 0x63, 0x83, 0xe2, 0x44, 0x74, 0xa4,
+    0xf1, 0x25, 0x26, 0x45, 0x65, 0x84, 0xb3, 0xd3, 0x07, 0x08, 0x09, 0x0a,
+    0x17, 0x18, 0x19, 0x1a, 0x27, 0x28, 0x29, 0x2a, 0xc3, 0x37, 0x38, 0x39,
+    0x3a, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x66,
+    0x67, 0x68, 0x69, 0x6a, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x85, 0x86,
+    0x87, 0x88, 0x89, 0x8a, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa5, 0xa6,
+    0xa7, 0xa8, 0xa9, 0xaa, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc4,
+    0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9,
+    0xda, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const UINT8 bits_dc_chrominance_graphics_q30[] =
+  { /* 0-base */ 0, 1, 1, 1, 1, 1, 1, 1, 0, 2, 3, 0, 0, 0, 0, 0, 0 };
+
+static const UINT8 val_dc_chrominance_graphics_q30[] =
+  {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b
+  };
+
+static const UINT8 bits_ac_chrominance_graphics_q30[] =
+  { /* 0-base */ 0, 1, 1, 0, 2, 1, 4, 1, 3, 2, 3, 5, 1, 0, 1, 2, 135 };
+
+static const UINT8 val_ac_chrominance_graphics_q30[] =
+  {
+    0x00, 0x01, 0x02, 0x11, 0x31, 0x03, 0x12, 0x21, 0x41, 0x51, 0x13, 0x32,
+    0x61, 0x04, 0x22, 0x71, 0x81, 0xa1, 0x14, 0x42, 0x52, 0x91, 0xd1, 0xe1,
+    0xf0, 0x33, 0x62, 0xb1, 0x23, 0xc1, 0xf1, 0x05, 0x06, 0x07, 0x08, 0x09,
+    0x0a, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x72, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+  };
+
+static const huff_table_spec pretrained_dc_tables[] = {
+  { bits_dc_luminance_photo_q95, val_dc_luminance_photo_q95 },
+  { bits_dc_chrominance_photo_q95, val_dc_chrominance_photo_q95 },
+  { bits_dc_luminance_photo_q90, val_dc_luminance_photo_q90 },
+  { bits_dc_chrominance_photo_q90, val_dc_chrominance_photo_q90 },
+  { bits_dc_luminance_photo_q85, val_dc_luminance_photo_q85 },
+  { bits_dc_chrominance_photo_q85, val_dc_chrominance_photo_q85 },
+  { bits_dc_luminance_photo_q80, val_dc_luminance_photo_q80 },
+  { bits_dc_chrominance_photo_q80, val_dc_chrominance_photo_q80 },
+  { bits_dc_luminance_photo_q70, val_dc_luminance_photo_q70 },
+  { bits_dc_chrominance_photo_q70, val_dc_chrominance_photo_q70 },
+  { bits_dc_luminance_photo_q60, val_dc_luminance_photo_q60 },
+  { bits_dc_chrominance_photo_q60, val_dc_chrominance_photo_q60 },
+  { bits_dc_luminance_photo_q50, val_dc_luminance_photo_q50 },
+  { bits_dc_chrominance_photo_q50, val_dc_chrominance_photo_q50 },
+  { bits_dc_luminance_photo_q40, val_dc_luminance_photo_q40 },
+  { bits_dc_chrominance_photo_q40, val_dc_chrominance_photo_q40 },
+  { bits_dc_luminance_photo_q30, val_dc_luminance_photo_q30 },
+  { bits_dc_chrominance_photo_q30, val_dc_chrominance_photo_q30 },
+  { bits_dc_luminance_photo_q20, val_dc_luminance_photo_q20 },
+  { bits_dc_chrominance_photo_q20, val_dc_chrominance_photo_q20 },
+  { bits_dc_luminance_graphics_q95, val_dc_luminance_graphics_q95 },
+  { bits_dc_chrominance_graphics_q95, val_dc_chrominance_graphics_q95 },
+  { bits_dc_luminance_graphics_q85, val_dc_luminance_graphics_q85 },
+  { bits_dc_chrominance_graphics_q85, val_dc_chrominance_graphics_q85 },
+  { bits_dc_luminance_graphics_q75, val_dc_luminance_graphics_q75 },
+  { bits_dc_chrominance_graphics_q75, val_dc_chrominance_graphics_q75 },
+  { bits_dc_luminance_graphics_q60, val_dc_luminance_graphics_q60 },
+  { bits_dc_chrominance_graphics_q60, val_dc_chrominance_graphics_q60 },
+  { bits_dc_luminance_graphics_q45, val_dc_luminance_graphics_q45 },
+  { bits_dc_chrominance_graphics_q45, val_dc_chrominance_graphics_q45 },
+  { bits_dc_luminance_graphics_q30, val_dc_luminance_graphics_q30 },
+  { bits_dc_chrominance_graphics_q30, val_dc_chrominance_graphics_q30 }
+};
+
+#define NUM_PRETRAINED_DC_TABLES \
+  (int) (sizeof(pretrained_dc_tables) / sizeof(huff_table_spec))
+
+static const huff_table_spec pretrained_ac_tables[] = {
+  { bits_ac_luminance_photo_q95, val_ac_luminance_photo_q95 },
+  { bits_ac_chrominance_photo_q95, val_ac_chrominance_photo_q95 },
+  { bits_ac_luminance_photo_q90, val_ac_luminance_photo_q90 },
+  { bits_ac_chrominance_photo_q90, val_ac_chrominance_photo_q90 },
+  { bits_ac_luminance_photo_q85, val_ac_luminance_photo_q85 },
+  { bits_ac_chrominance_photo_q85, val_ac_chrominance_photo_q85 },
+  { bits_ac_luminance_photo_q80, val_ac_luminance_photo_q80 },
+  { bits_ac_chrominance_photo_q80, val_ac_chrominance_photo_q80 },
+  { bits_ac_luminance_photo_q70, val_ac_luminance_photo_q70 },
+  { bits_ac_chrominance_photo_q70, val_ac_chrominance_photo_q70 },
+  { bits_ac_luminance_photo_q60, val_ac_luminance_photo_q60 },
+  { bits_ac_chrominance_photo_q60, val_ac_chrominance_photo_q60 },
+  { bits_ac_luminance_photo_q50, val_ac_luminance_photo_q50 },
+  { bits_ac_chrominance_photo_q50, val_ac_chrominance_photo_q50 },
+  { bits_ac_luminance_photo_q40, val_ac_luminance_photo_q40 },
+  { bits_ac_chrominance_photo_q40, val_ac_chrominance_photo_q40 },
+  { bits_ac_luminance_photo_q30, val_ac_luminance_photo_q30 },
+  { bits_ac_chrominance_photo_q30, val_ac_chrominance_photo_q30 },
+  { bits_ac_luminance_photo_q20, val_ac_luminance_photo_q20 },
+  { bits_ac_chrominance_photo_q20, val_ac_chrominance_photo_q20 },
+  { bits_ac_luminance_graphics_q95, val_ac_luminance_graphics_q95 },
+  { bits_ac_chrominance_graphics_q95, val_ac_chrominance_graphics_q95 },
+  { bits_ac_luminance_graphics_q85, val_ac_luminance_graphics_q85 },
+  { bits_ac_chrominance_graphics_q85, val_ac_chrominance_graphics_q85 },
+  { bits_ac_luminance_graphics_q75, val_ac_luminance_graphics_q75 },
+  { bits_ac_chrominance_graphics_q75, val_ac_chrominance_graphics_q75 },
+  { bits_ac_luminance_graphics_q60, val_ac_luminance_graphics_q60 },
+  { bits_ac_chrominance_graphics_q60, val_ac_chrominance_graphics_q60 },
+  { bits_ac_luminance_graphics_q45, val_ac_luminance_graphics_q45 },
+  { bits_ac_chrominance_graphics_q45, val_ac_chrominance_graphics_q45 },
+  { bits_ac_luminance_graphics_q30, val_ac_luminance_graphics_q30 },
+  { bits_ac_chrominance_graphics_q30, val_ac_chrominance_graphics_q30 }
+};
+
+#define NUM_PRETRAINED_AC_TABLES \
+  (int) (sizeof(pretrained_ac_tables) / sizeof(huff_table_spec))
@@ -59,9 +59,13 @@ jinit_compress_master (j_compress_ptr cinfo)
       jinit_huff_encoder(cinfo);
   }
 
-  /* Need a full-image coefficient buffer in any multi-pass mode. */
+  /* Need a full-image coefficient buffer in any multi-pass mode, unless the
+   * Huffman encoder can replay the optimization pass from its symbol stream.
+   */
   jinit_c_coef_controller(cinfo,
-                (boolean) (cinfo->num_scans > 1 || cinfo->optimize_coding));
+                (boolean) (cinfo->num_scans > 1 ||
+                           (cinfo->optimize_coding &&
+                            ! cinfo->master->huff_symbol_stream)));
   jinit_c_main_controller(cinfo, FALSE /* never need full buffer here */);
 
   jinit_marker_writer(cinfo);
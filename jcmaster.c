@@ -20,38 +20,17 @@
 #include "jpeglib.h"
 #include "jpegcomp.h"
 #include "jconfigint.h"
+#include "jcmaster.h"
 
 
-/* Private state */
-
-typedef enum {
-        main_pass,              /* input data, also do first output step */
-        huff_opt_pass,          /* Huffman code optimization pass */
-        output_pass             /* data output pass */
-} c_pass_type;
-
-typedef struct {
-  struct jpeg_comp_master pub;  /* public fields */
-
-  c_pass_type pass_type;        /* the type of the current pass */
-
-  int pass_number;              /* # of passes completed */
-  int total_passes;             /* total # of passes needed */
-
-  int scan_number;              /* current index in scan_info[] */
-
-  /*
-   * This is here so we can add libjpeg-turbo version/build information to the
-   * global string table without introducing a new global symbol.  Adding this
-   * information to the global string table allows one to examine a binary
-   * object and determine which version of libjpeg-turbo it was built from or
-   * linked against.
-   */
-  const char *jpeg_version;
-
-} my_comp_master;
+/*
+ * When the Huffman entropy encoder chooses pre-trained tables from a sample
+ * of the scan (see jpegint.h), it writes the scan header itself.
+ */
 
-typedef my_comp_master *my_master_ptr;
+#define HUFF_WRITES_SCAN_HEADER(cinfo) \
+  ((cinfo)->master->huff_pretrained && ! (cinfo)->optimize_coding && \
+   ! (cinfo)->arith_code && ! (cinfo)->progressive_mode)
 
 
 /*
@@ -464,7 +443,9 @@ prepare_for_pass (j_compress_ptr cinfo)
     (*cinfo->fdct->start_pass) (cinfo);
     (*cinfo->entropy->start_pass) (cinfo, cinfo->optimize_coding);
     (*cinfo->coef->start_pass) (cinfo,
-                                (master->total_passes > 1 ?
+                                (cinfo->num_scans > 1 ||
+                                 (cinfo->optimize_coding &&
+                                  ! cinfo->master->huff_symbol_stream) ?
                                  JBUF_SAVE_AND_PASS : JBUF_PASS_THRU));
     (*cinfo->main->start_pass) (cinfo, JBUF_PASS_THRU);
     if (cinfo->optimize_coding) {
@@ -505,7 +486,8 @@ prepare_for_pass (j_compress_ptr cinfo)
     /* We emit frame/scan headers now */
     if (master->scan_number == 0)
       (*cinfo->marker->write_frame_header) (cinfo);
-    (*cinfo->marker->write_scan_header) (cinfo);
+    if (! HUFF_WRITES_SCAN_HEADER(cinfo))
+      (*cinfo->marker->write_scan_header) (cinfo);
     master->pub.call_pass_startup = FALSE;
     break;
   default:
@@ -538,7 +520,8 @@ pass_startup (j_compress_ptr cinfo)
   cinfo->master->call_pass_startup = FALSE; /* reset flag so call only once */
 
   (*cinfo->marker->write_frame_header) (cinfo);
-  (*cinfo->marker->write_scan_header) (cinfo);
+  if (! HUFF_WRITES_SCAN_HEADER(cinfo))
+    (*cinfo->marker->write_scan_header) (cinfo);
 }
 
 
@@ -589,12 +572,8 @@ finish_pass_master (j_compress_ptr cinfo)
 GLOBAL(void)
 jinit_c_master_control (j_compress_ptr cinfo, boolean transcode_only)
 {
-  my_master_ptr master;
+  my_master_ptr master = (my_master_ptr) cinfo->master;
 
-  master = (my_master_ptr)
-      (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
-                                  sizeof(my_comp_master));
-  cinfo->master = (struct jpeg_comp_master *) master;
   master->pub.prepare_for_pass = prepare_for_pass;
   master->pub.pass_startup = pass_startup;
   master->pub.finish_pass = finish_pass_master;
@@ -18,7 +18,9 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
-#include "jchuff.h"             /* Declarations shared with jchuff.c */
+#include "jconfigint.h"
+#include "jsimd.h"
+#include <limits.h>
 
 #ifdef C_PROGRESSIVE_SUPPORTED
 
@@ -27,6 +29,16 @@
 typedef struct {
   struct jpeg_entropy_encoder pub; /* public fields */
 
+  /* Pointers to routines to prepare data for encode_mcu_AC_first() and
+   * encode_mcu_AC_refine().
+   */
+  void (*AC_first_prepare) (const JCOEF *block,
+                            const int *jpeg_natural_order_start, int Sl,
+                            int Al, JCOEF *values, size_t *zerobits);
+  int (*AC_refine_prepare) (const JCOEF *block,
+                            const int *jpeg_natural_order_start, int Sl,
+                            int Al, JCOEF *absvalues, size_t *bits);
+
   /* Mode flag: TRUE for optimization, FALSE for actual data output */
   boolean gather_statistics;
 
@@ -88,11 +100,44 @@ typedef phuff_entropy_encoder *phuff_entropy_ptr;
 #define IRIGHT_SHIFT(x,shft)    ((x) >> (shft))
 #endif
 
+/*
+ * On 64-bit platforms with a count-trailing-zeros intrinsic (see jchuff.h),
+ * the AC scans make a pre-pass over each block that applies the point
+ * transform to the coefficients in the spectral band and records which of
+ * them are nonzero in a 64-bit mask (bit k corresponds to coefficient Ss+k.)
+ * The emission loops then jump directly from one nonzero coefficient to the
+ * next.  The pre-pass has no data-dependent branches, so start_pass_phuff()
+ * selects a SIMD implementation of it if one is available.
+ */
+
+#ifdef JPEG_CTZ64
+#if defined __GNUC__
+#define JPEG_NBITS_NONZERO(x) (32 - __builtin_clz(x))
+#elif defined _MSC_VER
+#pragma intrinsic(_BitScanReverse)
+static INLINE int jpeg_nbits_nonzero (unsigned int x)
+{
+  unsigned long index;
+  _BitScanReverse(&index, x);
+  return (int) index + 1;
+}
+#define JPEG_NBITS_NONZERO(x) jpeg_nbits_nonzero(x)
+#endif
+#endif
+
 /* Forward declarations */
 METHODDEF(boolean) encode_mcu_DC_first (j_compress_ptr cinfo,
                                         JBLOCKROW *MCU_data);
 METHODDEF(boolean) encode_mcu_AC_first (j_compress_ptr cinfo,
                                         JBLOCKROW *MCU_data);
+#ifdef JPEG_CTZ64
+METHODDEF(void) encode_mcu_AC_first_prepare
+        (const JCOEF *block, const int *jpeg_natural_order_start, int Sl,
+         int Al, JCOEF *values, size_t *zerobits);
+METHODDEF(int) encode_mcu_AC_refine_prepare
+        (const JCOEF *block, const int *jpeg_natural_order_start, int Sl,
+         int Al, JCOEF *absvalues, size_t *bits);
+#endif
 METHODDEF(boolean) encode_mcu_DC_refine (j_compress_ptr cinfo,
                                          JBLOCKROW *MCU_data);
 METHODDEF(boolean) encode_mcu_AC_refine (j_compress_ptr cinfo,
@@ -124,13 +169,26 @@ start_pass_phuff (j_compress_ptr cinfo, boolean gather_statistics)
   if (cinfo->Ah == 0) {
     if (is_DC_band)
       entropy->pub.encode_mcu = encode_mcu_DC_first;
-    else
+    else {
       entropy->pub.encode_mcu = encode_mcu_AC_first;
+#ifdef JPEG_CTZ64
+      if (jsimd_can_encode_mcu_AC_first_prepare())
+        entropy->AC_first_prepare = jsimd_encode_mcu_AC_first_prepare;
+      else
+        entropy->AC_first_prepare = encode_mcu_AC_first_prepare;
+#endif
+    }
   } else {
     if (is_DC_band)
       entropy->pub.encode_mcu = encode_mcu_DC_refine;
     else {
       entropy->pub.encode_mcu = encode_mcu_AC_refine;
+#ifdef JPEG_CTZ64
+      if (jsimd_can_encode_mcu_AC_refine_prepare())
+        entropy->AC_refine_prepare = jsimd_encode_mcu_AC_refine_prepare;
+      else
+        entropy->AC_refine_prepare = encode_mcu_AC_refine_prepare;
+#endif
       /* AC refinement needs a correction bit buffer */
       if (entropy->bit_buffer == NULL)
         entropy->bit_buffer = (char *)
@@ -298,13 +356,22 @@ LOCAL(void)
 emit_buffered_bits (phuff_entropy_ptr entropy, char *bufstart,
                     unsigned int nbits)
 {
+  unsigned int code, size, i;
+
   if (entropy->gather_statistics)
     return;                     /* no real work */
 
+  /* Pack the bits into groups of up to 16, which is the most that emit_bits
+   * accepts in one call.
+   */
   while (nbits > 0) {
-    emit_bits(entropy, (unsigned int) (*bufstart), 1);
-    bufstart++;
-    nbits--;
+    size = nbits < 16 ? nbits : 16;
+    code = 0;
+    for (i = 0; i < size; i++)
+      code = (code << 1) | (unsigned int) bufstart[i];
+    emit_bits(entropy, code, (int) size);
+    bufstart += size;
+    nbits -= size;
   }
 }
 
@@ -456,6 +523,46 @@ encode_mcu_DC_first (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
 }
 
 
+#ifdef JPEG_CTZ64
+
+/*
+ * Data preparation for encode_mcu_AC_first().  For each coefficient k in the
+ * band, values[k] receives its absolute value after the point transform, and
+ * values[k + DCTSIZE2] receives the bits to emit for it (the bitwise
+ * complement of the absolute value, if the coefficient is negative.)  Bit k
+ * of *zerobits is set if the transformed coefficient is nonzero.
+ */
+
+METHODDEF(void)
+encode_mcu_AC_first_prepare (const JCOEF *block,
+                             const int *jpeg_natural_order_start, int Sl,
+                             int Al, JCOEF *values, size_t *zerobits)
+{
+  register int temp, temp2, k;
+  size_t mask = 0;
+
+  for (k = 0; k < Sl; k++) {
+    temp = block[jpeg_natural_order_start[k]];
+    /* We must apply the point transform by Al.  For AC coefficients this
+     * is an integer division with rounding towards 0.  To do this portably
+     * in C, we shift after obtaining the absolute value.  temp2 is -1 for
+     * a negative coefficient and 0 otherwise.
+     */
+    temp2 = temp >> (CHAR_BIT * sizeof(int) - 1);
+    temp ^= temp2;
+    temp -= temp2;              /* temp is abs value of input */
+    temp >>= Al;                /* apply the point transform */
+    values[k] = (JCOEF) temp;
+    values[k + DCTSIZE2] = (JCOEF) (temp ^ temp2);
+    mask |= ((size_t) (temp != 0)) << k;
+  }
+
+  *zerobits = mask;
+}
+
+#endif
+
+
 /*
  * MCU encoding for AC initial scan (either spectral selection,
  * or first pass of successive approximation).
@@ -468,7 +575,13 @@ encode_mcu_AC_first (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   register int temp, temp2;
   register int nbits;
   register int r, k;
+#ifdef JPEG_CTZ64
+  int Sl = cinfo->Se - cinfo->Ss + 1;
+  JCOEF values[2 * DCTSIZE2];
+  size_t zerobits;
+#else
   int Se = cinfo->Se;
+#endif
   int Al = cinfo->Al;
   JBLOCKROW block;
 
@@ -483,6 +596,51 @@ encode_mcu_AC_first (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   /* Encode the MCU data block */
   block = MCU_data[0];
 
+#ifdef JPEG_CTZ64
+  /* Apply the point transform and find the nonzero coefficients */
+  (*entropy->AC_first_prepare) (*block, jpeg_natural_order + cinfo->Ss, Sl,
+                                Al, values, &zerobits);
+
+  /* Encode the AC coefficients per section G.1.2.2, fig. G.3 */
+
+  k = -1;                       /* k = index of previous nonzero coef */
+
+  while (zerobits) {
+    r = JPEG_CTZ64(zerobits) - k - 1; /* r = run length of zeros */
+    k += r + 1;
+    zerobits &= zerobits - 1;   /* clear the bit for this coef */
+    temp = values[k];
+    temp2 = values[k + DCTSIZE2];
+
+    /* Emit any pending EOBRUN */
+    if (entropy->EOBRUN > 0)
+      emit_eobrun(entropy);
+    /* if run length > 15, must emit special run-length-16 codes (0xF0) */
+    while (r > 15) {
+      emit_symbol(entropy, entropy->ac_tbl_no, 0xF0);
+      r -= 16;
+    }
+
+    /* Find the number of bits needed for the magnitude of the coefficient */
+    nbits = JPEG_NBITS_NONZERO(temp);
+    /* Check for out-of-range coefficient values */
+    if (nbits > MAX_COEF_BITS)
+      ERREXIT(cinfo, JERR_BAD_DCT_COEF);
+
+    /* Count/emit Huffman symbol for run length / number of bits */
+    emit_symbol(entropy, entropy->ac_tbl_no, (r << 4) + nbits);
+
+    /* Emit that number of bits of the value, if positive, */
+    /* or the complement of its magnitude, if negative. */
+    emit_bits(entropy, (unsigned int) temp2, nbits);
+  }
+
+  if (k < Sl - 1) {             /* If there are trailing zeroes, */
+    entropy->EOBRUN++;          /* count an EOB */
+    if (entropy->EOBRUN == 0x7FFF)
+      emit_eobrun(entropy);     /* force it out to avoid overflow */
+  }
+#else
   /* Encode the AC coefficients per section G.1.2.2, fig. G.3 */
 
   r = 0;                        /* r = run length of zeros */
@@ -544,6 +702,7 @@ encode_mcu_AC_first (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
     if (entropy->EOBRUN == 0x7FFF)
       emit_eobrun(entropy);     /* force it out to avoid overflow */
   }
+#endif
 
   cinfo->dest->next_output_byte = entropy->next_output_byte;
   cinfo->dest->free_in_buffer = entropy->free_in_buffer;
@@ -611,6 +770,47 @@ encode_mcu_DC_refine (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
 }
 
 
+#ifdef JPEG_CTZ64
+
+/*
+ * Data preparation for encode_mcu_AC_refine().  For each coefficient k in the
+ * band, absvalues[k] receives its absolute value after the point transform.
+ * Bit k of bits[0] is set if the transformed coefficient is nonzero, and bit
+ * k of bits[1] is set if the coefficient is not negative.  The return value
+ * is the number of coefficients up to and including the last one that
+ * becomes nonzero in this scan (the EOB position), or 0 if there is none.
+ */
+
+METHODDEF(int)
+encode_mcu_AC_refine_prepare (const JCOEF *block,
+                              const int *jpeg_natural_order_start, int Sl,
+                              int Al, JCOEF *absvalues, size_t *bits)
+{
+  register int temp, temp2, k;
+  int EOB = 0;
+  size_t zerobits = 0, signbits = 0;
+
+  for (k = 0; k < Sl; k++) {
+    temp = block[jpeg_natural_order_start[k]];
+    temp2 = temp >> (CHAR_BIT * sizeof(int) - 1);
+    temp ^= temp2;
+    temp -= temp2;              /* temp is abs value of input */
+    temp >>= Al;                /* apply the point transform */
+    absvalues[k] = (JCOEF) temp;
+    zerobits |= ((size_t) (temp != 0)) << k;
+    signbits |= ((size_t) (temp2 + 1)) << k;
+    if (temp == 1)
+      EOB = k + 1;              /* EOB = index of last newly-nonzero coef + 1 */
+  }
+
+  bits[0] = zerobits;
+  bits[1] = signbits;
+  return EOB;
+}
+
+#endif
+
+
 /*
  * MCU encoding for AC successive approximation refinement scan.
  */
@@ -624,10 +824,16 @@ encode_mcu_AC_refine (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   int EOB;
   char *BR_buffer;
   unsigned int BR;
+#ifdef JPEG_CTZ64
+  int Sl = cinfo->Se - cinfo->Ss + 1;
+  JCOEF absvalues[DCTSIZE2];
+  size_t bits[2], zerobits;
+#else
   int Se = cinfo->Se;
+  int absvalues[DCTSIZE2];
+#endif
   int Al = cinfo->Al;
   JBLOCKROW block;
-  int absvalues[DCTSIZE2];
 
   entropy->next_output_byte = cinfo->dest->next_output_byte;
   entropy->free_in_buffer = cinfo->dest->free_in_buffer;
@@ -640,6 +846,66 @@ encode_mcu_AC_refine (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   /* Encode the MCU data block */
   block = MCU_data[0];
 
+#ifdef JPEG_CTZ64
+  /* It is convenient to make a pre-pass to determine the transformed
+   * coefficients' absolute values and the EOB position.
+   */
+  EOB = (*entropy->AC_refine_prepare) (*block, jpeg_natural_order + cinfo->Ss,
+                                       Sl, Al, absvalues, bits);
+  zerobits = bits[0];
+
+  /* Encode the AC coefficients per section G.1.2.3, fig. G.7 */
+
+  r = 0;                        /* r = run length of zeros */
+  BR = 0;                       /* BR = count of buffered bits added now */
+  BR_buffer = entropy->bit_buffer + entropy->BE; /* Append bits to buffer */
+  k = -1;                       /* k = index of previous nonzero coef */
+
+  while (zerobits) {
+    temp = JPEG_CTZ64(zerobits);
+    r += temp - k - 1;
+    k = temp;
+    zerobits &= zerobits - 1;   /* clear the bit for this coef */
+    temp = absvalues[k];
+
+    /* Emit any required ZRLs, but not if they can be folded into EOB */
+    while (r > 15 && k < EOB) {
+      /* emit any pending EOBRUN and the BE correction bits */
+      emit_eobrun(entropy);
+      /* Emit ZRL */
+      emit_symbol(entropy, entropy->ac_tbl_no, 0xF0);
+      r -= 16;
+      /* Emit buffered correction bits that must be associated with ZRL */
+      emit_buffered_bits(entropy, BR_buffer, BR);
+      BR_buffer = entropy->bit_buffer; /* BE bits are gone now */
+      BR = 0;
+    }
+
+    /* If the coef was previously nonzero, it only needs a correction bit. */
+    if (temp > 1) {
+      /* The correction bit is the next bit of the absolute value. */
+      BR_buffer[BR++] = (char) (temp & 1);
+      continue;
+    }
+
+    /* Emit any pending EOBRUN and the BE correction bits */
+    emit_eobrun(entropy);
+
+    /* Count/emit Huffman symbol for run length / number of bits */
+    emit_symbol(entropy, entropy->ac_tbl_no, (r << 4) + 1);
+
+    /* Emit output bit for newly-nonzero coef */
+    emit_bits(entropy, (unsigned int) (bits[1] >> k) & 1, 1);
+
+    /* Emit buffered correction bits that must be associated with this code */
+    emit_buffered_bits(entropy, BR_buffer, BR);
+    BR_buffer = entropy->bit_buffer; /* BE bits are gone now */
+    BR = 0;
+    r = 0;                      /* reset zero run length */
+  }
+
+  r += Sl - k - 1;              /* count trailing zeroes */
+#else
   /* It is convenient to make a pre-pass to determine the transformed
    * coefficients' absolute values and the EOB position.
    */
@@ -710,6 +976,7 @@ encode_mcu_AC_refine (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
     BR = 0;
     r = 0;                      /* reset zero run length */
   }
+#endif
 
   if (r > 0 || BR > 0) {        /* If there are trailing zeroes, */
     entropy->EOBRUN++;          /* count an EOB */
@@ -21,6 +21,8 @@
 #include "jinclude.h"
 #include "jdmainct.h"
 #include "jdcoefct.h"
+#include "jdmaster.h"
+#include "jdmerge.h"
 #include "jdsample.h"
 #include "jmemsys.h"
 
@@ -241,6 +243,16 @@ jpeg_crop_scanline (j_decompress_ptr cinfo, JDIMENSION *xoffset,
     jinit_upsampler(cinfo);
     cinfo->master->jinit_upsampler_no_alloc = FALSE;
   }
+
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  /* The merged upsampler copies whole output rows out of its spare row, so it
+   * must be told about the new output width as well.
+   */
+  if (((my_master_ptr) cinfo->master)->using_merged_upsample) {
+    my_merged_upsample_ptr upsample = (my_merged_upsample_ptr) cinfo->upsample;
+    upsample->out_row_width = cinfo->output_width * cinfo->out_color_components;
+  }
+#endif
 }
 
 
@@ -305,17 +317,60 @@ LOCAL(void)
 read_and_discard_scanlines (j_decompress_ptr cinfo, JDIMENSION num_lines)
 {
   JDIMENSION n;
+  JSAMPARRAY scanlines = NULL;
   void (*color_convert) (j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                          JDIMENSION input_row, JSAMPARRAY output_buf,
-                         int num_rows);
+                         int num_rows) = NULL;
 
-  color_convert = cinfo->cconvert->color_convert;
-  cinfo->cconvert->color_convert = noop_convert;
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  /* The merged upsampler performs color conversion itself, so it must be
+   * given somewhere to put the output.  Its spare row serves the purpose.
+   */
+  if (((my_master_ptr) cinfo->master)->using_merged_upsample) {
+    my_merged_upsample_ptr upsample = (my_merged_upsample_ptr) cinfo->upsample;
+    scanlines = &upsample->spare_row;
+  } else
+#endif
+  {
+    color_convert = cinfo->cconvert->color_convert;
+    cinfo->cconvert->color_convert = noop_convert;
+  }
 
   for (n = 0; n < num_lines; n++)
-    jpeg_read_scanlines(cinfo, NULL, 1);
+    jpeg_read_scanlines(cinfo, scanlines, 1);
 
-  cinfo->cconvert->color_convert = color_convert;
+  if (color_convert)
+    cinfo->cconvert->color_convert = color_convert;
+}
+
+
+/*
+ * Called by jpeg_skip_scanlines().  Since skipping lines involves skipping the
+ * upsampling step, the upsampler's row counters will become invalid unless we
+ * set them here.  If new_row_group is TRUE, then the next line to be read is
+ * the first line of a row group, so any buffered output rows are discarded.
+ */
+
+LOCAL(void)
+reset_upsampler (j_decompress_ptr cinfo, boolean new_row_group)
+{
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  if (((my_master_ptr) cinfo->master)->using_merged_upsample) {
+    my_merged_upsample_ptr upsample = (my_merged_upsample_ptr) cinfo->upsample;
+
+    if (new_row_group)
+      upsample->spare_full = FALSE;
+    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+    return;
+  }
+#endif
+  {
+    my_upsample_ptr upsample = (my_upsample_ptr) cinfo->upsample;
+
+    if (new_row_group)
+      upsample->next_row_out = cinfo->max_v_samp_factor;
+    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+  }
 }
 
 
@@ -342,6 +397,40 @@ increment_simple_rowgroup_ctr (j_decompress_ptr cinfo, JDIMENSION rows)
   read_and_discard_scanlines(cinfo, rows_left);
 }
 
+
+/*
+ * Called by jpeg_skip_scanlines().  If entropy checkpoints have been supplied,
+ * this resumes entropy decoding from the latest checkpoint that does not lie
+ * beyond the iMCU rows being skipped, so that the MCUs before it need not be
+ * decoded.  Returns the number of iMCU rows that were skipped.
+ */
+
+LOCAL(JDIMENSION)
+skip_to_checkpoint (j_decompress_ptr cinfo, JDIMENSION num_iMCU_rows)
+{
+  const jpeg_entropy_checkpoint *ckpt = NULL;
+  JDIMENSION last_row = cinfo->input_iMCU_row + num_iMCU_rows, rows;
+  int i;
+
+  if (cinfo->entropy->restore_checkpoint == NULL)
+    return 0;
+
+  for (i = 0; i < cinfo->master->num_checkpoints; i++) {
+    if (cinfo->master->checkpoints[i].iMCU_row > last_row)
+      break;
+    if (cinfo->master->checkpoints[i].iMCU_row > cinfo->input_iMCU_row)
+      ckpt = &cinfo->master->checkpoints[i];
+  }
+  if (ckpt == NULL || !(*cinfo->entropy->restore_checkpoint) (cinfo, ckpt))
+    return 0;
+
+  rows = ckpt->iMCU_row - cinfo->input_iMCU_row;
+  cinfo->input_iMCU_row += rows;
+  cinfo->output_iMCU_row += rows;
+  start_iMCU_row(cinfo);
+  return rows;
+}
+
 /*
  * Skips some scanlines of data from the JPEG decompressor.
  *
@@ -358,7 +447,6 @@ jpeg_skip_scanlines (j_decompress_ptr cinfo, JDIMENSION num_lines)
 {
   my_main_ptr main_ptr = (my_main_ptr) cinfo->main;
   my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
-  my_upsample_ptr upsample = (my_upsample_ptr) cinfo->upsample;
   JDIMENSION i, x;
   int y;
   JDIMENSION lines_per_iMCU_row, lines_left_in_iMCU_row, lines_after_iMCU_row;
@@ -419,8 +507,7 @@ jpeg_skip_scanlines (j_decompress_ptr cinfo, JDIMENSION num_lines)
     main_ptr->buffer_full = FALSE;
     main_ptr->rowgroup_ctr = 0;
     main_ptr->context_state = CTX_PREPARE_FOR_IMCU;
-    upsample->next_row_out = cinfo->max_v_samp_factor;
-    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+    reset_upsampler(cinfo, TRUE);
   }
 
   /* Skipping is much simpler when context rows are not required. */
@@ -432,8 +519,7 @@ jpeg_skip_scanlines (j_decompress_ptr cinfo, JDIMENSION num_lines)
       cinfo->output_scanline += lines_left_in_iMCU_row;
       main_ptr->buffer_full = FALSE;
       main_ptr->rowgroup_ctr = 0;
-      upsample->next_row_out = cinfo->max_v_samp_factor;
-      upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+      reset_upsampler(cinfo, TRUE);
     }
   }
 
@@ -468,12 +554,14 @@ jpeg_skip_scanlines (j_decompress_ptr cinfo, JDIMENSION num_lines)
       cinfo->output_iMCU_row += lines_to_skip / lines_per_iMCU_row;
       increment_simple_rowgroup_ctr(cinfo, lines_to_read);
     }
-    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+    reset_upsampler(cinfo, FALSE);
     return num_lines;
   }
 
   /* Skip the iMCU rows that we can safely skip. */
-  for (i = 0; i < lines_to_skip; i += lines_per_iMCU_row) {
+  i = skip_to_checkpoint(cinfo, lines_to_skip / lines_per_iMCU_row) *
+      lines_per_iMCU_row;
+  for (; i < lines_to_skip; i += lines_per_iMCU_row) {
     for (y = 0; y < coef->MCU_rows_per_iMCU_row; y++) {
       for (x = 0; x < cinfo->MCUs_per_row; x++) {
         /* Calling decode_mcu() with a NULL pointer causes it to discard the
@@ -509,7 +597,7 @@ jpeg_skip_scanlines (j_decompress_ptr cinfo, JDIMENSION num_lines)
    * bit odd, since "rows_to_go" seems to be redundantly keeping track of
    * output_scanline.
    */
-  upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+  reset_upsampler(cinfo, FALSE);
 
   /* Always skip the requested number of lines. */
   return num_lines;
@@ -19,6 +19,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jconfigint.h"
 
 
 #define NEG_1 ((unsigned int)-1)
@@ -81,13 +82,114 @@ get_byte (j_decompress_ptr cinfo)
 }
 
 
+/*
+ * Read the next byte of compressed data, undoing the zero stuffing.
+ * Returns zero data once a marker has been hit.
+ */
+
+LOCAL(int)
+get_data (j_decompress_ptr cinfo)
+{
+  int data;
+
+  if (cinfo->unread_marker)
+    return 0;                   /* stuff zero data */
+  data = get_byte(cinfo);       /* read next input byte */
+  if (data == 0xFF) {           /* zero stuff or marker code */
+    do data = get_byte(cinfo);
+    while (data == 0xFF);       /* swallow extra 0xFF bytes */
+    if (data == 0)
+      data = 0xFF;              /* discard stuffed zero byte */
+    else {
+      /* Note: Different from the Huffman decoder, hitting
+       * a marker while processing the compressed data
+       * segment is legal in arithmetic coding.
+       * The convention is to supply zero data
+       * then until decoding is complete.
+       */
+      cinfo->unread_marker = data;
+      data = 0;
+    }
+  }
+  return data;
+}
+
+
+/*
+ * The C register holds the 16-bit base of the coding interval (plus a
+ * possible carry bit) above CT bits of look-ahead.  Rather than fetching one
+ * byte at a time as renormalization consumes them, we pre-load as many bytes
+ * as a JLONG can hold, much as the Huffman decoder fills its bit buffer.
+ * This allows most renormalizations to be done with a single shift.
+ */
+
+#define MAX_CT  ((int) sizeof(JLONG) * 8 - 18)
+
+/*
+ * Slow path of arith_decode(), taken when the look-ahead bits do not suffice
+ * for renormalization (this includes the initial fill after a start of scan
+ * or restart, which is signalled by CT = -16.)  The working state is passed
+ * by value and returned in the entropy decoder object, so that the caller can
+ * keep its copy in registers.
+ */
+
+LOCAL(void)
+fill_c_register (j_decompress_ptr cinfo, JLONG c, JLONG a, int ct)
+{
+  arith_entropy_ptr e = (arith_entropy_ptr) cinfo->entropy;
+
+  /* Renormalization & data input per section D.2.6 */
+  while (a < 0x8000L) {
+    if (--ct < 0) {
+      /* Need to fetch next data byte */
+      c = (c << 8) | get_data(cinfo); /* insert data into C register */
+      if ((ct += 8) < 0)              /* update bit shift counter */
+        /* Need more initial bytes */
+        if (++ct == 0)
+          /* Got 2 initial bytes -> re-init A and exit loop */
+          a = 0x8000L; /* => a = 0x10000L after loop exit */
+    }
+    a <<= 1;
+  }
+
+  /* Pre-load as many further bytes as C can hold */
+  while (ct <= MAX_CT - 8) {
+    c = (c << 8) | get_data(cinfo);
+    ct += 8;
+  }
+
+  e->c = c;
+  e->a = a;
+  e->ct = ct;
+}
+
+
+/*
+ * Number of doublings needed to bring a nonzero A (< 0x8000) back into
+ * the range 0x8000..0xFFFF.  A = 0, which only occurs before the initial fill
+ * (CT = -16), yields a positive value so that the slow path is taken.
+ */
+
+#ifdef __GNUC__
+#define RENORM_SHIFT(a)  (__builtin_clz((unsigned int) (a) | 1) - 16)
+#else
+INLINE
+LOCAL(int)
+renorm_shift (JLONG a)
+{
+  int shift = 1;
+
+  while (shift < 16 && ((a << shift) & 0x8000L) == 0)
+    shift++;
+  return shift;
+}
+#define RENORM_SHIFT(a)  renorm_shift(a)
+#endif
+
+
 /*
  * The core arithmetic decoding routine (common in JPEG and JBIG).
  * This needs to go as fast as possible.
- * Machine-dependent optimization facilities
- * are not utilized in this portable implementation.
- * However, this code should be fairly efficient and
- * may be a good base for further optimizations anyway.
  *
  * Return value is 0 or 1 (binary decision).
  *
@@ -106,49 +208,37 @@ get_byte (j_decompress_ptr cinfo)
  * I've also introduced a new scheme for accessing
  * the probability estimation state machine table,
  * derived from Markus Kuhn's JBIG implementation.
+ *
+ * The C, A, and CT registers are passed by reference so that the MCU
+ * decoders can hold them in local variables.  Since the statistics bins are
+ * accessed through unsigned char pointers, which may alias anything, keeping
+ * the registers in the entropy decoder object would force them to be
+ * reloaded from memory after every statistics update.
  */
 
+INLINE
 LOCAL(int)
-arith_decode (j_decompress_ptr cinfo, unsigned char *st)
+arith_decode (j_decompress_ptr cinfo, unsigned char *st,
+              JLONG *c_reg, JLONG *a_reg, int *ct_reg)
 {
-  register arith_entropy_ptr e = (arith_entropy_ptr) cinfo->entropy;
+  register JLONG c = *c_reg, a = *a_reg;
+  register int ct = *ct_reg;
   register unsigned char nl, nm;
   register JLONG qe, temp;
-  register int sv, data;
+  register int sv, shift;
+
+  /* Renormalization per section D.2.6, in a single step if possible */
+  if (a < 0x8000L) {
+    shift = RENORM_SHIFT(a);
+    if (shift <= ct) {
+      a <<= shift;
+      ct -= shift;
+    } else {
+      arith_entropy_ptr e = (arith_entropy_ptr) cinfo->entropy;
 
-  /* Renormalization & data input per section D.2.6 */
-  while (e->a < 0x8000L) {
-    if (--e->ct < 0) {
-      /* Need to fetch next data byte */
-      if (cinfo->unread_marker)
-        data = 0;               /* stuff zero data */
-      else {
-        data = get_byte(cinfo); /* read next input byte */
-        if (data == 0xFF) {     /* zero stuff or marker code */
-          do data = get_byte(cinfo);
-          while (data == 0xFF); /* swallow extra 0xFF bytes */
-          if (data == 0)
-            data = 0xFF;        /* discard stuffed zero byte */
-          else {
-            /* Note: Different from the Huffman decoder, hitting
-             * a marker while processing the compressed data
-             * segment is legal in arithmetic coding.
-             * The convention is to supply zero data
-             * then until decoding is complete.
-             */
-            cinfo->unread_marker = data;
-            data = 0;
-          }
-        }
-      }
-      e->c = (e->c << 8) | data; /* insert data into C register */
-      if ((e->ct += 8) < 0)      /* update bit shift counter */
-        /* Need more initial bytes */
-        if (++e->ct == 0)
-          /* Got 2 initial bytes -> re-init A and exit loop */
-          e->a = 0x8000L; /* => e->a = 0x10000L after loop exit */
+      fill_c_register(cinfo, c, a, ct);
+      c = e->c;  a = e->a;  ct = e->ct;
     }
-    e->a <<= 1;
   }
 
   /* Fetch values from our compact representation of Table D.2:
@@ -160,23 +250,23 @@ arith_decode (j_decompress_ptr cinfo, unsigned char *st)
   nm = qe & 0xFF; qe >>= 8;     /* Next_Index_MPS */
 
   /* Decode & estimation procedures per sections D.2.4 & D.2.5 */
-  temp = e->a - qe;
-  e->a = temp;
-  temp <<= e->ct;
-  if (e->c >= temp) {
-    e->c -= temp;
+  temp = a - qe;
+  a = temp;
+  temp <<= ct;
+  if (c >= temp) {
+    c -= temp;
     /* Conditional LPS (less probable symbol) exchange */
-    if (e->a < qe) {
-      e->a = qe;
+    if (a < qe) {
+      a = qe;
       *st = (sv & 0x80) ^ nm;   /* Estimate_after_MPS */
     } else {
-      e->a = qe;
+      a = qe;
       *st = (sv & 0x80) ^ nl;   /* Estimate_after_LPS */
       sv ^= 0x80;               /* Exchange LPS/MPS */
     }
-  } else if (e->a < 0x8000L) {
+  } else if (a < 0x8000L) {
     /* Conditional MPS (more probable symbol) exchange */
-    if (e->a < qe) {
+    if (a < qe) {
       *st = (sv & 0x80) ^ nl;   /* Estimate_after_LPS */
       sv ^= 0x80;               /* Exchange LPS/MPS */
     } else {
@@ -184,10 +274,26 @@ arith_decode (j_decompress_ptr cinfo, unsigned char *st)
     }
   }
 
+  *c_reg = c;  *a_reg = a;  *ct_reg = ct;
   return sv >> 7;
 }
 
 
+/*
+ * Macros to load the C, A, and CT registers into local variables of the
+ * calling MCU decoder, decode one binary decision using them, and store them
+ * back when the MCU is done.
+ */
+
+#define LOAD_ARITH_STATE(entropy) \
+  c = (entropy)->c;  a = (entropy)->a;  ct = (entropy)->ct;
+
+#define SAVE_ARITH_STATE(entropy) \
+  (entropy)->c = c;  (entropy)->a = a;  (entropy)->ct = ct;
+
+#define DECODE(st)  arith_decode(cinfo, st, &c, &a, &ct)
+
+
 /*
  * Check for a restart marker & resynchronize decoder.
  */
@@ -236,6 +342,10 @@ process_restart (j_decompress_ptr cinfo)
  *
  * The i'th block of the MCU is stored into the block pointed to by
  * MCU_data[i].  WE ASSUME THIS AREA IS INITIALLY ZEROED BY THE CALLER.
+ *
+ * The routines work on local copies of the C, A, and CT registers and of
+ * the statistics area pointers for the current block, which are set up once
+ * per block rather than being looked up for every binary decision.
  */
 
 /*
@@ -248,9 +358,11 @@ decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr) cinfo->entropy;
   JBLOCKROW block;
-  unsigned char *st;
+  unsigned char *st, *dc_stats;
   int blkn, ci, tbl, sign;
   int v, m;
+  JLONG c, a;
+  int ct;
 
   /* Process restart marker if needed */
   if (cinfo->restart_interval) {
@@ -261,30 +373,33 @@ decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  LOAD_ARITH_STATE(entropy);
+
   /* Outer loop handles each block in the MCU */
 
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
     block = MCU_data[blkn];
     ci = cinfo->MCU_membership[blkn];
     tbl = cinfo->cur_comp_info[ci]->dc_tbl_no;
+    dc_stats = entropy->dc_stats[tbl];
 
     /* Sections F.2.4.1 & F.1.4.4.1: Decoding of DC coefficients */
 
     /* Table F.4: Point to statistics bin S0 for DC coefficient coding */
-    st = entropy->dc_stats[tbl] + entropy->dc_context[ci];
+    st = dc_stats + entropy->dc_context[ci];
 
     /* Figure F.19: Decode_DC_DIFF */
-    if (arith_decode(cinfo, st) == 0)
+    if (DECODE(st) == 0)
       entropy->dc_context[ci] = 0;
     else {
       /* Figure F.21: Decoding nonzero value v */
       /* Figure F.22: Decoding the sign of v */
-      sign = arith_decode(cinfo, st + 1);
+      sign = DECODE(st + 1);
       st += 2; st += sign;
       /* Figure F.23: Decoding the magnitude category of v */
-      if ((m = arith_decode(cinfo, st)) != 0) {
-        st = entropy->dc_stats[tbl] + 20;       /* Table F.4: X1 = 20 */
-        while (arith_decode(cinfo, st)) {
+      if ((m = DECODE(st)) != 0) {
+        st = dc_stats + 20;                     /* Table F.4: X1 = 20 */
+        while (DECODE(st)) {
           if ((m <<= 1) == 0x8000) {
             WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
             entropy->ct = -1;                   /* magnitude overflow */
@@ -304,7 +419,7 @@ decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       /* Figure F.24: Decoding the magnitude bit pattern of v */
       st += 14;
       while (m >>= 1)
-        if (arith_decode(cinfo, st)) v |= m;
+        if (DECODE(st)) v |= m;
       v += 1; if (sign) v = -v;
       entropy->last_dc_val[ci] += v;
     }
@@ -313,6 +428,8 @@ decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     (*block)[0] = (JCOEF) LEFT_SHIFT(entropy->last_dc_val[ci], cinfo->Al);
   }
 
+  SAVE_ARITH_STATE(entropy);
+
   return TRUE;
 }
 
@@ -327,9 +444,11 @@ decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr) cinfo->entropy;
   JBLOCKROW block;
-  unsigned char *st;
-  int tbl, sign, k;
+  unsigned char *st, *ac_stats, *fixed_bin;
+  int tbl, sign, k, se, ac_K;
   int v, m;
+  JLONG c, a;
+  int ct;
 
   /* Process restart marker if needed */
   if (cinfo->restart_interval) {
@@ -340,19 +459,25 @@ decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  LOAD_ARITH_STATE(entropy);
+
   /* There is always only one block per MCU */
   block = MCU_data[0];
   tbl = cinfo->cur_comp_info[0]->ac_tbl_no;
+  ac_stats = entropy->ac_stats[tbl];
+  ac_K = cinfo->arith_ac_K[tbl];
+  fixed_bin = entropy->fixed_bin;
+  se = cinfo->Se;
 
   /* Sections F.2.4.2 & F.1.4.4.2: Decoding of AC coefficients */
 
   /* Figure F.20: Decode_AC_coefficients */
-  for (k = cinfo->Ss; k <= cinfo->Se; k++) {
-    st = entropy->ac_stats[tbl] + 3 * (k - 1);
-    if (arith_decode(cinfo, st)) break;         /* EOB flag */
-    while (arith_decode(cinfo, st + 1) == 0) {
+  for (k = cinfo->Ss; k <= se; k++) {
+    st = ac_stats + 3 * (k - 1);
+    if (DECODE(st)) break;                      /* EOB flag */
+    while (DECODE(st + 1) == 0) {
       st += 3; k++;
-      if (k > cinfo->Se) {
+      if (k > se) {
         WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
         entropy->ct = -1;                       /* spectral overflow */
         return TRUE;
@@ -360,15 +485,14 @@ decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     }
     /* Figure F.21: Decoding nonzero value v */
     /* Figure F.22: Decoding the sign of v */
-    sign = arith_decode(cinfo, entropy->fixed_bin);
+    sign = DECODE(fixed_bin);
     st += 2;
     /* Figure F.23: Decoding the magnitude category of v */
-    if ((m = arith_decode(cinfo, st)) != 0) {
-      if (arith_decode(cinfo, st)) {
+    if ((m = DECODE(st)) != 0) {
+      if (DECODE(st)) {
         m <<= 1;
-        st = entropy->ac_stats[tbl] +
-             (k <= cinfo->arith_ac_K[tbl] ? 189 : 217);
-        while (arith_decode(cinfo, st)) {
+        st = ac_stats + (k <= ac_K ? 189 : 217);
+        while (DECODE(st)) {
           if ((m <<= 1) == 0x8000) {
             WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
             entropy->ct = -1;                   /* magnitude overflow */
@@ -382,12 +506,14 @@ decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     /* Figure F.24: Decoding the magnitude bit pattern of v */
     st += 14;
     while (m >>= 1)
-      if (arith_decode(cinfo, st)) v |= m;
+      if (DECODE(st)) v |= m;
     v += 1; if (sign) v = -v;
     /* Scale and output coefficient in natural (dezigzagged) order */
     (*block)[jpeg_natural_order[k]] = (JCOEF) ((unsigned)v << cinfo->Al);
   }
 
+  SAVE_ARITH_STATE(entropy);
+
   return TRUE;
 }
 
@@ -402,6 +528,8 @@ decode_mcu_DC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   arith_entropy_ptr entropy = (arith_entropy_ptr) cinfo->entropy;
   unsigned char *st;
   int p1, blkn;
+  JLONG c, a;
+  int ct;
 
   /* Process restart marker if needed */
   if (cinfo->restart_interval) {
@@ -410,6 +538,8 @@ decode_mcu_DC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     entropy->restarts_to_go--;
   }
 
+  LOAD_ARITH_STATE(entropy);
+
   st = entropy->fixed_bin;      /* use fixed probability estimation */
   p1 = 1 << cinfo->Al;          /* 1 in the bit position being coded */
 
@@ -417,10 +547,12 @@ decode_mcu_DC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
     /* Encoded data is simply the next bit of the two's-complement DC value */
-    if (arith_decode(cinfo, st))
+    if (DECODE(st))
       MCU_data[blkn][0][0] |= p1;
   }
 
+  SAVE_ARITH_STATE(entropy);
+
   return TRUE;
 }
 
@@ -435,9 +567,11 @@ decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   arith_entropy_ptr entropy = (arith_entropy_ptr) cinfo->entropy;
   JBLOCKROW block;
   JCOEFPTR thiscoef;
-  unsigned char *st;
-  int tbl, k, kex;
+  unsigned char *st, *ac_stats, *fixed_bin;
+  int tbl, k, kex, se;
   int p1, m1;
+  JLONG c, a;
+  int ct;
 
   /* Process restart marker if needed */
   if (cinfo->restart_interval) {
@@ -448,25 +582,30 @@ decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  LOAD_ARITH_STATE(entropy);
+
   /* There is always only one block per MCU */
   block = MCU_data[0];
   tbl = cinfo->cur_comp_info[0]->ac_tbl_no;
+  ac_stats = entropy->ac_stats[tbl];
+  fixed_bin = entropy->fixed_bin;
+  se = cinfo->Se;
 
   p1 = 1 << cinfo->Al;          /* 1 in the bit position being coded */
   m1 = (NEG_1) << cinfo->Al;    /* -1 in the bit position being coded */
 
   /* Establish EOBx (previous stage end-of-block) index */
-  for (kex = cinfo->Se; kex > 0; kex--)
+  for (kex = se; kex > 0; kex--)
     if ((*block)[jpeg_natural_order[kex]]) break;
 
-  for (k = cinfo->Ss; k <= cinfo->Se; k++) {
-    st = entropy->ac_stats[tbl] + 3 * (k - 1);
+  for (k = cinfo->Ss; k <= se; k++) {
+    st = ac_stats + 3 * (k - 1);
     if (k > kex)
-      if (arith_decode(cinfo, st)) break;       /* EOB flag */
+      if (DECODE(st)) break;                    /* EOB flag */
     for (;;) {
       thiscoef = *block + jpeg_natural_order[k];
       if (*thiscoef) {                          /* previously nonzero coef */
-        if (arith_decode(cinfo, st + 2)) {
+        if (DECODE(st + 2)) {
           if (*thiscoef < 0)
             *thiscoef += m1;
           else
@@ -474,15 +613,15 @@ decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
         }
         break;
       }
-      if (arith_decode(cinfo, st + 1)) {        /* newly nonzero coef */
-        if (arith_decode(cinfo, entropy->fixed_bin))
+      if (DECODE(st + 1)) {                     /* newly nonzero coef */
+        if (DECODE(fixed_bin))
           *thiscoef = m1;
         else
           *thiscoef = p1;
         break;
       }
       st += 3; k++;
-      if (k > cinfo->Se) {
+      if (k > se) {
         WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
         entropy->ct = -1;                       /* spectral overflow */
         return TRUE;
@@ -490,6 +629,8 @@ decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     }
   }
 
+  SAVE_ARITH_STATE(entropy);
+
   return TRUE;
 }
 
@@ -504,9 +645,11 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   arith_entropy_ptr entropy = (arith_entropy_ptr) cinfo->entropy;
   jpeg_component_info *compptr;
   JBLOCKROW block;
-  unsigned char *st;
-  int blkn, ci, tbl, sign, k;
+  unsigned char *st, *dc_stats, *ac_stats, *fixed_bin;
+  int blkn, ci, tbl, sign, k, ac_K;
   int v, m;
+  JLONG c, a;
+  int ct;
 
   /* Process restart marker if needed */
   if (cinfo->restart_interval) {
@@ -517,6 +660,9 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  LOAD_ARITH_STATE(entropy);
+  fixed_bin = entropy->fixed_bin;
+
   /* Outer loop handles each block in the MCU */
 
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
@@ -527,22 +673,23 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     /* Sections F.2.4.1 & F.1.4.4.1: Decoding of DC coefficients */
 
     tbl = compptr->dc_tbl_no;
+    dc_stats = entropy->dc_stats[tbl];
 
     /* Table F.4: Point to statistics bin S0 for DC coefficient coding */
-    st = entropy->dc_stats[tbl] + entropy->dc_context[ci];
+    st = dc_stats + entropy->dc_context[ci];
 
     /* Figure F.19: Decode_DC_DIFF */
-    if (arith_decode(cinfo, st) == 0)
+    if (DECODE(st) == 0)
       entropy->dc_context[ci] = 0;
     else {
       /* Figure F.21: Decoding nonzero value v */
       /* Figure F.22: Decoding the sign of v */
-      sign = arith_decode(cinfo, st + 1);
+      sign = DECODE(st + 1);
       st += 2; st += sign;
       /* Figure F.23: Decoding the magnitude category of v */
-      if ((m = arith_decode(cinfo, st)) != 0) {
-        st = entropy->dc_stats[tbl] + 20;       /* Table F.4: X1 = 20 */
-        while (arith_decode(cinfo, st)) {
+      if ((m = DECODE(st)) != 0) {
+        st = dc_stats + 20;                     /* Table F.4: X1 = 20 */
+        while (DECODE(st)) {
           if ((m <<= 1) == 0x8000) {
             WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
             entropy->ct = -1;                   /* magnitude overflow */
@@ -562,7 +709,7 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       /* Figure F.24: Decoding the magnitude bit pattern of v */
       st += 14;
       while (m >>= 1)
-        if (arith_decode(cinfo, st)) v |= m;
+        if (DECODE(st)) v |= m;
       v += 1; if (sign) v = -v;
       entropy->last_dc_val[ci] += v;
     }
@@ -573,12 +720,14 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     /* Sections F.2.4.2 & F.1.4.4.2: Decoding of AC coefficients */
 
     tbl = compptr->ac_tbl_no;
+    ac_stats = entropy->ac_stats[tbl];
+    ac_K = cinfo->arith_ac_K[tbl];
 
     /* Figure F.20: Decode_AC_coefficients */
     for (k = 1; k <= DCTSIZE2 - 1; k++) {
-      st = entropy->ac_stats[tbl] + 3 * (k - 1);
-      if (arith_decode(cinfo, st)) break;       /* EOB flag */
-      while (arith_decode(cinfo, st + 1) == 0) {
+      st = ac_stats + 3 * (k - 1);
+      if (DECODE(st)) break;                    /* EOB flag */
+      while (DECODE(st + 1) == 0) {
         st += 3; k++;
         if (k > DCTSIZE2 - 1) {
           WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
@@ -588,15 +737,14 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       }
       /* Figure F.21: Decoding nonzero value v */
       /* Figure F.22: Decoding the sign of v */
-      sign = arith_decode(cinfo, entropy->fixed_bin);
+      sign = DECODE(fixed_bin);
       st += 2;
       /* Figure F.23: Decoding the magnitude category of v */
-      if ((m = arith_decode(cinfo, st)) != 0) {
-        if (arith_decode(cinfo, st)) {
+      if ((m = DECODE(st)) != 0) {
+        if (DECODE(st)) {
           m <<= 1;
-          st = entropy->ac_stats[tbl] +
-               (k <= cinfo->arith_ac_K[tbl] ? 189 : 217);
-          while (arith_decode(cinfo, st)) {
+          st = ac_stats + (k <= ac_K ? 189 : 217);
+          while (DECODE(st)) {
             if ((m <<= 1) == 0x8000) {
               WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
               entropy->ct = -1;                 /* magnitude overflow */
@@ -610,13 +758,15 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       /* Figure F.24: Decoding the magnitude bit pattern of v */
       st += 14;
       while (m >>= 1)
-        if (arith_decode(cinfo, st)) v |= m;
+        if (DECODE(st)) v |= m;
       v += 1; if (sign) v = -v;
       if (block)
         (*block)[jpeg_natural_order[k]] = (JCOEF) v;
     }
   }
 
+  SAVE_ARITH_STATE(entropy);
+
   return TRUE;
 }
 
@@ -745,6 +895,9 @@ jinit_arith_decoder (j_decompress_ptr cinfo)
                                 sizeof(arith_entropy_decoder));
   cinfo->entropy = (struct jpeg_entropy_decoder *) entropy;
   entropy->pub.start_pass = start_pass;
+  entropy->pub.restore_checkpoint = NULL;
+  entropy->pub.save_checkpoint = NULL;
+  entropy->pub.scan_mcus = NULL;
 
   /* Mark tables unallocated */
   for (i = 0; i < NUM_ARITH_TBLS; i++) {
@@ -199,4 +199,10 @@ jpeg_mem_dest_tj (j_compress_ptr cinfo,
   if (!reused)
     dest->bufsize = *outsize;
   dest->pub.free_in_buffer = dest->bufsize;
+  /* When the buffer is grown, the old buffer is freed.  It may have been
+   * allocated by the caller or by another JPEG object, so we must not free a
+   * buffer left over from a previous image instead.
+   */
+  if (alloc)
+    dest->newbuffer = *outbuffer;
 }
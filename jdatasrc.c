@@ -37,6 +37,7 @@ typedef struct {
 typedef my_source_mgr *my_src_ptr;
 
 #define INPUT_BUF_SIZE  4096    /* choose an efficiently fread'able size */
+#define MAX_FILL_AHEAD  8192    /* largest request honored by jpeg_fill_ahead */
 
 
 /*
@@ -147,6 +148,42 @@ fill_mem_input_buffer (j_decompress_ptr cinfo)
 #endif
 
 
+/*
+ * Fill ahead --- called by the Huffman decoders when fewer than nbytes remain
+ * in the buffer, so that they can keep using their fast paths, which need that
+ * much data to be available.  This is not part of the source manager
+ * interface; it is supported only by the stdio source manager, which never
+ * suspends and can therefore read more data at any time.
+ *
+ * The unread data is moved to the front of the buffer, and the rest of the
+ * buffer is filled from the file.  Returns TRUE if at least nbytes are now
+ * available.  Reaching the end of the file is not an error here; the caller
+ * simply decodes the remaining data the slow way, and fill_input_buffer
+ * handles the end of the file when the buffer is emptied.
+ */
+
+GLOBAL(boolean)
+jpeg_fill_ahead (j_decompress_ptr cinfo, size_t nbytes)
+{
+  my_src_ptr src = (my_src_ptr) cinfo->src;
+  size_t n;
+
+  if (src == NULL || src->pub.init_source != init_source ||
+      nbytes > MAX_FILL_AHEAD || feof(src->infile))
+    return FALSE;
+
+  n = src->pub.bytes_in_buffer;
+  if (n > 0 && src->pub.next_input_byte != src->buffer)
+    MEMMOVE(src->buffer, src->pub.next_input_byte, n);
+  n += JFREAD(src->infile, src->buffer + n, INPUT_BUF_SIZE);
+
+  src->pub.next_input_byte = src->buffer;
+  src->pub.bytes_in_buffer = n;
+
+  return (n >= nbytes);
+}
+
+
 /*
  * Skip data --- used to skip over a potentially large amount of
  * uninteresting data (such as an APPn marker).
@@ -230,7 +267,8 @@ jpeg_stdio_src (j_decompress_ptr cinfo, FILE *infile)
     src = (my_src_ptr) cinfo->src;
     src->buffer = (JOCTET *)
       (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_PERMANENT,
-                                  INPUT_BUF_SIZE * sizeof(JOCTET));
+                                  (INPUT_BUF_SIZE + MAX_FILL_AHEAD) *
+                                  sizeof(JOCTET));
   } else if (cinfo->src->init_source != init_source) {
     /* It is unsafe to reuse the existing source manager unless it was created
      * by this function.  Otherwise, there is no guarantee that the opaque
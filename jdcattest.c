@@ -0,0 +1,169 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This program verifies that decompressing a progressive JPEG image to 1/8
+   scale consumes the whole image, so that the next image in a stream of
+   concatenated JPEG images (such as a Motion-JPEG stream) can be read with the
+   same decompressor.  The JPEG image specified on the command line is
+   decompressed twice from a buffer containing two copies of it.  Each
+   decompression must read exactly one copy without issuing any warnings, and
+   the two decompressed images must match. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jpeglib.h>
+#include <jerror.h>
+#include <setjmp.h>
+
+typedef struct _error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf jb;
+} error_mgr;
+
+static void my_error_exit(j_common_ptr cinfo)
+{
+  error_mgr *myerr = (error_mgr *)cinfo->err;
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(myerr->jb, 1);
+}
+
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+
+/* Decompress the next image in the source buffer to 1/8 scale.  Returns the
+   number of bytes of decompressed image data, or 0 if something went wrong.
+   The caller must free *buf. */
+static unsigned long decompress_one(j_decompress_ptr cinfo,
+                                    unsigned char **buf)
+{
+  unsigned long size, pitch;
+  JSAMPROW row;
+
+  jpeg_read_header(cinfo, TRUE);
+  if (!jpeg_has_multiple_scans(cinfo)) {
+    fprintf(stderr, "ERROR: the JPEG image is not progressive\n");
+    return 0;
+  }
+  cinfo->scale_num = 1;
+  cinfo->scale_denom = 8;
+  jpeg_start_decompress(cinfo);
+  pitch = (unsigned long)cinfo->output_width * cinfo->output_components;
+  size = pitch * cinfo->output_height;
+  if ((*buf = (unsigned char *)malloc(size)) == NULL) {
+    fprintf(stderr, "ERROR: memory allocation failure\n");
+    return 0;
+  }
+  while (cinfo->output_scanline < cinfo->output_height) {
+    row = &(*buf)[pitch * cinfo->output_scanline];
+    jpeg_read_scanlines(cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(cinfo);
+  if (cinfo->err->num_warnings != 0) {
+    fprintf(stderr, "ERROR: %ld warning(s) were issued\n",
+            cinfo->err->num_warnings);
+    return 0;
+  }
+  return size;
+}
+
+#endif
+
+int main(int argc, char **argv)
+{
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+  struct jpeg_decompress_struct cinfo;
+  error_mgr jerr;
+  FILE *file = NULL;
+  unsigned char *jpegBuf = NULL, *buf1 = NULL, *buf2 = NULL;
+  long jpegSize;
+  unsigned long size1, size2;
+  int retval = 1;
+
+  if (argc < 2) {
+    fprintf(stderr, "USAGE: %s <progressive JPEG file>\n", argv[0]);
+    return 1;
+  }
+
+  if ((file = fopen(argv[1], "rb")) == NULL || fseek(file, 0, SEEK_END) < 0 ||
+      (jpegSize = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) < 0) {
+    fprintf(stderr, "ERROR: could not read %s\n", argv[1]);
+    if (file) fclose(file);
+    return 1;
+  }
+  if ((jpegBuf = (unsigned char *)malloc(jpegSize * 2)) == NULL ||
+      fread(jpegBuf, jpegSize, 1, file) < 1) {
+    fprintf(stderr, "ERROR: could not read %s\n", argv[1]);
+    fclose(file);
+    free(jpegBuf);
+    return 1;
+  }
+  fclose(file);
+  memcpy(&jpegBuf[jpegSize], jpegBuf, jpegSize);
+
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = my_error_exit;
+  if (setjmp(jerr.jb)) {
+    /* this will execute if libjpeg has an error */
+    goto bailout;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, jpegBuf, jpegSize * 2);
+
+  if ((size1 = decompress_one(&cinfo, &buf1)) == 0)
+    goto bailout;
+  if (cinfo.src->bytes_in_buffer != (size_t)jpegSize) {
+    fprintf(stderr,
+            "ERROR: %lu bytes left after the first image (expected %ld)\n",
+            (unsigned long)cinfo.src->bytes_in_buffer, jpegSize);
+    goto bailout;
+  }
+  if ((size2 = decompress_one(&cinfo, &buf2)) == 0)
+    goto bailout;
+  if (cinfo.src->bytes_in_buffer != 0) {
+    fprintf(stderr, "ERROR: %lu bytes left after the second image\n",
+            (unsigned long)cinfo.src->bytes_in_buffer);
+    goto bailout;
+  }
+  if (size1 != size2 || memcmp(buf1, buf2, size1)) {
+    fprintf(stderr, "ERROR: the decompressed images differ\n");
+    goto bailout;
+  }
+  printf("GOOD\n");
+  retval = 0;
+
+  bailout:
+  jpeg_destroy_decompress(&cinfo);
+  free(jpegBuf);
+  free(buf1);
+  free(buf2);
+  return retval;
+#else
+  printf("In-memory source manager not supported.  Test skipped.\n");
+  return 0;
+#endif
+}
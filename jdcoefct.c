@@ -178,6 +178,139 @@ dummy_consume_data (j_decompress_ptr cinfo)
 }
 
 
+/*
+ * Pipelined operation.  The coefficients are stored in a ring buffer of
+ * cinfo->master->coef_ring_rows iMCU rows, so the input side can run ahead of
+ * the output side (typically in another thread) by up to that many rows.
+ * Consume input data and store it in the ring.  Return value is
+ * JPEG_ROW_COMPLETED, JPEG_SCAN_COMPLETED, or JPEG_SUSPENDED.
+ */
+
+METHODDEF(int)
+consume_ring (j_decompress_ptr cinfo)
+{
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+  JDIMENSION MCU_col_num;       /* index of current MCU within row */
+  JDIMENSION slot = cinfo->input_iMCU_row % cinfo->master->coef_ring_rows;
+  int blkn, ci, xindex, yindex, yoffset;
+  JDIMENSION start_col;
+  JBLOCKARRAY buffer[MAX_COMPS_IN_SCAN];
+  JBLOCKROW buffer_ptr;
+  jpeg_component_info *compptr;
+
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+    compptr = cinfo->cur_comp_info[ci];
+    buffer[ci] = cinfo->master->coef_ring[compptr->component_index] +
+                 slot * compptr->v_samp_factor;
+    /* The entropy decoder expects the buffer to be zeroed, and the ring slot
+     * still holds an earlier iMCU row.
+     */
+    if (coef->MCU_vert_offset == 0 && coef->MCU_ctr == 0) {
+      for (yindex = 0; yindex < compptr->v_samp_factor; yindex++)
+        jzero_far((void *) buffer[ci][yindex],
+                  (size_t) jround_up((long) compptr->width_in_blocks,
+                                     (long) compptr->h_samp_factor) *
+                  sizeof(JBLOCK));
+    }
+  }
+
+  /* Loop to process one whole iMCU row */
+  for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
+       yoffset++) {
+    for (MCU_col_num = coef->MCU_ctr; MCU_col_num < cinfo->MCUs_per_row;
+         MCU_col_num++) {
+      /* Construct list of pointers to DCT blocks belonging to this MCU */
+      blkn = 0;                 /* index of current DCT block within MCU */
+      for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+        compptr = cinfo->cur_comp_info[ci];
+        start_col = MCU_col_num * compptr->MCU_width;
+        for (yindex = 0; yindex < compptr->MCU_height; yindex++) {
+          buffer_ptr = buffer[ci][yindex+yoffset] + start_col;
+          for (xindex = 0; xindex < compptr->MCU_width; xindex++) {
+            coef->MCU_buffer[blkn++] = buffer_ptr++;
+          }
+        }
+      }
+      /* Try to fetch the MCU. */
+      if (! (*cinfo->entropy->decode_mcu) (cinfo, coef->MCU_buffer)) {
+        /* Suspension forced; update state counters and exit */
+        coef->MCU_vert_offset = yoffset;
+        coef->MCU_ctr = MCU_col_num;
+        return JPEG_SUSPENDED;
+      }
+    }
+    /* Completed an MCU row, but perhaps not an iMCU row */
+    coef->MCU_ctr = 0;
+  }
+  /* Completed the iMCU row, advance counters for next one */
+  if (++(cinfo->input_iMCU_row) < cinfo->total_iMCU_rows) {
+    start_iMCU_row(cinfo);
+    return JPEG_ROW_COMPLETED;
+  }
+  /* Completed the scan */
+  (*cinfo->inputctl->finish_input_pass) (cinfo);
+  return JPEG_SCAN_COMPLETED;
+}
+
+
+/*
+ * Decompress and return some data from the ring buffer.  Suspends if the next
+ * iMCU row has not yet been decoded.
+ */
+
+METHODDEF(int)
+decompress_ring (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
+{
+  JDIMENSION last_iMCU_row = cinfo->total_iMCU_rows - 1;
+  JDIMENSION slot = cinfo->output_iMCU_row % cinfo->master->coef_ring_rows;
+  JDIMENSION block_num;
+  int ci, block_row, block_rows;
+  JBLOCKARRAY buffer;
+  JBLOCKROW buffer_ptr;
+  JSAMPARRAY output_ptr;
+  JDIMENSION output_col;
+  jpeg_component_info *compptr;
+  inverse_DCT_method_ptr inverse_DCT;
+
+  if (cinfo->output_iMCU_row >= cinfo->master->coef_ring_avail)
+    return JPEG_SUSPENDED;
+
+  for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+       ci++, compptr++) {
+    /* Don't bother to IDCT an uninteresting component. */
+    if (! compptr->component_needed)
+      continue;
+    buffer = cinfo->master->coef_ring[ci] + slot * compptr->v_samp_factor;
+    /* Count non-dummy DCT block rows in this iMCU row. */
+    if (cinfo->output_iMCU_row < last_iMCU_row)
+      block_rows = compptr->v_samp_factor;
+    else {
+      block_rows = (int) (compptr->height_in_blocks % compptr->v_samp_factor);
+      if (block_rows == 0) block_rows = compptr->v_samp_factor;
+    }
+    inverse_DCT = cinfo->idct->inverse_DCT[ci];
+    output_ptr = output_buf[ci];
+    /* Loop over all DCT blocks to be processed. */
+    for (block_row = 0; block_row < block_rows; block_row++) {
+      buffer_ptr = buffer[block_row] + cinfo->master->first_MCU_col[ci];
+      output_col = 0;
+      for (block_num = cinfo->master->first_MCU_col[ci];
+           block_num <= cinfo->master->last_MCU_col[ci]; block_num++) {
+        (*inverse_DCT) (cinfo, compptr, (JCOEFPTR) buffer_ptr,
+                        output_ptr, output_col);
+        buffer_ptr++;
+        output_col += compptr->_DCT_scaled_size;
+      }
+      output_ptr += compptr->_DCT_scaled_size;
+    }
+  }
+
+  if (++(cinfo->output_iMCU_row) < cinfo->total_iMCU_rows)
+    return JPEG_ROW_COMPLETED;
+  return JPEG_SCAN_COMPLETED;
+}
+
+
 #ifdef D_MULTISCAN_FILES_SUPPORTED
 
 /*
@@ -388,10 +521,12 @@ smoothing_ok (j_decompress_ptr cinfo)
     coef_bits = cinfo->coef_bits[ci];
     if (coef_bits[0] < 0)
       return FALSE;
-    /* Block smoothing is helpful if some AC coefficients remain inaccurate. */
+    /* Block smoothing is helpful if some AC coefficients remain inaccurate
+     * (unless the component's output depends only on its DC coefficients.)
+     */
     for (coefi = 1; coefi <= 5; coefi++) {
       coef_bits_latch[coefi] = coef_bits[coefi];
-      if (coef_bits[coefi] != 0)
+      if (coef_bits[coefi] != 0 && !cinfo->master->dc_only[ci])
         smoothing_useful = TRUE;
     }
     coef_bits_latch += SAVED_COEFS;
@@ -670,6 +805,24 @@ jinit_d_coef_controller (j_decompress_ptr cinfo, boolean need_full_buffer)
 #else
     ERREXIT(cinfo, JERR_NOT_COMPILED);
 #endif
+  } else if (cinfo->master->coef_ring_rows > 0) {
+    /* Allocate the ring buffer, unless another decompressor has supplied it. */
+    int ci;
+    jpeg_component_info *compptr;
+
+    for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+         ci++, compptr++) {
+      if (cinfo->master->coef_ring[ci] == NULL)
+        cinfo->master->coef_ring[ci] = (*cinfo->mem->alloc_barray)
+          ((j_common_ptr) cinfo, JPOOL_IMAGE,
+           (JDIMENSION) jround_up((long) compptr->width_in_blocks,
+                                  (long) compptr->h_samp_factor),
+           (JDIMENSION) (compptr->v_samp_factor *
+                         cinfo->master->coef_ring_rows));
+    }
+    coef->pub.consume_data = consume_ring;
+    coef->pub.decompress_data = decompress_ring;
+    coef->pub.coef_arrays = NULL;
   } else {
     /* We only need a single-MCU buffer. */
     JBLOCKROW buffer;
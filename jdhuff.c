@@ -54,6 +54,73 @@ typedef struct {
 #endif
 
 
+/*
+ * Lookahead table for discarding AC coefficients without decoding them,
+ * indexed by the next HUFF_SKIP_LOOKAHEAD bits of the input data stream.  Each
+ * entry describes the run of complete AC codes (each followed by its value
+ * bits) at the start of those bits, which usually spans several coefficients:
+ *   bits 0-6:   number of coefficient positions covered (not counting EOB)
+ *   bit 7:      set if the run ends with EOB
+ *   bits 8-11:  total number of bits in the run
+ * An entry of 0 means that the first code is too long, so it must be decoded
+ * in the usual way.
+ */
+
+#define HUFF_SKIP_LOOKAHEAD  12
+#define SKIP_EOB             0x80
+
+typedef struct {
+  short lookup[1<<HUFF_SKIP_LOOKAHEAD];
+} d_skip_tbl;
+
+
+/*
+ * Lookahead table for decoding an AC coefficient with a single lookup,
+ * indexed by the next HUFF_FAST_AC_LOOKAHEAD bits of the input data stream.
+ * If the first code and its value bits fit within those bits, then the entry
+ * holds:
+ *   bits 0-7:   total number of bits in the code and its value bits
+ *   bits 8-11:  run length of zero coefficients preceding the coefficient
+ *   bits 16-31: the (sign-extended) value of the coefficient, or 0 for EOB
+ *               and ZRL
+ * An entry of 0 means that the code or its value bits don't fit, so the code
+ * must be decoded in the usual way.
+ */
+
+#define HUFF_FAST_AC_LOOKAHEAD  11
+
+typedef struct {
+  int lookup[1<<HUFF_FAST_AC_LOOKAHEAD];
+} d_fast_ac_tbl;
+
+
+/*
+ * The skip tables and fast AC tables take much longer to compute than the
+ * derived tables, so they are cached across scans and images in a small cache
+ * that is allocated from the permanent pool.  Most images use one of a handful
+ * of AC tables (usually the standard ones), so the cache is keyed by the
+ * contents of the Huffman table.
+ */
+
+#define HUFF_CACHE_SIZE  4
+
+typedef struct {
+  UINT8 bits[17];               /* key: copy of the Huffman table */
+  UINT8 huffval[256];
+  d_skip_tbl *skip_tbl;         /* NULL if not yet allocated */
+  boolean skip_tbl_valid;
+  d_fast_ac_tbl *fast_tbl;      /* NULL if not yet allocated */
+  boolean fast_tbl_valid;
+  boolean in_use;               /* TRUE if used by the current scan */
+} huff_cache_entry;
+
+typedef struct {
+  huff_cache_entry entries[HUFF_CACHE_SIZE];
+  int num_entries;              /* # of entries in use */
+  int next_victim;              /* entry to replace when the cache is full */
+} huff_cache;
+
+
 typedef struct {
   struct jpeg_entropy_decoder pub; /* public fields */
 
@@ -65,6 +132,7 @@ typedef struct {
 
   /* These fields are NOT loaded into local working state. */
   unsigned int restarts_to_go;  /* MCUs left in this restart interval */
+  const JOCTET *scan_start;     /* first byte of this scan's entropy data */
 
   /* Pointers to derived tables (these workspaces have image lifespan) */
   d_derived_tbl *dc_derived_tbls[NUM_HUFF_TBLS];
@@ -78,11 +146,167 @@ typedef struct {
   /* Whether we care about the DC and AC coefficient values for each block */
   boolean dc_needed[D_MAX_BLOCKS_IN_MCU];
   boolean ac_needed[D_MAX_BLOCKS_IN_MCU];
+
+  /* Skip tables for blocks whose AC coefficients we don't care about (NULL
+   * if the AC coefficients are needed) and fast AC tables for blocks whose AC
+   * coefficients we do care about (NULL otherwise.)  These point into the
+   * cache.
+   */
+  d_skip_tbl *ac_skip_cur_tbls[D_MAX_BLOCKS_IN_MCU];
+  d_fast_ac_tbl *ac_fast_cur_tbls[D_MAX_BLOCKS_IN_MCU];
+
+  /* Fast/slow path statistics, which are traced at the end of the scan */
+  JDIMENSION MCUs_left;         /* MCUs left to decode in this scan */
+  JDIMENSION fast_MCUs;         /* MCUs decoded using the fast path */
+  JDIMENSION slow_MCUs;         /* MCUs decoded using the slow path */
 } huff_entropy_decoder;
 
 typedef huff_entropy_decoder *huff_entropy_ptr;
 
 
+/*
+ * Find the cache entry for a Huffman table, creating it (and the cache) if
+ * necessary.  The tables in a new entry are marked invalid.  An entry that is
+ * already used by the current scan is never replaced, and since a scan uses at
+ * most NUM_HUFF_TBLS AC tables, there is always another entry to replace.
+ */
+
+LOCAL(huff_cache_entry *)
+get_cache_entry (j_decompress_ptr cinfo, JHUFF_TBL *htbl)
+{
+  huff_cache *cache = (huff_cache *) cinfo->master->huff_cache;
+  huff_cache_entry *entry;
+  int i, j, numsymbols = 0;
+
+  if (cache == NULL) {
+    cache = (huff_cache *)
+      (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_PERMANENT,
+                                  sizeof(huff_cache));
+    MEMZERO(cache, sizeof(huff_cache));
+    cinfo->master->huff_cache = (void *) cache;
+  }
+
+  for (i = 1; i <= 16; i++)
+    numsymbols += htbl->bits[i];
+
+  for (i = 0; i < cache->num_entries; i++) {
+    entry = &cache->entries[i];
+    for (j = 1; j <= 16; j++)
+      if (entry->bits[j] != htbl->bits[j])
+        break;
+    if (j <= 16)
+      continue;
+    for (j = 0; j < numsymbols; j++)
+      if (entry->huffval[j] != htbl->huffval[j])
+        break;
+    if (j == numsymbols) {
+      entry->in_use = TRUE;
+      return entry;
+    }
+  }
+
+  if (cache->num_entries < HUFF_CACHE_SIZE)
+    entry = &cache->entries[cache->num_entries++];
+  else {
+    do {
+      entry = &cache->entries[cache->next_victim];
+      cache->next_victim = (cache->next_victim + 1) % HUFF_CACHE_SIZE;
+    } while (entry->in_use);
+  }
+  MEMCOPY(entry->bits, htbl->bits, sizeof(entry->bits));
+  MEMCOPY(entry->huffval, htbl->huffval, sizeof(entry->huffval));
+  entry->skip_tbl_valid = entry->fast_tbl_valid = FALSE;
+  entry->in_use = TRUE;
+  return entry;
+}
+
+
+/*
+ * Compute the skip table for an AC Huffman table whose derived table has
+ * already been computed.
+ */
+
+LOCAL(void)
+make_skip_tbl (d_derived_tbl *dtbl, d_skip_tbl *stbl)
+{
+  int look, pos, npos, l, sym, r, s, span;
+  JLONG code;
+
+  for (look = 0; look < (1 << HUFF_SKIP_LOOKAHEAD); look++) {
+    stbl->lookup[look] = 0;
+    pos = 0;                    /* bits consumed so far */
+    span = 0;                   /* coefficient positions covered so far */
+    for (;;) {
+      /* Find the code starting at bit pos (Figure F.16) */
+      if (pos >= HUFF_SKIP_LOOKAHEAD)
+        break;
+      l = 1;
+      code = (look >> (HUFF_SKIP_LOOKAHEAD - pos - 1)) & 1;
+      while (code > dtbl->maxcode[l] && pos + l < HUFF_SKIP_LOOKAHEAD) {
+        l++;
+        code = (look >> (HUFF_SKIP_LOOKAHEAD - pos - l)) & ((1 << l) - 1);
+      }
+      if (code > dtbl->maxcode[l])
+        break;                  /* code doesn't fit */
+      sym = dtbl->pub->huffval[(int) (code + dtbl->valoffset[l]) & 0xFF];
+      r = sym >> 4;
+      s = sym & 15;
+      npos = pos + l + s;
+      if (npos > HUFF_SKIP_LOOKAHEAD)
+        break;                  /* value bits don't fit */
+      if (s == 0 && r != 15) {  /* EOB ends the run */
+        stbl->lookup[look] = (short) (((pos + l) << 8) | SKIP_EOB | span);
+        break;
+      }
+      if (span + (s ? r + 1 : 16) >= DCTSIZE2)
+        break;
+      span += (s ? r + 1 : 16);
+      pos = npos;
+      stbl->lookup[look] = (short) ((pos << 8) | span);
+    }
+  }
+}
+
+
+/*
+ * Compute the fast AC table for an AC Huffman table whose derived table has
+ * already been computed.
+ */
+
+LOCAL(void)
+make_fast_ac_tbl (d_derived_tbl *dtbl, d_fast_ac_tbl *ftbl)
+{
+  int look, l, sym, r, s, v;
+  JLONG code;
+
+  for (look = 0; look < (1 << HUFF_FAST_AC_LOOKAHEAD); look++) {
+    ftbl->lookup[look] = 0;
+    /* Find the code at the start of the lookahead bits (Figure F.16) */
+    l = 1;
+    code = look >> (HUFF_FAST_AC_LOOKAHEAD - 1);
+    while (code > dtbl->maxcode[l] && l < HUFF_FAST_AC_LOOKAHEAD) {
+      l++;
+      code = look >> (HUFF_FAST_AC_LOOKAHEAD - l);
+    }
+    if (code > dtbl->maxcode[l])
+      continue;                 /* code doesn't fit */
+    sym = dtbl->pub->huffval[(int) (code + dtbl->valoffset[l]) & 0xFF];
+    r = sym >> 4;
+    s = sym & 15;
+    if (l + s > HUFF_FAST_AC_LOOKAHEAD)
+      continue;                 /* value bits don't fit */
+    v = 0;
+    if (s) {
+      /* Section F.2.2.1: extend the sign of the value bits */
+      v = (look >> (HUFF_FAST_AC_LOOKAHEAD - l - s)) & ((1 << s) - 1);
+      if (v < (1 << (s - 1)))
+        v -= (1 << s) - 1;
+    }
+    ftbl->lookup[look] = v * (1 << 16) + (r << 8) + l + s;
+  }
+}
+
+
 /*
  * Initialize for a Huffman-compressed scan.
  */
@@ -91,9 +315,10 @@ METHODDEF(void)
 start_pass_huff_decoder (j_decompress_ptr cinfo)
 {
   huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
-  int ci, blkn, dctbl, actbl;
+  int ci, blkn, dctbl, actbl, i;
   d_derived_tbl **pdtbl;
   jpeg_component_info *compptr;
+  huff_cache_entry *entry;
 
   /* Check that the scan parameters Ss, Se, Ah/Al are OK for sequential JPEG.
    * This ought to be an error condition, but we make it a warning because
@@ -117,6 +342,14 @@ start_pass_huff_decoder (j_decompress_ptr cinfo)
     entropy->saved.last_dc_val[ci] = 0;
   }
 
+  /* Release the cache entries used by the previous scan */
+  if (cinfo->master->huff_cache != NULL) {
+    huff_cache *cache = (huff_cache *) cinfo->master->huff_cache;
+
+    for (i = 0; i < cache->num_entries; i++)
+      cache->entries[i].in_use = FALSE;
+  }
+
   /* Precalculate decoding info for each block in an MCU of this scan */
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
     ci = cinfo->MCU_membership[blkn];
@@ -132,6 +365,32 @@ start_pass_huff_decoder (j_decompress_ptr cinfo)
     } else {
       entropy->dc_needed[blkn] = entropy->ac_needed[blkn] = FALSE;
     }
+
+    /* Look up (or compute) the skip table or fast AC table for the block */
+    entry = get_cache_entry(cinfo, entropy->ac_cur_tbls[blkn]->pub);
+    entropy->ac_skip_cur_tbls[blkn] = NULL;
+    entropy->ac_fast_cur_tbls[blkn] = NULL;
+    if (entropy->ac_needed[blkn]) {
+      if (entry->fast_tbl == NULL)
+        entry->fast_tbl = (d_fast_ac_tbl *)
+          (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_PERMANENT,
+                                      sizeof(d_fast_ac_tbl));
+      if (! entry->fast_tbl_valid) {
+        make_fast_ac_tbl(entropy->ac_cur_tbls[blkn], entry->fast_tbl);
+        entry->fast_tbl_valid = TRUE;
+      }
+      entropy->ac_fast_cur_tbls[blkn] = entry->fast_tbl;
+    } else {
+      if (entry->skip_tbl == NULL)
+        entry->skip_tbl = (d_skip_tbl *)
+          (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_PERMANENT,
+                                      sizeof(d_skip_tbl));
+      if (! entry->skip_tbl_valid) {
+        make_skip_tbl(entropy->ac_cur_tbls[blkn], entry->skip_tbl);
+        entry->skip_tbl_valid = TRUE;
+      }
+      entropy->ac_skip_cur_tbls[blkn] = entry->skip_tbl;
+    }
   }
 
   /* Initialize bitread state variables */
@@ -141,6 +400,13 @@ start_pass_huff_decoder (j_decompress_ptr cinfo)
 
   /* Initialize restart counter */
   entropy->restarts_to_go = cinfo->restart_interval;
+
+  /* Remember where the scan data began, for restore_checkpoint() */
+  entropy->scan_start = cinfo->src->next_input_byte;
+
+  /* Initialize statistics */
+  entropy->MCUs_left = cinfo->MCUs_per_row * cinfo->MCU_rows_in_scan;
+  entropy->fast_MCUs = entropy->slow_MCUs = 0;
 }
 
 
@@ -396,50 +662,6 @@ jpeg_fill_bit_buffer (bitread_working_state *state,
 }
 
 
-/* Macro version of the above, which performs much better but does not
-   handle markers.  We have to hand off any blocks with markers to the
-   slower routines. */
-
-#define GET_BYTE \
-{ \
-  register int c0, c1; \
-  c0 = GETJOCTET(*buffer++); \
-  c1 = GETJOCTET(*buffer); \
-  /* Pre-execute most common case */ \
-  get_buffer = (get_buffer << 8) | c0; \
-  bits_left += 8; \
-  if (c0 == 0xFF) { \
-    /* Pre-execute case of FF/00, which represents an FF data byte */ \
-    buffer++; \
-    if (c1 != 0) { \
-      /* Oops, it's actually a marker indicating end of compressed data. */ \
-      cinfo->unread_marker = c1; \
-      /* Back out pre-execution and fill the buffer with zero bits */ \
-      buffer -= 2; \
-      get_buffer &= ~0xFF; \
-    } \
-  } \
-}
-
-#if SIZEOF_SIZE_T==8 || defined(_WIN64)
-
-/* Pre-fetch 48 bytes, because the holding register is 64-bit */
-#define FILL_BIT_BUFFER_FAST \
-  if (bits_left <= 16) { \
-    GET_BYTE GET_BYTE GET_BYTE GET_BYTE GET_BYTE GET_BYTE \
-  }
-
-#else
-
-/* Pre-fetch 16 bytes, because the holding register is 32-bit */
-#define FILL_BIT_BUFFER_FAST \
-  if (bits_left <= 16) { \
-    GET_BYTE GET_BYTE \
-  }
-
-#endif
-
-
 /*
  * Out-of-line code for Huffman code decoding.
  * See jdhuff.h for info about usage.
@@ -551,6 +773,38 @@ process_restart (j_decompress_ptr cinfo)
 }
 
 
+/*
+ * Resume decoding from a checkpoint previously taken in this scan.
+ * Returns FALSE, leaving the decoder state untouched, if the checkpoint does
+ * not lie within the current input buffer.
+ */
+
+METHODDEF(boolean)
+restore_checkpoint (j_decompress_ptr cinfo, const jpeg_entropy_checkpoint *ckpt)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  struct jpeg_source_mgr *src = cinfo->src;
+  size_t pos = (size_t) (src->next_input_byte - entropy->scan_start);
+  int ci;
+
+  if (ckpt->offset > pos + src->bytes_in_buffer)
+    return FALSE;
+
+  src->bytes_in_buffer = pos + src->bytes_in_buffer - ckpt->offset;
+  src->next_input_byte = entropy->scan_start + ckpt->offset;
+  entropy->bitstate.get_buffer = (bit_buf_type) ckpt->get_buffer;
+  entropy->bitstate.bits_left = ckpt->bits_left;
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+    entropy->saved.last_dc_val[ci] = ckpt->last_dc_val[ci];
+  entropy->restarts_to_go = ckpt->restarts_to_go;
+  entropy->pub.insufficient_data = FALSE;
+  cinfo->unread_marker = ckpt->unread_marker;
+  cinfo->marker->next_restart_num = ckpt->next_restart_num;
+
+  return TRUE;
+}
+
+
 LOCAL(boolean)
 decode_mcu_slow (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
@@ -671,7 +925,7 @@ decode_mcu_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
     HUFF_DECODE_FAST(s, l, dctbl);
     if (s) {
-      FILL_BIT_BUFFER_FAST
+      FILL_BIT_BUFFER_VALUE
       r = GET_BITS(s);
       s = HUFF_EXTEND(r, s);
     }
@@ -685,17 +939,31 @@ decode_mcu_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     }
 
     if (entropy->ac_needed[blkn] && block) {
+      d_fast_ac_tbl *fasttbl = entropy->ac_fast_cur_tbls[blkn];
 
       for (k = 1; k < DCTSIZE2; k++) {
-        HUFF_DECODE_FAST(s, l, actbl);
-        r = s >> 4;
-        s &= 15;
+        /* Decode the code and its value bits with a single lookup, if they
+         * fit in the fast AC table.  Otherwise, decode them in the usual way.
+         */
+        FILL_BIT_BUFFER_FAST
+        s = fasttbl->lookup[PEEK_BITS(HUFF_FAST_AC_LOOKAHEAD)];
+        if (s) {
+          DROP_BITS(s & 0xFF);
+          r = (s >> 8) & 15;
+          s >>= 16;
+        } else {
+          HUFF_DECODE_FAST(s, l, actbl);
+          r = s >> 4;
+          s &= 15;
+          if (s) {
+            FILL_BIT_BUFFER_VALUE
+            l = GET_BITS(s);
+            s = HUFF_EXTEND(l, s);
+          }
+        }
 
         if (s) {
           k += r;
-          FILL_BIT_BUFFER_FAST
-          r = GET_BITS(s);
-          s = HUFF_EXTEND(r, s);
           (*block)[jpeg_natural_order[k]] = (JCOEF) s;
         } else {
           if (r != 15) break;
@@ -703,6 +971,43 @@ decode_mcu_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
         }
       }
 
+    } else if (entropy->ac_skip_cur_tbls[blkn]) {
+      d_skip_tbl *skiptbl = entropy->ac_skip_cur_tbls[blkn];
+
+      /* Discard the AC coefficients, using the skip table to pass over runs of
+       * short codes.  A run can be used only if it ends within this block;
+       * otherwise (or if the next code is too long for the table), we decode
+       * one code in the usual way.
+       */
+      for (k = 1; k < DCTSIZE2; ) {
+        FILL_BIT_BUFFER_FAST
+        s = skiptbl->lookup[PEEK_BITS(HUFF_SKIP_LOOKAHEAD)];
+        r = s & 0x7F;
+        if (s & SKIP_EOB) {
+          if (k + r < DCTSIZE2) {
+            DROP_BITS(s >> 8);
+            break;
+          }
+        } else if (s && k + r <= DCTSIZE2) {
+          DROP_BITS(s >> 8);
+          k += r;
+          continue;
+        }
+
+        HUFF_DECODE_FAST(s, l, actbl);
+        r = s >> 4;
+        s &= 15;
+
+        if (s) {
+          k += r + 1;
+          FILL_BIT_BUFFER_VALUE
+          DROP_BITS(s);
+        } else {
+          if (r != 15) break;
+          k += 16;
+        }
+      }
+
     } else {
 
       for (k = 1; k < DCTSIZE2; k++) {
@@ -712,7 +1017,7 @@ decode_mcu_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
         if (s) {
           k += r;
-          FILL_BIT_BUFFER_FAST
+          FILL_BIT_BUFFER_VALUE
           DROP_BITS(s);
         } else {
           if (r != 15) break;
@@ -750,8 +1055,6 @@ decode_mcu_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
  * this module, since we'll just re-assign them on the next call.)
  */
 
-#define BUFSIZE (DCTSIZE2 * 8)
-
 METHODDEF(boolean)
 decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
@@ -766,9 +1069,15 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     usefast = 0;
   }
 
-  if (cinfo->src->bytes_in_buffer < BUFSIZE * (size_t)cinfo->blocks_in_MCU
-    || cinfo->unread_marker != 0)
+  /* The fast path needs BUFSIZE bytes per block.  If fewer remain in the
+   * input buffer, ask the source manager to read ahead so that the fast path
+   * can keep running across buffer boundaries.
+   */
+  if (cinfo->unread_marker != 0)
     usefast = 0;
+  else if (usefast &&
+           cinfo->src->bytes_in_buffer < BUFSIZE * (size_t)cinfo->blocks_in_MCU)
+    usefast = jpeg_fill_ahead(cinfo, BUFSIZE * (size_t)cinfo->blocks_in_MCU);
 
   /* If we've run out of data, just leave the MCU set to zeroes.
    * This way, we return uniform gray for the remainder of the segment.
@@ -777,10 +1086,12 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
     if (usefast) {
       if (!decode_mcu_fast(cinfo, MCU_data)) goto use_slow;
+      entropy->fast_MCUs++;
     }
     else {
       use_slow:
       if (!decode_mcu_slow(cinfo, MCU_data)) return FALSE;
+      entropy->slow_MCUs++;
     }
 
   }
@@ -788,10 +1099,207 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   /* Account for restart interval (no-op if not using restarts) */
   entropy->restarts_to_go--;
 
+  if (--entropy->MCUs_left == 0)
+    TRACEMS2(cinfo, 1, JTRC_HUFF_PATHS, entropy->fast_MCUs,
+             entropy->slow_MCUs);
+
+  return TRUE;
+}
+
+
+/*
+ * Speculative scanning.  The routines below decode the Huffman codes of a
+ * sequential scan without producing any coefficients, recording where each
+ * MCU begins.  The caller may start scanning from a guessed position (using
+ * restore_checkpoint()), in which case the decoder will initially be out of
+ * step with the real MCU boundaries.  Huffman codes tend to resynchronize
+ * quickly, and once the recorded position of an MCU matches a position
+ * recorded by a scan that started from a known MCU boundary, both scans will
+ * agree from that point onward.  Because the input may be garbage until then,
+ * no warnings are issued, and an invalid code causes the scan to start over
+ * at the next byte.
+ */
+
+/* Decode a Huffman code without issuing a warning.  At least 16 bits must be
+ * in the bit buffer.
+ */
+
+#define SCAN_DECODE(result,htbl,failaction) \
+{ register int nb, look; \
+  look = PEEK_BITS(HUFF_LOOKAHEAD); \
+  if ((nb = (htbl->lookup[look] >> HUFF_LOOKAHEAD)) <= HUFF_LOOKAHEAD) { \
+    DROP_BITS(nb); \
+    result = htbl->lookup[look] & ((1 << HUFF_LOOKAHEAD) - 1); \
+  } else { \
+    register JLONG code = GET_BITS(nb); \
+    while (code > htbl->maxcode[nb]) { \
+      if (++nb > 16) { failaction; } \
+      code = (code << 1) | GET_BITS(1); \
+    } \
+    result = htbl->pub->huffval[ (int) (code + htbl->valoffset[nb]) & 0xFF ]; \
+  } \
+}
+
+
+/*
+ * Return the position of the next unread bit, in bits from the start of the
+ * scan data.  The bit buffer may contain several bytes, some of which may have
+ * been followed by stuffed zero bytes, so we back up over the buffered bytes to
+ * find the one that contains the next bit.
+ */
+
+LOCAL(size_t)
+scan_position (huff_entropy_ptr entropy, const JOCTET *next_input_byte,
+               int bits_left)
+{
+  const JOCTET *ptr = next_input_byte;
+  int nbytes = (bits_left + 7) >> 3;
+
+  while (nbytes-- > 0) {
+    ptr--;
+    if (*ptr == 0 && ptr > entropy->scan_start && ptr[-1] == 0xFF)
+      ptr--;
+  }
+  return (size_t) (ptr - entropy->scan_start) * 8 + ((8 - (bits_left & 7)) & 7);
+}
+
+
+/*
+ * Take a checkpoint at the current MCU boundary.  The checkpoint is normalized
+ * so that the bit buffer holds only the unused bits of the last byte read,
+ * which makes it independent of how far ahead the bit buffer has been filled
+ * (and of the size of the bit buffer.)  Returns FALSE if the decoder has
+ * already read the marker that terminates the entropy-coded data, in which
+ * case the bit buffer contains padding rather than data.
+ */
+
+METHODDEF(boolean)
+save_checkpoint (j_decompress_ptr cinfo, jpeg_entropy_checkpoint *ckpt)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  size_t pos;
+  int ci;
+
+  if (cinfo->unread_marker != 0 || entropy->pub.insufficient_data)
+    return FALSE;
+
+  pos = scan_position(entropy, cinfo->src->next_input_byte,
+                      entropy->bitstate.bits_left);
+  MEMZERO(ckpt, sizeof(jpeg_entropy_checkpoint));
+  ckpt->offset = pos / 8;
+  if (pos % 8) {
+    ckpt->get_buffer = entropy->scan_start[ckpt->offset];
+    ckpt->bits_left = 8 - (int) (pos % 8);
+    ckpt->offset += (entropy->scan_start[ckpt->offset] == 0xFF ? 2 : 1);
+  }
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+    ckpt->last_dc_val[ci] = entropy->saved.last_dc_val[ci];
+  ckpt->restarts_to_go = entropy->restarts_to_go;
+  ckpt->next_restart_num = cinfo->marker->next_restart_num;
+
   return TRUE;
 }
 
 
+/*
+ * Scan up to max_MCUs MCUs, stopping before any MCU that begins at or beyond
+ * end_pos.  The starting position of each MCU is stored in bit_pos[], and the
+ * DC predictions at that point (for each component in the scan) are stored in
+ * dc_val[].  Returns the number of MCUs scanned.  This is less than max_MCUs
+ * if end_pos or a marker was reached.
+ */
+
+METHODDEF(JDIMENSION)
+scan_mcus (j_decompress_ptr cinfo, size_t end_pos, size_t *bit_pos,
+           int *dc_val, JDIMENSION max_MCUs)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  BITREAD_STATE_VARS;
+  savable_state state;
+  const JOCTET *next_byte;
+  JDIMENSION n = 0;
+  int blkn, ci;
+  size_t pos;
+
+  /* Running into the end of the scan is expected, so don't warn about it */
+  entropy->pub.insufficient_data = TRUE;
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+  ASSIGN_STATE(state, entropy->saved);
+
+  while (n < max_MCUs && cinfo->unread_marker == 0) {
+    pos = scan_position(entropy, br_state.next_input_byte, bits_left);
+    if (pos >= end_pos)
+      break;
+    bit_pos[n] = pos;
+    for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+      dc_val[n * cinfo->comps_in_scan + ci] = state.last_dc_val[ci];
+
+    for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+      d_derived_tbl *dctbl = entropy->dc_cur_tbls[blkn];
+      d_derived_tbl *actbl = entropy->ac_cur_tbls[blkn];
+      register int s, k, r;
+
+      /* DC coefficient difference */
+      CHECK_BIT_BUFFER(br_state, 16, goto done);
+      SCAN_DECODE(s, dctbl, goto resync);
+      if (s) {
+        if (s > 15)
+          goto resync;
+        CHECK_BIT_BUFFER(br_state, s, goto done);
+        r = GET_BITS(s);
+        s = HUFF_EXTEND(r, s);
+      }
+      ci = cinfo->MCU_membership[blkn];
+      state.last_dc_val[ci] =
+        (int) ((unsigned int) state.last_dc_val[ci] + (unsigned int) s);
+
+      /* AC coefficients */
+      for (k = 1; k < DCTSIZE2; k++) {
+        CHECK_BIT_BUFFER(br_state, 16, goto done);
+        SCAN_DECODE(s, actbl, goto resync);
+        r = s >> 4;
+        s &= 15;
+        if (s) {
+          k += r;
+          CHECK_BIT_BUFFER(br_state, s, goto done);
+          DROP_BITS(s);
+        } else {
+          if (r != 15)
+            break;
+          k += 15;
+        }
+      }
+      /* A run past the end of the block means that we are out of step */
+      if (k > DCTSIZE2)
+        goto resync;
+    }
+    n++;
+    continue;
+
+resync:
+    /* Start over at the byte following the start of the rejected MCU */
+    next_byte = entropy->scan_start + pos / 8 + 1;
+    if (next_byte[-1] == 0xFF)
+      next_byte++;
+    if (cinfo->unread_marker != 0 || next_byte > br_state.next_input_byte)
+      break;
+    br_state.bytes_in_buffer += br_state.next_input_byte - next_byte;
+    br_state.next_input_byte = next_byte;
+    bits_left = 0;
+    for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+      state.last_dc_val[ci] = 0;
+  }
+
+done:
+  /* Save the state so that another call can continue scanning */
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  ASSIGN_STATE(entropy->saved, state);
+  return n;
+}
+
+
 /*
  * Module initialization routine for Huffman entropy decoding.
  */
@@ -814,6 +1322,9 @@ jinit_huff_decoder (j_decompress_ptr cinfo)
   cinfo->entropy = (struct jpeg_entropy_decoder *) entropy;
   entropy->pub.start_pass = start_pass_huff_decoder;
   entropy->pub.decode_mcu = decode_mcu;
+  entropy->pub.restore_checkpoint = restore_checkpoint;
+  entropy->pub.save_checkpoint = save_checkpoint;
+  entropy->pub.scan_mcus = scan_mcus;
 
   /* Mark tables unallocated */
   for (i = 0; i < NUM_HUFF_TBLS; i++) {
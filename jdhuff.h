@@ -169,6 +169,112 @@ EXTERN(boolean) jpeg_fill_bit_buffer
         (bitread_working_state *state, register bit_buf_type get_buffer,
          register int bits_left, int nbits);
 
+/* Macro version of jpeg_fill_bit_buffer(), which performs much better but
+   does not handle markers.  We have to hand off any blocks with markers to the
+   slower routines.  The macros expect a local variable (buffer) that points to
+   the next input byte.  The caller must ensure that at least BUFSIZE bytes per
+   block remain in the source buffer, so that the macros cannot read past the
+   end of it. */
+
+#define BUFSIZE (DCTSIZE2 * 8)
+
+
+#define GET_BYTE \
+{ \
+  register int c0, c1; \
+  c0 = GETJOCTET(*buffer++); \
+  c1 = GETJOCTET(*buffer); \
+  /* Pre-execute most common case */ \
+  get_buffer = (get_buffer << 8) | c0; \
+  bits_left += 8; \
+  if (c0 == 0xFF) { \
+    /* Pre-execute case of FF/00, which represents an FF data byte */ \
+    buffer++; \
+    if (c1 != 0) { \
+      /* Oops, it's actually a marker indicating end of compressed data. */ \
+      cinfo->unread_marker = c1; \
+      /* Back out pre-execution and fill the buffer with zero bits */ \
+      buffer -= 2; \
+      get_buffer &= ~0xFF; \
+    } \
+  } \
+}
+
+#if SIZEOF_SIZE_T==8 || defined(_WIN64)
+
+/* On 64-bit platforms with a byte-swap intrinsic, the buffer is refilled
+   4 bytes at a time using a single unaligned load, and the 4 bytes are tested
+   for 0xFF all at once.  Only if one of them is 0xFF (a stuffed byte or a
+   marker) do we fall back to fetching the bytes one at a time.  Because the
+   buffer is refilled whenever it holds 32 or fewer bits, it always holds at
+   least 32 bits afterward, which is enough for a Huffman code (at most 17 bits,
+   counting the extra bit consumed by an invalid code) and the value bits that
+   follow it (at most 15 bits.)  Thus, the value bits can be fetched without
+   checking the buffer again.  LOAD_BYTES() returns the next 8 bytes of the
+   input, with the first byte in the most significant position. */
+
+#if defined __GNUC__ && defined __BYTE_ORDER__
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LOAD_BYTES(ptr, bytes) \
+  { MEMCOPY(&bytes, ptr, 8);  bytes = __builtin_bswap64(bytes); }
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LOAD_BYTES(ptr, bytes)  MEMCOPY(&bytes, ptr, 8)
+#endif
+#elif defined _MSC_VER && (defined _M_X64 || defined _M_ARM64)
+#define LOAD_BYTES(ptr, bytes) \
+  { MEMCOPY(&bytes, ptr, 8);  bytes = _byteswap_uint64(bytes); }
+#endif
+
+#ifdef LOAD_BYTES
+
+/* Nonzero if any of the 4 low-order bytes of x is 0xFF.  Adding 1 to the low
+   7 bits of a byte carries into bit 7 only if those bits are all set, and
+   bit 7 of x is then set only if the byte is 0xFF.  No carry can propagate
+   into the next byte. */
+#define HAS_FF_BYTE(x) \
+  ((((x) & 0x7F7F7F7F) + 0x01010101) & (x) & 0x80808080)
+
+#define FILL_BIT_BUFFER_FAST \
+  if (bits_left <= 32) { \
+    bit_buf_type bytes; \
+    LOAD_BYTES(buffer, bytes); \
+    bytes >>= 32; \
+    if (!HAS_FF_BYTE(bytes)) { \
+      get_buffer = (get_buffer << 32) | bytes; \
+      bits_left += 32; \
+      buffer += 4; \
+    } else { \
+      GET_BYTE GET_BYTE GET_BYTE GET_BYTE \
+    } \
+  }
+
+#define FILL_BIT_BUFFER_VALUE
+
+#else
+
+/* Pre-fetch 48 bytes, because the holding register is 64-bit */
+#define FILL_BIT_BUFFER_FAST \
+  if (bits_left <= 16) { \
+    GET_BYTE GET_BYTE GET_BYTE GET_BYTE GET_BYTE GET_BYTE \
+  }
+
+#endif
+
+#else
+
+/* Pre-fetch 16 bytes, because the holding register is 32-bit */
+#define FILL_BIT_BUFFER_FAST \
+  if (bits_left <= 16) { \
+    GET_BYTE GET_BYTE \
+  }
+
+#endif
+
+/* Ensure that the value bits following a Huffman code are in the buffer */
+#ifndef FILL_BIT_BUFFER_VALUE
+#define FILL_BIT_BUFFER_VALUE  FILL_BIT_BUFFER_FAST
+#endif
+
 
 /*
  * Code for extracting next Huffman-coded symbol from input bit stream.
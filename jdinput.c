@@ -99,6 +99,7 @@ initial_setup (j_decompress_ptr cinfo)
 #else
     compptr->DCT_scaled_size = DCTSIZE;
 #endif
+    cinfo->master->dc_only[ci] = FALSE;
     /* Size in DCT blocks */
     compptr->width_in_blocks = (JDIMENSION)
       jdiv_round_up((long) cinfo->image_width * (long) compptr->h_samp_factor,
@@ -308,6 +309,27 @@ finish_input_pass (j_decompress_ptr cinfo)
  * we are reading a compressed data segment or inter-segment markers.
  */
 
+LOCAL(boolean)
+dc_only_complete (j_decompress_ptr cinfo)
+/* Do the remaining scans of a progressive image have no effect on the output?
+ * That is the case if every component is DC-only and its DC coefficients have
+ * been fully refined.  (Checked only if the application has asked us to stop
+ * reading at that point.)
+ */
+{
+  int ci;
+
+  if (!cinfo->master->dc_only_stop || !cinfo->progressive_mode ||
+      cinfo->coef_bits == NULL)
+    return FALSE;
+  for (ci = 0; ci < cinfo->num_components; ci++) {
+    if (!cinfo->master->dc_only[ci] || cinfo->coef_bits[ci][0] != 0)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
 METHODDEF(int)
 consume_markers (j_decompress_ptr cinfo)
 {
@@ -317,6 +339,15 @@ consume_markers (j_decompress_ptr cinfo)
   if (inputctl->pub.eoi_reached) /* After hitting EOI, read no further */
     return JPEG_REACHED_EOI;
 
+  /* If requested, stop reading a progressive image once the remaining scans
+   * cannot affect the output, and treat the image as though EOI had been
+   * reached.  Otherwise, those scans are skipped by the entropy decoder.
+   */
+  if (!inputctl->inheaders && dc_only_complete(cinfo)) {
+    inputctl->pub.eoi_reached = TRUE;
+    return JPEG_REACHED_EOI;
+  }
+
   val = (*cinfo->marker->read_markers) (cinfo);
 
   switch (val) {
@@ -463,6 +463,8 @@ master_selection (j_decompress_ptr cinfo)
   boolean use_c_buffer;
   long samplesperrow;
   JDIMENSION jd_samplesperrow;
+  int ci;
+  jpeg_component_info *compptr;
 
   /* Initialize dimensions and other stuff */
   jpeg_calc_output_dimensions(cinfo);
@@ -478,6 +480,14 @@ master_selection (j_decompress_ptr cinfo)
   master->pass_number = 0;
   master->using_merged_upsample = use_merged_upsample(cinfo);
 
+  /* The 1x1 inverse DCT uses only the DC coefficient.  (In buffered-image
+   * mode, the application may change the scaling between output passes.)
+   */
+  for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+       ci++, compptr++)
+    master->pub.dc_only[ci] = (!cinfo->buffered_image &&
+                               compptr->_DCT_scaled_size == 1);
+
   /* Color quantizer selection */
   master->quantizer_1pass = NULL;
   master->quantizer_2pass = NULL;
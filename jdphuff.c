@@ -72,6 +72,15 @@ typedef struct {
   d_derived_tbl *derived_tbls[NUM_HUFF_TBLS];
 
   d_derived_tbl *ac_derived_tbl; /* active table during an AC scan */
+
+  /* State for skipping a scan that cannot affect the output */
+  boolean scan_skipped;         /* TRUE once the scan data has been skipped */
+  boolean skip_saw_FF;          /* TRUE if the last byte skipped was 0xFF */
+
+  /* Fast/slow path statistics, which are traced at the end of the scan */
+  JDIMENSION MCUs_left;         /* MCUs left to decode in this scan */
+  JDIMENSION fast_MCUs;         /* MCUs decoded using the fast path */
+  JDIMENSION slow_MCUs;         /* MCUs decoded using the slow path */
 } phuff_entropy_decoder;
 
 typedef phuff_entropy_decoder *phuff_entropy_ptr;
@@ -85,6 +94,8 @@ METHODDEF(boolean) decode_mcu_DC_refine (j_decompress_ptr cinfo,
                                          JBLOCKROW *MCU_data);
 METHODDEF(boolean) decode_mcu_AC_refine (j_decompress_ptr cinfo,
                                          JBLOCKROW *MCU_data);
+METHODDEF(boolean) decode_mcu_skip (j_decompress_ptr cinfo,
+                                    JBLOCKROW *MCU_data);
 
 
 /*
@@ -162,6 +173,16 @@ start_pass_phuff_decoder (j_decompress_ptr cinfo)
       entropy->pub.decode_mcu = decode_mcu_AC_refine;
   }
 
+  /* An AC scan for a component whose output depends only on its DC
+   * coefficients can be skipped without decoding it.
+   */
+  if (!is_DC_band &&
+      cinfo->master->dc_only[cinfo->cur_comp_info[0]->component_index]) {
+    entropy->pub.decode_mcu = decode_mcu_skip;
+    entropy->scan_skipped = FALSE;
+    entropy->skip_saw_FF = FALSE;
+  }
+
   for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
     compptr = cinfo->cur_comp_info[ci];
     /* Make sure requested tables are present, and compute derived tables.
@@ -194,6 +215,10 @@ start_pass_phuff_decoder (j_decompress_ptr cinfo)
 
   /* Initialize restart counter */
   entropy->restarts_to_go = cinfo->restart_interval;
+
+  /* Initialize statistics */
+  entropy->MCUs_left = cinfo->MCUs_per_row * cinfo->MCU_rows_in_scan;
+  entropy->fast_MCUs = entropy->slow_MCUs = 0;
 }
 
 
@@ -281,15 +306,43 @@ process_restart (j_decompress_ptr cinfo)
  * coefficients may already have been assigned.  This is harmless for
  * spectral selection, since we'll just re-assign them on the next call.
  * Successive approximation AC refinement has to be more careful, however.)
+ *
+ * As in jdhuff.c, the DC first, AC first, and AC refinement scans each have a
+ * fast routine, which uses the macro versions of the bit buffer and Huffman
+ * decoding code, and a slow routine, which handles markers and suspension.
+ * The fast routine is used whenever enough data remains in the source buffer
+ * to decode the MCU without refilling it.  If it runs into a marker, it
+ * returns FALSE without updating the permanent state, and the MCU is decoded
+ * again using the slow routine.
  */
 
+
+/*
+ * Determine whether the fast routines can be used to decode the next MCU.
+ */
+
+LOCAL(boolean)
+use_fast_path (j_decompress_ptr cinfo)
+{
+  size_t nbytes = BUFSIZE * (size_t)cinfo->blocks_in_MCU;
+
+  if (cinfo->restart_interval || cinfo->unread_marker != 0)
+    return FALSE;
+
+  /* Ask the source manager to read ahead if too little data remains */
+  if (cinfo->src->bytes_in_buffer < nbytes)
+    return jpeg_fill_ahead(cinfo, nbytes);
+
+  return TRUE;
+}
+
 /*
  * MCU decoding for DC initial scan (either spectral selection,
  * or first pass of successive approximation).
  */
 
-METHODDEF(boolean)
-decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+LOCAL(boolean)
+decode_mcu_DC_first_slow (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
   int Al = cinfo->Al;
@@ -301,6 +354,100 @@ decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   d_derived_tbl *tbl;
   jpeg_component_info *compptr;
 
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+  ASSIGN_STATE(state, entropy->saved);
+
+  /* Outer loop handles each block in the MCU */
+
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+    block = MCU_data[blkn];
+    ci = cinfo->MCU_membership[blkn];
+    compptr = cinfo->cur_comp_info[ci];
+    tbl = entropy->derived_tbls[compptr->dc_tbl_no];
+
+    /* Decode a single block's worth of coefficients */
+
+    /* Section F.2.2.1: decode the DC coefficient difference */
+    HUFF_DECODE(s, br_state, tbl, return FALSE, label1);
+    if (s) {
+      CHECK_BIT_BUFFER(br_state, s, return FALSE);
+      r = GET_BITS(s);
+      s = HUFF_EXTEND(r, s);
+    }
+
+    /* Convert DC difference to actual value, update last_dc_val */
+    s += state.last_dc_val[ci];
+    state.last_dc_val[ci] = s;
+    /* Scale and output the coefficient (assumes jpeg_natural_order[0]=0) */
+    (*block)[0] = (JCOEF) LEFT_SHIFT(s, Al);
+  }
+
+  /* Completed MCU, so update state */
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  ASSIGN_STATE(entropy->saved, state);
+
+  return TRUE;
+}
+
+
+LOCAL(boolean)
+decode_mcu_DC_first_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+  int Al = cinfo->Al;
+  register int s, r, l;
+  int blkn, ci;
+  JBLOCKROW block;
+  BITREAD_STATE_VARS;
+  JOCTET *buffer;
+  savable_state state;
+  d_derived_tbl *tbl;
+  jpeg_component_info *compptr;
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+  buffer = (JOCTET *) br_state.next_input_byte;
+  ASSIGN_STATE(state, entropy->saved);
+
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+    block = MCU_data[blkn];
+    ci = cinfo->MCU_membership[blkn];
+    compptr = cinfo->cur_comp_info[ci];
+    tbl = entropy->derived_tbls[compptr->dc_tbl_no];
+
+    HUFF_DECODE_FAST(s, l, tbl);
+    if (s) {
+      FILL_BIT_BUFFER_VALUE
+      r = GET_BITS(s);
+      s = HUFF_EXTEND(r, s);
+    }
+
+    s += state.last_dc_val[ci];
+    state.last_dc_val[ci] = s;
+    (*block)[0] = (JCOEF) LEFT_SHIFT(s, Al);
+  }
+
+  if (cinfo->unread_marker != 0) {
+    cinfo->unread_marker = 0;
+    return FALSE;
+  }
+
+  /* Completed MCU, so update state */
+  br_state.bytes_in_buffer -= (buffer - br_state.next_input_byte);
+  br_state.next_input_byte = buffer;
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  ASSIGN_STATE(entropy->saved, state);
+
+  return TRUE;
+}
+
+
+METHODDEF(boolean)
+decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+
   /* Process restart marker if needed; may have to suspend */
   if (cinfo->restart_interval) {
     if (entropy->restarts_to_go == 0)
@@ -313,64 +460,154 @@ decode_mcu_DC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
    */
   if (! entropy->pub.insufficient_data) {
 
-    /* Load up working state */
-    BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
-    ASSIGN_STATE(state, entropy->saved);
-
-    /* Outer loop handles each block in the MCU */
-
-    for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
-      block = MCU_data[blkn];
-      ci = cinfo->MCU_membership[blkn];
-      compptr = cinfo->cur_comp_info[ci];
-      tbl = entropy->derived_tbls[compptr->dc_tbl_no];
-
-      /* Decode a single block's worth of coefficients */
-
-      /* Section F.2.2.1: decode the DC coefficient difference */
-      HUFF_DECODE(s, br_state, tbl, return FALSE, label1);
-      if (s) {
-        CHECK_BIT_BUFFER(br_state, s, return FALSE);
-        r = GET_BITS(s);
-        s = HUFF_EXTEND(r, s);
-      }
-
-      /* Convert DC difference to actual value, update last_dc_val */
-      s += state.last_dc_val[ci];
-      state.last_dc_val[ci] = s;
-      /* Scale and output the coefficient (assumes jpeg_natural_order[0]=0) */
-      (*block)[0] = (JCOEF) LEFT_SHIFT(s, Al);
+    if (use_fast_path(cinfo)) {
+      if (! decode_mcu_DC_first_fast(cinfo, MCU_data)) goto use_slow;
+      entropy->fast_MCUs++;
+    }
+    else {
+      use_slow:
+      if (! decode_mcu_DC_first_slow(cinfo, MCU_data)) return FALSE;
+      entropy->slow_MCUs++;
     }
 
-    /* Completed MCU, so update state */
-    BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
-    ASSIGN_STATE(entropy->saved, state);
   }
 
   /* Account for restart interval (no-op if not using restarts) */
   entropy->restarts_to_go--;
 
+  if (--entropy->MCUs_left == 0)
+    TRACEMS2(cinfo, 1, JTRC_HUFF_PATHS, entropy->fast_MCUs,
+             entropy->slow_MCUs);
+
   return TRUE;
 }
 
 
 /*
  * MCU decoding for AC initial scan (either spectral selection,
- * or first pass of successive approximation).
+ * or first pass of successive approximation).  The slow and fast routines
+ * are called only when the current block is not part of an EOB run.
  */
 
-METHODDEF(boolean)
-decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+LOCAL(boolean)
+decode_mcu_AC_first_slow (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
   int Se = cinfo->Se;
   int Al = cinfo->Al;
   register int s, k, r;
-  unsigned int EOBRUN;
+  unsigned int EOBRUN = 0;
   JBLOCKROW block;
   BITREAD_STATE_VARS;
   d_derived_tbl *tbl;
 
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+
+  /* There is always only one block per MCU */
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
+
+  for (k = cinfo->Ss; k <= Se; k++) {
+    HUFF_DECODE(s, br_state, tbl, return FALSE, label2);
+    r = s >> 4;
+    s &= 15;
+    if (s) {
+      k += r;
+      CHECK_BIT_BUFFER(br_state, s, return FALSE);
+      r = GET_BITS(s);
+      s = HUFF_EXTEND(r, s);
+      /* Scale and output coefficient in natural (dezigzagged) order */
+      (*block)[jpeg_natural_order[k]] = (JCOEF) LEFT_SHIFT(s, Al);
+    } else {
+      if (r == 15) {            /* ZRL */
+        k += 15;                /* skip 15 zeroes in band */
+      } else {                  /* EOBr, run length is 2^r + appended bits */
+        EOBRUN = 1 << r;
+        if (r) {                /* EOBr, r > 0 */
+          CHECK_BIT_BUFFER(br_state, r, return FALSE);
+          r = GET_BITS(r);
+          EOBRUN += r;
+        }
+        EOBRUN--;               /* this band is processed at this moment */
+        break;                  /* force end-of-band */
+      }
+    }
+  }
+
+  /* Completed MCU, so update state */
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN;       /* only part of saved state we need */
+
+  return TRUE;
+}
+
+
+LOCAL(boolean)
+decode_mcu_AC_first_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+  int Se = cinfo->Se;
+  int Al = cinfo->Al;
+  register int s, k, r, l;
+  unsigned int EOBRUN = 0;
+  JBLOCKROW block;
+  BITREAD_STATE_VARS;
+  JOCTET *buffer;
+  d_derived_tbl *tbl;
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+  buffer = (JOCTET *) br_state.next_input_byte;
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
+
+  for (k = cinfo->Ss; k <= Se; k++) {
+    HUFF_DECODE_FAST(s, l, tbl);
+    r = s >> 4;
+    s &= 15;
+    if (s) {
+      k += r;
+      FILL_BIT_BUFFER_VALUE
+      r = GET_BITS(s);
+      s = HUFF_EXTEND(r, s);
+      (*block)[jpeg_natural_order[k]] = (JCOEF) LEFT_SHIFT(s, Al);
+    } else {
+      if (r == 15) {
+        k += 15;
+      } else {
+        EOBRUN = 1 << r;
+        if (r) {
+          FILL_BIT_BUFFER_VALUE
+          r = GET_BITS(r);
+          EOBRUN += r;
+        }
+        EOBRUN--;
+        break;
+      }
+    }
+  }
+
+  if (cinfo->unread_marker != 0) {
+    cinfo->unread_marker = 0;
+    return FALSE;
+  }
+
+  /* Completed MCU, so update state */
+  br_state.bytes_in_buffer -= (buffer - br_state.next_input_byte);
+  br_state.next_input_byte = buffer;
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN;
+
+  return TRUE;
+}
+
+
+METHODDEF(boolean)
+decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+
   /* Process restart marker if needed; may have to suspend */
   if (cinfo->restart_interval) {
     if (entropy->restarts_to_go == 0)
@@ -383,57 +620,30 @@ decode_mcu_AC_first (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
    */
   if (! entropy->pub.insufficient_data) {
 
-    /* Load up working state.
-     * We can avoid loading/saving bitread state if in an EOB run.
+    /* If it's a band of zeroes, process it now (we do nothing).  We can avoid
+     * loading/saving bitread state if in an EOB run.
      */
-    EOBRUN = entropy->saved.EOBRUN;     /* only part of saved state we need */
-
-    /* There is always only one block per MCU */
-
-    if (EOBRUN > 0)             /* if it's a band of zeroes... */
-      EOBRUN--;                 /* ...process it now (we do nothing) */
+    if (entropy->saved.EOBRUN > 0)
+      entropy->saved.EOBRUN--;
+    else if (use_fast_path(cinfo)) {
+      if (! decode_mcu_AC_first_fast(cinfo, MCU_data)) goto use_slow;
+      entropy->fast_MCUs++;
+    }
     else {
-      BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
-      block = MCU_data[0];
-      tbl = entropy->ac_derived_tbl;
-
-      for (k = cinfo->Ss; k <= Se; k++) {
-        HUFF_DECODE(s, br_state, tbl, return FALSE, label2);
-        r = s >> 4;
-        s &= 15;
-        if (s) {
-          k += r;
-          CHECK_BIT_BUFFER(br_state, s, return FALSE);
-          r = GET_BITS(s);
-          s = HUFF_EXTEND(r, s);
-          /* Scale and output coefficient in natural (dezigzagged) order */
-          (*block)[jpeg_natural_order[k]] = (JCOEF) LEFT_SHIFT(s, Al);
-        } else {
-          if (r == 15) {        /* ZRL */
-            k += 15;            /* skip 15 zeroes in band */
-          } else {              /* EOBr, run length is 2^r + appended bits */
-            EOBRUN = 1 << r;
-            if (r) {            /* EOBr, r > 0 */
-              CHECK_BIT_BUFFER(br_state, r, return FALSE);
-              r = GET_BITS(r);
-              EOBRUN += r;
-            }
-            EOBRUN--;           /* this band is processed at this moment */
-            break;              /* force end-of-band */
-          }
-        }
-      }
-
-      BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+      use_slow:
+      if (! decode_mcu_AC_first_slow(cinfo, MCU_data)) return FALSE;
+      entropy->slow_MCUs++;
     }
 
-    /* Completed MCU, so update state */
-    entropy->saved.EOBRUN = EOBRUN;     /* only part of saved state we need */
   }
 
   /* Account for restart interval (no-op if not using restarts) */
   entropy->restarts_to_go--;
 
+  if (--entropy->MCUs_left == 0)
+    TRACEMS2(cinfo, 1, JTRC_HUFF_PATHS, entropy->fast_MCUs,
+             entropy->slow_MCUs);
+
   return TRUE;
 }
 
@@ -493,8 +703,8 @@ decode_mcu_DC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
  * MCU decoding for AC successive approximation refinement scan.
  */
 
-METHODDEF(boolean)
-decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+LOCAL(boolean)
+decode_mcu_AC_refine_slow (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
   int Se = cinfo->Se;
@@ -509,129 +719,232 @@ decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   int num_newnz;
   int newnz_pos[DCTSIZE2];
 
-  /* Process restart marker if needed; may have to suspend */
-  if (cinfo->restart_interval) {
-    if (entropy->restarts_to_go == 0)
-      if (! process_restart(cinfo))
-        return FALSE;
-  }
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+  EOBRUN = entropy->saved.EOBRUN; /* only part of saved state we need */
 
-  /* If we've run out of data, don't modify the MCU.
-   */
-  if (! entropy->pub.insufficient_data) {
+  /* There is always only one block per MCU */
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
 
-    /* Load up working state */
-    BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
-    EOBRUN = entropy->saved.EOBRUN; /* only part of saved state we need */
+  /* If we are forced to suspend, we must undo the assignments to any newly
+   * nonzero coefficients in the block, because otherwise we'd get confused
+   * next time about which coefficients were already nonzero.
+   * But we need not undo addition of bits to already-nonzero coefficients;
+   * instead, we can test the current bit to see if we already did it.
+   */
+  num_newnz = 0;
 
-    /* There is always only one block per MCU */
-    block = MCU_data[0];
-    tbl = entropy->ac_derived_tbl;
+  /* initialize coefficient loop counter to start of band */
+  k = cinfo->Ss;
 
-    /* If we are forced to suspend, we must undo the assignments to any newly
-     * nonzero coefficients in the block, because otherwise we'd get confused
-     * next time about which coefficients were already nonzero.
-     * But we need not undo addition of bits to already-nonzero coefficients;
-     * instead, we can test the current bit to see if we already did it.
-     */
-    num_newnz = 0;
-
-    /* initialize coefficient loop counter to start of band */
-    k = cinfo->Ss;
-
-    if (EOBRUN == 0) {
-      for (; k <= Se; k++) {
-        HUFF_DECODE(s, br_state, tbl, goto undoit, label3);
-        r = s >> 4;
-        s &= 15;
-        if (s) {
-          if (s != 1)           /* size of new coef should always be 1 */
-            WARNMS(cinfo, JWRN_HUFF_BAD_CODE);
+  if (EOBRUN == 0) {
+    for (; k <= Se; k++) {
+      HUFF_DECODE(s, br_state, tbl, goto undoit, label3);
+      r = s >> 4;
+      s &= 15;
+      if (s) {
+        if (s != 1)             /* size of new coef should always be 1 */
+          WARNMS(cinfo, JWRN_HUFF_BAD_CODE);
+        CHECK_BIT_BUFFER(br_state, 1, goto undoit);
+        if (GET_BITS(1))
+          s = p1;               /* newly nonzero coef is positive */
+        else
+          s = m1;               /* newly nonzero coef is negative */
+      } else {
+        if (r != 15) {
+          EOBRUN = 1 << r;      /* EOBr, run length is 2^r + appended bits */
+          if (r) {
+            CHECK_BIT_BUFFER(br_state, r, goto undoit);
+            r = GET_BITS(r);
+            EOBRUN += r;
+          }
+          break;                /* rest of block is handled by EOB logic */
+        }
+        /* note s = 0 for processing ZRL */
+      }
+      /* Advance over already-nonzero coefs and r still-zero coefs,
+       * appending correction bits to the nonzeroes.  A correction bit is 1
+       * if the absolute value of the coefficient must be increased.
+       */
+      do {
+        thiscoef = *block + jpeg_natural_order[k];
+        if (*thiscoef != 0) {
           CHECK_BIT_BUFFER(br_state, 1, goto undoit);
-          if (GET_BITS(1))
-            s = p1;             /* newly nonzero coef is positive */
-          else
-            s = m1;             /* newly nonzero coef is negative */
-        } else {
-          if (r != 15) {
-            EOBRUN = 1 << r;    /* EOBr, run length is 2^r + appended bits */
-            if (r) {
-              CHECK_BIT_BUFFER(br_state, r, goto undoit);
-              r = GET_BITS(r);
-              EOBRUN += r;
+          if (GET_BITS(1)) {
+            if ((*thiscoef & p1) == 0) { /* do nothing if already set it */
+              if (*thiscoef >= 0)
+                *thiscoef += p1;
+              else
+                *thiscoef += m1;
             }
-            break;              /* rest of block is handled by EOB logic */
           }
-          /* note s = 0 for processing ZRL */
+        } else {
+          if (--r < 0)
+            break;              /* reached target zero coefficient */
         }
-        /* Advance over already-nonzero coefs and r still-zero coefs,
-         * appending correction bits to the nonzeroes.  A correction bit is 1
-         * if the absolute value of the coefficient must be increased.
-         */
-        do {
-          thiscoef = *block + jpeg_natural_order[k];
-          if (*thiscoef != 0) {
-            CHECK_BIT_BUFFER(br_state, 1, goto undoit);
-            if (GET_BITS(1)) {
-              if ((*thiscoef & p1) == 0) { /* do nothing if already set it */
-                if (*thiscoef >= 0)
-                  *thiscoef += p1;
-                else
-                  *thiscoef += m1;
-              }
-            }
-          } else {
-            if (--r < 0)
-              break;            /* reached target zero coefficient */
+        k++;
+      } while (k <= Se);
+      if (s) {
+        int pos = jpeg_natural_order[k];
+        /* Output newly nonzero coefficient */
+        (*block)[pos] = (JCOEF) s;
+        /* Remember its position in case we have to suspend */
+        newnz_pos[num_newnz++] = pos;
+      }
+    }
+  }
+
+  if (EOBRUN > 0) {
+    /* Scan any remaining coefficient positions after the end-of-band
+     * (the last newly nonzero coefficient, if any).  Append a correction
+     * bit to each already-nonzero coefficient.  A correction bit is 1
+     * if the absolute value of the coefficient must be increased.
+     */
+    for (; k <= Se; k++) {
+      thiscoef = *block + jpeg_natural_order[k];
+      if (*thiscoef != 0) {
+        CHECK_BIT_BUFFER(br_state, 1, goto undoit);
+        if (GET_BITS(1)) {
+          if ((*thiscoef & p1) == 0) { /* do nothing if already changed it */
+            if (*thiscoef >= 0)
+              *thiscoef += p1;
+            else
+              *thiscoef += m1;
           }
-          k++;
-        } while (k <= Se);
-        if (s) {
-          int pos = jpeg_natural_order[k];
-          /* Output newly nonzero coefficient */
-          (*block)[pos] = (JCOEF) s;
-          /* Remember its position in case we have to suspend */
-          newnz_pos[num_newnz++] = pos;
         }
       }
     }
+    /* Count one block completed in EOB run */
+    EOBRUN--;
+  }
 
-    if (EOBRUN > 0) {
-      /* Scan any remaining coefficient positions after the end-of-band
-       * (the last newly nonzero coefficient, if any).  Append a correction
-       * bit to each already-nonzero coefficient.  A correction bit is 1
-       * if the absolute value of the coefficient must be increased.
-       */
-      for (; k <= Se; k++) {
+  /* Completed MCU, so update state */
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN; /* only part of saved state we need */
+
+  return TRUE;
+
+undoit:
+  /* Re-zero any output coefficients that we made newly nonzero */
+  while (num_newnz > 0)
+    (*block)[newnz_pos[--num_newnz]] = 0;
+
+  return FALSE;
+}
+
+
+/* Since the correction bits are applied only once to each coefficient (see
+ * above), the slow routine can safely repeat the MCU after the fast routine
+ * has backed out.  The fast routine also backs out if it encounters a
+ * malformed new coefficient, so that the slow routine can emit the warning.
+ */
+
+LOCAL(boolean)
+decode_mcu_AC_refine_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+  int Se = cinfo->Se;
+  int p1 = 1 << cinfo->Al;        /* 1 in the bit position being coded */
+  int m1 = (NEG_1) << cinfo->Al;  /* -1 in the bit position being coded */
+  register int s, k, r, l;
+  unsigned int EOBRUN;
+  JBLOCKROW block;
+  JCOEFPTR thiscoef;
+  BITREAD_STATE_VARS;
+  JOCTET *buffer;
+  d_derived_tbl *tbl;
+  int num_newnz;
+  int newnz_pos[DCTSIZE2];
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+  buffer = (JOCTET *) br_state.next_input_byte;
+  EOBRUN = entropy->saved.EOBRUN;
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
+  num_newnz = 0;
+  k = cinfo->Ss;
+
+  if (EOBRUN == 0) {
+    for (; k <= Se; k++) {
+      HUFF_DECODE_FAST(s, l, tbl);
+      r = s >> 4;
+      s &= 15;
+      if (s) {
+        if (s != 1)
+          goto undoit;
+        FILL_BIT_BUFFER_VALUE
+        s = GET_BITS(1) ? p1 : m1;
+      } else {
+        if (r != 15) {
+          EOBRUN = 1 << r;
+          if (r) {
+            FILL_BIT_BUFFER_VALUE
+            r = GET_BITS(r);
+            EOBRUN += r;
+          }
+          break;
+        }
+      }
+      do {
         thiscoef = *block + jpeg_natural_order[k];
         if (*thiscoef != 0) {
-          CHECK_BIT_BUFFER(br_state, 1, goto undoit);
+          FILL_BIT_BUFFER_FAST
           if (GET_BITS(1)) {
-            if ((*thiscoef & p1) == 0) { /* do nothing if already changed it */
+            if ((*thiscoef & p1) == 0) {
               if (*thiscoef >= 0)
                 *thiscoef += p1;
               else
                 *thiscoef += m1;
             }
           }
+        } else {
+          if (--r < 0)
+            break;
         }
+        k++;
+      } while (k <= Se);
+      if (s) {
+        int pos = jpeg_natural_order[k];
+        (*block)[pos] = (JCOEF) s;
+        newnz_pos[num_newnz++] = pos;
       }
-      /* Count one block completed in EOB run */
-      EOBRUN--;
     }
+  }
 
-    /* Completed MCU, so update state */
-    BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
-    entropy->saved.EOBRUN = EOBRUN; /* only part of saved state we need */
+  if (EOBRUN > 0) {
+    for (; k <= Se; k++) {
+      thiscoef = *block + jpeg_natural_order[k];
+      if (*thiscoef != 0) {
+        FILL_BIT_BUFFER_FAST
+        if (GET_BITS(1)) {
+          if ((*thiscoef & p1) == 0) {
+            if (*thiscoef >= 0)
+              *thiscoef += p1;
+            else
+              *thiscoef += m1;
+          }
+        }
+      }
+    }
+    EOBRUN--;
   }
 
-  /* Account for restart interval (no-op if not using restarts) */
-  entropy->restarts_to_go--;
+  if (cinfo->unread_marker != 0) {
+    cinfo->unread_marker = 0;
+    goto undoit;
+  }
+
+  /* Completed MCU, so update state */
+  br_state.bytes_in_buffer -= (buffer - br_state.next_input_byte);
+  br_state.next_input_byte = buffer;
+  BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN;
 
   return TRUE;
 
 undoit:
-  /* Re-zero any output coefficients that we made newly nonzero */
   while (num_newnz > 0)
     (*block)[newnz_pos[--num_newnz]] = 0;
 
@@ -639,6 +952,100 @@ undoit:
 }
 
 
+METHODDEF(boolean)
+decode_mcu_AC_refine (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+
+  /* Process restart marker if needed; may have to suspend */
+  if (cinfo->restart_interval) {
+    if (entropy->restarts_to_go == 0)
+      if (! process_restart(cinfo))
+        return FALSE;
+  }
+
+  /* If we've run out of data, don't modify the MCU.
+   */
+  if (! entropy->pub.insufficient_data) {
+
+    if (use_fast_path(cinfo)) {
+      if (! decode_mcu_AC_refine_fast(cinfo, MCU_data)) goto use_slow;
+      entropy->fast_MCUs++;
+    }
+    else {
+      use_slow:
+      if (! decode_mcu_AC_refine_slow(cinfo, MCU_data)) return FALSE;
+      entropy->slow_MCUs++;
+    }
+
+  }
+
+  /* Account for restart interval (no-op if not using restarts) */
+  entropy->restarts_to_go--;
+
+  if (--entropy->MCUs_left == 0)
+    TRACEMS2(cinfo, 1, JTRC_HUFF_PATHS, entropy->fast_MCUs,
+             entropy->slow_MCUs);
+
+  return TRUE;
+}
+
+
+/*
+ * Skip an AC scan that cannot affect the output.  Rather than decoding the
+ * scan, we discard its entropy-coded data (including any restart markers) up
+ * to the next marker, which is left for the marker reader just as if the
+ * scan had been decoded.  The remaining MCUs are then no-ops.
+ */
+
+METHODDEF(boolean)
+decode_mcu_skip (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr) cinfo->entropy;
+  struct jpeg_source_mgr *src = cinfo->src;
+  const JOCTET *next_input_byte;
+  size_t bytes_in_buffer;
+  int c;
+
+  if (entropy->scan_skipped)
+    return TRUE;
+
+  for (;;) {
+    if (src->bytes_in_buffer == 0) {
+      if (! (*src->fill_input_buffer) (cinfo))
+        return FALSE;           /* suspend; resume from the same state */
+    }
+    next_input_byte = src->next_input_byte;
+    bytes_in_buffer = src->bytes_in_buffer;
+
+    if (! entropy->skip_saw_FF) {
+      while (bytes_in_buffer > 0 && *next_input_byte != 0xFF) {
+        next_input_byte++;  bytes_in_buffer--;
+      }
+      if (bytes_in_buffer > 0) {
+        next_input_byte++;  bytes_in_buffer--;
+        entropy->skip_saw_FF = TRUE;
+      }
+      src->next_input_byte = next_input_byte;
+      src->bytes_in_buffer = bytes_in_buffer;
+      continue;
+    }
+
+    c = GETJOCTET(*next_input_byte);
+    src->next_input_byte = next_input_byte + 1;
+    src->bytes_in_buffer = bytes_in_buffer - 1;
+    if (c == 0xFF)              /* fill byte; still looking at a marker */
+      continue;
+    entropy->skip_saw_FF = FALSE;
+    if (c == 0 || (c >= 0xD0 && c <= 0xD7))
+      continue;                 /* stuffed zero or restart marker */
+    cinfo->unread_marker = c;
+    entropy->scan_skipped = TRUE;
+    return TRUE;
+  }
+}
+
+
 /*
  * Module initialization routine for progressive Huffman entropy decoding.
  */
@@ -655,6 +1062,9 @@ jinit_phuff_decoder (j_decompress_ptr cinfo)
                                 sizeof(phuff_entropy_decoder));
   cinfo->entropy = (struct jpeg_entropy_decoder *) entropy;
   entropy->pub.start_pass = start_pass_phuff_decoder;
+  entropy->pub.restore_checkpoint = NULL;
+  entropy->pub.save_checkpoint = NULL;
+  entropy->pub.scan_mcus = NULL;
 
   /* Mark derived tables unallocated */
   for (i = 0; i < NUM_HUFF_TBLS; i++) {
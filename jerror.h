@@ -201,6 +201,8 @@ JMESSAGE(JWRN_MUST_RESYNC,
          "Corrupt JPEG data: found marker 0x%02x instead of RST%d")
 JMESSAGE(JWRN_NOT_SEQUENTIAL, "Invalid SOS parameters for sequential JPEG")
 JMESSAGE(JWRN_TOO_MUCH_DATA, "Application transferred too many scanlines")
+JMESSAGE(JTRC_HUFF_PATHS,
+         "Huffman decoding: %u MCUs using fast path, %u using slow path")
 #if JPEG_LIB_VERSION < 70
 JMESSAGE(JERR_BAD_CROP_SPEC, "Invalid crop request")
 #if defined(C_ARITH_CODING_SUPPORTED) || defined(D_ARITH_CODING_SUPPORTED)
@@ -63,12 +63,14 @@
 #include <strings.h>
 #define MEMZERO(target,size)    bzero((void *)(target), (size_t)(size))
 #define MEMCOPY(dest,src,size)  bcopy((const void *)(src), (void *)(dest), (size_t)(size))
+#define MEMMOVE(dest,src,size)  bcopy((const void *)(src), (void *)(dest), (size_t)(size))
 
 #else /* not BSD, assume ANSI/SysV string lib */
 
 #include <string.h>
 #define MEMZERO(target,size)    memset((void *)(target), 0, (size_t)(size))
 #define MEMCOPY(dest,src,size)  memcpy((void *)(dest), (const void *)(src), (size_t)(size))
+#define MEMMOVE(dest,src,size)  memmove((void *)(dest), (const void *)(src), (size_t)(size))
 
 #endif
 
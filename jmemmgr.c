@@ -143,6 +143,14 @@ typedef struct {
    * array routines.
    */
   JDIMENSION last_rowsperchunk; /* from most recent alloc_sarray/barray */
+
+  /* In retain mode (see jpeg_mem_retain()), freeing the IMAGE pool moves its
+   * small pools and large objects to these lists, from which alloc_small and
+   * alloc_large reuse them for the next image.
+   */
+  boolean retain;
+  small_pool_ptr small_free_list;
+  large_pool_ptr large_free_list;
 } my_memory_mgr;
 
 typedef my_memory_mgr *my_mem_ptr;
@@ -304,6 +312,33 @@ alloc_small (j_common_ptr cinfo, int pool_id, size_t sizeofobject)
     hdr_ptr = hdr_ptr->next;
   }
 
+  /* Reuse the first retained pool that has enough space.  Retained pools are
+   * kept in the order in which they were added to the IMAGE pool list, so the
+   * same sequence of requests is satisfied from the same pools.
+   */
+  if (hdr_ptr == NULL && pool_id == JPOOL_IMAGE) {
+    small_pool_ptr prev_ptr = NULL;
+
+    for (hdr_ptr = mem->small_free_list; hdr_ptr != NULL;
+         prev_ptr = hdr_ptr, hdr_ptr = hdr_ptr->next) {
+      if (hdr_ptr->bytes_left >= sizeofobject)
+        break;
+    }
+    if (hdr_ptr != NULL) {
+      if (prev_ptr == NULL)
+        mem->small_free_list = hdr_ptr->next;
+      else
+        prev_ptr->next = hdr_ptr->next;
+      mem->total_space_allocated += hdr_ptr->bytes_left +
+                                    sizeof(small_pool_hdr);
+      hdr_ptr->next = NULL;
+      if (prev_hdr_ptr == NULL)
+        mem->small_list[pool_id] = hdr_ptr;
+      else
+        prev_hdr_ptr->next = hdr_ptr;
+    }
+  }
+
   /* Time to make a new pool? */
   if (hdr_ptr == NULL) {
     /* min_request is what we need now, slop is what will be leftover */
@@ -386,25 +421,57 @@ alloc_large (j_common_ptr cinfo, int pool_id, size_t sizeofobject)
       MAX_ALLOC_CHUNK)
     out_of_memory(cinfo, 3);    /* request exceeds malloc's ability */
 
-  /* Always make a new pool */
   if (pool_id < 0 || pool_id >= JPOOL_NUMPOOLS)
     ERREXIT1(cinfo, JERR_BAD_POOL_ID, pool_id); /* safety check */
 
-  hdr_ptr = (large_pool_ptr) jpeg_get_large(cinfo, sizeofobject +
-                                            sizeof(large_pool_hdr) +
-                                            ALIGN_SIZE - 1);
-  if (hdr_ptr == NULL)
-    out_of_memory(cinfo, 4);    /* jpeg_get_large failed */
-  mem->total_space_allocated += sizeofobject + sizeof(large_pool_hdr) +
-                                ALIGN_SIZE - 1;
+  /* Reuse the smallest retained object that is large enough, but not twice
+   * as large as the request or more.  Since the data offset within a pool
+   * depends only on the pool's address, the object fits in the same place.
+   */
+  hdr_ptr = NULL;
+  if (pool_id == JPOOL_IMAGE) {
+    large_pool_ptr prev_ptr, this_ptr, best_prev_ptr = NULL;
+    size_t capacity, best_capacity = 0;
+
+    for (prev_ptr = NULL, this_ptr = mem->large_free_list; this_ptr != NULL;
+         prev_ptr = this_ptr, this_ptr = this_ptr->next) {
+      capacity = this_ptr->bytes_used + this_ptr->bytes_left;
+      if (capacity >= sizeofobject && capacity / 2 < sizeofobject &&
+          (hdr_ptr == NULL || capacity < best_capacity)) {
+        hdr_ptr = this_ptr;
+        best_prev_ptr = prev_ptr;
+        best_capacity = capacity;
+      }
+    }
+    if (hdr_ptr != NULL) {
+      if (best_prev_ptr == NULL)
+        mem->large_free_list = hdr_ptr->next;
+      else
+        best_prev_ptr->next = hdr_ptr->next;
+      mem->total_space_allocated += best_capacity + sizeof(large_pool_hdr);
+      hdr_ptr->bytes_left = best_capacity - sizeofobject;
+    }
+  }
+
+  /* Otherwise, make a new pool */
+  if (hdr_ptr == NULL) {
+    hdr_ptr = (large_pool_ptr) jpeg_get_large(cinfo, sizeofobject +
+                                              sizeof(large_pool_hdr) +
+                                              ALIGN_SIZE - 1);
+    if (hdr_ptr == NULL)
+      out_of_memory(cinfo, 4);  /* jpeg_get_large failed */
+    mem->total_space_allocated += sizeofobject + sizeof(large_pool_hdr) +
+                                  ALIGN_SIZE - 1;
+    hdr_ptr->bytes_left = 0;
+  }
 
-  /* Success, initialize the new pool header and add to list */
+  /* Success, initialize the pool header and add to list */
   hdr_ptr->next = mem->large_list[pool_id];
   /* We maintain space counts in each pool header for statistical purposes,
-   * even though they are not needed for allocation.
+   * even though they are not needed for allocation.  (In retain mode, they
+   * also record the capacity of the pool.)
    */
   hdr_ptr->bytes_used = sizeofobject;
-  hdr_ptr->bytes_left = 0;
   mem->large_list[pool_id] = hdr_ptr;
 
   data_ptr = (char *) hdr_ptr; /* point to first data byte in pool... */
@@ -987,6 +1054,50 @@ access_virt_barray (j_common_ptr cinfo, jvirt_barray_ptr ptr,
 }
 
 
+/*
+ * Release a list of small pools, and return the amount of space freed.
+ */
+
+LOCAL(size_t)
+release_small_list (j_common_ptr cinfo, small_pool_ptr shdr_ptr)
+{
+  size_t space_freed, total_freed = 0;
+
+  while (shdr_ptr != NULL) {
+    small_pool_ptr next_shdr_ptr = shdr_ptr->next;
+    space_freed = shdr_ptr->bytes_used +
+                  shdr_ptr->bytes_left +
+                  sizeof(small_pool_hdr);
+    jpeg_free_small(cinfo, (void *) shdr_ptr, space_freed);
+    total_freed += space_freed;
+    shdr_ptr = next_shdr_ptr;
+  }
+  return total_freed;
+}
+
+
+/*
+ * Release a list of large objects, and return the amount of space freed.
+ */
+
+LOCAL(size_t)
+release_large_list (j_common_ptr cinfo, large_pool_ptr lhdr_ptr)
+{
+  size_t space_freed, total_freed = 0;
+
+  while (lhdr_ptr != NULL) {
+    large_pool_ptr next_lhdr_ptr = lhdr_ptr->next;
+    space_freed = lhdr_ptr->bytes_used +
+                  lhdr_ptr->bytes_left +
+                  sizeof(large_pool_hdr);
+    jpeg_free_large(cinfo, (void *) lhdr_ptr, space_freed);
+    total_freed += space_freed;
+    lhdr_ptr = next_lhdr_ptr;
+  }
+  return total_freed;
+}
+
+
 /*
  * Release all objects belonging to a specified pool.
  */
@@ -997,7 +1108,6 @@ free_pool (j_common_ptr cinfo, int pool_id)
   my_mem_ptr mem = (my_mem_ptr) cinfo->mem;
   small_pool_ptr shdr_ptr;
   large_pool_ptr lhdr_ptr;
-  size_t space_freed;
 
   if (pool_id < 0 || pool_id >= JPOOL_NUMPOOLS)
     ERREXIT1(cinfo, JERR_BAD_POOL_ID, pool_id); /* safety check */
@@ -1028,36 +1138,95 @@ free_pool (j_common_ptr cinfo, int pool_id)
     mem->virt_barray_list = NULL;
   }
 
+  /* In retain mode, release only the memory that the image did not reuse,
+   * and keep the rest (emptied) for the next image.
+   */
+  if (pool_id == JPOOL_IMAGE && mem->retain) {
+    release_large_list(cinfo, mem->large_free_list);
+    mem->large_free_list = mem->large_list[pool_id];
+    mem->large_list[pool_id] = NULL;
+    for (lhdr_ptr = mem->large_free_list; lhdr_ptr != NULL;
+         lhdr_ptr = lhdr_ptr->next)
+      mem->total_space_allocated -= lhdr_ptr->bytes_used +
+                                    lhdr_ptr->bytes_left +
+                                    sizeof(large_pool_hdr);
+
+    release_small_list(cinfo, mem->small_free_list);
+    mem->small_free_list = mem->small_list[pool_id];
+    mem->small_list[pool_id] = NULL;
+    for (shdr_ptr = mem->small_free_list; shdr_ptr != NULL;
+         shdr_ptr = shdr_ptr->next) {
+      shdr_ptr->bytes_left += shdr_ptr->bytes_used;
+      shdr_ptr->bytes_used = 0;
+      mem->total_space_allocated -= shdr_ptr->bytes_left +
+                                    sizeof(small_pool_hdr);
+    }
+    return;
+  }
+
   /* Release large objects */
   lhdr_ptr = mem->large_list[pool_id];
   mem->large_list[pool_id] = NULL;
-
-  while (lhdr_ptr != NULL) {
-    large_pool_ptr next_lhdr_ptr = lhdr_ptr->next;
-    space_freed = lhdr_ptr->bytes_used +
-                  lhdr_ptr->bytes_left +
-                  sizeof(large_pool_hdr);
-    jpeg_free_large(cinfo, (void *) lhdr_ptr, space_freed);
-    mem->total_space_allocated -= space_freed;
-    lhdr_ptr = next_lhdr_ptr;
-  }
+  mem->total_space_allocated -= release_large_list(cinfo, lhdr_ptr);
 
   /* Release small objects */
   shdr_ptr = mem->small_list[pool_id];
   mem->small_list[pool_id] = NULL;
+  mem->total_space_allocated -= release_small_list(cinfo, shdr_ptr);
+}
 
-  while (shdr_ptr != NULL) {
-    small_pool_ptr next_shdr_ptr = shdr_ptr->next;
-    space_freed = shdr_ptr->bytes_used +
-                  shdr_ptr->bytes_left +
-                  sizeof(small_pool_hdr);
-    jpeg_free_small(cinfo, (void *) shdr_ptr, space_freed);
-    mem->total_space_allocated -= space_freed;
-    shdr_ptr = next_shdr_ptr;
+
+/*
+ * Enable or disable retain mode.  In retain mode, the memory that the IMAGE
+ * pool obtained for one image is kept when the pool is freed (by
+ * jpeg_finish_(de)compress() or jpeg_abort()), and it is reused for the next
+ * image processed with the same JPEG object.  Memory that the next image does
+ * not reuse is released when that image's pool is freed, so a stream of
+ * similar images requires no further requests to the system-dependent memory
+ * allocation routines, while the memory retained is only that which the IMAGE
+ * pool held for the most recent image.  Retained memory is not counted in
+ * total_space_allocated.  Disabling retain mode releases any memory that is
+ * being retained (but not the IMAGE pool, if it is in use.)
+ */
+
+GLOBAL(void)
+jpeg_mem_retain (j_common_ptr cinfo, boolean retain)
+{
+  my_mem_ptr mem = (my_mem_ptr) cinfo->mem;
+
+  mem->retain = retain;
+  if (!retain) {
+    release_small_list(cinfo, mem->small_free_list);
+    mem->small_free_list = NULL;
+    release_large_list(cinfo, mem->large_free_list);
+    mem->large_free_list = NULL;
   }
 }
 
 
+/*
+ * Return the amount of memory that is being retained for the next image.
+ */
+
+GLOBAL(size_t)
+jpeg_mem_retained (j_common_ptr cinfo)
+{
+  my_mem_ptr mem = (my_mem_ptr) cinfo->mem;
+  small_pool_ptr shdr_ptr;
+  large_pool_ptr lhdr_ptr;
+  size_t total = 0;
+
+  for (shdr_ptr = mem->small_free_list; shdr_ptr != NULL;
+       shdr_ptr = shdr_ptr->next)
+    total += shdr_ptr->bytes_left + sizeof(small_pool_hdr);
+  for (lhdr_ptr = mem->large_free_list; lhdr_ptr != NULL;
+       lhdr_ptr = lhdr_ptr->next)
+    total += lhdr_ptr->bytes_used + lhdr_ptr->bytes_left +
+             sizeof(large_pool_hdr);
+  return total;
+}
+
+
 /*
  * Close up shop entirely.
  * Note that this cannot be called unless cinfo->mem is non-NULL.
@@ -1072,6 +1241,7 @@ self_destruct (j_common_ptr cinfo)
    * Releasing pools in reverse order might help avoid fragmentation
    * with some (brain-damaged) malloc libraries.
    */
+  jpeg_mem_retain(cinfo, FALSE);
   for (pool = JPOOL_NUMPOOLS-1; pool >= JPOOL_PERMANENT; pool--) {
     free_pool(cinfo, pool);
   }
@@ -1153,6 +1323,9 @@ jinit_memory_mgr (j_common_ptr cinfo)
   }
   mem->virt_sarray_list = NULL;
   mem->virt_barray_list = NULL;
+  mem->retain = FALSE;
+  mem->small_free_list = NULL;
+  mem->large_free_list = NULL;
 
   mem->total_space_allocated = sizeof(my_memory_mgr);
 
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This program verifies that the retain mode of the libjpeg memory manager
+   retains only the memory that was used by the most recent image.  A large
+   image and then a small one are compressed with the same compressor object,
+   and the memory that is retained afterwards must not exceed the memory that
+   is retained after compressing only the small image with a new compressor
+   object. */
+
+#include <stdio.h>
+#include <setjmp.h>
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jerror.h"
+
+typedef struct _error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf jb;
+} error_mgr;
+
+static void my_error_exit(j_common_ptr cinfo)
+{
+  error_mgr *myerr = (error_mgr *)cinfo->err;
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(myerr->jb, 1);
+}
+
+/* Destination manager that discards the JPEG image */
+
+static JOCTET outbuf[4096];
+
+static void init_destination(j_compress_ptr cinfo)
+{
+  cinfo->dest->next_output_byte = outbuf;
+  cinfo->dest->free_in_buffer = sizeof(outbuf);
+}
+
+static boolean empty_output_buffer(j_compress_ptr cinfo)
+{
+  init_destination(cinfo);
+  return TRUE;
+}
+
+static void term_destination(j_compress_ptr cinfo)
+{
+}
+
+/* Compress a width x height image, and return the amount of memory that is
+   retained afterwards. */
+static size_t compress_one(j_compress_ptr cinfo, JDIMENSION width,
+                           JDIMENSION height)
+{
+  JSAMPARRAY row;
+  JDIMENSION x;
+
+  cinfo->image_width = width;
+  cinfo->image_height = height;
+  cinfo->input_components = 3;
+  cinfo->in_color_space = JCS_RGB;
+  jpeg_set_defaults(cinfo);
+  /* Progressive mode requires a full-image coefficient buffer, whose row
+     pointers are allocated from small pools. */
+  jpeg_simple_progression(cinfo);
+  jpeg_start_compress(cinfo, TRUE);
+  row = (*cinfo->mem->alloc_sarray) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                     width * 3, 1);
+  for (x = 0; x < width * 3; x++)
+    row[0][x] = (JSAMPLE)(x * 7);
+  while (cinfo->next_scanline < cinfo->image_height)
+    jpeg_write_scanlines(cinfo, row, 1);
+  jpeg_finish_compress(cinfo);
+  return jpeg_mem_retained((j_common_ptr)cinfo);
+}
+
+int main(void)
+{
+  struct jpeg_compress_struct cinfo1, cinfo2;
+  struct jpeg_destination_mgr dest;
+  error_mgr jerr;
+  size_t large, large_small, small;
+  int retval = 1;
+
+  dest.init_destination = init_destination;
+  dest.empty_output_buffer = empty_output_buffer;
+  dest.term_destination = term_destination;
+
+  cinfo1.err = cinfo2.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = my_error_exit;
+  jpeg_create_compress(&cinfo1);
+  jpeg_create_compress(&cinfo2);
+  if (setjmp(jerr.jb)) {
+    /* this will execute if libjpeg has an error */
+    goto bailout;
+  }
+  cinfo1.dest = cinfo2.dest = &dest;
+  jpeg_mem_retain((j_common_ptr)&cinfo1, TRUE);
+  jpeg_mem_retain((j_common_ptr)&cinfo2, TRUE);
+
+  large = compress_one(&cinfo1, 64, 32768);
+  large_small = compress_one(&cinfo1, 64, 64);
+  small = compress_one(&cinfo2, 64, 64);
+  printf("Memory retained:\n");
+  printf("  large image:                %lu bytes\n", (unsigned long)large);
+  printf("  large image, then small:    %lu bytes\n",
+         (unsigned long)large_small);
+  printf("  small image:                %lu bytes\n", (unsigned long)small);
+  if (large_small > small) {
+    fprintf(stderr, "ERROR: memory from the large image was retained\n");
+    goto bailout;
+  }
+  printf("GOOD\n");
+  retval = 0;
+
+  bailout:
+  jpeg_destroy_compress(&cinfo1);
+  jpeg_destroy_compress(&cinfo2);
+  return retval;
+}
@@ -67,6 +67,44 @@ struct jpeg_comp_master {
   /* State variables made visible to other modules */
   boolean call_pass_startup;    /* True if pass_startup must be called */
   boolean is_last_pass;         /* True during last pass */
+
+  /* Pipelined compression (single-scan images without Huffman optimization
+   * only.)  If coef_ring_rows is nonzero, then the coefficient controller
+   * keeps that many iMCU rows of coefficients in a ring buffer.  If
+   * coef_ring_fill is TRUE, then the compressor only performs the forward DCT,
+   * storing iMCU row N of the image in ring row
+   * (coef_ring_start + N) % coef_ring_rows.  Otherwise, the compressor ignores
+   * its input data and entropy-encodes the coefficients in the ring,
+   * suspending rather than encoding iMCU row coef_ring_avail or beyond.  The
+   * ring is allocated by jpeg_start_compress() unless coef_ring[] has already
+   * been set, which allows several compressors to transform the image while
+   * another encodes it.
+   */
+  int coef_ring_rows;
+  boolean coef_ring_fill;
+  JDIMENSION coef_ring_start;
+  JDIMENSION coef_ring_avail;
+  JBLOCKARRAY coef_ring[MAX_COMPONENTS];
+
+  /* Single-pass Huffman optimization (Huffman-coded sequential images with
+   * optimize_coding only.)  If huff_symbol_stream is TRUE, then the Huffman
+   * encoder records the symbols of each scan while gathering statistics, and
+   * the output pass emits the recorded symbols rather than encoding the
+   * coefficients again.  For a single-scan image, this means that no
+   * full-image coefficient buffer is needed.  The output is identical.
+   */
+  boolean huff_symbol_stream;
+
+  /* Pre-trained Huffman tables (Huffman-coded sequential images without
+   * optimize_coding only.)  If huff_pretrained is TRUE, then the Huffman
+   * encoder buffers the first few MCU rows of each scan, counts the Huffman
+   * symbols in them, and then codes the scan with whichever of its built-in
+   * table sets (see jchuffsets.c) or the current tables would code that sample
+   * in the fewest bits.  The chosen tables replace the current ones.  Since the
+   * tables are not known until the sample has been gathered, the Huffman
+   * encoder writes the scan header itself.
+   */
+  boolean huff_pretrained;
 };
 
 /* Main buffer control (downsampled-data buffer) */
@@ -144,6 +182,21 @@ struct jpeg_marker_writer {
 
 /* Declarations for decompression modules */
 
+/* Snapshot of the entropy decoder state at the start of an iMCU row in a
+ * sequential scan.  This allows decoding to resume partway through the scan,
+ * provided that the entire scan is held in a single input buffer.
+ */
+typedef struct {
+  JDIMENSION iMCU_row;          /* iMCU row to which this state applies */
+  size_t offset;                /* # of bytes from start of scan data */
+  size_t get_buffer;            /* contents of bit-extraction buffer */
+  int bits_left;                /* # of unused bits in it */
+  int unread_marker;            /* marker, if any, that has been read */
+  int last_dc_val[MAX_COMPS_IN_SCAN]; /* last DC coef for each component */
+  unsigned int restarts_to_go;  /* MCUs left in this restart interval */
+  int next_restart_num;         /* next restart number expected (0-7) */
+} jpeg_entropy_checkpoint;
+
 /* Master control module */
 struct jpeg_decomp_master {
   void (*prepare_for_output_pass) (j_decompress_ptr cinfo);
@@ -158,6 +211,47 @@ struct jpeg_decomp_master {
   JDIMENSION first_MCU_col[MAX_COMPONENTS];
   JDIMENSION last_MCU_col[MAX_COMPONENTS];
   boolean jinit_upsampler_no_alloc;
+
+  /* Entropy decoder checkpoints, sorted by iMCU row.  If these are supplied,
+   * jpeg_skip_scanlines() resumes entropy decoding from the nearest checkpoint
+   * rather than decoding all of the skipped MCUs.  (Single-scan images only.)
+   */
+  const jpeg_entropy_checkpoint *checkpoints;
+  int num_checkpoints;
+
+  /* Pipelined decompression (single-scan images only.)  If coef_ring_rows is
+   * nonzero, then the coefficient controller keeps that many iMCU rows of
+   * coefficients in a ring buffer.  Each call to jpeg_consume_input() decodes
+   * one iMCU row into the ring, and the output side suspends rather than
+   * reading iMCU row coef_ring_avail or beyond.  The caller must not allow the
+   * input side to overwrite a row that has not yet been output.  The ring is
+   * allocated by jpeg_start_decompress() unless coef_ring[] has already been
+   * set, which allows one decompressor to decode the image while another
+   * outputs it.
+   */
+  int coef_ring_rows;
+  JDIMENSION coef_ring_avail;
+  JBLOCKARRAY coef_ring[MAX_COMPONENTS];
+
+  /* Components whose output depends only on their DC coefficients, because
+   * they are scaled to 1/8 (not set in buffered-image mode or when
+   * transcoding.)  In a progressive image, the AC scans for these components
+   * are skipped rather than decoded.
+   */
+  boolean dc_only[MAX_COMPONENTS];
+
+  /* If dc_only_stop is TRUE and all components are DC-only, then input stops
+   * as soon as the DC coefficients of a progressive image are complete, and
+   * the rest of the data stream (including EOI and any markers that precede
+   * it) is never read.  This suits only applications that decompress one image
+   * per buffer, so it is FALSE unless the application sets it.
+   */
+  boolean dc_only_stop;
+
+  /* Cache of lookup tables derived from the Huffman tables, which is kept
+   * across images (private to jdhuff.c)
+   */
+  void *huff_cache;
 };
 
 /* Input control module */
@@ -223,6 +317,19 @@ struct jpeg_marker_reader {
 struct jpeg_entropy_decoder {
   void (*start_pass) (j_decompress_ptr cinfo);
   boolean (*decode_mcu) (j_decompress_ptr cinfo, JBLOCKROW *MCU_data);
+  /* NULL if the entropy decoder cannot resume from a checkpoint */
+  boolean (*restore_checkpoint) (j_decompress_ptr cinfo,
+                                 const jpeg_entropy_checkpoint *ckpt);
+  /* Take a checkpoint at the current MCU boundary (all fields except
+   * iMCU_row.)  NULL if restore_checkpoint is NULL.
+   */
+  boolean (*save_checkpoint) (j_decompress_ptr cinfo,
+                              jpeg_entropy_checkpoint *ckpt);
+  /* Decode MCUs without producing coefficients, recording the bit position
+   * at which each one starts.  NULL if not supported by the entropy decoder.
+   */
+  JDIMENSION (*scan_mcus) (j_decompress_ptr cinfo, size_t end_pos,
+                           size_t *bit_pos, int *dc_val, JDIMENSION max_MCUs);
 
   /* This is here to share code between baseline and progressive decoders; */
   /* other modules probably should not use it */
@@ -339,6 +446,8 @@ EXTERN(void) jinit_2pass_quantizer (j_decompress_ptr cinfo);
 EXTERN(void) jinit_merged_upsampler (j_decompress_ptr cinfo);
 /* Memory manager initialization */
 EXTERN(void) jinit_memory_mgr (j_common_ptr cinfo);
+EXTERN(void) jpeg_mem_retain (j_common_ptr cinfo, boolean retain);
+EXTERN(size_t) jpeg_mem_retained (j_common_ptr cinfo);
 
 /* Utility routines in jutils.c */
 EXTERN(long) jdiv_round_up (long a, long b);
@@ -349,6 +458,8 @@ EXTERN(void) jcopy_sample_rows (JSAMPARRAY input_array, int source_row,
 EXTERN(void) jcopy_block_row (JBLOCKROW input_row, JBLOCKROW output_row,
                               JDIMENSION num_blocks);
 EXTERN(void) jzero_far (void *target, size_t bytestozero);
+/* Look-ahead support for the stdio data source in jdatasrc.c */
+EXTERN(boolean) jpeg_fill_ahead (j_decompress_ptr cinfo, size_t nbytes);
 /* Constant tables in jutils.c */
 #if 0                           /* This table is not actually needed in v6a */
 extern const int jpeg_zigzag_order[]; /* natural coef order to zigzag order */
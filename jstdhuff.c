@@ -8,8 +8,10 @@
  * For conditions of distribution and use, see the accompanying README.ijg
  * file.
  *
- * This file contains routines to set the default Huffman tables, if they are
- * not already set.
+ * This file contains routines to set the default Huffman tables.  The
+ * decompressor sets only the tables that are not already set, whereas the
+ * compressor replaces any tables left over from a previous image (such as
+ * optimal tables generated for a progressive image.)
  */
 
 /*
@@ -25,7 +27,7 @@ add_huff_table (j_common_ptr cinfo,
 
   if (*htblptr == NULL)
     *htblptr = jpeg_alloc_huff_table(cinfo);
-  else
+  else if (cinfo->is_decompressor)
     return;
 
   /* Copy the number-of-symbols-of-each-code-length counts */
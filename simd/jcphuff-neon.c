@@ -0,0 +1,143 @@
+/*
+ * ARMv8 NEON optimizations for libjpeg-turbo
+ *
+ * Copyright (C) 2026, The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/* DATA PREPARATION FOR PROGRESSIVE HUFFMAN ENCODING
+ *
+ * These routines compute the same results as encode_mcu_AC_first_prepare()
+ * and encode_mcu_AC_refine_prepare() in jcphuff.c, eight coefficients at a
+ * time.  The coefficients are gathered in zigzag order with scalar loads, and
+ * the rest of the work is done with vector instructions.  vabsq_s16() wraps
+ * around, and the result is then shifted logically, which gives the same
+ * 16-bit result as the C code for every input, including -32768.
+ */
+
+#define JPEG_INTERNALS
+#include "../jinclude.h"
+#include "../jpeglib.h"
+#include "../jsimd.h"
+#include "../jdct.h"
+#include "jsimd.h"
+#include <arm_neon.h>
+
+
+/* Weight of each lane in a lane mask */
+static const uint16_t lane_weights[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+
+
+/* Load the eight coefficients block[order[0]] ... block[order[7]], or only
+ * the first n of them (with zeros in the remaining lanes) if n < 8
+ */
+
+static int16x8_t
+load_coefs (const JCOEF *block, const int *order, int n)
+{
+  int16x8_t coefs = vdupq_n_s16(0);
+
+  if (n >= 8) {
+    coefs = vsetq_lane_s16(block[order[0]], coefs, 0);
+    coefs = vsetq_lane_s16(block[order[1]], coefs, 1);
+    coefs = vsetq_lane_s16(block[order[2]], coefs, 2);
+    coefs = vsetq_lane_s16(block[order[3]], coefs, 3);
+    coefs = vsetq_lane_s16(block[order[4]], coefs, 4);
+    coefs = vsetq_lane_s16(block[order[5]], coefs, 5);
+    coefs = vsetq_lane_s16(block[order[6]], coefs, 6);
+    coefs = vsetq_lane_s16(block[order[7]], coefs, 7);
+  } else {
+    JCOEF tail[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+      tail[i] = i < n ? block[order[i]] : 0;
+    coefs = vld1q_s16(tail);
+  }
+  return coefs;
+}
+
+/* Return one bit per 16-bit lane of a comparison result */
+
+static size_t
+lane_bits (uint16x8_t cmp, uint16x8_t weights)
+{
+  return (size_t)vaddvq_u16(vandq_u16(cmp, weights));
+}
+
+
+void
+jsimd_encode_mcu_AC_first_prepare_neon (const JCOEF *block,
+                                        const int *jpeg_natural_order_start,
+                                        int Sl, int Al, JCOEF *values,
+                                        size_t *zerobits)
+{
+  int16x8_t coefs, neg, shift = vdupq_n_s16(-Al);
+  uint16x8_t abscoefs, weights = vld1q_u16(lane_weights);
+  size_t mask = 0;
+  int k;
+
+  for (k = 0; k < Sl; k += 8) {
+    coefs = load_coefs(block, jpeg_natural_order_start + k, Sl - k);
+    neg = vshrq_n_s16(coefs, 15);             /* -1 if negative, else 0 */
+    abscoefs = vreinterpretq_u16_s16(vabsq_s16(coefs));
+    abscoefs = vshlq_u16(abscoefs, shift);    /* point transform */
+    vst1q_s16(values + k, vreinterpretq_s16_u16(abscoefs));
+    vst1q_s16(values + k + DCTSIZE2,
+              veorq_s16(vreinterpretq_s16_u16(abscoefs), neg));
+    mask |= lane_bits(vtstq_u16(abscoefs, abscoefs), weights) << k;
+  }
+
+  /* Lanes past the end of the band were zero, so their bits are clear. */
+  *zerobits = mask;
+}
+
+
+int
+jsimd_encode_mcu_AC_refine_prepare_neon (const JCOEF *block,
+                                         const int *jpeg_natural_order_start,
+                                         int Sl, int Al, JCOEF *absvalues,
+                                         size_t *bits)
+{
+  int16x8_t coefs, shift = vdupq_n_s16(-Al);
+  uint16x8_t abscoefs, weights = vld1q_u16(lane_weights),
+    one = vdupq_n_u16(1);
+  size_t zerobits = 0, signbits = 0, onebits = 0;
+  int k;
+
+  for (k = 0; k < Sl; k += 8) {
+    coefs = load_coefs(block, jpeg_natural_order_start + k, Sl - k);
+    abscoefs = vreinterpretq_u16_s16(vabsq_s16(coefs));
+    abscoefs = vshlq_u16(abscoefs, shift);    /* point transform */
+    vst1q_s16(absvalues + k, vreinterpretq_s16_u16(abscoefs));
+    zerobits |= lane_bits(vtstq_u16(abscoefs, abscoefs), weights) << k;
+    signbits |= lane_bits(vcgezq_s16(coefs), weights) << k;
+    onebits |= lane_bits(vceqq_u16(abscoefs, one), weights) << k;
+  }
+
+  /* Lanes past the end of the band were zero, which would otherwise set
+   * their sign bits.
+   */
+  if (Sl < 64)
+    signbits &= ((size_t)1 << Sl) - 1;
+
+  bits[0] = zerobits;
+  bits[1] = signbits;
+  /* EOB = index of last newly-nonzero coef + 1 */
+  return onebits ? 64 - __builtin_clzll(onebits) : 0;
+}
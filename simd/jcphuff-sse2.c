@@ -0,0 +1,151 @@
+/*
+ * SSE2 optimizations for libjpeg-turbo
+ *
+ * Copyright (C) 2026, The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/* DATA PREPARATION FOR PROGRESSIVE HUFFMAN ENCODING
+ *
+ * These routines compute the same results as encode_mcu_AC_first_prepare()
+ * and encode_mcu_AC_refine_prepare() in jcphuff.c, eight coefficients at a
+ * time.  The coefficients are gathered in zigzag order with scalar loads, and
+ * the rest of the work is done with vector instructions.  The absolute value
+ * wraps around in 16 bits and is then shifted logically, which gives the same
+ * 16-bit result as the C code for every input, including -32768.
+ */
+
+#define JPEG_INTERNALS
+#include "../jinclude.h"
+#include "../jpeglib.h"
+#include "../jsimd.h"
+#include "../jdct.h"
+#include "jsimd.h"
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_BitScanReverse64)
+#endif
+
+
+/* Load the eight coefficients block[order[0]] ... block[order[7]], or only
+ * the first n of them (with zeros in the remaining lanes) if n < 8
+ */
+
+static __m128i
+load_coefs (const JCOEF *block, const int *order, int n)
+{
+  JCOEF tail[8];
+  int i;
+
+  if (n >= 8)
+    return _mm_set_epi16(block[order[7]], block[order[6]], block[order[5]],
+                         block[order[4]], block[order[3]], block[order[2]],
+                         block[order[1]], block[order[0]]);
+
+  for (i = 0; i < 8; i++)
+    tail[i] = i < n ? block[order[i]] : 0;
+  return _mm_loadu_si128((__m128i *)tail);
+}
+
+/* Return one bit per 16-bit lane of a comparison result */
+
+static size_t
+lane_bits (__m128i cmp)
+{
+  return (size_t)(_mm_movemask_epi8(_mm_packs_epi16(cmp, cmp)) & 0xFF);
+}
+
+/* Return the index of the most significant set bit of x (x != 0) */
+
+static int
+highest_bit (size_t x)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, x);
+  return (int)index;
+#else
+  return 63 - __builtin_clzll(x);
+#endif
+}
+
+
+void
+jsimd_encode_mcu_AC_first_prepare_sse2 (const JCOEF *block,
+                                        const int *jpeg_natural_order_start,
+                                        int Sl, int Al, JCOEF *values,
+                                        size_t *zerobits)
+{
+  __m128i coefs, neg, abscoefs, nonzero;
+  __m128i shift = _mm_cvtsi32_si128(Al), zero = _mm_setzero_si128();
+  size_t mask = 0;
+  int k;
+
+  for (k = 0; k < Sl; k += 8) {
+    coefs = load_coefs(block, jpeg_natural_order_start + k, Sl - k);
+    neg = _mm_srai_epi16(coefs, 15);          /* -1 if negative, else 0 */
+    abscoefs = _mm_sub_epi16(_mm_xor_si128(coefs, neg), neg);
+    abscoefs = _mm_srl_epi16(abscoefs, shift); /* point transform */
+    _mm_storeu_si128((__m128i *)(values + k), abscoefs);
+    _mm_storeu_si128((__m128i *)(values + k + DCTSIZE2),
+                     _mm_xor_si128(abscoefs, neg));
+    nonzero = _mm_cmpeq_epi16(abscoefs, zero);
+    mask |= (~lane_bits(nonzero) & 0xFF) << k;
+  }
+
+  /* Lanes past the end of the band were zero, so their bits are clear. */
+  *zerobits = mask;
+}
+
+
+int
+jsimd_encode_mcu_AC_refine_prepare_sse2 (const JCOEF *block,
+                                         const int *jpeg_natural_order_start,
+                                         int Sl, int Al, JCOEF *absvalues,
+                                         size_t *bits)
+{
+  __m128i coefs, neg, abscoefs;
+  __m128i shift = _mm_cvtsi32_si128(Al), zero = _mm_setzero_si128(),
+    one = _mm_set1_epi16(1);
+  size_t zerobits = 0, signbits = 0, onebits = 0;
+  int k;
+
+  for (k = 0; k < Sl; k += 8) {
+    coefs = load_coefs(block, jpeg_natural_order_start + k, Sl - k);
+    neg = _mm_srai_epi16(coefs, 15);          /* -1 if negative, else 0 */
+    abscoefs = _mm_sub_epi16(_mm_xor_si128(coefs, neg), neg);
+    abscoefs = _mm_srl_epi16(abscoefs, shift); /* point transform */
+    _mm_storeu_si128((__m128i *)(absvalues + k), abscoefs);
+    zerobits |= (~lane_bits(_mm_cmpeq_epi16(abscoefs, zero)) & 0xFF) << k;
+    signbits |= (~lane_bits(neg) & 0xFF) << k;
+    onebits |= lane_bits(_mm_cmpeq_epi16(abscoefs, one)) << k;
+  }
+
+  /* Lanes past the end of the band were zero, which would otherwise set
+   * their sign bits.
+   */
+  if (Sl < 64)
+    signbits &= ((size_t)1 << Sl) - 1;
+
+  bits[0] = zerobits;
+  bits[1] = signbits;
+  /* EOB = index of last newly-nonzero coef + 1 */
+  return onebits ? highest_bit(onebits) + 1 : 0;
+}
@@ -1031,3 +1031,18 @@ EXTERN(JOCTET*) jsimd_huff_encode_one_block_neon
 EXTERN(JOCTET*) jsimd_huff_encode_one_block_neon_slowtbl
         (void *state, JOCTET *buffer, JCOEFPTR block, int last_dc_val,
          c_derived_tbl *dctbl, c_derived_tbl *actbl);
+
+/* Progressive Huffman encoding */
+EXTERN(void) jsimd_encode_mcu_AC_first_prepare_sse2
+        (const JCOEF *block, const int *jpeg_natural_order_start, int Sl,
+         int Al, JCOEF *values, size_t *zerobits);
+EXTERN(int) jsimd_encode_mcu_AC_refine_prepare_sse2
+        (const JCOEF *block, const int *jpeg_natural_order_start, int Sl,
+         int Al, JCOEF *absvalues, size_t *bits);
+
+EXTERN(void) jsimd_encode_mcu_AC_first_prepare_neon
+        (const JCOEF *block, const int *jpeg_natural_order_start, int Sl,
+         int Al, JCOEF *values, size_t *zerobits);
+EXTERN(int) jsimd_encode_mcu_AC_refine_prepare_neon
+        (const JCOEF *block, const int *jpeg_natural_order_start, int Sl,
+         int Al, JCOEF *absvalues, size_t *bits);
@@ -46,7 +46,7 @@
 #define _throwbmp(m) _throw(m, bmpgeterr())
 
 int flags=TJFLAG_NOREALLOC, componly=0, decomponly=0, doyuv=0, quiet=0,
-	dotile=0, pf=TJPF_BGR, yuvpad=1, dowrite=1;
+	dotile=0, pf=TJPF_BGR, yuvpad=1, dowrite=1, nthreads=1;
 char *ext="ppm";
 const char *pixFormatStr[TJ_NUMPF]=
 {
@@ -124,6 +124,8 @@ int decomp(unsigned char *srcbuf, unsigned char **jpegbuf,
 
 	if((handle=tjInitDecompress())==NULL)
 		_throwtj("executing tjInitDecompress()");
+	if(tjSetNumThreads(handle, nthreads)==-1)
+		_throwtj("executing tjSetNumThreads()");
 
 	if(dstbuf==NULL)
 	{
@@ -335,6 +337,8 @@ int fullTest(unsigned char *srcbuf, int w, int h, int subsamp, int jpegqual,
 			memcpy(&tmpbuf[pitch*i], &srcbuf[w*ps*i], w*ps);
 		if((handle=tjInitCompress())==NULL)
 			_throwtj("executing tjInitCompress()");
+		if(tjSetNumThreads(handle, nthreads)==-1)
+			_throwtj("executing tjSetNumThreads()");
 
 		if(doyuv)
 		{
@@ -783,6 +787,16 @@ void usage(char *progname)
 	printf("-warmup <t> = Run each benchmark for <t> seconds (default = 1.0) prior to\n");
 	printf("     starting the timer, in order to prime the caches and thus improve the\n");
 	printf("     consistency of the results.\n");
+	printf("-nt <n> = Allow the codec to use up to <n> threads (0 = one per CPU core)\n");
+	printf("     when decompressing JPEG images that contain restart markers\n");
+	printf("-striped = When used with -nt, compress the image as parallel stripes joined\n");
+	printf("     with restart markers\n");
+	printf("-speculative = When used with -nt, decompress JPEG images that do not contain\n");
+	printf("     restart markers by speculatively decoding segments in parallel\n");
+	printf("-arithmetic = Use arithmetic entropy coding when compressing, so that the\n");
+	printf("     decompression tests measure the arithmetic decoder\n");
+	printf("-pretrained = Code each scan with the best-fitting pre-trained Huffman tables\n");
+	printf("     when compressing\n");
 	printf("-componly = Stop after running compression tests.  Do not test decompression.\n");
 	printf("-nowrite = Do not write reference or output images (improves consistency of\n");
 	printf("     performance measurements.)\n\n");
@@ -931,6 +945,16 @@ int main(int argc, char *argv[])
 					}
 				}
 			}
+			if(!strcasecmp(argv[i], "-nt") && i<argc-1)
+			{
+				int temp=atoi(argv[++i]);
+				if(temp>=0) nthreads=temp;
+				else usage(argv[0]);
+			}
+			if(!strcasecmp(argv[i], "-striped")) flags|=TJFLAG_STRIPED;
+			if(!strcasecmp(argv[i], "-speculative")) flags|=TJFLAG_SPECULATIVE;
+			if(!strcasecmp(argv[i], "-arithmetic")) putenv("TJ_ARITHMETIC=1");
+			if(!strcasecmp(argv[i], "-pretrained")) flags|=TJFLAG_PRETRAINED;
 			if(!strcasecmp(argv[i], "-componly")) componly=1;
 			if(!strcasecmp(argv[i], "-nowrite")) dowrite=0;
 		}
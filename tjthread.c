@@ -0,0 +1,179 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tjthread.h"
+
+#ifdef _WIN32
+
+static DWORD WINAPI threadFunc(LPVOID param)
+{
+	tjthread *thread=(tjthread *)param;
+	thread->func(thread->arg);
+	return 0;
+}
+
+int tjThreadCreate(tjthread *thread, void (*func)(void *), void *arg)
+{
+	thread->func=func;  thread->arg=arg;
+	thread->handle=CreateThread(NULL, 0, threadFunc, thread, 0, NULL);
+	return thread->handle ? 0:-1;
+}
+
+int tjThreadJoin(tjthread *thread)
+{
+	if(WaitForSingleObject(thread->handle, INFINITE)==WAIT_FAILED) return -1;
+	CloseHandle(thread->handle);
+	return 0;
+}
+
+int tjMutexInit(tjmutex *mutex)
+{
+	InitializeCriticalSection(&mutex->cs);
+	return 0;
+}
+
+int tjMutexDestroy(tjmutex *mutex)
+{
+	DeleteCriticalSection(&mutex->cs);
+	return 0;
+}
+
+int tjMutexLock(tjmutex *mutex)
+{
+	EnterCriticalSection(&mutex->cs);
+	return 0;
+}
+
+int tjMutexUnlock(tjmutex *mutex)
+{
+	LeaveCriticalSection(&mutex->cs);
+	return 0;
+}
+
+int tjCondInit(tjcond *cond)
+{
+	InitializeConditionVariable(&cond->cv);
+	return 0;
+}
+
+int tjCondDestroy(tjcond *cond)
+{
+	return 0;
+}
+
+int tjCondWait(tjcond *cond, tjmutex *mutex)
+{
+	return SleepConditionVariableCS(&cond->cv, &mutex->cs, INFINITE) ? 0:-1;
+}
+
+int tjCondBroadcast(tjcond *cond)
+{
+	WakeAllConditionVariable(&cond->cv);
+	return 0;
+}
+
+int tjGetNumCPUs(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors>0 ? (int)info.dwNumberOfProcessors:1;
+}
+
+#else
+
+#include <unistd.h>
+
+static void *threadFunc(void *param)
+{
+	tjthread *thread=(tjthread *)param;
+	thread->func(thread->arg);
+	return NULL;
+}
+
+int tjThreadCreate(tjthread *thread, void (*func)(void *), void *arg)
+{
+	thread->func=func;  thread->arg=arg;
+	return pthread_create(&thread->handle, NULL, threadFunc, thread)==0 ?
+		0:-1;
+}
+
+int tjThreadJoin(tjthread *thread)
+{
+	return pthread_join(thread->handle, NULL)==0 ? 0:-1;
+}
+
+int tjMutexInit(tjmutex *mutex)
+{
+	return pthread_mutex_init(&mutex->mutex, NULL)==0 ? 0:-1;
+}
+
+int tjMutexDestroy(tjmutex *mutex)
+{
+	return pthread_mutex_destroy(&mutex->mutex)==0 ? 0:-1;
+}
+
+int tjMutexLock(tjmutex *mutex)
+{
+	return pthread_mutex_lock(&mutex->mutex)==0 ? 0:-1;
+}
+
+int tjMutexUnlock(tjmutex *mutex)
+{
+	return pthread_mutex_unlock(&mutex->mutex)==0 ? 0:-1;
+}
+
+int tjCondInit(tjcond *cond)
+{
+	return pthread_cond_init(&cond->cond, NULL)==0 ? 0:-1;
+}
+
+int tjCondDestroy(tjcond *cond)
+{
+	return pthread_cond_destroy(&cond->cond)==0 ? 0:-1;
+}
+
+int tjCondWait(tjcond *cond, tjmutex *mutex)
+{
+	return pthread_cond_wait(&cond->cond, &mutex->mutex)==0 ? 0:-1;
+}
+
+int tjCondBroadcast(tjcond *cond)
+{
+	return pthread_cond_broadcast(&cond->cond)==0 ? 0:-1;
+}
+
+int tjGetNumCPUs(void)
+{
+	#ifdef _SC_NPROCESSORS_ONLN
+	long n=sysconf(_SC_NPROCESSORS_ONLN);
+	if(n>0) return (int)n;
+	#endif
+	return 1;
+}
+
+#endif
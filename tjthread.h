@@ -0,0 +1,101 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Minimal threading abstraction used by the multithreaded TurboJPEG
+   functions (POSIX threads or Win32 threads) */
+
+#ifndef __TJTHREAD_H__
+#define __TJTHREAD_H__
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef struct _tjthread
+{
+	#ifdef _WIN32
+	HANDLE handle;
+	#else
+	pthread_t handle;
+	#endif
+	void (*func)(void *);
+	void *arg;
+} tjthread;
+
+typedef struct _tjmutex
+{
+	#ifdef _WIN32
+	CRITICAL_SECTION cs;
+	#else
+	pthread_mutex_t mutex;
+	#endif
+} tjmutex;
+
+typedef struct _tjcond
+{
+	#ifdef _WIN32
+	CONDITION_VARIABLE cv;
+	#else
+	pthread_cond_t cond;
+	#endif
+} tjcond;
+
+/* Storage class specifier for variables that have a separate instance in each
+   thread */
+#ifdef _MSC_VER
+#define TJ_THREAD_LOCAL __declspec(thread)
+#else
+#define TJ_THREAD_LOCAL __thread
+#endif
+
+/* Start a thread that calls func(arg).  The tjthread structure must remain
+   valid until tjThreadJoin() is called.  Returns 0 if successful. */
+int tjThreadCreate(tjthread *thread, void (*func)(void *), void *arg);
+
+/* Wait for a thread started with tjThreadCreate() to finish */
+int tjThreadJoin(tjthread *thread);
+
+/* Mutexes and condition variables.  All return 0 if successful. */
+int tjMutexInit(tjmutex *mutex);
+int tjMutexDestroy(tjmutex *mutex);
+int tjMutexLock(tjmutex *mutex);
+int tjMutexUnlock(tjmutex *mutex);
+int tjCondInit(tjcond *cond);
+int tjCondDestroy(tjcond *cond);
+/* Atomically release the mutex (which must be locked) and wait for the
+   condition to be signaled, then reacquire the mutex */
+int tjCondWait(tjcond *cond, tjmutex *mutex);
+/* Wake all threads waiting on the condition */
+int tjCondBroadcast(tjcond *cond);
+
+/* Return the number of CPU cores available to this process (at least 1) */
+int tjGetNumCPUs(void);
+
+#endif
@@ -157,6 +157,17 @@ void initBuf(unsigned char *buf, int w, int h, int pf, int flags)
 }
 
 
+/* Fill an RGB buffer with a gradient plus some noise, which compresses to
+   JPEG images with realistic amounts of entropy-coded data. */
+void initNoisyBuf(unsigned char *buf, int w, int h)
+{
+	int i;
+
+	for(i=0; i<w*h*3; i++)
+		buf[i]=(unsigned char)((i/3)%w+(i/(w*3))*2+random()%32);
+}
+
+
 #define checkval(v, cv) { \
 	if(v<cv-1 || v>cv+1) { \
 		printf("\nComp. %s at %d,%d should be %d, not %d\n",  \
@@ -686,39 +697,1624 @@ void bufSizeTest(void)
 }
 
 
-int main(int argc, char *argv[])
+/* Verify that multithreaded decompression produces the same output as
+   single-threaded decompression */
+void threadTest(void)
 {
-	int i, num4bf=5;
-	#ifdef _WIN32
-	srand((unsigned int)time(NULL));
-	#endif
-	if(argc>1)
+	const char *restartStr[]={"TJ_RESTART=1", "TJ_RESTART=3", "TJ_RESTART=5B",
+		"TJ_RESTART=0"};
+	const int restartFlags[]={0, TJFLAG_FASTUPSAMPLE, TJFLAG_BOTTOMUP};
+	int w=227, h=201, subsamp, r, f, i, n=0;
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *dstBuf1=NULL, *dstBuf2=NULL;
+	unsigned long jpegSize=0;
+	tjhandle chandle=NULL, dhandle1=NULL, dhandle2=NULL;
+	tjscalingfactor *sf=tjGetScalingFactors(&n);
+
+	if(!sf || !n) _throwtj();
+	if((chandle=tjInitCompress())==NULL || (dhandle1=tjInitDecompress())==NULL
+		|| (dhandle2=tjInitDecompress())==NULL)
+		_throwtj();
+	_tj(tjSetNumThreads(dhandle2, 4));
+	if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+		|| (dstBuf1=(unsigned char *)malloc(w*h*3))==NULL
+		|| (dstBuf2=(unsigned char *)malloc(w*h*3))==NULL)
+		_throw("Memory allocation failure");
+	initNoisyBuf(srcBuf, w, h);
+
+	for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
 	{
-		for(i=1; i<argc; i++)
+		for(r=0; r<4; r++)
 		{
-			if(!strcasecmp(argv[i], "-yuv")) doyuv=1;
-			if(!strcasecmp(argv[i], "-noyuvpad")) pad=1;
-			if(!strcasecmp(argv[i], "-alloc")) alloc=1;
-			if(!strncasecmp(argv[i], "-h", 2) || !strcasecmp(argv[i], "-?"))
-				usage(argv[0]);
+			printf("Multithreaded decompression (%s, %s) ... ",
+				subNameLong[subsamp], restartStr[r]);
+			putenv((char *)restartStr[r]);
+			_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+				&jpegSize, subsamp, 95, 0));
+			putenv("TJ_RESTART=");
+			for(f=0; f<6; f++)
+			{
+				/* Test both pipelined and speculative decompression of the images
+				   that have no restart markers */
+				int flags=restartFlags[f%3]|(f>=3 ? TJFLAG_SPECULATIVE:0);
+
+				for(i=0; i<n; i++)
+				{
+					int sw=TJSCALED(w, sf[i]), sh=TJSCALED(h, sf[i]);
+					if(sf[i].num!=1) continue;
+					memset(dstBuf1, 0, w*h*3);  memset(dstBuf2, 0, w*h*3);
+					_tj(tjDecompress2(dhandle1, jpegBuf, jpegSize, dstBuf1, sw, 0, sh,
+						TJPF_RGB, flags));
+					_tj(tjDecompress2(dhandle2, jpegBuf, jpegSize, dstBuf2, sw, 0, sh,
+						TJPF_RGB, flags));
+					if(memcmp(dstBuf1, dstBuf2, sw*sh*3))
+					{
+						printf("FAILED! (flags=%d, scale=1/%d)\n", flags, sf[i].denom);
+						bailout();
+					}
+				}
+			}
+			printf("Passed.\n");
 		}
 	}
-	if(alloc) printf("Testing automatic buffer allocation\n");
-	if(doyuv) num4bf=4;
-	doTest(35, 39, _3byteFormats, 2, TJSAMP_444, "test");
-	doTest(39, 41, _4byteFormats, num4bf, TJSAMP_444, "test");
-	doTest(41, 35, _3byteFormats, 2, TJSAMP_422, "test");
-	doTest(35, 39, _4byteFormats, num4bf, TJSAMP_422, "test");
-	doTest(39, 41, _3byteFormats, 2, TJSAMP_420, "test");
-	doTest(41, 35, _4byteFormats, num4bf, TJSAMP_420, "test");
-	doTest(35, 39, _3byteFormats, 2, TJSAMP_440, "test");
-	doTest(39, 41, _4byteFormats, num4bf, TJSAMP_440, "test");
-	doTest(41, 35, _3byteFormats, 2, TJSAMP_411, "test");
-	doTest(35, 39, _4byteFormats, num4bf, TJSAMP_411, "test");
-	doTest(39, 41, _onlyGray, 1, TJSAMP_GRAY, "test");
-	doTest(41, 35, _3byteFormats, 2, TJSAMP_GRAY, "test");
-	doTest(35, 39, _4byteFormats, 4, TJSAMP_GRAY, "test");
-	bufSizeTest();
+	printf("--------------------\n\n");
+
+	bailout:
+	if(chandle) tjDestroy(chandle);
+	if(dhandle1) tjDestroy(dhandle1);
+	if(dhandle2) tjDestroy(dhandle2);
+	if(srcBuf) free(srcBuf);
+	if(dstBuf1) free(dstBuf1);
+	if(dstBuf2) free(dstBuf2);
+	if(jpegBuf) tjFree(jpegBuf);
+}
+
+
+/* Verify that striped multithreaded compression produces the same JPEG image
+   as single-threaded compression with the equivalent restart interval */
+void stripeTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {9000, 40}};
+	int subsamp, sz, f, i, w, h, ri;
+	unsigned char *srcBuf=NULL, *jpegBuf1=NULL, *jpegBuf2=NULL;
+	unsigned long jpegSize1=0, jpegSize2=0;
+	tjhandle chandle1=NULL, chandle2=NULL;
+	static char envStr[80];
+
+	if((chandle1=tjInitCompress())==NULL || (chandle2=tjInitCompress())==NULL)
+		_throwtj();
+	_tj(tjSetNumThreads(chandle2, 3));
+
+	for(sz=0; sz<3; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Striped compression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(f=0; f<2; f++)
+			{
+				int flags=TJFLAG_STRIPED|(f ? TJFLAG_BOTTOMUP:0);
+				_tj(tjCompress2(chandle2, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf2,
+					&jpegSize2, subsamp, 95, flags));
+
+				/* Find the restart interval that was used */
+				for(i=2, ri=0; i+5<(int)jpegSize2 && jpegBuf2[i]==0xFF;
+					i+=2+((jpegBuf2[i+2]<<8)|jpegBuf2[i+3]))
+				{
+					if(jpegBuf2[i+1]==0xDD) ri=(jpegBuf2[i+4]<<8)|jpegBuf2[i+5];
+					if(jpegBuf2[i+1]==0xDA) break;
+				}
+				if(ri==0)
+				{
+					printf("FAILED! (no restart interval)\n");
+					bailout();
+				}
+				snprintf(envStr, 80, "TJ_RESTART=%dB", ri);
+				putenv(envStr);
+				_tj(tjCompress2(chandle1, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf1,
+					&jpegSize1, subsamp, 95, flags));
+				putenv("TJ_RESTART=");
+				if(jpegSize1!=jpegSize2 || memcmp(jpegBuf1, jpegBuf2, jpegSize1))
+				{
+					printf("FAILED! (flags=%d)\n", flags);
+					bailout();
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	if(chandle1) tjDestroy(chandle1);
+	if(chandle2) tjDestroy(chandle2);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf1) tjFree(jpegBuf1);
+	if(jpegBuf2) tjFree(jpegBuf2);
+}
+
+
+/* Verify that pipelined multithreaded compression produces the same JPEG image
+   as single-threaded compression */
+void pipelineTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {35, 300}};
+	int subsamp, sz, f, w, h;
+	unsigned char *srcBuf=NULL, *jpegBuf1=NULL, *jpegBuf2=NULL;
+	unsigned long jpegSize1=0, jpegSize2=0;
+	tjhandle chandle1=NULL, chandle2=NULL;
+
+	if((chandle1=tjInitCompress())==NULL || (chandle2=tjInitCompress())==NULL)
+		_throwtj();
+	_tj(tjSetNumThreads(chandle2, 3));
+
+	for(sz=0; sz<3; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Pipelined compression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(f=0; f<4; f++)
+			{
+				int flags=(f&1 ? TJFLAG_BOTTOMUP:0);
+				putenv(f&2 ? "TJ_RESTART=1":"TJ_RESTART=");
+				_tj(tjCompress2(chandle1, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf1,
+					&jpegSize1, subsamp, 95, flags));
+				_tj(tjCompress2(chandle2, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf2,
+					&jpegSize2, subsamp, 95, flags));
+				if(jpegSize1!=jpegSize2 || memcmp(jpegBuf1, jpegBuf2, jpegSize1))
+				{
+					printf("FAILED! (flags=%d%s)\n", flags,
+						f&2 ? ", restart interval=1 row":"");
+					bailout();
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	if(chandle1) tjDestroy(chandle1);
+	if(chandle2) tjDestroy(chandle2);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf1) tjFree(jpegBuf1);
+	if(jpegBuf2) tjFree(jpegBuf2);
+}
+
+
+/* Verify that compressing, decompressing, and transforming images with
+   tjBatch() produces the same results as the equivalent single-image
+   functions, and that a failing job is reported without affecting the others */
+#define NUMJOBS 13
+
+void batchTest(void)
+{
+	tjjob jobs[NUMJOBS];
+	unsigned char *srcBufs[NUMJOBS], *dstBufs[NUMJOBS], *xformBufs[NUMJOBS];
+	unsigned char *jpegBuf=NULL, *dstBuf=NULL;
+	unsigned long xformSizes[NUMJOBS], jpegSize=0;
+	tjtransform xform;
+	tjhandle handle=NULL, chandle=NULL, dhandle=NULL, thandle=NULL;
+	int i, w, h, op;
+
+	memset(jobs, 0, sizeof(jobs));
+	memset(srcBufs, 0, sizeof(srcBufs));
+	memset(dstBufs, 0, sizeof(dstBufs));
+	memset(xformBufs, 0, sizeof(xformBufs));
+	memset(&xform, 0, sizeof(xform));
+	if((handle=tjInitDecompress())==NULL || (chandle=tjInitCompress())==NULL
+		|| (dhandle=tjInitDecompress())==NULL
+		|| (thandle=tjInitTransform())==NULL)
+		_throwtj();
+	_tj(tjSetNumThreads(handle, 3));
+
+	printf("Batch compression ... ");
+	for(i=0; i<NUMJOBS; i++)
+	{
+		w=37+i*29;  h=41+i*13;
+		if((srcBufs[i]=(unsigned char *)malloc(w*h*3))==NULL
+			|| (dstBufs[i]=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBufs[i], w, h);
+		jobs[i].op=TJOP_COMPRESS;
+		jobs[i].buf=srcBufs[i];
+		jobs[i].width=w;  jobs[i].height=h;  jobs[i].pixelFormat=TJPF_RGB;
+		jobs[i].jpegSubsamp=i%TJ_NUMSAMP;  jobs[i].jpegQual=90;
+		jobs[i].flags=(i&1 ? TJFLAG_BOTTOMUP:0);
+	}
+	_tj(tjBatch(handle, jobs, NUMJOBS));
+	for(i=0; i<NUMJOBS; i++)
+	{
+		_tj(tjCompress2(chandle, jobs[i].buf, jobs[i].width, 0, jobs[i].height,
+			TJPF_RGB, &jpegBuf, &jpegSize, jobs[i].jpegSubsamp, 90,
+			jobs[i].flags));
+		if(jobs[i].retval!=0 || jpegSize!=jobs[i].jpegSize
+			|| memcmp(jpegBuf, jobs[i].jpegBuf, jpegSize))
+		{
+			printf("FAILED! (job %d)\n", i);
+			bailout();
+		}
+	}
+	printf("Passed.\n");
+
+	printf("Batch decompression ... ");
+	for(i=0; i<NUMJOBS; i++)
+	{
+		jobs[i].op=TJOP_DECOMPRESS;
+		jobs[i].buf=dstBufs[i];
+	}
+	_tj(tjBatch(handle, jobs, NUMJOBS));
+	for(i=0; i<NUMJOBS; i++)
+	{
+		w=jobs[i].width;  h=jobs[i].height;
+		if((dstBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		_tj(tjDecompress2(dhandle, jobs[i].jpegBuf, jobs[i].jpegSize, dstBuf, w,
+			0, h, TJPF_RGB, jobs[i].flags));
+		if(jobs[i].retval!=0 || memcmp(dstBuf, dstBufs[i], w*h*3))
+		{
+			printf("FAILED! (job %d)\n", i);
+			bailout();
+		}
+		free(dstBuf);  dstBuf=NULL;
+	}
+	printf("Passed.\n");
+
+	printf("Batch transformation ... ");
+	xform.op=TJXOP_HFLIP;  xform.options=TJXOPT_TRIM;
+	for(i=0; i<NUMJOBS; i++)
+	{
+		jobs[i].op=TJOP_TRANSFORM;
+		jobs[i].n=1;
+		jobs[i].dstBufs=&xformBufs[i];
+		jobs[i].dstSizes=&xformSizes[i];
+		jobs[i].transforms=&xform;
+	}
+	_tj(tjBatch(handle, jobs, NUMJOBS));
+	for(i=0; i<NUMJOBS; i++)
+	{
+		_tj(tjTransform(thandle, jobs[i].jpegBuf, jobs[i].jpegSize, 1, &jpegBuf,
+			&jpegSize, &xform, 0));
+		if(jobs[i].retval!=0 || jpegSize!=xformSizes[i]
+			|| memcmp(jpegBuf, xformBufs[i], jpegSize))
+		{
+			printf("FAILED! (job %d)\n", i);
+			bailout();
+		}
+	}
+	printf("Passed.\n");
+
+	printf("Batch error reporting ... ");
+	op=jobs[5].op;
+	jobs[5].op=-1;
+	if(tjBatch(handle, jobs, NUMJOBS)!=-1 || jobs[5].retval!=-1
+		|| strlen(jobs[5].errStr)==0)
+	{
+		printf("FAILED! (invalid job not reported)\n");
+		bailout();
+	}
+	for(i=0; i<NUMJOBS; i++)
+	{
+		if(i!=5 && jobs[i].retval!=0)
+		{
+			printf("FAILED! (job %d)\n", i);
+			bailout();
+		}
+	}
+	jobs[5].op=op;
+	printf("Passed.\n");
+	printf("--------------------\n\n");
+
+	bailout:
+	for(i=0; i<NUMJOBS; i++)
+	{
+		if(srcBufs[i]) free(srcBufs[i]);
+		if(dstBufs[i]) free(dstBufs[i]);
+		if(xformBufs[i]) tjFree(xformBufs[i]);
+		if(jobs[i].jpegBuf) tjFree(jobs[i].jpegBuf);
+	}
+	if(handle) tjDestroy(handle);
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(thandle) tjDestroy(thandle);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(dstBuf) free(dstBuf);
+}
+
+
+/* Verify that decompressing a region of a JPEG image produces the same pixels
+   as decompressing the whole image at the same scaling factor */
+void regionTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}};
+	const tjscalingfactor sfs[]={{1, 1}, {2, 1}, {1, 2}, {3, 8}};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *fullBuf=NULL, *regBuf=NULL;
+	unsigned long jpegSize=0;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, s, f, i, w, h, sw, sh, row;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<2; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Region decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+				&jpegSize, subsamp, 95, 0));
+			for(s=0; s<4; s++)
+			{
+				sw=TJSCALED(w, sfs[s]);  sh=TJSCALED(h, sfs[s]);
+				if((fullBuf=(unsigned char *)malloc(sw*sh*3))==NULL
+					|| (regBuf=(unsigned char *)malloc(sw*sh*3))==NULL)
+					_throw("Memory allocation failure");
+				for(f=0; f<2; f++)
+				{
+					int flags=(f ? TJFLAG_FASTUPSAMPLE:0);
+					_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, fullBuf, sw, 0, sh,
+						TJPF_RGB, flags));
+					for(i=0; i<8; i++)
+					{
+						tjregion r;
+						r.x=i==0 ? 0:random()%sw;  r.y=i==0 ? 0:random()%sh;
+						r.w=i==1 ? 0:random()%(sw-r.x)+1;
+						r.h=i==1 ? 0:random()%(sh-r.y)+1;
+						if(i==2) r.x=(sw>16 ? 16:0);
+						if(r.x+r.w>sw) r.w=sw-r.x;
+						if(i&1) flags|=TJFLAG_BOTTOMUP;
+						else flags&=~TJFLAG_BOTTOMUP;
+						_tj(tjDecompressRegion(dhandle, jpegBuf, jpegSize, sfs[s], r,
+							regBuf, 0, TJPF_RGB, flags));
+						if(r.w==0) r.w=sw-r.x;
+						if(r.h==0) r.h=sh-r.y;
+						for(row=0; row<r.h; row++)
+						{
+							int regRow=(flags&TJFLAG_BOTTOMUP) ? r.h-row-1:row;
+							if(memcmp(&fullBuf[((r.y+row)*sw+r.x)*3],
+								&regBuf[regRow*r.w*3], r.w*3))
+							{
+								printf("FAILED! (scale=%d/%d, region=%dx%d+%d+%d, "
+									"flags=%d)\n",
+									sfs[s].num, sfs[s].denom, r.w, r.h, r.x, r.y, flags);
+								bailout();
+							}
+						}
+					}
+				}
+				free(fullBuf);  fullBuf=NULL;
+				free(regBuf);  regBuf=NULL;
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(fullBuf) free(fullBuf);
+	if(regBuf) free(regBuf);
+}
+
+
+/* Verify that feeding a JPEG image to the decompressor in small pieces and
+   pulling the rows as they become available produces the same image as
+   decompressing all of it at once */
+void streamTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *fullBuf=NULL, *streamBuf=NULL;
+	unsigned long jpegSize=0, pos;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, r, w, h, w2, h2, s2, cs2, rows, n, suspended;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<2; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (fullBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (streamBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Streaming decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(r=0; r<2; r++)
+			{
+				putenv(r ? "TJ_RESTART=1":"TJ_RESTART=");
+				_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+					&jpegSize, subsamp, 95, 0));
+				_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, fullBuf, w, 0, h,
+					TJPF_RGB, 0));
+
+				/* Feed a few bytes at a time, and pull the rows in small groups */
+				pos=0;  rows=0;  w2=h2=0;  suspended=0;
+				memset(streamBuf, 0, w*h*3);
+				while(rows<h)
+				{
+					if(pos<jpegSize)
+					{
+						unsigned long size=random()%400+1;
+						if(size>jpegSize-pos) size=jpegSize-pos;
+						_tj(tjDecompressFeed(dhandle, &jpegBuf[pos], size));
+						pos+=size;
+						if(pos==jpegSize) _tj(tjDecompressFeed(dhandle, NULL, 0));
+					}
+					if(w2==0)
+					{
+						if((n=tjDecompressPullHeader(dhandle, &w2, &h2, &s2,
+							&cs2))==-1)
+							_throwtj();
+						if(n==1) {w2=0;  suspended=1;  continue;}
+						if(w2!=w || h2!=h || s2!=subsamp)
+						{
+							printf("FAILED! (header)\n");
+							bailout();
+						}
+					}
+					if((n=tjDecompressPull(dhandle, &streamBuf[rows*w*3], 0,
+						min(5, h-rows), TJPF_RGB, 0))==-1)
+						_throwtj();
+					if(n==0)
+					{
+						if(pos>=jpegSize)
+						{
+							printf("FAILED! (decompressor stalled)\n");
+							bailout();
+						}
+						suspended=1;
+					}
+					rows+=n;
+				}
+				if(!suspended || memcmp(fullBuf, streamBuf, w*h*3))
+				{
+					printf("FAILED! (restart interval=%d)\n", r);
+					bailout();
+				}
+			}
+
+			/* A truncated image should produce an error once the end of the data
+			   is signaled */
+			_tj(tjDecompressFeed(dhandle, jpegBuf, jpegSize/2));
+			_tj(tjDecompressFeed(dhandle, NULL, 0));
+			for(rows=0; rows<h; rows+=n)
+			{
+				if((n=tjDecompressPull(dhandle, streamBuf, 0, h, TJPF_RGB, 0))<=0)
+					break;
+			}
+			if(n!=-1)
+			{
+				printf("FAILED! (truncated image not reported)\n");
+				bailout();
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(fullBuf);  fullBuf=NULL;
+		free(streamBuf);  streamBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(fullBuf) free(fullBuf);
+	if(streamBuf) free(streamBuf);
+}
+
+
+typedef struct
+{
+	unsigned char *buf;
+	int pitch, nextRow, bandHeight, abortRow;
+} bandParams;
+
+int bandCallback(unsigned char *band, int y, int numRows, void *data)
+{
+	bandParams *params=(bandParams *)data;
+
+	if(y!=params->nextRow || numRows>params->bandHeight || y==params->abortRow)
+		return -1;
+	memcpy(&params->buf[y*params->pitch], band, numRows*params->pitch);
+	params->nextRow+=numRows;
+	return 0;
+}
+
+/* Verify that decompressing a JPEG image in bands produces the same image as
+   decompressing all of it at once */
+void bandTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}};
+	const int bandHeights[]={1, 7, 16, 1000};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *fullBuf=NULL, *bandBuf=NULL;
+	unsigned long jpegSize=0;
+	tjhandle chandle=NULL, dhandle=NULL;
+	bandParams params;
+	int subsamp, sz, b, w, h, sw, sh;
+
+	memset(&params, 0, sizeof(params));
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<2; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (fullBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (params.buf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (bandBuf=(unsigned char *)malloc(w*1000*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Band decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+				&jpegSize, subsamp, 95, 0));
+			for(b=0; b<4; b++)
+			{
+				/* Also test scaling with the last band height */
+				sw=b<3 ? w:(w+1)/2;  sh=b<3 ? h:(h+1)/2;
+				_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, fullBuf, sw, 0, sh,
+					TJPF_RGB, 0));
+				params.pitch=sw*3;  params.nextRow=0;
+				params.bandHeight=bandHeights[b];  params.abortRow=-1;
+				_tj(tjDecompressBands(dhandle, jpegBuf, jpegSize, bandBuf, sw, 0, sh,
+					bandHeights[b], TJPF_RGB, 0, bandCallback, &params));
+				if(params.nextRow!=sh || memcmp(fullBuf, params.buf, sw*sh*3))
+				{
+					printf("FAILED! (band height=%d)\n", bandHeights[b]);
+					bailout();
+				}
+			}
+
+			/* An error in the callback should abort decompression */
+			params.nextRow=0;  params.bandHeight=7;  params.abortRow=7;
+			if(tjDecompressBands(dhandle, jpegBuf, jpegSize, bandBuf, w, 0, h, 7,
+				TJPF_RGB, 0, bandCallback, &params)!=-1 || params.nextRow!=7)
+			{
+				printf("FAILED! (callback error not reported)\n");
+				bailout();
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(fullBuf);  fullBuf=NULL;
+		free(params.buf);  params.buf=NULL;
+		free(bandBuf);  bandBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(fullBuf) free(fullBuf);
+	if(params.buf) free(params.buf);
+	if(bandBuf) free(bandBuf);
+}
+
+
+typedef struct
+{
+	unsigned char *buf;
+	unsigned long size, chunkSize;
+	int numChunks, abortChunk, shortChunks;
+} chunkParams;
+
+int chunkCallback(const unsigned char *chunk, unsigned long size, void *data)
+{
+	chunkParams *params=(chunkParams *)data;
+
+	if(params->numChunks==params->abortChunk) return -1;
+	if(size!=params->chunkSize) params->shortChunks++;
+	params->buf=(unsigned char *)realloc(params->buf, params->size+size);
+	if(!params->buf) return -1;
+	memcpy(&params->buf[params->size], chunk, size);
+	params->size+=size;  params->numChunks++;
+	return 0;
+}
+
+/* Verify that pushing the rows of an image to the compressor in small groups
+   and receiving the JPEG image in chunks produces the same JPEG image as
+   compressing all of it at once */
+void compStreamTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}};
+	const unsigned long chunkSizes[]={1, 100, 65536};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL;
+	unsigned long jpegSize=0;
+	tjhandle chandle=NULL;
+	chunkParams params;
+	int subsamp, sz, c, w, h, rows, n;
+
+	memset(&params, 0, sizeof(params));
+	if((chandle=tjInitCompress())==NULL) _throwtj();
+
+	for(sz=0; sz<2; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Streaming compression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+				&jpegSize, subsamp, 95, 0));
+			for(c=0; c<3; c++)
+			{
+				free(params.buf);
+				memset(&params, 0, sizeof(params));
+				params.chunkSize=chunkSizes[c];  params.abortChunk=-1;
+				_tj(tjCompressStart(chandle, w, h, TJPF_RGB, subsamp, 95, 0,
+					chunkSizes[c], chunkCallback, &params));
+				for(rows=0; rows<h; rows+=n)
+				{
+					n=random()%20+1;
+					if(n>h-rows) n=h-rows;
+					_tj(tjCompressPush(chandle, &srcBuf[rows*w*3], 0, n));
+				}
+				_tj(tjCompressFinish(chandle));
+				if(params.size!=jpegSize || memcmp(params.buf, jpegBuf, jpegSize)
+					|| params.shortChunks>1)
+				{
+					printf("FAILED! (chunk size=%lu)\n", chunkSizes[c]);
+					bailout();
+				}
+			}
+
+			/* An error in the callback should abort compression */
+			params.size=0;  params.numChunks=0;  params.abortChunk=3;
+			if(tjCompressStart(chandle, w, h, TJPF_RGB, subsamp, 95, 0, 100,
+				chunkCallback, &params)==0)
+				tjCompressPush(chandle, srcBuf, 0, h);
+			if(tjCompressFinish(chandle)!=-1 || params.numChunks!=3)
+			{
+				printf("FAILED! (callback error not reported)\n");
+				bailout();
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	if(chandle) tjDestroy(chandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(params.buf) free(params.buf);
+}
+
+
+/* Verify that compressing an image into segments produces the same JPEG image
+   as compressing it into a single buffer, with and without multithreading */
+void segmentTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}};
+	const unsigned long segmentSizes[]={1, 100, 65536};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL;
+	unsigned long jpegSize=0, pos;
+	tjhandle chandle=NULL;
+	tjsegment *segments=NULL;
+	int numSegments=0, subsamp, sz, s, t, i, w, h;
+
+	if((chandle=tjInitCompress())==NULL) _throwtj();
+
+	for(sz=0; sz<2; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Segmented compression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(t=0; t<3; t++)
+			{
+				int flags=(t==2 ? TJFLAG_STRIPED:0);
+				_tj(tjSetNumThreads(chandle, t==0 ? 1:3));
+				_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+					&jpegSize, subsamp, 95, flags));
+				for(s=0; s<3; s++)
+				{
+					_tj(tjCompressToSegments(chandle, srcBuf, w, 0, h, TJPF_RGB,
+						&segments, &numSegments, segmentSizes[s], subsamp, 95, flags));
+					for(i=0, pos=0; i<numSegments; i++)
+					{
+						if((i<numSegments-1 && segments[i].size!=segmentSizes[s])
+							|| segments[i].size==0 || pos+segments[i].size>jpegSize
+							|| memcmp(&jpegBuf[pos], segments[i].buf, segments[i].size))
+							break;
+						pos+=segments[i].size;
+					}
+					if(i<numSegments || pos!=jpegSize)
+					{
+						printf("FAILED! (segment size=%lu, threads=%d, flags=%d)\n",
+							segmentSizes[s], t==0 ? 1:3, flags);
+						bailout();
+					}
+					tjFreeSegments(segments, numSegments);  segments=NULL;
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	if(chandle) tjDestroy(chandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(segments) tjFreeSegments(segments, numSegments);
+}
+
+
+/* Verify that decompressing a JPEG image from a list of segments of various
+   sizes produces the same image as decompressing it from a single buffer */
+void gatherTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {1200, 800}};
+	const int maxSegSizes[]={1, 1500, 40000};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *fullBuf=NULL, *segBuf=NULL;
+	unsigned long jpegSize=0, pos;
+	tjhandle chandle=NULL, dhandle=NULL;
+	tjsegment *segments=NULL;
+	int numSegments, subsamp, sz, m, w, h, w2, h2, s2, cs2;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<3; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (fullBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (segBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Scatter/gather decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+				&jpegSize, subsamp, 95, 0));
+			_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, fullBuf, w, 0, h,
+				TJPF_RGB, 0));
+			if((segments=(tjsegment *)malloc(sizeof(tjsegment)*jpegSize*2))==NULL)
+				_throw("Memory allocation failure");
+			for(m=0; m<3; m++)
+			{
+				/* Split the JPEG image into segments of random sizes, including some
+				   empty segments */
+				for(pos=0, numSegments=0; pos<jpegSize; numSegments++)
+				{
+					unsigned long size=numSegments%7==3 ?
+						0:random()%maxSegSizes[m]+1;
+					if(size>jpegSize-pos) size=jpegSize-pos;
+					segments[numSegments].buf=&jpegBuf[pos];
+					segments[numSegments].size=size;
+					pos+=size;
+				}
+				_tj(tjDecompressHeaderFromSegments(dhandle, segments, numSegments,
+					&w2, &h2, &s2, &cs2));
+				memset(segBuf, 0, w*h*3);
+				_tj(tjDecompressFromSegments(dhandle, segments, numSegments, segBuf,
+					w, 0, h, TJPF_RGB, 0));
+				if(w2!=w || h2!=h || s2!=subsamp || memcmp(fullBuf, segBuf, w*h*3))
+				{
+					printf("FAILED! (maximum segment size=%d)\n", maxSegSizes[m]);
+					bailout();
+				}
+			}
+
+			/* A truncated image should produce an error */
+			segments[0].buf=jpegBuf;  segments[0].size=jpegSize/2;
+			if(tjDecompressFromSegments(dhandle, segments, 1, segBuf, w, 0, h,
+				TJPF_RGB, 0)!=-1)
+			{
+				printf("FAILED! (truncated image not reported)\n");
+				bailout();
+			}
+			free(segments);  segments=NULL;
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(fullBuf);  fullBuf=NULL;
+		free(segBuf);  segBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(fullBuf) free(fullBuf);
+	if(segBuf) free(segBuf);
+	if(segments) free(segments);
+}
+
+
+/* Verify that compressing a baseline JPEG image with a handle that was
+   previously used to compress a Huffman-optimized JPEG image produces the
+   same JPEG image as before (that is, that the standard Huffman tables
+   replace the optimized tables left over from the previous image) */
+void stdHuffTest(void)
+{
+	int w=227, h=201, subsamp;
+	unsigned char *srcBuf=NULL, *jpegBuf1=NULL, *jpegBuf2=NULL, *optBuf=NULL;
+	unsigned long jpegSize1=0, jpegSize2=0, optSize=0;
+	tjhandle chandle=NULL;
+
+	if((chandle=tjInitCompress())==NULL) _throwtj();
+	if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL)
+		_throw("Memory allocation failure");
+	initNoisyBuf(srcBuf, w, h);
+
+	for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+	{
+		printf("Standard Huffman tables after optimization (%s) ... ",
+			subNameLong[subsamp]);
+		_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf1,
+			&jpegSize1, subsamp, 95, 0));
+		putenv("TJ_OPTIMIZE=1");
+		_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &optBuf, &optSize,
+			subsamp, 95, 0));
+		putenv("TJ_OPTIMIZE=");
+		_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf2,
+			&jpegSize2, subsamp, 95, 0));
+		if(jpegSize1!=jpegSize2 || memcmp(jpegBuf1, jpegBuf2, jpegSize1))
+		{
+			printf("FAILED!\n");
+			bailout();
+		}
+		printf("Passed.\n");
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_OPTIMIZE=");
+	if(chandle) tjDestroy(chandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf1) tjFree(jpegBuf1);
+	if(jpegBuf2) tjFree(jpegBuf2);
+	if(optBuf) tjFree(optBuf);
+}
+
+
+/* Verify that decompressing a progressive JPEG image produces the same image
+   as decompressing the equivalent baseline JPEG image, particularly when the
+   decompressor skips the scans that cannot affect a 1/8-scaled image.  For
+   4:4:4 and grayscale images, all of the scans after the DC refinement scan
+   can be skipped, so the image should decompress at 1/8 scale even if it is
+   truncated after that scan. */
+void progressiveTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}};
+	const tjscalingfactor sfs[]={{1, 8}, {1, 4}, {1, 1}};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *progBuf=NULL, *baseBuf=NULL,
+		*dstBuf=NULL;
+	unsigned long jpegSize=0, progSize=0, cut=0, pos;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, s, r, w, h, sw, sh;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<2; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (baseBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (dstBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Progressive decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(r=0; r<2; r++)
+			{
+				putenv(r ? "TJ_RESTART=1":"TJ_RESTART=");
+				_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+					&jpegSize, subsamp, 95, 0));
+				putenv("TJ_PROGRESSIVE=1");
+				_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &progBuf,
+					&progSize, subsamp, 95, 0));
+				putenv("TJ_PROGRESSIVE=");
+
+				for(s=0; s<3; s++)
+				{
+					sw=TJSCALED(w, sfs[s]);  sh=TJSCALED(h, sfs[s]);
+					_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, baseBuf, sw, 0, sh,
+						TJPF_RGB, 0));
+					memset(dstBuf, 0, sw*sh*3);
+					_tj(tjDecompress2(dhandle, progBuf, progSize, dstBuf, sw, 0, sh,
+						TJPF_RGB, 0));
+					if(memcmp(baseBuf, dstBuf, sw*sh*3))
+					{
+						printf("FAILED! (scale=%d/%d, restart=%d)\n", sfs[s].num,
+							sfs[s].denom, r);
+						bailout();
+					}
+				}
+
+				if(subsamp!=TJSAMP_444 && subsamp!=TJSAMP_GRAY) continue;
+
+				/* Truncate the image just after the SOS marker that follows the DC
+				   refinement scan (Ss=0, Ah>0.) */
+				for(pos=0, cut=0; pos+12<progSize && !cut; pos++)
+				{
+					if(progBuf[pos]==0xFF && progBuf[pos+1]==0xDA
+						&& progBuf[pos+5+progBuf[pos+4]*2]==0
+						&& (progBuf[pos+7+progBuf[pos+4]*2]>>4)>0)
+					{
+						for(pos+=2; pos+1<progSize; pos++)
+						{
+							if(progBuf[pos]==0xFF && progBuf[pos+1]==0xDA)
+							{
+								cut=pos+2;  break;
+							}
+						}
+					}
+				}
+				if(!cut)
+				{
+					printf("FAILED! (no DC refinement scan)\n");
+					bailout();
+				}
+				sw=TJSCALED(w, sfs[0]);  sh=TJSCALED(h, sfs[0]);
+				_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, baseBuf, sw, 0, sh,
+					TJPF_RGB, 0));
+				memset(dstBuf, 0, sw*sh*3);
+				_tj(tjDecompress2(dhandle, progBuf, cut, dstBuf, sw, 0, sh, TJPF_RGB,
+					0));
+				if(memcmp(baseBuf, dstBuf, sw*sh*3))
+				{
+					printf("FAILED! (truncated image, restart=%d)\n", r);
+					bailout();
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(baseBuf);  baseBuf=NULL;
+		free(dstBuf);  dstBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	putenv("TJ_PROGRESSIVE=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(progBuf) tjFree(progBuf);
+	if(baseBuf) free(baseBuf);
+	if(dstBuf) free(dstBuf);
+}
+
+
+/* Verify that decompressing a JPEG image to 1/8 scale, in which case the
+   Huffman decoder discards the AC coefficients using a skip table, produces the
+   same image as decompressing the same image with restart markers (which
+   causes the Huffman decoder to take its slow path, which does not use the skip
+   table.)  Noisy images at quality 100 ensure that some blocks have nonzero
+   coefficients all the way to the end of the block. */
+void thumbnailTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {1200, 800}};
+	const int quals[]={100, 75, 10};
+	const tjscalingfactor sf={1, 8};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *rstBuf=NULL, *dstBuf=NULL,
+		*refBuf=NULL;
+	unsigned long jpegSize=0, rstSize=0;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, q, i, w, h, sw, sh;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<3; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		sw=TJSCALED(w, sf);  sh=TJSCALED(h, sf);
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (dstBuf=(unsigned char *)malloc(sw*sh*3))==NULL
+			|| (refBuf=(unsigned char *)malloc(sw*sh*3))==NULL)
+			_throw("Memory allocation failure");
+		for(i=0; i<w*h*3; i++)
+			srcBuf[i]=(unsigned char)((i/3)%w+(i/(w*3))*2
+				+random()%(i%7==0 ? 256:32));
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("1/8-scale decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(q=0; q<3; q++)
+			{
+				_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+					&jpegSize, subsamp, quals[q], 0));
+				putenv("TJ_RESTART=1");
+				_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &rstBuf,
+					&rstSize, subsamp, quals[q], 0));
+				putenv("TJ_RESTART=");
+				memset(dstBuf, 0, sw*sh*3);
+				_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, sw, 0, sh,
+					TJPF_RGB, 0));
+				_tj(tjDecompress2(dhandle, rstBuf, rstSize, refBuf, sw, 0, sh,
+					TJPF_RGB, 0));
+				if(memcmp(dstBuf, refBuf, sw*sh*3))
+				{
+					printf("FAILED! (quality=%d)\n", quals[q]);
+					bailout();
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(dstBuf);  dstBuf=NULL;
+		free(refBuf);  refBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(rstBuf) tjFree(rstBuf);
+	if(dstBuf) free(dstBuf);
+	if(refBuf) free(refBuf);
+}
+
+
+/* Verify that decompressing an image using a random-access index produces the
+   same image as decompressing it without one, that an index is ignored when
+   decompressing a different image, and that invalid indices are rejected */
+void indexTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {1200, 800}};
+	const int intervals[]={1, 3};
+	const tjscalingfactor sfs[]={{1, 1}, {1, 2}};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *indexBuf=NULL, *fullBuf=NULL,
+		*regBuf=NULL, grayBuf[64];
+	unsigned long jpegSize=0, indexSize=0;
+	tjhandle chandle=NULL, dhandle=NULL, refhandle=NULL;
+	int subsamp, sz, n, s, i, w, h, sw, sh, row;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL
+		|| (refhandle=tjInitDecompress())==NULL)
+		_throwtj();
+	_tj(tjSetNumThreads(dhandle, 4));
+
+	for(sz=0; sz<3; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (fullBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (regBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		initNoisyBuf(srcBuf, w, h);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Indexed decompression (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+				&jpegSize, subsamp, 95, 0));
+
+			/* The first pass uses the index of the previous image (if any), which
+			   must be ignored. */
+			for(n=-1; n<2; n++)
+			{
+				if(n>=0)
+				{
+					_tj(tjBuildIndex(dhandle, jpegBuf, jpegSize, intervals[n],
+						&indexBuf, &indexSize));
+					if(indexSize<32 || (indexSize-32)%36
+						|| (sz==2 && indexSize==32))
+					{
+						printf("FAILED! (index size=%lu)\n", indexSize);
+						bailout();
+					}
+					_tj(tjSetIndex(dhandle, indexBuf, indexSize));
+					tjFree(indexBuf);  indexBuf=NULL;
+				}
+				for(s=0; s<2; s++)
+				{
+					sw=TJSCALED(w, sfs[s]);  sh=TJSCALED(h, sfs[s]);
+					_tj(tjDecompress2(refhandle, jpegBuf, jpegSize, fullBuf, sw, 0,
+						sh, TJPF_RGB, 0));
+					_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, regBuf, sw, 0, sh,
+						TJPF_RGB, 0));
+					if(memcmp(fullBuf, regBuf, sw*sh*3))
+					{
+						printf("FAILED! (interval=%d, scale=%d/%d)\n",
+							n>=0 ? intervals[n]:0, sfs[s].num, sfs[s].denom);
+						bailout();
+					}
+					for(i=0; i<6; i++)
+					{
+						tjregion r;
+						r.x=random()%sw;  r.y=i==0 ? sh-1:random()%sh;
+						r.w=random()%(sw-r.x)+1;  r.h=random()%(sh-r.y)+1;
+						_tj(tjDecompressRegion(dhandle, jpegBuf, jpegSize, sfs[s], r,
+							regBuf, 0, TJPF_RGB, 0));
+						for(row=0; row<r.h; row++)
+						{
+							if(memcmp(&fullBuf[((r.y+row)*sw+r.x)*3], &regBuf[row*r.w*3],
+								r.w*3))
+							{
+								printf("FAILED! (interval=%d, scale=%d/%d, "
+									"region=%dx%d+%d+%d)\n", n>=0 ? intervals[n]:0,
+									sfs[s].num, sfs[s].denom, r.w, r.h, r.x, r.y);
+								bailout();
+							}
+						}
+					}
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(fullBuf);  fullBuf=NULL;
+		free(regBuf);  regBuf=NULL;
+	}
+
+	printf("Invalid indices ... ");
+	_tj(tjBuildIndex(dhandle, jpegBuf, jpegSize, 2, &indexBuf, &indexSize));
+	if(tjSetIndex(dhandle, indexBuf, indexSize-1)!=-1
+		|| tjSetIndex(dhandle, indexBuf, 31)!=-1)
+	{
+		printf("FAILED! (truncated index was accepted)\n");
+		bailout();
+	}
+	indexBuf[0]='X';
+	if(tjSetIndex(dhandle, indexBuf, indexSize)!=-1)
+	{
+		printf("FAILED! (corrupt index was accepted)\n");
+		bailout();
+	}
+	putenv("TJ_PROGRESSIVE=1");
+	memset(grayBuf, 128, 64);
+	_tj(tjCompress2(chandle, grayBuf, 8, 0, 8, TJPF_GRAY, &jpegBuf, &jpegSize,
+		TJSAMP_GRAY, 95, 0));
+	putenv("TJ_PROGRESSIVE=");
+	tjFree(indexBuf);  indexBuf=NULL;
+	if(tjBuildIndex(dhandle, jpegBuf, jpegSize, 1, &indexBuf, &indexSize)!=-1)
+	{
+		printf("FAILED! (progressive image was indexed)\n");
+		bailout();
+	}
+	_tj(tjSetIndex(dhandle, NULL, 0));
+	printf("Passed.\n");
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_PROGRESSIVE=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(refhandle) tjDestroy(refhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(indexBuf) tjFree(indexBuf);
+	if(fullBuf) free(fullBuf);
+	if(regBuf) free(regBuf);
+}
+
+
+/* Verify that a decompressor produces the same images as a new decompressor
+   when it is reused for images with many different Huffman tables (which
+   exercises the decompressor's cache of Huffman lookup tables) */
+#define NUMIMAGES 7
+
+void huffCacheTest(void)
+{
+	const int w=227, h=201;
+	unsigned char *srcBuf=NULL, *jpegBuf[NUMIMAGES], *dstBuf=NULL, *refBuf=NULL;
+	unsigned long jpegSize[NUMIMAGES];
+	tjhandle chandle=NULL, dhandle=NULL, refhandle=NULL;
+	int n, pass, i;
+
+	for(n=0; n<NUMIMAGES; n++) {jpegBuf[n]=NULL;  jpegSize[n]=0;}
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+	if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+		|| (dstBuf=(unsigned char *)malloc(w*h*3))==NULL
+		|| (refBuf=(unsigned char *)malloc(w*h*3))==NULL)
+		_throw("Memory allocation failure");
+
+	printf("Huffman table cache ... ");
+	/* Images 0 and 3 use the standard Huffman tables.  The others use optimal
+	   tables, which differ because the images have different amounts of noise.
+	   Images 0 and 2 are grayscale, so when image 3 is decompressed after
+	   images 0-2, its luminance table is in the cache but its chrominance table
+	   is not.  The images are large enough that most MCUs are decoded using the
+	   cached tables. */
+	for(n=0; n<NUMIMAGES; n++)
+	{
+		for(i=0; i<w*h*3; i++)
+			srcBuf[i]=(unsigned char)((i/3)%w*3+(i/(w*3))+random()%(4<<n));
+		if(n!=0 && n!=3) putenv("TJ_OPTIMIZE=1");
+		_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf[n],
+			&jpegSize[n], n==0 || n==2 ? TJSAMP_GRAY:n%2 ? TJSAMP_420:TJSAMP_444,
+			90, 0));
+		putenv("TJ_OPTIMIZE=");
+	}
+	for(pass=0; pass<2; pass++)
+	{
+		for(n=0; n<NUMIMAGES; n++)
+		{
+			int m=pass ? NUMIMAGES-1-n:n;
+			if((refhandle=tjInitDecompress())==NULL) _throwtj();
+			_tj(tjDecompress2(refhandle, jpegBuf[m], jpegSize[m], refBuf, w, 0, h,
+				TJPF_RGB, 0));
+			tjDestroy(refhandle);  refhandle=NULL;
+			_tj(tjDecompress2(dhandle, jpegBuf[m], jpegSize[m], dstBuf, w, 0, h,
+				TJPF_RGB, 0));
+			if(memcmp(dstBuf, refBuf, w*h*3))
+			{
+				printf("FAILED! (image %d, pass %d)\n", m, pass);
+				bailout();
+			}
+		}
+	}
+	printf("Passed.\n");
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_OPTIMIZE=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(refhandle) tjDestroy(refhandle);
+	if(srcBuf) free(srcBuf);
+	for(n=0; n<NUMIMAGES; n++)
+		if(jpegBuf[n]) tjFree(jpegBuf[n]);
+	if(dstBuf) free(dstBuf);
+	if(refBuf) free(refBuf);
+}
+
+/* Verify that optimized Huffman coding, which TurboJPEG performs in a single
+   pass by recording the Huffman symbols of the image, produces the same
+   decompressed image as the standard Huffman tables, and that it never produces
+   a larger JPEG image. */
+void optimizeTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {1, 1}};
+	const int quals[]={100, 75, 10};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *optBuf=NULL, *dstBuf=NULL,
+		*refBuf=NULL;
+	unsigned long jpegSize=0, optSize=0;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, q, r, i, w, h;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<3; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (dstBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (refBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		for(i=0; i<w*h*3; i++)
+			srcBuf[i]=(unsigned char)((i/3)%w+(i/(w*3))*3+random()%64);
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Optimized Huffman coding (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(q=0; q<3; q++)
+			{
+				for(r=0; r<2; r++)
+				{
+					putenv(r ? "TJ_RESTART=1":"TJ_RESTART=");
+					_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+						&jpegSize, subsamp, quals[q], 0));
+					putenv("TJ_OPTIMIZE=1");
+					_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &optBuf,
+						&optSize, subsamp, quals[q], 0));
+					putenv("TJ_OPTIMIZE=");
+					if(optSize>jpegSize)
+					{
+						printf("FAILED! (quality=%d, restart=%d, %lu > %lu bytes)\n",
+							quals[q], r, optSize, jpegSize);
+						bailout();
+					}
+
+					_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, refBuf, w, 0, h,
+						TJPF_RGB, 0));
+					memset(dstBuf, 0, w*h*3);
+					_tj(tjDecompress2(dhandle, optBuf, optSize, dstBuf, w, 0, h,
+						TJPF_RGB, 0));
+					if(memcmp(refBuf, dstBuf, w*h*3))
+					{
+						printf("FAILED! (quality=%d, restart=%d)\n", quals[q], r);
+						bailout();
+					}
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(dstBuf);  dstBuf=NULL;
+		free(refBuf);  refBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	putenv("TJ_OPTIMIZE=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(optBuf) tjFree(optBuf);
+	if(dstBuf) free(dstBuf);
+	if(refBuf) free(refBuf);
+}
+
+/* Verify that choosing pre-trained Huffman tables from a sample of the image
+   produces the same decompressed image as the standard Huffman tables,
+   including for images that are shorter than the sample, images with restart
+   markers, progressive images (which ignore the pre-trained tables), and
+   images that are compressed by multiple threads. */
+void pretrainedTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {1, 1}, {67, 1200}};
+	const int quals[]={100, 75, 10};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *preBuf=NULL, *dstBuf=NULL,
+		*refBuf=NULL;
+	unsigned long jpegSize=0, preSize=0;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, q, m, i, w, h;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<4; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (dstBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (refBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		for(i=0; i<w*h*3; i++)
+			srcBuf[i]=(unsigned char)((i/3)%w*5+(i/(w*3))+random()%(8<<sz));
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Pre-trained Huffman tables (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(q=0; q<3; q++)
+			{
+				/* m=0: standard, m=1: restart markers, m=2: progressive,
+				   m=3: multithreaded */
+				for(m=0; m<4; m++)
+				{
+					putenv(m==1 ? "TJ_RESTART=1":"TJ_RESTART=");
+					putenv(m==2 ? "TJ_PROGRESSIVE=1":"TJ_PROGRESSIVE=");
+					_tj(tjSetNumThreads(chandle, m==3 ? 3:1));
+					_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+						&jpegSize, subsamp, quals[q], 0));
+					_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &preBuf,
+						&preSize, subsamp, quals[q], TJFLAG_PRETRAINED));
+
+					_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, refBuf, w, 0, h,
+						TJPF_RGB, 0));
+					memset(dstBuf, 0, w*h*3);
+					_tj(tjDecompress2(dhandle, preBuf, preSize, dstBuf, w, 0, h,
+						TJPF_RGB, 0));
+					if(memcmp(refBuf, dstBuf, w*h*3))
+					{
+						printf("FAILED! (quality=%d, mode=%d)\n", quals[q], m);
+						bailout();
+					}
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(dstBuf);  dstBuf=NULL;
+		free(refBuf);  refBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	putenv("TJ_PROGRESSIVE=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(preBuf) tjFree(preBuf);
+	if(dstBuf) free(dstBuf);
+	if(refBuf) free(refBuf);
+}
+
+
+/* Verify that an arithmetic-coded JPEG image decompresses to the same image as
+   a Huffman-coded JPEG image with the same quantized coefficients.  The noisy
+   source image and the range of sizes and restart intervals ensure that the
+   arithmetic decoder reads ahead across stuffed zero bytes and hits markers at
+   various points in its input window. */
+void arithmeticTest(void)
+{
+	const int sizes[][2]={{227, 201}, {48, 17}, {1, 1}, {67, 1200}};
+	const int quals[]={100, 75, 10};
+	unsigned char *srcBuf=NULL, *jpegBuf=NULL, *ariBuf=NULL, *dstBuf=NULL,
+		*refBuf=NULL;
+	unsigned long jpegSize=0, ariSize=0;
+	tjhandle chandle=NULL, dhandle=NULL;
+	int subsamp, sz, q, m, i, w, h;
+
+	if((chandle=tjInitCompress())==NULL || (dhandle=tjInitDecompress())==NULL)
+		_throwtj();
+
+	for(sz=0; sz<4; sz++)
+	{
+		w=sizes[sz][0];  h=sizes[sz][1];
+		if((srcBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (dstBuf=(unsigned char *)malloc(w*h*3))==NULL
+			|| (refBuf=(unsigned char *)malloc(w*h*3))==NULL)
+			_throw("Memory allocation failure");
+		for(i=0; i<w*h*3; i++)
+			srcBuf[i]=(unsigned char)((i/3)%w*5+(i/(w*3))+random()%(8<<sz));
+
+		for(subsamp=0; subsamp<TJ_NUMSAMP; subsamp++)
+		{
+			printf("Arithmetic decoding (%d x %d, %s) ... ", w, h,
+				subNameLong[subsamp]);
+			for(q=0; q<3; q++)
+			{
+				/* m=0: sequential, m=1: sequential with restart markers,
+				   m=2: progressive, m=3: progressive with restart markers */
+				for(m=0; m<4; m++)
+				{
+					putenv(m&1 ? "TJ_RESTART=1B":"TJ_RESTART=");
+					putenv(m&2 ? "TJ_PROGRESSIVE=1":"TJ_PROGRESSIVE=");
+					_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf,
+						&jpegSize, subsamp, quals[q], 0));
+					putenv("TJ_ARITHMETIC=1");
+					_tj(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &ariBuf,
+						&ariSize, subsamp, quals[q], 0));
+					putenv("TJ_ARITHMETIC=");
+
+					_tj(tjDecompress2(dhandle, jpegBuf, jpegSize, refBuf, w, 0, h,
+						TJPF_RGB, 0));
+					memset(dstBuf, 0, w*h*3);
+					_tj(tjDecompress2(dhandle, ariBuf, ariSize, dstBuf, w, 0, h,
+						TJPF_RGB, 0));
+					if(memcmp(refBuf, dstBuf, w*h*3))
+					{
+						printf("FAILED! (quality=%d, mode=%d)\n", quals[q], m);
+						bailout();
+					}
+				}
+			}
+			printf("Passed.\n");
+		}
+		free(srcBuf);  srcBuf=NULL;
+		free(dstBuf);  dstBuf=NULL;
+		free(refBuf);  refBuf=NULL;
+	}
+	printf("--------------------\n\n");
+
+	bailout:
+	putenv("TJ_RESTART=");
+	putenv("TJ_PROGRESSIVE=");
+	putenv("TJ_ARITHMETIC=");
+	if(chandle) tjDestroy(chandle);
+	if(dhandle) tjDestroy(dhandle);
+	if(srcBuf) free(srcBuf);
+	if(jpegBuf) tjFree(jpegBuf);
+	if(ariBuf) tjFree(ariBuf);
+	if(dstBuf) free(dstBuf);
+	if(refBuf) free(refBuf);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int i, num4bf=5;
+	#ifdef _WIN32
+	srand((unsigned int)time(NULL));
+	#endif
+	if(argc>1)
+	{
+		for(i=1; i<argc; i++)
+		{
+			if(!strcasecmp(argv[i], "-yuv")) doyuv=1;
+			if(!strcasecmp(argv[i], "-noyuvpad")) pad=1;
+			if(!strcasecmp(argv[i], "-alloc")) alloc=1;
+			if(!strncasecmp(argv[i], "-h", 2) || !strcasecmp(argv[i], "-?"))
+				usage(argv[0]);
+		}
+	}
+	if(alloc) printf("Testing automatic buffer allocation\n");
+	if(doyuv) num4bf=4;
+	doTest(35, 39, _3byteFormats, 2, TJSAMP_444, "test");
+	doTest(39, 41, _4byteFormats, num4bf, TJSAMP_444, "test");
+	doTest(41, 35, _3byteFormats, 2, TJSAMP_422, "test");
+	doTest(35, 39, _4byteFormats, num4bf, TJSAMP_422, "test");
+	doTest(39, 41, _3byteFormats, 2, TJSAMP_420, "test");
+	doTest(41, 35, _4byteFormats, num4bf, TJSAMP_420, "test");
+	doTest(35, 39, _3byteFormats, 2, TJSAMP_440, "test");
+	doTest(39, 41, _4byteFormats, num4bf, TJSAMP_440, "test");
+	doTest(41, 35, _3byteFormats, 2, TJSAMP_411, "test");
+	doTest(35, 39, _4byteFormats, num4bf, TJSAMP_411, "test");
+	doTest(39, 41, _onlyGray, 1, TJSAMP_GRAY, "test");
+	doTest(41, 35, _3byteFormats, 2, TJSAMP_GRAY, "test");
+	doTest(35, 39, _4byteFormats, 4, TJSAMP_GRAY, "test");
+	bufSizeTest();
+	if(!doyuv)
+	{
+		threadTest();
+		stripeTest();
+		pipelineTest();
+		batchTest();
+		regionTest();
+		streamTest();
+		bandTest();
+		compStreamTest();
+		segmentTest();
+		gatherTest();
+		stdHuffTest();
+		progressiveTest();
+		thumbnailTest();
+		indexTest();
+		huffCacheTest();
+		optimizeTest();
+		pretrainedTest();
+		arithmeticTest();
+	}
 	if(doyuv)
 	{
 		printf("\n--------------------\n\n");
@@ -94,6 +94,7 @@ int ProcessSystemProperties(JNIEnv *env)
 	prop2env("turbojpeg.arithmetic", "TJ_ARITHMETIC");
 	prop2env("turbojpeg.restart", "TJ_RESTART");
 	prop2env("turbojpeg.progressive", "TJ_PROGRESSIVE");
+	prop2env("turbojpeg.pretrained", "TJ_PRETRAINED");
 	return 0;
 
 	bailout:
@@ -41,6 +41,7 @@
 #include "./tjutil.h"
 #include "transupp.h"
 #include "./jpegcomp.h"
+#include "./tjthread.h"
 
 extern void jpeg_mem_dest_tj(j_compress_ptr, unsigned char **,
 	unsigned long *, boolean);
@@ -53,7 +54,7 @@ extern void jpeg_mem_src_tj(j_decompress_ptr, const unsigned char *,
 
 /* Error handling (based on example in example.c) */
 
-static char errStr[JMSG_LENGTH_MAX]="No error";
+static TJ_THREAD_LOCAL char errStr[JMSG_LENGTH_MAX]="No error";
 
 struct my_error_mgr
 {
@@ -96,8 +97,51 @@ typedef struct _tjinstance
 	struct jpeg_decompress_struct dinfo;
 	struct my_error_mgr jerr;
 	int init, headerRead;
+	int numThreads, numWorkers;
+	struct _tjworker **workers;
+	struct _tjpool *pool;
+	struct _tjstream *stream;
+	struct _tjcstream *cstream;
+	struct _tjindex *index;
 } tjinstance;
 
+/* Suspending source manager used by the streaming decompression functions.
+   The JPEG data that has been fed but not yet consumed by the decompressor is
+   kept in buf. */
+enum {STREAM_IDLE=0, STREAM_HEADER, STREAM_START, STREAM_SCANNING};
+
+typedef struct _tjstream
+{
+	struct jpeg_source_mgr pub;
+	JOCTET *buf;
+	size_t bufSize, skip;
+	boolean eof;
+	int state, pixelFormat, flags;
+} tjstream;
+
+/* Destination manager used by the streaming compression functions.  The
+   compressed data is passed to the callback each time buf fills. */
+typedef struct _tjcstream
+{
+	struct jpeg_destination_mgr pub;
+	JOCTET *buf;
+	size_t bufSize;
+	int (*callback)(const unsigned char *, unsigned long, void *);
+	void *callbackData;
+	int active, callbackFailed, pixelFormat;
+} tjcstream;
+
+/* Random-access index attached by tjSetIndex().  The size of the JPEG image
+   and a hash of its headers identify the image that was indexed. */
+typedef struct _tjindex
+{
+	unsigned long jpegSize;
+	unsigned int headerSize, headerHash;
+	JDIMENSION totalIMCURows;
+	int compsInScan, numCheckpoints;
+	jpeg_entropy_checkpoint *checkpoints;
+} tjindex;
+
 static const int pixelsize[TJ_NUMSAMP]={3, 3, 3, 1, 3, 3};
 
 static const JXFORM_CODE xformtypes[TJ_NUMXOP]=
@@ -218,10 +262,17 @@ static int setCompDefaults(struct jpeg_compress_struct *cinfo,
 
 	cinfo->input_components=tjPixelSize[pixelFormat];
 	jpeg_set_defaults(cinfo);
+	/* If optimized Huffman coding is requested, then generate the optimal tables
+	   and the compressed data in a single pass over the image. */
+	cinfo->master->huff_symbol_stream=TRUE;
+	cinfo->master->huff_pretrained=(flags&TJFLAG_PRETRAINED) ? TRUE:FALSE;
 
 #ifndef NO_GETENV
 	if((env=getenv("TJ_OPTIMIZE"))!=NULL && strlen(env)>0 && !strcmp(env, "1"))
 		cinfo->optimize_coding=TRUE;
+	if((env=getenv("TJ_PRETRAINED"))!=NULL && strlen(env)>0
+		&& !strcmp(env, "1"))
+		cinfo->master->huff_pretrained=TRUE;
 	if((env=getenv("TJ_ARITHMETIC"))!=NULL && strlen(env)>0	&& !strcmp(env, "1"))
 		cinfo->arith_code=TRUE;
 	if((env=getenv("TJ_RESTART"))!=NULL && strlen(env)>0)
@@ -324,6 +375,10 @@ static int setDecompDefaults(struct jpeg_decompress_struct *dinfo,
 	}
 
 	if(flags&TJFLAG_FASTDCT) dinfo->dct_method=JDCT_FASTEST;
+	/* Each TurboJPEG decompression operation reads one image from its own
+	   buffer, so there is no need to read past the scans that affect a
+	   DC-only (1/8-scaled) image. */
+	dinfo->master->dc_only_stop=TRUE;
 
 	bailout:
 	return retval;
@@ -540,6 +595,298 @@ static void fromRGB(unsigned char *src, unsigned char *dst, int width,
 #endif
 
 
+/* Worker threads */
+
+typedef struct _tjworker
+{
+	struct jpeg_compress_struct cinfo;
+	struct jpeg_decompress_struct dinfo;
+	struct my_error_mgr jerr;
+	char errStr[JMSG_LENGTH_MAX];
+	int init;
+	tjthread thread;
+	const void *job;
+	int index, startRow, endRow, retval;
+	int threaded;  /* set by runWorkers() if the worker has its own thread */
+} tjworker;
+
+static void my_output_message_worker(j_common_ptr cinfo)
+{
+	tjworker *worker=(tjworker *)cinfo->client_data;
+	(*cinfo->err->format_message)(cinfo, worker->errStr);
+}
+
+static void destroyWorkers(tjinstance *this)
+{
+	int i;
+	for(i=0; i<this->numWorkers; i++)
+	{
+		if(this->workers[i]->init&COMPRESS)
+			jpeg_destroy_compress(&this->workers[i]->cinfo);
+		if(this->workers[i]->init&DECOMPRESS)
+			jpeg_destroy_decompress(&this->workers[i]->dinfo);
+		free(this->workers[i]);
+	}
+	if(this->workers) free(this->workers);
+	this->workers=NULL;  this->numWorkers=0;
+}
+
+/* Make sure that at least numWorkers workers exist and that each has been
+   initialized for the given type of operation (COMPRESS or DECOMPRESS.)  The
+   workers are retained by the TurboJPEG instance so that their memory pools
+   can be reused by subsequent calls. */
+static int initWorkers(tjinstance *this, int numWorkers, int type)
+{
+	tjworker **workers, *worker;  int i;
+
+	if(numWorkers>this->numWorkers)
+	{
+		if((workers=(tjworker **)realloc(this->workers,
+			sizeof(tjworker *)*numWorkers))==NULL)
+			return -1;
+		this->workers=workers;
+		while(this->numWorkers<numWorkers)
+		{
+			if((worker=(tjworker *)malloc(sizeof(tjworker)))==NULL) return -1;
+			MEMZERO(worker, sizeof(tjworker));
+			workers[this->numWorkers++]=worker;
+		}
+	}
+
+	for(i=0; i<numWorkers; i++)
+	{
+		worker=this->workers[i];
+		if(worker->init&type) continue;
+		jpeg_std_error(&worker->jerr.pub);
+		worker->jerr.pub.error_exit=my_error_exit;
+		worker->jerr.pub.output_message=my_output_message_worker;
+		worker->jerr.emit_message=worker->jerr.pub.emit_message;
+		worker->jerr.pub.emit_message=my_emit_message;
+		if(setjmp(worker->jerr.setjmp_buffer)) return -1;
+		if(type==COMPRESS)
+		{
+			worker->cinfo.err=&worker->jerr.pub;
+			jpeg_create_compress(&worker->cinfo);
+			jpeg_mem_retain((j_common_ptr)&worker->cinfo, TRUE);
+			worker->cinfo.client_data=worker;
+		}
+		else
+		{
+			worker->dinfo.err=&worker->jerr.pub;
+			jpeg_create_decompress(&worker->dinfo);
+			jpeg_mem_retain((j_common_ptr)&worker->dinfo, TRUE);
+			worker->dinfo.client_data=worker;
+		}
+		worker->init|=type;
+	}
+	return 0;
+}
+
+/* Run func() for each of the first numWorkers workers, using a separate thread
+   for all but the first.  If a thread cannot be created, then that worker's
+   job is run in the calling thread instead.  Returns the index of the first
+   worker that failed, or -1 if all succeeded. */
+static int runWorkers(tjinstance *this, int numWorkers, void (*func)(void *),
+	const void *job)
+{
+	int i, j, numThreads;
+
+	for(i=0; i<numWorkers; i++)
+	{
+		this->workers[i]->index=i;
+		this->workers[i]->job=job;
+		this->workers[i]->threaded=(i>0);
+	}
+	for(numThreads=1; numThreads<numWorkers; numThreads++)
+	{
+		if(tjThreadCreate(&this->workers[numThreads]->thread, func,
+			this->workers[numThreads])==-1)
+			break;
+	}
+	for(j=numThreads; j<numWorkers; j++) this->workers[j]->threaded=0;
+	func(this->workers[0]);
+	for(j=1; j<numWorkers; j++)
+	{
+		if(j<numThreads) tjThreadJoin(&this->workers[j]->thread);
+		else func(this->workers[j]);
+	}
+
+	for(i=0; i<numWorkers; i++)
+		if(this->workers[i]->retval==-1) return i;
+	return -1;
+}
+
+
+/* Batch processing.  Each thread in the pool owns a contiguous range of the
+   jobs and takes jobs from the front of that range.  A thread whose range is
+   empty steals the back half of the largest remaining range. */
+
+typedef struct _tjpoolworker
+{
+	struct _tjpool *pool;
+	tjhandle handle;
+	tjthread thread;
+	int first, last;  /* range of jobs not yet taken */
+} tjpoolworker;
+
+typedef struct _tjpool
+{
+	tjmutex mutex;
+	tjcond cond;
+	tjpoolworker *workers;
+	int numWorkers, numThreads;  /* numWorkers includes the calling thread */
+	tjjob *jobs;
+	unsigned int batch;  /* incremented when a new batch is started */
+	int busy;  /* # of pool threads still working on the current batch */
+	int shutdown;
+} tjpool;
+
+static void runJob(tjpoolworker *worker, tjjob *job)
+{
+	if(!worker->handle && (worker->handle=tjInitTransform())==NULL)
+		job->retval=-1;
+	else switch(job->op)
+	{
+		case TJOP_DECOMPRESS:
+			job->retval=tjDecompress2(worker->handle, job->jpegBuf, job->jpegSize,
+				job->buf, job->width, job->pitch, job->height, job->pixelFormat,
+				job->flags);
+			break;
+		case TJOP_COMPRESS:
+			job->retval=tjCompress2(worker->handle, job->buf, job->width,
+				job->pitch, job->height, job->pixelFormat, &job->jpegBuf,
+				&job->jpegSize, job->jpegSubsamp, job->jpegQual, job->flags);
+			break;
+		case TJOP_TRANSFORM:
+			job->retval=tjTransform(worker->handle, job->jpegBuf, job->jpegSize,
+				job->n, job->dstBufs, job->dstSizes, job->transforms, job->flags);
+			break;
+		default:
+			snprintf(errStr, JMSG_LENGTH_MAX, "tjBatch(): Invalid operation");
+			job->retval=-1;
+	}
+	if(job->retval==-1) snprintf(job->errStr, TJ_ERRSTR_LENGTH, "%s", errStr);
+	else job->errStr[0]=0;
+}
+
+static void runJobs(tjpoolworker *worker)
+{
+	tjpool *pool=worker->pool;
+	tjpoolworker *victim;
+	int i, n;
+
+	for(;;)
+	{
+		tjMutexLock(&pool->mutex);
+		if(worker->first>=worker->last)
+		{
+			for(victim=NULL, i=0; i<pool->numWorkers; i++)
+			{
+				if(!victim || pool->workers[i].last-pool->workers[i].first
+					>victim->last-victim->first)
+					victim=&pool->workers[i];
+			}
+			if((n=(victim->last-victim->first+1)/2)==0)
+			{
+				tjMutexUnlock(&pool->mutex);
+				return;
+			}
+			worker->last=victim->last;
+			worker->first=victim->last=victim->last-n;
+		}
+		i=worker->first++;
+		tjMutexUnlock(&pool->mutex);
+
+		runJob(worker, &pool->jobs[i]);
+	}
+}
+
+static void poolThread(void *arg)
+{
+	tjpoolworker *worker=(tjpoolworker *)arg;
+	tjpool *pool=worker->pool;
+	unsigned int batch=0;
+
+	tjMutexLock(&pool->mutex);
+	for(;;)
+	{
+		while(pool->batch==batch && !pool->shutdown)
+			tjCondWait(&pool->cond, &pool->mutex);
+		if(pool->shutdown) break;
+		batch=pool->batch;
+		tjMutexUnlock(&pool->mutex);
+
+		runJobs(worker);
+
+		tjMutexLock(&pool->mutex);
+		if(--pool->busy==0) tjCondBroadcast(&pool->cond);
+	}
+	tjMutexUnlock(&pool->mutex);
+}
+
+static void destroyPool(tjinstance *this)
+{
+	tjpool *pool=this->pool;
+	int i;
+
+	if(!pool) return;
+	tjMutexLock(&pool->mutex);
+	pool->shutdown=1;
+	tjCondBroadcast(&pool->cond);
+	tjMutexUnlock(&pool->mutex);
+	for(i=1; i<=pool->numThreads; i++)
+		tjThreadJoin(&pool->workers[i].thread);
+	for(i=0; i<pool->numWorkers; i++)
+		if(pool->workers[i].handle) tjDestroy(pool->workers[i].handle);
+	tjCondDestroy(&pool->cond);
+	tjMutexDestroy(&pool->mutex);
+	free(pool->workers);
+	free(pool);
+	this->pool=NULL;
+}
+
+/* Make sure that a pool with this->numThreads workers exists.  If some of the
+   threads cannot be created, then the pool uses fewer workers. */
+static int initPool(tjinstance *this)
+{
+	tjpool *pool=this->pool;
+
+	if(pool && pool->numWorkers==max(this->numThreads, 1)) return 0;
+	destroyPool(this);
+
+	if((pool=(tjpool *)malloc(sizeof(tjpool)))==NULL) return -1;
+	MEMZERO(pool, sizeof(tjpool));
+	pool->numWorkers=max(this->numThreads, 1);
+	if((pool->workers=(tjpoolworker *)malloc(
+		sizeof(tjpoolworker)*pool->numWorkers))==NULL)
+	{
+		free(pool);  return -1;
+	}
+	MEMZERO(pool->workers, sizeof(tjpoolworker)*pool->numWorkers);
+	if(tjMutexInit(&pool->mutex)==-1)
+	{
+		free(pool->workers);  free(pool);  return -1;
+	}
+	if(tjCondInit(&pool->cond)==-1)
+	{
+		tjMutexDestroy(&pool->mutex);  free(pool->workers);  free(pool);
+		return -1;
+	}
+	this->pool=pool;
+
+	pool->workers[0].pool=pool;
+	while(pool->numThreads<pool->numWorkers-1)
+	{
+		tjpoolworker *worker=&pool->workers[pool->numThreads+1];
+		worker->pool=pool;
+		if(tjThreadCreate(&worker->thread, poolThread, worker)==-1) break;
+		pool->numThreads++;
+	}
+	pool->numWorkers=pool->numThreads+1;
+	return 0;
+}
+
+
 /* General API functions */
 
 DLLEXPORT char* DLLCALL tjGetErrorStr(void)
@@ -554,11 +901,86 @@ DLLEXPORT int DLLCALL tjDestroy(tjhandle handle)
 	if(setjmp(this->jerr.setjmp_buffer)) return -1;
 	if(this->init&COMPRESS) jpeg_destroy_compress(cinfo);
 	if(this->init&DECOMPRESS) jpeg_destroy_decompress(dinfo);
+	destroyPool(this);
+	destroyWorkers(this);
+	if(this->stream)
+	{
+		if(this->stream->buf) free(this->stream->buf);
+		free(this->stream);
+	}
+	if(this->cstream)
+	{
+		if(this->cstream->buf) free(this->cstream->buf);
+		free(this->cstream);
+	}
+	if(this->index)
+	{
+		if(this->index->checkpoints) free(this->index->checkpoints);
+		free(this->index);
+	}
 	free(this);
 	return 0;
 }
 
 
+DLLEXPORT int DLLCALL tjSetNumThreads(tjhandle handle, int numThreads)
+{
+	tjinstance *this=(tjinstance *)handle;  int retval=0;
+
+	if(!this) _throw("Invalid handle");
+	if(numThreads<0) _throw("tjSetNumThreads(): Invalid argument");
+	this->numThreads=numThreads==0 ? tjGetNumCPUs():numThreads;
+
+	bailout:
+	return retval;
+}
+
+
+DLLEXPORT int DLLCALL tjBatch(tjhandle handle, tjjob *jobs, int numJobs)
+{
+	tjinstance *this=(tjinstance *)handle;  tjpool *pool;
+	int i, perWorker, retval=0;
+
+	if(!this) _throw("Invalid handle");
+	if(jobs==NULL || numJobs<0) _throw("tjBatch(): Invalid argument");
+	if(initPool(this)==-1) _throw("tjBatch(): Could not create thread pool");
+	pool=this->pool;
+
+	/* Divide the jobs evenly among the workers and wake the pool threads */
+	tjMutexLock(&pool->mutex);
+	perWorker=numJobs/pool->numWorkers;
+	for(i=0; i<pool->numWorkers; i++)
+	{
+		pool->workers[i].first=i*perWorker+min(i, numJobs%pool->numWorkers);
+		pool->workers[i].last=pool->workers[i].first+perWorker
+			+(i<numJobs%pool->numWorkers);
+	}
+	pool->jobs=jobs;
+	pool->busy=pool->numThreads;
+	pool->batch++;
+	tjCondBroadcast(&pool->cond);
+	tjMutexUnlock(&pool->mutex);
+
+	runJobs(&pool->workers[0]);
+
+	tjMutexLock(&pool->mutex);
+	while(pool->busy>0) tjCondWait(&pool->cond, &pool->mutex);
+	tjMutexUnlock(&pool->mutex);
+
+	for(i=0; i<numJobs; i++)
+	{
+		if(jobs[i].retval==-1)
+		{
+			snprintf(errStr, JMSG_LENGTH_MAX, "%s", jobs[i].errStr);
+			retval=-1;  break;
+		}
+	}
+
+	bailout:
+	return retval;
+}
+
+
 /* These are exposed mainly because Windows can't malloc() and free() across
    DLL boundaries except when the CRT DLL is used, and we don't use the CRT DLL
    with turbojpeg.dll for compatibility reasons.  However, these functions
@@ -598,6 +1020,7 @@ static tjhandle _tjInitCompress(tjinstance *this)
 	}
 
 	jpeg_create_compress(&this->cinfo);
+	jpeg_mem_retain((j_common_ptr)&this->cinfo, TRUE);
 	/* Make an initial call so it will create the destination manager */
 	jpeg_mem_dest_tj(&this->cinfo, &buf, &size, 0);
 
@@ -754,109 +1177,666 @@ DLLEXPORT unsigned long DLLCALL tjPlaneSizeYUV(int componentID, int width,
 }
 
 
-DLLEXPORT int DLLCALL tjCompress2(tjhandle handle, const unsigned char *srcBuf,
-	int width, int pitch, int height, int pixelFormat, unsigned char **jpegBuf,
-	unsigned long *jpegSize, int jpegSubsamp, int jpegQual, int flags)
+/* Multithreaded compression */
+
+typedef struct _tjcompjob
 {
-	int i, retval=0, alloc=1;  JSAMPROW *row_pointer=NULL;
-	#ifndef JCS_EXTENSIONS
-	unsigned char *rgbBuf=NULL;
-	#endif
+	JSAMPROW *row_pointer;
+	int width, height, pixelFormat, jpegSubsamp, jpegQual, flags;
+	int stripeHeight, numStripes, numWorkers;
+	unsigned char **stripeBufs;
+	unsigned long *stripeSizes;
+} tjcompjob;
+
+/* Compress every numWorkers-th stripe, starting with the stripe whose index
+   matches that of the worker, as a separate JPEG image */
+static void compressStripes(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+	const tjcompjob *job=(const tjcompjob *)worker->job;
+	j_compress_ptr cinfo=&worker->cinfo;
+	int i, rows;
+
+	worker->retval=0;
+	worker->jerr.warning=FALSE;
+	if(setjmp(worker->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		worker->retval=-1;
+		goto bailout;
+	}
 
-	getcinstance(handle)
-	if((this->init&COMPRESS)==0)
-		_throw("tjCompress2(): Instance has not been initialized for compression");
+	for(i=worker->index; i<job->numStripes; i+=job->numWorkers)
+	{
+		rows=min(job->stripeHeight, job->height-i*job->stripeHeight);
+		jpeg_mem_dest_tj(cinfo, &job->stripeBufs[i], &job->stripeSizes[i], FALSE);
+		cinfo->image_width=job->width;
+		cinfo->image_height=rows;
+		setCompDefaults(cinfo, job->pixelFormat, job->jpegSubsamp, job->jpegQual,
+			job->flags);
+
+		jpeg_start_compress(cinfo, TRUE);
+		while((int)cinfo->next_scanline<rows)
+		{
+			jpeg_write_scanlines(cinfo,
+				&job->row_pointer[i*job->stripeHeight+cinfo->next_scanline],
+				rows-cinfo->next_scanline);
+		}
+		jpeg_finish_compress(cinfo);
+	}
 
-	if(srcBuf==NULL || width<=0 || pitch<0 || height<=0 || pixelFormat<0
-		|| pixelFormat>=TJ_NUMPF || jpegBuf==NULL || jpegSize==NULL
-		|| jpegSubsamp<0 || jpegSubsamp>=NUMSUBOPT || jpegQual<0 || jpegQual>100)
-		_throw("tjCompress2(): Invalid argument");
+	bailout:
+	if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);
+	if(worker->jerr.warning) worker->retval=-1;
+}
 
-	if(pitch==0) pitch=width*tjPixelSize[pixelFormat];
+/* Find the SOF and SOS markers in a JPEG image generated by compressStripes().
+   Returns the offset of the first byte of entropy-coded data, or 0 if the
+   markers could not be found. */
+static unsigned long findScan(const unsigned char *buf, unsigned long size,
+	unsigned long *sofPos, unsigned long *sosPos)
+{
+	unsigned long pos=2;
 
-	#ifndef JCS_EXTENSIONS
-	if(pixelFormat!=TJPF_GRAY && pixelFormat!=TJPF_CMYK)
+	while(pos+4<=size && buf[pos]==0xFF)
 	{
-		rgbBuf=(unsigned char *)malloc(width*height*RGB_PIXELSIZE);
-		if(!rgbBuf) _throw("tjCompress2(): Memory allocation failure");
-		srcBuf=toRGB(srcBuf, width, pitch, height, pixelFormat, rgbBuf);
-		pitch=width*RGB_PIXELSIZE;
+		int marker=buf[pos+1];
+		if(marker==0xC0 || marker==0xC1) *sofPos=pos;
+		if(marker==0xDA)
+		{
+			*sosPos=pos;
+			return pos+2+((buf[pos+2]<<8)|buf[pos+3]);
+		}
+		pos+=2+((buf[pos+2]<<8)|buf[pos+3]);
 	}
-	#endif
+	return 0;
+}
 
-	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)*height))==NULL)
-		_throw("tjCompress2(): Memory allocation failure");
+static void writeBytes(j_compress_ptr cinfo, const unsigned char *buf,
+	unsigned long size)
+{
+	struct jpeg_destination_mgr *dest=cinfo->dest;
 
-	if(setjmp(this->jerr.setjmp_buffer))
+	while(size>0)
 	{
-		/* If we get here, the JPEG code has signaled an error. */
-		retval=-1;
-		goto bailout;
+		unsigned long n;
+		if(dest->free_in_buffer==0 && !(*dest->empty_output_buffer)(cinfo))
+			ERREXIT(cinfo, JERR_CANT_SUSPEND);
+		n=min(size, (unsigned long)dest->free_in_buffer);
+		memcpy(dest->next_output_byte, buf, n);
+		dest->next_output_byte+=n;  dest->free_in_buffer-=n;
+		buf+=n;  size-=n;
 	}
+}
 
-	cinfo->image_width=width;
-	cinfo->image_height=height;
-
-	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-	else if(flags&TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
+/* Compress the image as a series of horizontal stripes, in parallel, and join
+   the stripes with restart markers.  This produces the same JPEG image that
+   single-threaded compression would produce with a restart interval equal to
+   the number of MCUs in one stripe.  cinfo must have been set up with the
+   compression parameters and destination manager but not started.  Returns 1
+   if the image was compressed, 0 if it is not suitable for striped
+   compression, or -1 if an error occurred. */
+static int compressStriped(tjinstance *this, JSAMPROW *row_pointer,
+	int width, int height, int pixelFormat, int jpegSubsamp, int jpegQual,
+	int flags)
+{
+	j_compress_ptr cinfo=&this->cinfo;
+	int mcusPerRow, mcuRows, stripeMCURows, numStripes, i, retval=0;
+	unsigned long sofPos=0, sosPos=0, dataPos, dataEnd, stripePos, dummy;
+	unsigned char marker[6];
+	tjcompjob job;
+
+	MEMZERO(&job, sizeof(tjcompjob));
+	if(cinfo->optimize_coding || cinfo->arith_code || cinfo->num_scans>1
+		|| cinfo->restart_interval>0 || cinfo->restart_in_rows>0
+		|| cinfo->master->huff_pretrained)
+		return 0;
+
+	mcusPerRow=(width+tjMCUWidth[jpegSubsamp]-1)/tjMCUWidth[jpegSubsamp];
+	mcuRows=(height+tjMCUHeight[jpegSubsamp]-1)/tjMCUHeight[jpegSubsamp];
+	numStripes=min(this->numThreads, mcuRows);
+	if(numStripes<2) return 0;
+	stripeMCURows=(mcuRows+numStripes-1)/numStripes;
+	/* The restart interval cannot exceed 65535 MCUs. */
+	if(stripeMCURows*mcusPerRow>65535)
+	{
+		if((stripeMCURows=65535/mcusPerRow)<1) return 0;
+	}
+	numStripes=(mcuRows+stripeMCURows-1)/stripeMCURows;
+	if(numStripes<2) return 0;
+
+	job.row_pointer=row_pointer;
+	job.width=width;  job.height=height;  job.pixelFormat=pixelFormat;
+	job.jpegSubsamp=jpegSubsamp;  job.jpegQual=jpegQual;  job.flags=flags;
+	job.stripeHeight=stripeMCURows*tjMCUHeight[jpegSubsamp];
+	job.numStripes=numStripes;
+	job.numWorkers=min(this->numThreads, numStripes);
+	if((job.stripeBufs=(unsigned char **)malloc(
+		sizeof(unsigned char *)*numStripes))==NULL
+		|| (job.stripeSizes=(unsigned long *)malloc(
+			sizeof(unsigned long)*numStripes))==NULL)
+		_throw("tjCompress2(): Memory allocation failure");
+	MEMZERO(job.stripeBufs, sizeof(unsigned char *)*numStripes);
+	for(i=0; i<numStripes; i++)
+	{
+		job.stripeSizes[i]=tjBufSize(width, job.stripeHeight, jpegSubsamp);
+		if((job.stripeBufs[i]=(unsigned char *)malloc(job.stripeSizes[i]))==NULL)
+			_throw("tjCompress2(): Memory allocation failure");
+	}
+	if(initWorkers(this, job.numWorkers, COMPRESS)==-1)
+		_throw("tjCompress2(): Memory allocation failure");
 
-	if(flags&TJFLAG_NOREALLOC)
+	if((i=runWorkers(this, job.numWorkers, compressStripes, &job))>=0)
 	{
-		alloc=0;  *jpegSize=tjBufSize(width, height, jpegSubsamp);
+		snprintf(errStr, JMSG_LENGTH_MAX, "%s", this->workers[i]->errStr);
+		retval=-1;  goto bailout;
 	}
-	jpeg_mem_dest_tj(cinfo, jpegBuf, jpegSize, alloc);
-	if(setCompDefaults(cinfo, pixelFormat, jpegSubsamp, jpegQual, flags)==-1)
-		return -1;
 
-	jpeg_start_compress(cinfo, TRUE);
-	for(i=0; i<height; i++)
+	if(setjmp(this->jerr.setjmp_buffer))
 	{
-		if(flags&TJFLAG_BOTTOMUP)
-			row_pointer[i]=(JSAMPROW)&srcBuf[(height-i-1)*pitch];
-		else row_pointer[i]=(JSAMPROW)&srcBuf[i*pitch];
+		/* If we get here, the JPEG code has signaled an error (most likely, the
+		   destination buffer is too small.)  Nothing that the caller does after
+		   this function returns can invoke the error handler. */
+		retval=-1;  goto bailout;
 	}
-	while(cinfo->next_scanline<cinfo->image_height)
+
+	/* Use the headers from the first stripe, with the image height adjusted
+	   and a DRI marker inserted ahead of the SOS marker.  Each subsequent
+	   stripe contributes only its entropy-coded data (which is already padded
+	   to a byte boundary), preceded by the next RSTn marker. */
+	if((dataPos=findScan(job.stripeBufs[0], job.stripeSizes[0], &sofPos,
+		&sosPos))==0 || sofPos==0)
+		_throw("tjCompress2(): Could not join stripes");
+	writeBytes(cinfo, job.stripeBufs[0], sofPos+5);
+	marker[0]=(height>>8)&0xFF;  marker[1]=height&0xFF;
+	writeBytes(cinfo, marker, 2);
+	writeBytes(cinfo, &job.stripeBufs[0][sofPos+7], sosPos-sofPos-7);
+	marker[0]=0xFF;  marker[1]=0xDD;  marker[2]=0;  marker[3]=4;
+	marker[4]=((stripeMCURows*mcusPerRow)>>8)&0xFF;
+	marker[5]=(stripeMCURows*mcusPerRow)&0xFF;
+	writeBytes(cinfo, marker, 6);
+	writeBytes(cinfo, &job.stripeBufs[0][sosPos], dataPos-sosPos);
+	for(i=0; i<numStripes; i++)
 	{
-		jpeg_write_scanlines(cinfo, &row_pointer[cinfo->next_scanline],
-			cinfo->image_height-cinfo->next_scanline);
+		if(i>0)
+		{
+			if((dataPos=findScan(job.stripeBufs[i], job.stripeSizes[i], &dummy,
+				&stripePos))==0)
+				_throw("tjCompress2(): Could not join stripes");
+			marker[0]=0xFF;  marker[1]=JPEG_RST0+((i-1)&7);
+			writeBytes(cinfo, marker, 2);
+		}
+		dataEnd=job.stripeSizes[i]-2;  /* Strip EOI */
+		writeBytes(cinfo, &job.stripeBufs[i][dataPos], dataEnd-dataPos);
 	}
-	jpeg_finish_compress(cinfo);
+	marker[0]=0xFF;  marker[1]=JPEG_EOI;
+	writeBytes(cinfo, marker, 2);
+	(*cinfo->dest->term_destination)(cinfo);
+	retval=1;
 
 	bailout:
-	if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);
-	#ifndef JCS_EXTENSIONS
-	if(rgbBuf) free(rgbBuf);
-	#endif
-	if(row_pointer) free(row_pointer);
-	if(this->jerr.warning) retval=-1;
+	if(job.stripeBufs)
+	{
+		for(i=0; i<numStripes; i++)
+			if(job.stripeBufs[i]) free(job.stripeBufs[i]);
+		free(job.stripeBufs);
+	}
+	if(job.stripeSizes) free(job.stripeSizes);
 	return retval;
 }
 
-DLLEXPORT int DLLCALL tjCompress(tjhandle handle, unsigned char *srcBuf,
-	int width, int pitch, int height, int pixelSize, unsigned char *jpegBuf,
-	unsigned long *jpegSize, int jpegSubsamp, int jpegQual, int flags)
+
+/* Pipelined compression.  Worker threads perform color conversion,
+   downsampling, and the forward DCT on chunks of PIPELINE_CHUNK_ROWS iMCU rows,
+   storing the coefficients in a ring (see compress_ring_input() in
+   jccoefct.c), while the calling thread entropy-encodes the iMCU rows in
+   order. */
+
+#define PIPELINE_CHUNK_ROWS 2
+#define PIPELINE_HEADER_SIZE 4096
+
+typedef struct _tjcomppipe
 {
-	int retval=0;  unsigned long size;
-	if(flags&TJ_YUV)
+	tjmutex mutex;
+	tjcond cond;
+	tjcompjob job;
+	JBLOCKARRAY ring[MAX_COMPONENTS];
+	int ringRows, nextChunk, doneChunks, stop;
+	unsigned char *chunkDone;
+	JDIMENSION transformed, encoded;  /* # of iMCU rows transformed/encoded */
+	JDIMENSION totalRows;
+} tjcomppipe;
+
+/* Transform chunks of the image into the ring, in the order in which they
+   will be encoded, until all chunks have been claimed.  Each chunk is
+   compressed as a separate image whose headers are discarded. */
+static void transformChunks(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+	tjcomppipe *pipe=(tjcomppipe *)worker->job;
+	const tjcompjob *job=&pipe->job;
+	j_compress_ptr cinfo=&worker->cinfo;
+	unsigned char headerBuf[PIPELINE_HEADER_SIZE], *headerPtr;
+	unsigned long headerSize;
+	JDIMENSION startRow;
+	int i, ci, rows, stop=0;
+
+	worker->retval=0;
+	worker->jerr.warning=FALSE;
+	if(setjmp(worker->jerr.setjmp_buffer))
 	{
-		size=tjBufSizeYUV(width, height, jpegSubsamp);
-		retval=tjEncodeYUV2(handle, srcBuf, width, pitch, height,
-			getPixelFormat(pixelSize, flags), jpegBuf, jpegSubsamp, flags);
+		/* If we get here, the JPEG code has signaled an error. */
+		worker->retval=-1;
+		goto bailout;
 	}
-	else
+
+	for(;;)
 	{
-		retval=tjCompress2(handle, srcBuf, width, pitch, height,
-			getPixelFormat(pixelSize, flags), &jpegBuf, &size, jpegSubsamp, jpegQual,
-			flags|TJFLAG_NOREALLOC);
+		/* Wait until the ring is available and the ring rows for the next chunk
+		   have been encoded */
+		tjMutexLock(&pipe->mutex);
+		while(!pipe->stop && (pipe->ring[0]==NULL
+			|| (pipe->nextChunk<job->numStripes
+				&& (JDIMENSION)(pipe->nextChunk+1)*PIPELINE_CHUNK_ROWS-pipe->encoded
+					>(JDIMENSION)pipe->ringRows)))
+			tjCondWait(&pipe->cond, &pipe->mutex);
+		stop=pipe->stop || pipe->nextChunk>=job->numStripes;
+		i=pipe->nextChunk++;
+		tjMutexUnlock(&pipe->mutex);
+		if(stop) break;
+
+		startRow=(JDIMENSION)i*PIPELINE_CHUNK_ROWS;
+		rows=min(job->stripeHeight, job->height-i*job->stripeHeight);
+		headerPtr=headerBuf;  headerSize=PIPELINE_HEADER_SIZE;
+		jpeg_mem_dest_tj(cinfo, &headerPtr, &headerSize, FALSE);
+		cinfo->image_width=job->width;
+		cinfo->image_height=rows;
+		setCompDefaults(cinfo, job->pixelFormat, job->jpegSubsamp, job->jpegQual,
+			job->flags);
+		cinfo->master->coef_ring_rows=pipe->ringRows;
+		cinfo->master->coef_ring_fill=TRUE;
+		cinfo->master->coef_ring_start=startRow;
+		for(ci=0; ci<MAX_COMPONENTS; ci++)
+			cinfo->master->coef_ring[ci]=pipe->ring[ci];
+
+		jpeg_start_compress(cinfo, TRUE);
+		while((int)cinfo->next_scanline<rows)
+		{
+			jpeg_write_scanlines(cinfo,
+				&job->row_pointer[i*job->stripeHeight+cinfo->next_scanline],
+				rows-cinfo->next_scanline);
+		}
+		jpeg_abort_compress(cinfo);
+
+		tjMutexLock(&pipe->mutex);
+		pipe->chunkDone[i]=1;
+		while(pipe->doneChunks<job->numStripes && pipe->chunkDone[pipe->doneChunks])
+			pipe->doneChunks++;
+		pipe->transformed=min((JDIMENSION)pipe->doneChunks*PIPELINE_CHUNK_ROWS,
+			pipe->totalRows);
+		tjCondBroadcast(&pipe->cond);
+		tjMutexUnlock(&pipe->mutex);
 	}
-	*jpegSize=size;
-	return retval;
-}
 
+	bailout:
+	if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);
+	cinfo->master->coef_ring_rows=0;
+	cinfo->master->coef_ring_fill=FALSE;
+	for(ci=0; ci<MAX_COMPONENTS; ci++) cinfo->master->coef_ring[ci]=NULL;
+	if(worker->jerr.warning) worker->retval=-1;
+	if(worker->retval==-1)
+	{
+		tjMutexLock(&pipe->mutex);
+		pipe->stop=1;
+		tjCondBroadcast(&pipe->cond);
+		tjMutexUnlock(&pipe->mutex);
+	}
+}
 
-DLLEXPORT int DLLCALL tjEncodeYUVPlanes(tjhandle handle,
-	const unsigned char *srcBuf, int width, int pitch, int height,
+/* Compress a single-scan JPEG image using worker threads for everything but
+   entropy encoding.  cinfo must have been set up with the compression
+   parameters and destination manager but not started.  Returns 1 if the image
+   was compressed, 0 if it is not suitable for pipelined compression, or -1 if
+   an error occurred. */
+static int compressPipelined(tjinstance *this, JSAMPROW *row_pointer,
+	int width, int height, int pixelFormat, int jpegSubsamp, int jpegQual,
+	int flags)
+{
+	j_compress_ptr cinfo=&this->cinfo;
+	int mcuRows, numThreads=0, ci, i, stop=0, retval=0;
+	tjcomppipe pipe;
+
+	if(cinfo->optimize_coding || cinfo->num_scans>1
+		|| cinfo->smoothing_factor>0)
+		return 0;
+	mcuRows=(height+tjMCUHeight[jpegSubsamp]-1)/tjMCUHeight[jpegSubsamp];
+	if(mcuRows<2*PIPELINE_CHUNK_ROWS) return 0;
+
+	MEMZERO(&pipe, sizeof(tjcomppipe));
+	if(tjMutexInit(&pipe.mutex)==-1) return 0;
+	if(tjCondInit(&pipe.cond)==-1)
+	{
+		tjMutexDestroy(&pipe.mutex);  return 0;
+	}
+	pipe.job.row_pointer=row_pointer;
+	pipe.job.width=width;  pipe.job.height=height;
+	pipe.job.pixelFormat=pixelFormat;  pipe.job.jpegSubsamp=jpegSubsamp;
+	pipe.job.jpegQual=jpegQual;  pipe.job.flags=flags;
+	pipe.job.stripeHeight=PIPELINE_CHUNK_ROWS*tjMCUHeight[jpegSubsamp];
+	pipe.job.numStripes=(mcuRows+PIPELINE_CHUNK_ROWS-1)/PIPELINE_CHUNK_ROWS;
+	pipe.job.numWorkers=min(this->numThreads-1, pipe.job.numStripes);
+	pipe.ringRows=2*PIPELINE_CHUNK_ROWS*pipe.job.numWorkers;
+	pipe.totalRows=mcuRows;
+	if(initWorkers(this, pipe.job.numWorkers, COMPRESS)==-1)
+		_throw("tjCompress2(): Memory allocation failure");
+	if((pipe.chunkDone=(unsigned char *)malloc(pipe.job.numStripes))==NULL)
+		_throw("tjCompress2(): Memory allocation failure");
+	MEMZERO(pipe.chunkDone, pipe.job.numStripes);
+
+	/* Start the workers.  They wait until the ring has been allocated. */
+	for(numThreads=0; numThreads<pipe.job.numWorkers; numThreads++)
+	{
+		tjworker *worker=this->workers[numThreads];
+		worker->index=numThreads;
+		worker->job=&pipe;
+		if(tjThreadCreate(&worker->thread, transformChunks, worker)==-1)
+			break;
+	}
+	if(numThreads==0) goto bailout;
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+	cinfo->raw_data_in=TRUE;
+	cinfo->master->coef_ring_rows=pipe.ringRows;
+	cinfo->master->coef_ring_fill=FALSE;
+	cinfo->master->coef_ring_avail=0;
+	jpeg_start_compress(cinfo, TRUE);
+
+	tjMutexLock(&pipe.mutex);
+	for(ci=0; ci<MAX_COMPONENTS; ci++) pipe.ring[ci]=cinfo->master->coef_ring[ci];
+	tjCondBroadcast(&pipe.cond);
+	tjMutexUnlock(&pipe.mutex);
+
+	while(cinfo->next_scanline<cinfo->image_height)
+	{
+		/* Wait until the next iMCU row has been transformed */
+		tjMutexLock(&pipe.mutex);
+		while(pipe.transformed<=pipe.encoded && !pipe.stop)
+			tjCondWait(&pipe.cond, &pipe.mutex);
+		cinfo->master->coef_ring_avail=pipe.transformed;
+		stop=pipe.stop;
+		tjMutexUnlock(&pipe.mutex);
+		if(stop) break;
+
+		if(jpeg_write_raw_data(cinfo, NULL, tjMCUHeight[jpegSubsamp])==0)
+			continue;
+
+		tjMutexLock(&pipe.mutex);
+		pipe.encoded++;
+		tjCondBroadcast(&pipe.cond);
+		tjMutexUnlock(&pipe.mutex);
+	}
+	if(!stop) jpeg_finish_compress(cinfo);
+	retval=1;
+
+	bailout:
+	tjMutexLock(&pipe.mutex);
+	pipe.stop=1;
+	tjCondBroadcast(&pipe.cond);
+	tjMutexUnlock(&pipe.mutex);
+	for(i=0; i<numThreads; i++)
+	{
+		tjThreadJoin(&this->workers[i]->thread);
+		if(this->workers[i]->retval==-1 && retval!=-1)
+		{
+			snprintf(errStr, JMSG_LENGTH_MAX, "%s", this->workers[i]->errStr);
+			retval=-1;
+		}
+	}
+	cinfo->raw_data_in=FALSE;
+	cinfo->master->coef_ring_rows=0;
+	for(ci=0; ci<MAX_COMPONENTS; ci++) cinfo->master->coef_ring[ci]=NULL;
+	tjCondDestroy(&pipe.cond);
+	tjMutexDestroy(&pipe.mutex);
+	if(pipe.chunkDone) free(pipe.chunkDone);
+	return retval;
+}
+
+
+/* Segmented destination manager.  Rather than growing a single buffer and
+   copying the data written so far, as the in-memory destination manager does,
+   this allocates a new fixed-size segment each time the current one fills. */
+typedef struct _tjsegdest
+{
+	struct jpeg_destination_mgr pub;
+	tjsegment *segments;
+	int numSegments, maxSegments;
+	size_t segmentSize;
+} tjsegdest;
+
+static boolean seg_empty_output_buffer(j_compress_ptr cinfo)
+{
+	tjsegdest *dest=(tjsegdest *)cinfo->dest;
+	tjsegment *seg;
+
+	if(dest->numSegments>=dest->maxSegments)
+	{
+		int maxSegments=max(dest->maxSegments*2, 16);
+		tjsegment *segments=(tjsegment *)realloc(dest->segments,
+			sizeof(tjsegment)*maxSegments);
+		if(!segments) ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 10);
+		dest->segments=segments;  dest->maxSegments=maxSegments;
+	}
+	seg=&dest->segments[dest->numSegments];
+	if((seg->buf=(unsigned char *)malloc(dest->segmentSize))==NULL)
+		ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 10);
+	seg->size=dest->segmentSize;
+	dest->numSegments++;
+	dest->pub.next_output_byte=seg->buf;
+	dest->pub.free_in_buffer=dest->segmentSize;
+	return TRUE;
+}
+
+static void seg_init_destination(j_compress_ptr cinfo)
+{
+	seg_empty_output_buffer(cinfo);
+}
+
+/* libjpeg empties the buffer as soon as it fills, so the last segment may
+   be empty. */
+static void seg_term_destination(j_compress_ptr cinfo)
+{
+	tjsegdest *dest=(tjsegdest *)cinfo->dest;
+	tjsegment *seg;
+
+	if(dest->numSegments<1) return;
+	seg=&dest->segments[dest->numSegments-1];
+	seg->size=dest->segmentSize-dest->pub.free_in_buffer;
+	if(seg->size==0 && dest->numSegments>1)
+	{
+		free(seg->buf);  seg->buf=NULL;
+		dest->numSegments--;
+	}
+}
+
+/* Compress an image into either a JPEG buffer (if segDest is NULL) or a list
+   of segments */
+static int compress(tjhandle handle, const unsigned char *srcBuf, int width,
+	int pitch, int height, int pixelFormat, unsigned char **jpegBuf,
+	unsigned long *jpegSize, tjsegdest *segDest, int jpegSubsamp, int jpegQual,
+	int flags)
+{
+	int i, retval=0, alloc=1;  JSAMPROW *row_pointer=NULL;
+	struct jpeg_destination_mgr *dest=NULL;
+	#ifndef JCS_EXTENSIONS
+	unsigned char *rgbBuf=NULL;
+	#endif
+
+	getcinstance(handle)
+	if((this->init&COMPRESS)==0)
+		_throw("tjCompress2(): Instance has not been initialized for compression");
+
+	if(srcBuf==NULL || width<=0 || pitch<0 || height<=0 || pixelFormat<0
+		|| pixelFormat>=TJ_NUMPF
+		|| (segDest==NULL && (jpegBuf==NULL || jpegSize==NULL))
+		|| jpegSubsamp<0 || jpegSubsamp>=NUMSUBOPT || jpegQual<0 || jpegQual>100)
+		_throw("tjCompress2(): Invalid argument");
+
+	if(pitch==0) pitch=width*tjPixelSize[pixelFormat];
+
+	#ifndef JCS_EXTENSIONS
+	if(pixelFormat!=TJPF_GRAY && pixelFormat!=TJPF_CMYK)
+	{
+		rgbBuf=(unsigned char *)malloc(width*height*RGB_PIXELSIZE);
+		if(!rgbBuf) _throw("tjCompress2(): Memory allocation failure");
+		srcBuf=toRGB(srcBuf, width, pitch, height, pixelFormat, rgbBuf);
+		pitch=width*RGB_PIXELSIZE;
+	}
+	#endif
+
+	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)*height))==NULL)
+		_throw("tjCompress2(): Memory allocation failure");
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	cinfo->image_width=width;
+	cinfo->image_height=height;
+
+	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
+	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
+	else if(flags&TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
+
+	if(segDest)
+	{
+		dest=cinfo->dest;  cinfo->dest=&segDest->pub;
+	}
+	else
+	{
+		if(flags&TJFLAG_NOREALLOC)
+		{
+			alloc=0;  *jpegSize=tjBufSize(width, height, jpegSubsamp);
+		}
+		jpeg_mem_dest_tj(cinfo, jpegBuf, jpegSize, alloc);
+	}
+	if(setCompDefaults(cinfo, pixelFormat, jpegSubsamp, jpegQual, flags)==-1)
+	{
+		retval=-1;  goto bailout;
+	}
+
+	for(i=0; i<height; i++)
+	{
+		if(flags&TJFLAG_BOTTOMUP)
+			row_pointer[i]=(JSAMPROW)&srcBuf[(height-i-1)*pitch];
+		else row_pointer[i]=(JSAMPROW)&srcBuf[i*pitch];
+	}
+	if(this->numThreads>1
+		&& ((flags&TJFLAG_STRIPED
+				&& (i=compressStriped(this, row_pointer, width, height, pixelFormat,
+					jpegSubsamp, jpegQual, flags))!=0)
+			|| (i=compressPipelined(this, row_pointer, width, height, pixelFormat,
+				jpegSubsamp, jpegQual, flags))!=0))
+	{
+		if(i==-1) retval=-1;
+		goto bailout;
+	}
+
+	jpeg_start_compress(cinfo, TRUE);
+	while(cinfo->next_scanline<cinfo->image_height)
+	{
+		jpeg_write_scanlines(cinfo, &row_pointer[cinfo->next_scanline],
+			cinfo->image_height-cinfo->next_scanline);
+	}
+	jpeg_finish_compress(cinfo);
+
+	bailout:
+	if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);
+	if(segDest && cinfo->dest==&segDest->pub) cinfo->dest=dest;
+	#ifndef JCS_EXTENSIONS
+	if(rgbBuf) free(rgbBuf);
+	#endif
+	if(row_pointer) free(row_pointer);
+	if(this->jerr.warning) retval=-1;
+	return retval;
+}
+
+DLLEXPORT int DLLCALL tjCompress2(tjhandle handle, const unsigned char *srcBuf,
+	int width, int pitch, int height, int pixelFormat, unsigned char **jpegBuf,
+	unsigned long *jpegSize, int jpegSubsamp, int jpegQual, int flags)
+{
+	return compress(handle, srcBuf, width, pitch, height, pixelFormat, jpegBuf,
+		jpegSize, NULL, jpegSubsamp, jpegQual, flags);
+}
+
+DLLEXPORT int DLLCALL tjCompressToSegments(tjhandle handle,
+	const unsigned char *srcBuf, int width, int pitch, int height,
+	int pixelFormat, tjsegment **segments, int *numSegments,
+	unsigned long segmentSize, int jpegSubsamp, int jpegQual, int flags)
+{
+	tjsegdest dest;  int retval=0;
+
+	if(segments==NULL || numSegments==NULL || segmentSize==0)
+		_throw("tjCompressToSegments(): Invalid argument");
+
+	memset(&dest, 0, sizeof(tjsegdest));
+	dest.pub.init_destination=seg_init_destination;
+	dest.pub.empty_output_buffer=seg_empty_output_buffer;
+	dest.pub.term_destination=seg_term_destination;
+	dest.segmentSize=segmentSize;
+	if((retval=compress(handle, srcBuf, width, pitch, height, pixelFormat, NULL,
+		NULL, &dest, jpegSubsamp, jpegQual, flags))==-1)
+	{
+		tjFreeSegments(dest.segments, dest.numSegments);
+		goto bailout;
+	}
+	*segments=dest.segments;
+	*numSegments=dest.numSegments;
+
+	bailout:
+	return retval;
+}
+
+DLLEXPORT void DLLCALL tjFreeSegments(tjsegment *segments, int numSegments)
+{
+	int i;
+
+	if(!segments) return;
+	for(i=0; i<numSegments; i++) free(segments[i].buf);
+	free(segments);
+}
+
+DLLEXPORT int DLLCALL tjCompress(tjhandle handle, unsigned char *srcBuf,
+	int width, int pitch, int height, int pixelSize, unsigned char *jpegBuf,
+	unsigned long *jpegSize, int jpegSubsamp, int jpegQual, int flags)
+{
+	int retval=0;  unsigned long size;
+	if(flags&TJ_YUV)
+	{
+		size=tjBufSizeYUV(width, height, jpegSubsamp);
+		retval=tjEncodeYUV2(handle, srcBuf, width, pitch, height,
+			getPixelFormat(pixelSize, flags), jpegBuf, jpegSubsamp, flags);
+	}
+	else
+	{
+		retval=tjCompress2(handle, srcBuf, width, pitch, height,
+			getPixelFormat(pixelSize, flags), &jpegBuf, &size, jpegSubsamp, jpegQual,
+			flags|TJFLAG_NOREALLOC);
+	}
+	*jpegSize=size;
+	return retval;
+}
+
+
+DLLEXPORT int DLLCALL tjEncodeYUVPlanes(tjhandle handle,
+	const unsigned char *srcBuf, int width, int pitch, int height,
 	int pixelFormat, unsigned char **dstPlanes, int *strides, int subsamp,
 	int flags)
 {
@@ -1254,85 +2234,439 @@ DLLEXPORT int DLLCALL tjCompressFromYUV(tjhandle handle,
 }
 
 
-/* Decompressor */
+/* Streaming compression */
 
-static tjhandle _tjInitDecompress(tjinstance *this)
+static void chunk_init_destination(j_compress_ptr cinfo)
 {
-	static unsigned char buffer[1];
+	tjcstream *cstream=(tjcstream *)cinfo->dest;
 
-	/* This is also straight out of example.c */
-	this->dinfo.err=jpeg_std_error(&this->jerr.pub);
-	this->jerr.pub.error_exit=my_error_exit;
-	this->jerr.pub.output_message=my_output_message;
-	this->jerr.emit_message=this->jerr.pub.emit_message;
-	this->jerr.pub.emit_message=my_emit_message;
+	cstream->pub.next_output_byte=cstream->buf;
+	cstream->pub.free_in_buffer=cstream->bufSize;
+}
 
-	if(setjmp(this->jerr.setjmp_buffer))
+static boolean chunk_empty_output_buffer(j_compress_ptr cinfo)
+{
+	tjcstream *cstream=(tjcstream *)cinfo->dest;
+
+	if(cstream->callback(cstream->buf, cstream->bufSize,
+		cstream->callbackData)==-1)
 	{
-		/* If we get here, the JPEG code has signaled an error. */
-		if(this) free(this);
-		return NULL;
+		cstream->callbackFailed=1;
+		ERREXIT(cinfo, JERR_FILE_WRITE);
 	}
-
-	jpeg_create_decompress(&this->dinfo);
-	/* Make an initial call so it will create the source manager */
-	jpeg_mem_src_tj(&this->dinfo, buffer, 1);
-
-	this->init|=DECOMPRESS;
-	return (tjhandle)this;
+	cstream->pub.next_output_byte=cstream->buf;
+	cstream->pub.free_in_buffer=cstream->bufSize;
+	return TRUE;
 }
 
-DLLEXPORT tjhandle DLLCALL tjInitDecompress(void)
+static void chunk_term_destination(j_compress_ptr cinfo)
 {
-	tjinstance *this;
-	if((this=(tjinstance *)malloc(sizeof(tjinstance)))==NULL)
+	tjcstream *cstream=(tjcstream *)cinfo->dest;
+	size_t size=cstream->bufSize-cstream->pub.free_in_buffer;
+
+	if(size>0
+		&& cstream->callback(cstream->buf, size, cstream->callbackData)==-1)
 	{
-		snprintf(errStr, JMSG_LENGTH_MAX,
-			"tjInitDecompress(): Memory allocation failure");
-		return NULL;
+		cstream->callbackFailed=1;
+		ERREXIT(cinfo, JERR_FILE_WRITE);
 	}
-	MEMZERO(this, sizeof(tjinstance));
-	return _tjInitDecompress(this);
 }
 
+/* The stream's destination manager is installed only for the duration of
+   each call, so that the other compression functions can still use the
+   in-memory destination manager.  If an error occurs, then the stream is
+   aborted. */
+#define installChunkDest()  \
+	dest=cinfo->dest;  cinfo->dest=&this->cstream->pub;  \
+	this->cstream->callbackFailed=0;
 
-DLLEXPORT int DLLCALL tjDecompressHeader3(tjhandle handle,
-	const unsigned char *jpegBuf, unsigned long jpegSize, int *width,
-	int *height, int *jpegSubsamp, int *jpegColorspace)
+#define uninstallChunkDest(funcName)  \
+	if(this->cstream)  \
+	{  \
+		if(this->cstream->callbackFailed)  \
+		{  \
+			snprintf(errStr, JMSG_LENGTH_MAX,  \
+				"%s: Error in chunk callback", funcName);  \
+			this->cstream->callbackFailed=0;  \
+			retval=-1;  \
+		}  \
+		if(retval==-1)  \
+		{  \
+			if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);  \
+			this->cstream->active=0;  \
+		}  \
+		if(cinfo->dest==&this->cstream->pub) cinfo->dest=dest;  \
+	}
+
+DLLEXPORT int DLLCALL tjCompressStart(tjhandle handle, int width, int height,
+	int pixelFormat, int jpegSubsamp, int jpegQual, int flags,
+	unsigned long chunkSize, int (*chunkCallback)(const unsigned char *chunk,
+		unsigned long size, void *data), void *callbackData)
 {
-	int retval=0;
+	int retval=0;  struct jpeg_destination_mgr *dest=NULL;
 
-	getdinstance(handle);
-	if((this->init&DECOMPRESS)==0)
-		_throw("tjDecompressHeader3(): Instance has not been initialized for decompression");
+	getcinstance(handle)
+	if((this->init&COMPRESS)==0)
+		_throw("tjCompressStart(): Instance has not been initialized for compression");
 
-	if(jpegBuf==NULL || jpegSize<=0 || width==NULL || height==NULL
-		|| jpegSubsamp==NULL || jpegColorspace==NULL)
-		_throw("tjDecompressHeader3(): Invalid argument");
+	if(width<=0 || height<=0 || pixelFormat<0 || pixelFormat>=TJ_NUMPF
+		|| jpegSubsamp<0 || jpegSubsamp>=NUMSUBOPT || jpegQual<0 || jpegQual>100
+		|| (flags&TJFLAG_BOTTOMUP) || chunkSize==0 || chunkCallback==NULL)
+		_throw("tjCompressStart(): Invalid argument");
 
-	if(setjmp(this->jerr.setjmp_buffer))
+	if(!this->cstream)
 	{
-		/* If we get here, the JPEG code has signaled an error. */
-		return -1;
+		if((this->cstream=(tjcstream *)calloc(1, sizeof(tjcstream)))==NULL)
+			_throw("tjCompressStart(): Memory allocation failure");
+		this->cstream->pub.init_destination=chunk_init_destination;
+		this->cstream->pub.empty_output_buffer=chunk_empty_output_buffer;
+		this->cstream->pub.term_destination=chunk_term_destination;
 	}
+	if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);
+	this->cstream->active=0;
+	if(this->cstream->bufSize!=chunkSize)
+	{
+		if(this->cstream->buf) free(this->cstream->buf);
+		this->cstream->bufSize=0;
+		if((this->cstream->buf=(JOCTET *)malloc(chunkSize))==NULL)
+			_throw("tjCompressStart(): Memory allocation failure");
+		this->cstream->bufSize=chunkSize;
+	}
+	this->cstream->callback=chunkCallback;
+	this->cstream->callbackData=callbackData;
+	this->cstream->pixelFormat=pixelFormat;
 
-	jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
-	jpeg_read_header(dinfo, TRUE);
-
-	*width=dinfo->image_width;
-	*height=dinfo->image_height;
-	*jpegSubsamp=getSubsamp(dinfo);
-	switch(dinfo->jpeg_color_space)
+	installChunkDest();
+	if(setjmp(this->jerr.setjmp_buffer))
 	{
-		case JCS_GRAYSCALE:  *jpegColorspace=TJCS_GRAY;  break;
-		case JCS_RGB:        *jpegColorspace=TJCS_RGB;  break;
-		case JCS_YCbCr:      *jpegColorspace=TJCS_YCbCr;  break;
-		case JCS_CMYK:       *jpegColorspace=TJCS_CMYK;  break;
-		case JCS_YCCK:       *jpegColorspace=TJCS_YCCK;  break;
-		default:             *jpegColorspace=-1;  break;
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
 	}
 
-	jpeg_abort_decompress(dinfo);
+	cinfo->image_width=width;
+	cinfo->image_height=height;
+
+	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
+	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
+	else if(flags&TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
+
+	if(setCompDefaults(cinfo, pixelFormat, jpegSubsamp, jpegQual, flags)==-1)
+	{
+		retval=-1;  goto bailout;
+	}
+	jpeg_start_compress(cinfo, TRUE);
+	this->cstream->active=1;
+
+	bailout:
+	if(this->jerr.warning) retval=-1;
+	uninstallChunkDest("tjCompressStart()");
+	return retval;
+}
+
+DLLEXPORT int DLLCALL tjCompressPush(tjhandle handle,
+	const unsigned char *srcBuf, int pitch, int numRows)
+{
+	int i, retval=0;  JSAMPROW *row_pointer=NULL;
+	struct jpeg_destination_mgr *dest=NULL;
+	#ifndef JCS_EXTENSIONS
+	unsigned char *rgbBuf=NULL;
+	#endif
+
+	getcinstance(handle)
+	if((this->init&COMPRESS)==0)
+		_throw("tjCompressPush(): Instance has not been initialized for compression");
+
+	if(!this->cstream || !this->cstream->active)
+		_throw("tjCompressPush(): No image is being compressed");
+	if(srcBuf==NULL || pitch<0 || numRows<=0
+		|| numRows>(int)(cinfo->image_height-cinfo->next_scanline))
+		_throw("tjCompressPush(): Invalid argument");
+
+	if(pitch==0)
+		pitch=cinfo->image_width*tjPixelSize[this->cstream->pixelFormat];
+
+	#ifndef JCS_EXTENSIONS
+	if(this->cstream->pixelFormat!=TJPF_GRAY
+		&& this->cstream->pixelFormat!=TJPF_CMYK)
+	{
+		rgbBuf=(unsigned char *)malloc(cinfo->image_width*numRows*RGB_PIXELSIZE);
+		if(!rgbBuf) _throw("tjCompressPush(): Memory allocation failure");
+		srcBuf=toRGB((unsigned char *)srcBuf, cinfo->image_width, pitch, numRows,
+			this->cstream->pixelFormat, rgbBuf);
+		pitch=cinfo->image_width*RGB_PIXELSIZE;
+	}
+	#endif
+
+	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)*numRows))==NULL)
+		_throw("tjCompressPush(): Memory allocation failure");
+	for(i=0; i<numRows; i++) row_pointer[i]=(JSAMPROW)&srcBuf[i*pitch];
+
+	installChunkDest();
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	for(i=0; i<numRows; )
+		i+=jpeg_write_scanlines(cinfo, &row_pointer[i], numRows-i);
+
+	bailout:
+	if(this->jerr.warning) retval=-1;
+	uninstallChunkDest("tjCompressPush()");
+	#ifndef JCS_EXTENSIONS
+	if(rgbBuf) free(rgbBuf);
+	#endif
+	if(row_pointer) free(row_pointer);
+	return retval;
+}
+
+DLLEXPORT int DLLCALL tjCompressFinish(tjhandle handle)
+{
+	int retval=0;  struct jpeg_destination_mgr *dest=NULL;
+
+	getcinstance(handle)
+	if((this->init&COMPRESS)==0)
+		_throw("tjCompressFinish(): Instance has not been initialized for compression");
+
+	if(!this->cstream || !this->cstream->active)
+		_throw("tjCompressFinish(): No image is being compressed");
+	if(cinfo->next_scanline<cinfo->image_height)
+		_throw("tjCompressFinish(): Not all rows of the image have been pushed");
+
+	installChunkDest();
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	jpeg_finish_compress(cinfo);
+	this->cstream->active=0;
+
+	bailout:
+	if(this->jerr.warning) retval=-1;
+	uninstallChunkDest("tjCompressFinish()");
+	return retval;
+}
+
+DLLEXPORT int DLLCALL tjCompressAbort(tjhandle handle)
+{
+	int retval=0;
+
+	getcinstance(handle)
+	if((this->init&COMPRESS)==0)
+		_throw("tjCompressAbort(): Instance has not been initialized for compression");
+
+	if(this->cstream) this->cstream->active=0;
+	if(cinfo->global_state>CSTATE_START) jpeg_abort_compress(cinfo);
+
+	bailout:
+	return retval;
+}
+
+
+/* Decompressor */
+
+static tjhandle _tjInitDecompress(tjinstance *this)
+{
+	static unsigned char buffer[1];
+
+	/* This is also straight out of example.c */
+	this->dinfo.err=jpeg_std_error(&this->jerr.pub);
+	this->jerr.pub.error_exit=my_error_exit;
+	this->jerr.pub.output_message=my_output_message;
+	this->jerr.emit_message=this->jerr.pub.emit_message;
+	this->jerr.pub.emit_message=my_emit_message;
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		if(this) free(this);
+		return NULL;
+	}
+
+	jpeg_create_decompress(&this->dinfo);
+	jpeg_mem_retain((j_common_ptr)&this->dinfo, TRUE);
+	/* Make an initial call so it will create the source manager */
+	jpeg_mem_src_tj(&this->dinfo, buffer, 1);
+
+	this->init|=DECOMPRESS;
+	return (tjhandle)this;
+}
+
+DLLEXPORT tjhandle DLLCALL tjInitDecompress(void)
+{
+	tjinstance *this;
+	if((this=(tjinstance *)malloc(sizeof(tjinstance)))==NULL)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX,
+			"tjInitDecompress(): Memory allocation failure");
+		return NULL;
+	}
+	MEMZERO(this, sizeof(tjinstance));
+	return _tjInitDecompress(this);
+}
+
+
+/* Scatter/gather source manager.  Segments that are large enough are passed
+   to the decompressor directly.  The Huffman decoder can use its fast path
+   only when several hundred bytes per block of the MCU are available in the
+   current buffer, so runs of smaller segments are instead gathered into a
+   staging buffer. */
+#define STAGE_SIZE 65536
+
+typedef struct _tjsegsrc
+{
+	struct jpeg_source_mgr pub;
+	const tjsegment *segments;
+	int numSegments, segment;
+	unsigned long offset;
+	JOCTET *stage;
+} tjsegsrc;
+
+static void segsrc_init_source(j_decompress_ptr dinfo)
+{
+	tjsegsrc *src=(tjsegsrc *)dinfo->src;
+
+	/* The staging buffer is allocated from the image pool, so it has been
+	   freed if a previous image was finished or aborted. */
+	src->stage=NULL;
+}
+
+static boolean segsrc_fill_input_buffer(j_decompress_ptr dinfo)
+{
+	static const JOCTET eoi[2]={0xFF, JPEG_EOI};
+	tjsegsrc *src=(tjsegsrc *)dinfo->src;
+	const tjsegment *seg;
+	size_t n=0, m;
+
+	while(src->segment<src->numSegments
+		&& src->offset>=src->segments[src->segment].size)
+	{
+		src->segment++;  src->offset=0;
+	}
+	if(src->segment>=src->numSegments)
+	{
+		/* Insert a fake EOI marker, as the in-memory source manager does */
+		WARNMS(dinfo, JWRN_JPEG_EOF);
+		src->pub.next_input_byte=eoi;
+		src->pub.bytes_in_buffer=2;
+		return TRUE;
+	}
+
+	seg=&src->segments[src->segment];
+	if(seg->size-src->offset>=STAGE_SIZE/2)
+	{
+		src->pub.next_input_byte=&seg->buf[src->offset];
+		src->pub.bytes_in_buffer=seg->size-src->offset;
+		src->segment++;  src->offset=0;
+		return TRUE;
+	}
+
+	if(!src->stage)
+		src->stage=(JOCTET *)(*dinfo->mem->alloc_large)((j_common_ptr)dinfo,
+			JPOOL_IMAGE, STAGE_SIZE);
+	while(n<STAGE_SIZE && src->segment<src->numSegments)
+	{
+		seg=&src->segments[src->segment];
+		m=min(STAGE_SIZE-n, seg->size-src->offset);
+		memcpy(&src->stage[n], &seg->buf[src->offset], m);
+		n+=m;  src->offset+=m;
+		if(src->offset>=seg->size)
+		{
+			src->segment++;  src->offset=0;
+		}
+	}
+	src->pub.next_input_byte=src->stage;
+	src->pub.bytes_in_buffer=n;
+	return TRUE;
+}
+
+static void segsrc_skip_input_data(j_decompress_ptr dinfo, long num_bytes)
+{
+	struct jpeg_source_mgr *src=dinfo->src;
+
+	if(num_bytes<=0) return;
+	while(num_bytes>(long)src->bytes_in_buffer)
+	{
+		num_bytes-=(long)src->bytes_in_buffer;
+		(void)(*src->fill_input_buffer)(dinfo);
+	}
+	src->next_input_byte+=(size_t)num_bytes;
+	src->bytes_in_buffer-=(size_t)num_bytes;
+}
+
+static void segsrc_term_source(j_decompress_ptr dinfo)
+{
+}
+
+static int initSegSrc(tjsegsrc *src, const tjsegment *segments,
+	int numSegments)
+{
+	int i;
+
+	if(segments==NULL || numSegments<=0) return -1;
+	for(i=0; i<numSegments; i++)
+		if(segments[i].buf==NULL && segments[i].size>0) return -1;
+	memset(src, 0, sizeof(tjsegsrc));
+	src->pub.init_source=segsrc_init_source;
+	src->pub.fill_input_buffer=segsrc_fill_input_buffer;
+	src->pub.skip_input_data=segsrc_skip_input_data;
+	src->pub.resync_to_restart=jpeg_resync_to_restart;
+	src->pub.term_source=segsrc_term_source;
+	src->segments=segments;
+	src->numSegments=numSegments;
+	return 0;
+}
+
+/* Read the header of a JPEG image stored in either a JPEG buffer (if segSrc is
+   NULL) or a list of segments */
+static int decompressHeader(tjhandle handle, const unsigned char *jpegBuf,
+	unsigned long jpegSize, tjsegsrc *segSrc, int *width, int *height,
+	int *jpegSubsamp, int *jpegColorspace)
+{
+	int retval=0;  struct jpeg_source_mgr *src=NULL;
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompressHeader3(): Instance has not been initialized for decompression");
+
+	if((segSrc==NULL && (jpegBuf==NULL || jpegSize<=0)) || width==NULL
+		|| height==NULL || jpegSubsamp==NULL || jpegColorspace==NULL)
+		_throw("tjDecompressHeader3(): Invalid argument");
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	if(segSrc)
+	{
+		src=dinfo->src;  dinfo->src=&segSrc->pub;
+	}
+	else jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+
+	*width=dinfo->image_width;
+	*height=dinfo->image_height;
+	*jpegSubsamp=getSubsamp(dinfo);
+	switch(dinfo->jpeg_color_space)
+	{
+		case JCS_GRAYSCALE:  *jpegColorspace=TJCS_GRAY;  break;
+		case JCS_RGB:        *jpegColorspace=TJCS_RGB;  break;
+		case JCS_YCbCr:      *jpegColorspace=TJCS_YCbCr;  break;
+		case JCS_CMYK:       *jpegColorspace=TJCS_CMYK;  break;
+		case JCS_YCCK:       *jpegColorspace=TJCS_YCCK;  break;
+		default:             *jpegColorspace=-1;  break;
+	}
+
+	jpeg_abort_decompress(dinfo);
 
 	if(*jpegSubsamp<0)
 		_throw("tjDecompressHeader3(): Could not determine subsampling type for JPEG image");
@@ -1342,47 +2676,1193 @@ DLLEXPORT int DLLCALL tjDecompressHeader3(tjhandle handle,
 		_throw("tjDecompressHeader3(): Invalid data returned in header");
 
 	bailout:
+	if(retval==-1 && dinfo->global_state>DSTATE_START)
+		jpeg_abort_decompress(dinfo);
+	if(segSrc && dinfo->src==&segSrc->pub) dinfo->src=src;
+	if(this->jerr.warning) retval=-1;
+	return retval;
+}
+
+DLLEXPORT int DLLCALL tjDecompressHeader3(tjhandle handle,
+	const unsigned char *jpegBuf, unsigned long jpegSize, int *width,
+	int *height, int *jpegSubsamp, int *jpegColorspace)
+{
+	return decompressHeader(handle, jpegBuf, jpegSize, NULL, width, height,
+		jpegSubsamp, jpegColorspace);
+}
+
+DLLEXPORT int DLLCALL tjDecompressHeader2(tjhandle handle,
+	unsigned char *jpegBuf, unsigned long jpegSize, int *width, int *height,
+	int *jpegSubsamp)
+{
+	int jpegColorspace;
+	return tjDecompressHeader3(handle, jpegBuf, jpegSize, width, height,
+		jpegSubsamp, &jpegColorspace);
+}
+
+DLLEXPORT int DLLCALL tjDecompressHeader(tjhandle handle,
+	unsigned char *jpegBuf, unsigned long jpegSize, int *width, int *height)
+{
+	int jpegSubsamp;
+	return tjDecompressHeader2(handle, jpegBuf, jpegSize, width, height,
+		&jpegSubsamp);
+}
+
+
+DLLEXPORT tjscalingfactor* DLLCALL tjGetScalingFactors(int *numscalingfactors)
+{
+	if(numscalingfactors==NULL)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX,
+			"tjGetScalingFactors(): Invalid argument");
+		return NULL;
+	}
+
+	*numscalingfactors=NUMSF;
+	return (tjscalingfactor *)sf;
+}
+
+
+/* Random-access indices.  An index is stored as a header followed by one
+   entry per checkpoint.  All values are little-endian.
+
+   Header:  "TJI1", JPEG size (8 bytes), offset of the entropy-coded data (4),
+            hash of the headers (4), # of iMCU rows (4), # of components in
+            the scan (4), # of checkpoints (4)
+   Entry:   iMCU row (4), offset into the entropy-coded data (8), restarts to
+            go (4), bits left (1), bit buffer (1), next restart # (1),
+            padding (1), DC prediction for each of the 4 possible components
+            in the scan (4 x 4) */
+
+#define INDEX_HEADER_SIZE 32
+#define INDEX_ENTRY_SIZE 36
+
+static void putIndexValue(unsigned char *buf, unsigned long long value,
+	int size)
+{
+	int i;
+	for(i=0; i<size; i++) buf[i]=(unsigned char)(value>>(i*8));
+}
+
+static unsigned long long getIndexValue(const unsigned char *buf, int size)
+{
+	unsigned long long value=0;  int i;
+	for(i=size-1; i>=0; i--) value=(value<<8)|buf[i];
+	return value;
+}
+
+/* FNV-1a hash */
+static unsigned int hashHeaders(const unsigned char *buf, unsigned int size)
+{
+	unsigned int hash=2166136261U, i;
+	for(i=0; i<size; i++) hash=(hash^buf[i])*16777619U;
+	return hash;
+}
+
+/* Return the instance's index if it was created from the JPEG image that is
+   being decompressed, or NULL otherwise.  dinfo must have read the headers
+   but must not yet have read any of the entropy-coded data. */
+static const tjindex *matchIndex(tjinstance *this,
+	const unsigned char *jpegBuf, unsigned long jpegSize)
+{
+	j_decompress_ptr dinfo=&this->dinfo;
+	const tjindex *index=this->index;
+	size_t headerSize=dinfo->src->next_input_byte-jpegBuf;
+
+	if(!index || dinfo->progressive_mode || dinfo->arith_code
+		|| dinfo->inputctl->has_multiple_scans
+		|| index->jpegSize!=jpegSize || index->headerSize!=headerSize
+		|| index->totalIMCURows!=dinfo->total_iMCU_rows
+		|| index->compsInScan!=dinfo->comps_in_scan
+		|| index->headerHash!=hashHeaders(jpegBuf, index->headerSize))
+		return NULL;
+	return index;
+}
+
+
+/* Multithreaded decompression */
+
+typedef struct _tjdecompjob
+{
+	const unsigned char *jpegBuf;
+	unsigned long jpegSize;
+	JSAMPROW *row_pointer;
+	int pixelFormat, flags, scaleNum, scaleDenom;
+	const jpeg_entropy_checkpoint *checkpoints;
+	int numCheckpoints;
+} tjdecompjob;
+
+/* Decompress rows [startRow, endRow) of the image using the worker's own
+   decompressor.  The entropy checkpoints allow jpeg_skip_scanlines() to jump
+   directly to the restart interval preceding startRow. */
+static void decompressRows(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+	const tjdecompjob *job=(const tjdecompjob *)worker->job;
+	j_decompress_ptr dinfo=&worker->dinfo;
+
+	worker->retval=0;
+	worker->jerr.warning=FALSE;
+	if(setjmp(worker->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		worker->retval=-1;
+		goto bailout;
+	}
+
+	jpeg_mem_src_tj(dinfo, job->jpegBuf, job->jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+	if(setDecompDefaults(dinfo, job->pixelFormat, job->flags)==-1)
+	{
+		worker->retval=-1;  goto bailout;
+	}
+	if(job->flags&TJFLAG_FASTUPSAMPLE) dinfo->do_fancy_upsampling=FALSE;
+	dinfo->scale_num=job->scaleNum;
+	dinfo->scale_denom=job->scaleDenom;
+
+	jpeg_start_decompress(dinfo);
+	dinfo->master->checkpoints=job->checkpoints;
+	dinfo->master->num_checkpoints=job->numCheckpoints;
+	if(worker->startRow>0)
+		jpeg_skip_scanlines(dinfo, worker->startRow);
+	while((int)dinfo->output_scanline<worker->endRow)
+	{
+		jpeg_read_scanlines(dinfo, &job->row_pointer[dinfo->output_scanline],
+			worker->endRow-dinfo->output_scanline);
+	}
+
+	bailout:
+	if(dinfo->global_state>DSTATE_START)
+	{
+		dinfo->master->checkpoints=NULL;
+		dinfo->master->num_checkpoints=0;
+		jpeg_abort_decompress(dinfo);
+	}
+	if(worker->jerr.warning) worker->retval=-1;
+}
+
+/* Speculative decompression of images without restart markers.  The
+   entropy-coded data is divided into segments, and each segment is scanned
+   concurrently (see scan_mcus() in jdhuff.c) starting from a guessed MCU
+   boundary at the beginning of the segment.  The scan continues for a short
+   distance into the next segment, so that it can be matched against that
+   segment's scan. */
+
+#define SPEC_MIN_SEGMENT 4096  /* minimum size (in bytes) of a segment */
+#define SPEC_OVERLAP 8192      /* bytes to scan past the end of a segment */
+
+typedef struct _tjspecseg
+{
+	size_t startPos, endPos;     /* bit positions to scan */
+	size_t *bitPos;              /* starting bit position of each MCU */
+	int *dcVal;                  /* (relative) DC predictions for each MCU */
+	JDIMENSION numMCUs, maxMCUs;
+	/* Set once the segment has been validated: the MCUs [first, last) are known
+	   to be real, and MCU first is MCU number firstMCU in the scan. */
+	JDIMENSION first, last, firstMCU;
+	int dcOffset[MAX_COMPS_IN_SCAN];
+} tjspecseg;
+
+typedef struct _tjspecjob
+{
+	const unsigned char *jpegBuf;
+	unsigned long jpegSize;
+	tjspecseg *segs;
+} tjspecjob;
+
+static void scanSegment(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+	const tjspecjob *job=(const tjspecjob *)worker->job;
+	tjspecseg *seg=&job->segs[worker->index];
+	j_decompress_ptr dinfo=&worker->dinfo;
+	jpeg_entropy_checkpoint ckpt;
+	size_t *bitPos;  int *dcVal, ncomps;
+	JDIMENSION n;
+
+	worker->retval=0;
+	if(setjmp(worker->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		worker->retval=-1;
+		goto bailout;
+	}
+
+	jpeg_mem_src_tj(dinfo, job->jpegBuf, job->jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+	jpeg_start_decompress(dinfo);
+	ncomps=dinfo->comps_in_scan;
+	MEMZERO(&ckpt, sizeof(jpeg_entropy_checkpoint));
+	ckpt.offset=seg->startPos/8;
+	if(!(*dinfo->entropy->restore_checkpoint)(dinfo, &ckpt)) goto bailout;
+
+	do
+	{
+		if(seg->numMCUs==seg->maxMCUs)
+		{
+			if((bitPos=(size_t *)realloc(seg->bitPos,
+				sizeof(size_t)*seg->maxMCUs*2))==NULL)
+				goto memfail;
+			seg->bitPos=bitPos;
+			if((dcVal=(int *)realloc(seg->dcVal,
+				sizeof(int)*ncomps*seg->maxMCUs*2))==NULL)
+				goto memfail;
+			seg->dcVal=dcVal;
+			seg->maxMCUs*=2;
+		}
+		n=(*dinfo->entropy->scan_mcus)(dinfo, seg->endPos,
+			&seg->bitPos[seg->numMCUs], &seg->dcVal[seg->numMCUs*ncomps],
+			seg->maxMCUs-seg->numMCUs);
+		seg->numMCUs+=n;
+	} while(seg->numMCUs==seg->maxMCUs);
+	goto bailout;
+
+	memfail:
+	snprintf(worker->errStr, JMSG_LENGTH_MAX,
+		"tjDecompress2(): Memory allocation failure");
+	worker->retval=-1;
+
+	bailout:
+	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+}
+
+/* Build entropy checkpoints for a single-scan Huffman-coded image without
+   restart markers by speculatively scanning segments of the entropy-coded data
+   in parallel.  The scan of the first segment starts from the beginning of the
+   data, so it is known to be correct.  Each subsequent scan is accepted only
+   if it shares an MCU boundary with the (accepted) scan of the preceding
+   segment.  That boundary also establishes the MCU number and the DC
+   predictions for the rest of the scan.  If a scan cannot be matched, then
+   it and all subsequent scans are discarded, and no checkpoints are created
+   for the remainder of the image.  Returns the number of checkpoints, or -1 if
+   an error occurred. */
+static int speculateCheckpoints(tjinstance *this,
+	const unsigned char *jpegBuf, unsigned long jpegSize,
+	jpeg_entropy_checkpoint *checkpoints, JDIMENSION mcusPerIMCURow)
+{
+	j_decompress_ptr dinfo=&this->dinfo;
+	const unsigned char *scanStart=dinfo->src->next_input_byte, *ptr,
+		*end=&jpegBuf[jpegSize];
+	JDIMENSION totalMCUs=dinfo->total_iMCU_rows*mcusPerIMCURow, row, mcu, i;
+	size_t scanSize, start, pos;
+	int ncomps=dinfo->comps_in_scan, numSegs, numValid, numCheckpoints=0, k, c;
+	int retval=0;
+	tjspecseg *segs=NULL, *prev, *seg;
+	tjspecjob job;
+
+	/* Find the marker that terminates the entropy-coded data.  Fill bytes
+	   (0xFF 0xFF) confuse the position calculations, so don't bother with
+	   images that contain them. */
+	for(ptr=scanStart; ; ptr+=2)
+	{
+		if(ptr>=end-1
+			|| (ptr=(const unsigned char *)memchr(ptr, 0xFF, end-ptr-1))==NULL)
+			return 0;
+		if(ptr[1]!=0) break;
+	}
+	if(ptr[1]==0xFF) return 0;
+	scanSize=ptr-scanStart;
+
+	numSegs=min(this->numThreads, (int)(scanSize/SPEC_MIN_SEGMENT));
+	if(numSegs<2) return 0;
+	if((segs=(tjspecseg *)calloc(numSegs, sizeof(tjspecseg)))==NULL)
+		_throw("tjDecompress2(): Memory allocation failure");
+	for(k=0; k<numSegs; k++)
+	{
+		/* Don't start on the zero byte that follows a 0xFF data byte */
+		start=scanSize*k/numSegs;
+		if(k>0 && scanStart[start]==0 && scanStart[start-1]==0xFF) start++;
+		segs[k].startPos=start*8;
+	}
+	for(k=0; k<numSegs; k++)
+	{
+		seg=&segs[k];
+		if(k<numSegs-1)
+			seg->endPos=min(segs[k+1].startPos+SPEC_OVERLAP*8, scanSize*8);
+		else seg->endPos=scanSize*8+8;
+		seg->maxMCUs=(JDIMENSION)((double)totalMCUs*(seg->endPos-seg->startPos)
+			/(scanSize*8))+64;
+		if((seg->bitPos=(size_t *)malloc(sizeof(size_t)*seg->maxMCUs))==NULL
+			|| (seg->dcVal=(int *)malloc(sizeof(int)*ncomps*seg->maxMCUs))==NULL)
+			_throw("tjDecompress2(): Memory allocation failure");
+	}
+
+	if(initWorkers(this, numSegs, DECOMPRESS)==-1)
+		_throw("tjDecompress2(): Memory allocation failure");
+	job.jpegBuf=jpegBuf;  job.jpegSize=jpegSize;  job.segs=segs;
+	if((k=runWorkers(this, numSegs, scanSegment, &job))>=0)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX, "%s", this->workers[k]->errStr);
+		retval=-1;  goto bailout;
+	}
+
+	/* Validate the scans by matching each against the preceding one */
+	for(k=1; k<numSegs; k++)
+	{
+		JDIMENSION a, b=0;
+		prev=&segs[k-1];  seg=&segs[k];
+		a=prev->first;
+		while(a<prev->numMCUs && b<seg->numMCUs
+			&& prev->bitPos[a]!=seg->bitPos[b])
+		{
+			if(prev->bitPos[a]<seg->bitPos[b]) a++;
+			else b++;
+		}
+		if(a>=prev->numMCUs || b>=seg->numMCUs) break;
+		prev->last=a;
+		seg->first=b;
+		seg->firstMCU=prev->firstMCU+(a-prev->first);
+		for(c=0; c<ncomps; c++)
+			seg->dcOffset[c]=(int)((unsigned int)prev->dcVal[a*ncomps+c]
+				+(unsigned int)prev->dcOffset[c]-(unsigned int)seg->dcVal[b*ncomps+c]);
+	}
+	numValid=k;
+	segs[numValid-1].last=segs[numValid-1].numMCUs;
+
+	/* Create a checkpoint at the start of each iMCU row covered by the accepted
+	   scans.  A position that is not on a byte boundary leaves the remainder of
+	   the byte in the bit buffer. */
+	for(row=1, k=0; row<dinfo->total_iMCU_rows; row++)
+	{
+		jpeg_entropy_checkpoint *ckpt=&checkpoints[numCheckpoints];
+		mcu=row*mcusPerIMCURow;
+		while(k<numValid && mcu>=segs[k].firstMCU+(segs[k].last-segs[k].first))
+			k++;
+		if(k>=numValid) break;
+		seg=&segs[k];
+		i=seg->first+(mcu-seg->firstMCU);
+		pos=seg->bitPos[i];
+		MEMZERO(ckpt, sizeof(jpeg_entropy_checkpoint));
+		ckpt->iMCU_row=row;
+		ckpt->offset=pos/8;
+		if(pos%8)
+		{
+			ckpt->get_buffer=scanStart[ckpt->offset];
+			ckpt->bits_left=8-(int)(pos%8);
+			ckpt->offset+=(scanStart[ckpt->offset]==0xFF ? 2:1);
+		}
+		for(c=0; c<ncomps; c++)
+			ckpt->last_dc_val[c]=(int)((unsigned int)seg->dcVal[i*ncomps+c]
+				+(unsigned int)seg->dcOffset[c]);
+		numCheckpoints++;
+	}
+	retval=numCheckpoints;
+
+	bailout:
+	if(segs)
+	{
+		for(k=0; k<numSegs; k++)
+		{
+			if(segs[k].bitPos) free(segs[k].bitPos);
+			if(segs[k].dcVal) free(segs[k].dcVal);
+		}
+		free(segs);
+	}
+	return retval;
+}
+
+/* Returns nonzero if decompressParallel() can be used with the JPEG image,
+   whose header has been read into dinfo. */
+static int canDecompressParallel(tjinstance *this,
+	const unsigned char *jpegBuf, unsigned long jpegSize, int flags)
+{
+	j_decompress_ptr dinfo=&this->dinfo;
+
+	return !dinfo->progressive_mode && !dinfo->arith_code
+		&& !dinfo->inputctl->has_multiple_scans && dinfo->total_iMCU_rows>=2
+		&& (dinfo->restart_interval!=0 || matchIndex(this, jpegBuf, jpegSize)
+			|| (flags&TJFLAG_SPECULATIVE));
+}
+
+/* If the JPEG image is a single-scan Huffman-coded image with restart
+   markers, split it into bands of iMCU rows that begin at restart boundaries
+   and decompress the bands in parallel.  If an index for the image has been
+   attached with tjSetIndex(), then the bands begin at its checkpoints instead.
+   If the image has no restart markers or index and TJFLAG_SPECULATIVE is
+   specified, then the band boundaries are found by speculatively scanning the
+   entropy-coded data.  dinfo must have been started with the desired
+   decompression parameters.  Returns 1 if the image
+   was decompressed, 0 if the image is not suitable for parallel decompression,
+   or -1 if an error occurred. */
+static int decompressParallel(tjinstance *this, const unsigned char *jpegBuf,
+	unsigned long jpegSize, JSAMPROW *row_pointer, int pixelFormat, int flags)
+{
+	j_decompress_ptr dinfo=&this->dinfo;
+	jpeg_entropy_checkpoint *checkpoints=NULL;
+	const unsigned char *scanStart, *ptr, *end=&jpegBuf[jpegSize];
+	JDIMENSION mcusPerIMCURow, mcu, row, totalRows=dinfo->total_iMCU_rows;
+	int numCheckpoints=0, numBands, linesPerIMCURow, marker=0, i, j;
+	int retval=0;
+	const tjindex *index=matchIndex(this, jpegBuf, jpegSize);
+	tjdecompjob job;
+
+	if(!canDecompressParallel(this, jpegBuf, jpegSize, flags)) return 0;
+
+	mcusPerIMCURow=dinfo->MCUs_per_row;
+	if(dinfo->comps_in_scan==1)
+		mcusPerIMCURow*=dinfo->cur_comp_info[0]->v_samp_factor;
+
+	if((checkpoints=(jpeg_entropy_checkpoint *)malloc(
+		sizeof(jpeg_entropy_checkpoint)*totalRows))==NULL)
+		_throw("tjDecompress2(): Memory allocation failure");
+	if(index)
+	{
+		numCheckpoints=index->numCheckpoints;
+		if(numCheckpoints>0)
+			memcpy(checkpoints, index->checkpoints,
+				sizeof(jpeg_entropy_checkpoint)*numCheckpoints);
+	}
+	else if(dinfo->restart_interval==0)
+	{
+		if((numCheckpoints=speculateCheckpoints(this, jpegBuf, jpegSize,
+			checkpoints, mcusPerIMCURow))==-1)
+		{
+			retval=-1;  goto bailout;
+		}
+	}
+	else
+	{
+		/* Locate the restart markers.  Each one that falls on an iMCU row
+		   boundary yields a checkpoint at which the entropy decoder can be
+		   restarted with its state reset. */
+		scanStart=ptr=dinfo->src->next_input_byte;
+		while(ptr<end-1
+			&& (ptr=(const unsigned char *)memchr(ptr, 0xFF, end-ptr-1))!=NULL)
+		{
+			while(ptr<end-2 && ptr[1]==0xFF) ptr++;
+			if(ptr[1]==0) {ptr+=2;  continue;}
+			if(ptr[1]!=0xD0+(marker&7)) break;
+			ptr+=2;  marker++;
+			mcu=dinfo->restart_interval*marker;
+			if(mcu%mcusPerIMCURow) continue;
+			if((row=mcu/mcusPerIMCURow)>=totalRows) break;
+			MEMZERO(&checkpoints[numCheckpoints], sizeof(jpeg_entropy_checkpoint));
+			checkpoints[numCheckpoints].iMCU_row=row;
+			checkpoints[numCheckpoints].offset=ptr-scanStart;
+			checkpoints[numCheckpoints].restarts_to_go=dinfo->restart_interval;
+			checkpoints[numCheckpoints].next_restart_num=marker&7;
+			numCheckpoints++;
+		}
+	}
+
+	/* Divide the image into bands of approximately equal height */
+	numBands=min(this->numThreads, numCheckpoints+1);
+	if(numBands<2) goto bailout;
+	if(initWorkers(this, numBands, DECOMPRESS)==-1)
+		_throw("tjDecompress2(): Memory allocation failure");
+	linesPerIMCURow=dinfo->max_v_samp_factor*dinfo->_min_DCT_scaled_size;
+	this->workers[0]->startRow=0;
+	for(i=1, j=0; i<numBands; i++)
+	{
+		row=totalRows*i/numBands;
+		while(j<numCheckpoints && checkpoints[j].iMCU_row<row) j++;
+		if(j>=numCheckpoints) break;
+		this->workers[i]->startRow=checkpoints[j++].iMCU_row*linesPerIMCURow;
+		this->workers[i-1]->endRow=this->workers[i]->startRow;
+	}
+	if((numBands=i)<2) goto bailout;
+	this->workers[numBands-1]->endRow=dinfo->output_height;
+
+	job.jpegBuf=jpegBuf;  job.jpegSize=jpegSize;
+	job.row_pointer=row_pointer;
+	job.pixelFormat=pixelFormat;  job.flags=flags;
+	job.scaleNum=dinfo->scale_num;  job.scaleDenom=dinfo->scale_denom;
+	job.checkpoints=checkpoints;  job.numCheckpoints=numCheckpoints;
+
+	if((i=runWorkers(this, numBands, decompressRows, &job))>=0)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX, "%s", this->workers[i]->errStr);
+		retval=-1;
+	}
+	else retval=1;
+
+	bailout:
+	if(checkpoints) free(checkpoints);
+	return retval;
+}
+
+
+/* Pipelined decompression.  A worker thread entropy-decodes the image into a
+   small ring of coefficient buffers (see consume_ring() in jdcoefct.c), while
+   the calling thread performs the inverse DCT, upsampling, and color
+   conversion on the iMCU rows that have already been decoded. */
+
+#define PIPELINE_RING_ROWS 4
+
+typedef struct _tjpipeline
+{
+	tjmutex mutex;
+	tjcond cond;
+	tjinstance *inst;
+	const unsigned char *jpegBuf;
+	unsigned long jpegSize;
+	JSAMPROW *row_pointer;
+	JDIMENSION decoded, output;  /* # of iMCU rows decoded/output so far */
+	int stop;
+} tjpipeline;
+
+/* Returns nonzero if decompressPipelined() can be used with the JPEG image,
+   whose header has been read into dinfo.  The calling thread must then set
+   dinfo->master->coef_ring_rows to PIPELINE_RING_ROWS before starting dinfo,
+   so that dinfo allocates the ring and reads the coefficients from it. */
+static int canDecompressPipelined(tjinstance *this)
+{
+	j_decompress_ptr dinfo=&this->dinfo;
+
+	return !dinfo->inputctl->has_multiple_scans && dinfo->total_iMCU_rows>=2;
+}
+
+/* Entropy-decode the image into the ring (run by the second worker.)  If the
+   worker did not get its own thread, then the image has already been decoded
+   by outputRows(), so there is nothing left to do. */
+static void decodeCoefficients(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+	tjpipeline *pipe=(tjpipeline *)worker->job;
+	j_decompress_ptr dinfo=&worker->dinfo;
+	JDIMENSION row;  int ci, stop=0;
+
+	worker->retval=0;
+	worker->jerr.warning=FALSE;
+	if(!worker->threaded) return;
+	if(setjmp(worker->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		worker->retval=-1;
+		goto bailout;
+	}
+
+	jpeg_mem_src_tj(dinfo, pipe->jpegBuf, pipe->jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+	dinfo->master->coef_ring_rows=PIPELINE_RING_ROWS;
+	for(ci=0; ci<MAX_COMPONENTS; ci++)
+		dinfo->master->coef_ring[ci]=pipe->inst->dinfo.master->coef_ring[ci];
+	jpeg_start_decompress(dinfo);
+
+	for(row=0; row<dinfo->total_iMCU_rows; row++)
+	{
+		/* Wait until the ring slot for this row has been output */
+		tjMutexLock(&pipe->mutex);
+		while(row-pipe->output>=PIPELINE_RING_ROWS && !pipe->stop)
+			tjCondWait(&pipe->cond, &pipe->mutex);
+		stop=pipe->stop;
+		tjMutexUnlock(&pipe->mutex);
+		if(stop) break;
+
+		jpeg_consume_input(dinfo);
+
+		tjMutexLock(&pipe->mutex);
+		pipe->decoded=row+1;
+		tjCondBroadcast(&pipe->cond);
+		tjMutexUnlock(&pipe->mutex);
+	}
+
+	bailout:
+	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+	dinfo->master->coef_ring_rows=0;
+	for(ci=0; ci<MAX_COMPONENTS; ci++) dinfo->master->coef_ring[ci]=NULL;
+	if(worker->jerr.warning) worker->retval=-1;
+	if(worker->retval==-1)
+	{
+		tjMutexLock(&pipe->mutex);
+		pipe->stop=1;
+		tjCondBroadcast(&pipe->cond);
+		tjMutexUnlock(&pipe->mutex);
+	}
+}
+
+/* Output the image from the ring (run by the first worker, in the calling
+   thread.)  If the second worker could not be given its own thread, then the
+   calling thread's decompressor decodes each iMCU row into the ring itself
+   before outputting it. */
+static void outputRows(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+	tjpipeline *pipe=(tjpipeline *)worker->job;
+	tjinstance *this=pipe->inst;
+	j_decompress_ptr dinfo=&this->dinfo;
+	int threaded=this->workers[1]->threaded, stop=0;
+
+	worker->retval=0;
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		snprintf(worker->errStr, JMSG_LENGTH_MAX, "%s", errStr);
+		worker->retval=-1;
+		goto bailout;
+	}
+
+	while(dinfo->output_scanline<dinfo->output_height)
+	{
+		if(threaded)
+		{
+			/* Wait until the next iMCU row has been decoded */
+			tjMutexLock(&pipe->mutex);
+			while(pipe->decoded<=dinfo->output_iMCU_row
+				&& pipe->decoded<dinfo->total_iMCU_rows && !pipe->stop)
+				tjCondWait(&pipe->cond, &pipe->mutex);
+			dinfo->master->coef_ring_avail=pipe->decoded;
+			stop=pipe->stop;
+			tjMutexUnlock(&pipe->mutex);
+			if(stop) break;
+		}
+		else
+		{
+			while(dinfo->input_iMCU_row<=dinfo->output_iMCU_row
+				&& dinfo->input_iMCU_row<dinfo->total_iMCU_rows)
+				jpeg_consume_input(dinfo);
+			dinfo->master->coef_ring_avail=dinfo->input_iMCU_row;
+		}
+
+		jpeg_read_scanlines(dinfo, &pipe->row_pointer[dinfo->output_scanline],
+			dinfo->output_height-dinfo->output_scanline);
+
+		if(threaded)
+		{
+			tjMutexLock(&pipe->mutex);
+			pipe->output=dinfo->output_iMCU_row;
+			tjCondBroadcast(&pipe->cond);
+			tjMutexUnlock(&pipe->mutex);
+		}
+	}
+
+	bailout:
+	tjMutexLock(&pipe->mutex);
+	pipe->stop=1;
+	tjCondBroadcast(&pipe->cond);
+	tjMutexUnlock(&pipe->mutex);
+}
+
+static void runPipeline(void *arg)
+{
+	tjworker *worker=(tjworker *)arg;
+
+	if(worker->index==0) outputRows(arg);
+	else decodeCoefficients(arg);
+}
+
+/* Decompress a single-scan JPEG image using the instance's first two workers,
+   one of which outputs the image while the other entropy-decodes it.  dinfo
+   must have been started in pipelined mode (see canDecompressPipelined().)
+   Returns 0 if the image was decompressed or -1 if an error occurred. */
+static int decompressPipelined(tjinstance *this, const unsigned char *jpegBuf,
+	unsigned long jpegSize, JSAMPROW *row_pointer)
+{
+	j_decompress_ptr dinfo=&this->dinfo;
+	int ci, i, retval=0;
+	tjpipeline pipe;
+
+	pipe.inst=this;
+	pipe.jpegBuf=jpegBuf;  pipe.jpegSize=jpegSize;
+	pipe.row_pointer=row_pointer;
+	pipe.decoded=pipe.output=0;  pipe.stop=0;
+	if(tjMutexInit(&pipe.mutex)==-1)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX, "tjDecompress2(): Could not create mutex");
+		return -1;
+	}
+	if(tjCondInit(&pipe.cond)==-1)
+	{
+		tjMutexDestroy(&pipe.mutex);
+		snprintf(errStr, JMSG_LENGTH_MAX,
+			"tjDecompress2(): Could not create condition variable");
+		return -1;
+	}
+	if(initWorkers(this, 2, DECOMPRESS)==-1)
+		_throw("tjDecompress2(): Memory allocation failure");
+
+	if((i=runWorkers(this, 2, runPipeline, &pipe))>=0)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX, "%s", this->workers[i]->errStr);
+		retval=-1;
+	}
+
+	bailout:
+	dinfo->master->coef_ring_rows=0;
+	for(ci=0; ci<MAX_COMPONENTS; ci++) dinfo->master->coef_ring[ci]=NULL;
+	tjCondDestroy(&pipe.cond);
+	tjMutexDestroy(&pipe.mutex);
+	return retval;
+}
+
+/* Decompress a JPEG image stored in either a JPEG buffer (if segSrc is NULL)
+   or a list of segments.  The multithreaded code paths need the whole JPEG
+   image in one buffer, so they are used only in the former case. */
+static int decompress(tjhandle handle, const unsigned char *jpegBuf,
+	unsigned long jpegSize, tjsegsrc *segSrc, unsigned char *dstBuf, int width,
+	int pitch, int height, int pixelFormat, int flags)
+{
+	int i, retval=0, pipelined=0;  JSAMPROW *row_pointer=NULL;
+	struct jpeg_source_mgr *src=NULL;
+	int jpegwidth, jpegheight, scaledw, scaledh;
+	#ifndef JCS_EXTENSIONS
+	unsigned char *rgbBuf=NULL;
+	unsigned char *_dstBuf=NULL;  int _pitch=0;
+	#endif
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompress2(): Instance has not been initialized for decompression");
+
+	if((segSrc==NULL && (jpegBuf==NULL || jpegSize<=0)) || dstBuf==NULL
+		|| width<0 || pitch<0 || height<0 || pixelFormat<0
+		|| pixelFormat>=TJ_NUMPF)
+		_throw("tjDecompress2(): Invalid argument");
+
+	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
+	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
+	else if(flags&TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	if(segSrc)
+	{
+		src=dinfo->src;  dinfo->src=&segSrc->pub;
+	}
+	else jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+	if(setDecompDefaults(dinfo, pixelFormat, flags)==-1)
+	{
+		retval=-1;  goto bailout;
+	}
+
+	if(flags&TJFLAG_FASTUPSAMPLE) dinfo->do_fancy_upsampling=FALSE;
+
+	jpegwidth=dinfo->image_width;  jpegheight=dinfo->image_height;
+	if(width==0) width=jpegwidth;
+	if(height==0) height=jpegheight;
+	for(i=0; i<NUMSF; i++)
+	{
+		scaledw=TJSCALED(jpegwidth, sf[i]);
+		scaledh=TJSCALED(jpegheight, sf[i]);
+		if(scaledw<=width && scaledh<=height)
+			break;
+	}
+	if(i>=NUMSF)
+		_throw("tjDecompress2(): Could not scale down to desired image dimensions");
+	width=scaledw;  height=scaledh;
+	dinfo->scale_num=sf[i].num;
+	dinfo->scale_denom=sf[i].denom;
+
+	/* Images that cannot be decompressed in parallel bands are decompressed in
+	   pipelined mode instead, which must be chosen before dinfo is started. */
+	if(this->numThreads>1 && !segSrc
+		&& !canDecompressParallel(this, jpegBuf, jpegSize, flags)
+		&& canDecompressPipelined(this))
+	{
+		pipelined=1;
+		dinfo->master->coef_ring_rows=PIPELINE_RING_ROWS;
+		dinfo->master->coef_ring_avail=0;
+	}
+	jpeg_start_decompress(dinfo);
+	if(pitch==0) pitch=dinfo->output_width*tjPixelSize[pixelFormat];
+
+	#ifndef JCS_EXTENSIONS
+	if(pixelFormat!=TJPF_GRAY && pixelFormat!=TJPF_CMYK &&
+		(RGB_RED!=tjRedOffset[pixelFormat] ||
+			RGB_GREEN!=tjGreenOffset[pixelFormat] ||
+			RGB_BLUE!=tjBlueOffset[pixelFormat] ||
+			RGB_PIXELSIZE!=tjPixelSize[pixelFormat]))
+	{
+		rgbBuf=(unsigned char *)malloc(width*height*3);
+		if(!rgbBuf) _throw("tjDecompress2(): Memory allocation failure");
+		_pitch=pitch;  pitch=width*3;
+		_dstBuf=dstBuf;  dstBuf=rgbBuf;
+	}
+	#endif
+
+	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)
+		*dinfo->output_height))==NULL)
+		_throw("tjDecompress2(): Memory allocation failure");
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+	for(i=0; i<(int)dinfo->output_height; i++)
+	{
+		if(flags&TJFLAG_BOTTOMUP)
+			row_pointer[i]=&dstBuf[(dinfo->output_height-i-1)*pitch];
+		else row_pointer[i]=&dstBuf[i*pitch];
+	}
+	if(pipelined)
+	{
+		pipelined=0;
+		if(decompressPipelined(this, jpegBuf, jpegSize, row_pointer)==-1)
+		{
+			retval=-1;  goto bailout;
+		}
+	}
+	else if(this->numThreads>1 && !segSrc
+		&& (i=decompressParallel(this, jpegBuf, jpegSize, row_pointer,
+			pixelFormat, flags))!=0)
+	{
+		if(i==-1) {retval=-1;  goto bailout;}
+	}
+	else
+	{
+		while(dinfo->output_scanline<dinfo->output_height)
+		{
+			jpeg_read_scanlines(dinfo, &row_pointer[dinfo->output_scanline],
+				dinfo->output_height-dinfo->output_scanline);
+		}
+		jpeg_finish_decompress(dinfo);
+	}
+
+	#ifndef JCS_EXTENSIONS
+	fromRGB(rgbBuf, _dstBuf, width, _pitch, height, pixelFormat);
+	#endif
+
+	bailout:
+	if(pipelined)
+	{
+		dinfo->master->coef_ring_rows=0;
+		for(i=0; i<MAX_COMPONENTS; i++) dinfo->master->coef_ring[i]=NULL;
+	}
+	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+	if(segSrc && dinfo->src==&segSrc->pub) dinfo->src=src;
+	#ifndef JCS_EXTENSIONS
+	if(rgbBuf) free(rgbBuf);
+	#endif
+	if(row_pointer) free(row_pointer);
+	if(this->jerr.warning) retval=-1;
+	return retval;
+}
+
+DLLEXPORT int DLLCALL tjDecompress2(tjhandle handle,
+	const unsigned char *jpegBuf, unsigned long jpegSize, unsigned char *dstBuf,
+	int width, int pitch, int height, int pixelFormat, int flags)
+{
+	return decompress(handle, jpegBuf, jpegSize, NULL, dstBuf, width, pitch,
+		height, pixelFormat, flags);
+}
+
+DLLEXPORT int DLLCALL tjDecompressHeaderFromSegments(tjhandle handle,
+	const tjsegment *segments, int numSegments, int *width, int *height,
+	int *jpegSubsamp, int *jpegColorspace)
+{
+	tjsegsrc src;
+
+	if(initSegSrc(&src, segments, numSegments)==-1)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX,
+			"tjDecompressHeaderFromSegments(): Invalid argument");
+		return -1;
+	}
+	return decompressHeader(handle, NULL, 0, &src, width, height, jpegSubsamp,
+		jpegColorspace);
+}
+
+DLLEXPORT int DLLCALL tjDecompressFromSegments(tjhandle handle,
+	const tjsegment *segments, int numSegments, unsigned char *dstBuf,
+	int width, int pitch, int height, int pixelFormat, int flags)
+{
+	tjsegsrc src;
+
+	if(initSegSrc(&src, segments, numSegments)==-1)
+	{
+		snprintf(errStr, JMSG_LENGTH_MAX,
+			"tjDecompressFromSegments(): Invalid argument");
+		return -1;
+	}
+	return decompress(handle, NULL, 0, &src, dstBuf, width, pitch, height,
+		pixelFormat, flags);
+}
+
+DLLEXPORT int DLLCALL tjDecompressRegion(tjhandle handle,
+	const unsigned char *jpegBuf, unsigned long jpegSize,
+	tjscalingfactor scalingFactor, tjregion region, unsigned char *dstBuf,
+	int pitch, int pixelFormat, int flags)
+{
+	int i, retval=0, ps, cps;
+	int jpegwidth, jpegheight, scaledw, scaledh;
+	JDIMENSION xoff, cropw, row, nrows;
+	JSAMPARRAY scratch;
+	const tjindex *index;
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompressRegion(): Instance has not been initialized for decompression");
+
+	if(jpegBuf==NULL || jpegSize<=0 || dstBuf==NULL || pitch<0
+		|| pixelFormat<0 || pixelFormat>=TJ_NUMPF || region.x<0 || region.y<0
+		|| region.w<0 || region.h<0)
+		_throw("tjDecompressRegion(): Invalid argument");
+
+	for(i=0; i<NUMSF; i++)
+	{
+		if(scalingFactor.num==sf[i].num && scalingFactor.denom==sf[i].denom)
+			break;
+	}
+	if(i>=NUMSF)
+		_throw("tjDecompressRegion(): Unsupported scaling factor");
+
+	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
+	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
+	else if(flags&TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+	if(setDecompDefaults(dinfo, pixelFormat, flags)==-1)
+	{
+		retval=-1;  goto bailout;
+	}
+
+	if(flags&TJFLAG_FASTUPSAMPLE) dinfo->do_fancy_upsampling=FALSE;
+
+	jpegwidth=dinfo->image_width;  jpegheight=dinfo->image_height;
+	scaledw=TJSCALED(jpegwidth, scalingFactor);
+	scaledh=TJSCALED(jpegheight, scalingFactor);
+	if(region.w==0) region.w=scaledw-region.x;
+	if(region.h==0) region.h=scaledh-region.y;
+	if(region.w<=0 || region.h<=0 || region.x+region.w>scaledw
+		|| region.y+region.h>scaledh)
+		_throw("tjDecompressRegion(): Region is outside of the scaled image");
+	dinfo->scale_num=scalingFactor.num;
+	dinfo->scale_denom=scalingFactor.denom;
+
+	jpeg_start_decompress(dinfo);
+	ps=tjPixelSize[pixelFormat];
+	cps=dinfo->output_components;
+	if(pitch==0) pitch=region.w*ps;
+
+	/* Widen the crop by one pixel on either side of the region, so that the
+	   fancy upsampler sees the same neighboring pixels that it would see when
+	   decompressing the whole image.  jpeg_crop_scanline() will move the left
+	   edge further to the nearest iMCU boundary. */
+	xoff=region.x>0? region.x-1:0;
+	cropw=min(region.x+region.w+1, scaledw)-xoff;
+	jpeg_crop_scanline(dinfo, &xoff, &cropw);
+
+	nrows=dinfo->rec_outbuf_height;
+	scratch=(*dinfo->mem->alloc_sarray)((j_common_ptr)dinfo, JPOOL_IMAGE,
+		cropw*cps, nrows);
+
+	if(region.y>0)
+	{
+		if((index=matchIndex(this, jpegBuf, jpegSize))!=NULL)
+		{
+			dinfo->master->checkpoints=index->checkpoints;
+			dinfo->master->num_checkpoints=index->numCheckpoints;
+		}
+		jpeg_skip_scanlines(dinfo, region.y);
+	}
+	for(i=0; i<region.h; )
+	{
+		nrows=jpeg_read_scanlines(dinfo, scratch,
+			min(dinfo->rec_outbuf_height, region.h-i));
+		for(row=0; row<nrows; row++, i++)
+		{
+			unsigned char *src=&scratch[row][(region.x-xoff)*cps];
+			unsigned char *dst=(flags&TJFLAG_BOTTOMUP)?
+				&dstBuf[(region.h-i-1)*pitch]:&dstBuf[i*pitch];
+			#ifndef JCS_EXTENSIONS
+			if(pixelFormat!=TJPF_GRAY && pixelFormat!=TJPF_CMYK &&
+				(RGB_RED!=tjRedOffset[pixelFormat] ||
+					RGB_GREEN!=tjGreenOffset[pixelFormat] ||
+					RGB_BLUE!=tjBlueOffset[pixelFormat] ||
+					RGB_PIXELSIZE!=tjPixelSize[pixelFormat]))
+			{
+				fromRGB(src, dst, region.w, pitch, 1, pixelFormat);
+				continue;
+			}
+			#endif
+			memcpy(dst, src, region.w*ps);
+		}
+	}
+
+	bailout:
+	if(dinfo->global_state>DSTATE_START)
+	{
+		dinfo->master->checkpoints=NULL;
+		dinfo->master->num_checkpoints=0;
+		jpeg_abort_decompress(dinfo);
+	}
 	if(this->jerr.warning) retval=-1;
 	return retval;
 }
 
-DLLEXPORT int DLLCALL tjDecompressHeader2(tjhandle handle,
-	unsigned char *jpegBuf, unsigned long jpegSize, int *width, int *height,
-	int *jpegSubsamp)
+DLLEXPORT int DLLCALL tjBuildIndex(tjhandle handle,
+	const unsigned char *jpegBuf, unsigned long jpegSize, int interval,
+	unsigned char **indexBuf, unsigned long *indexSize)
 {
-	int jpegColorspace;
-	return tjDecompressHeader3(handle, jpegBuf, jpegSize, width, height,
-		jpegSubsamp, &jpegColorspace);
+	int retval=0, numCheckpoints=0, c;
+	unsigned char *buf=NULL, *entry;
+	JDIMENSION mcusPerIMCURow, row, mcu, totalRows;
+	jpeg_entropy_checkpoint ckpt;
+	size_t headerSize;
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjBuildIndex(): Instance has not been initialized for decompression");
+
+	if(jpegBuf==NULL || jpegSize<=0 || interval<1 || indexBuf==NULL
+		|| indexSize==NULL)
+		_throw("tjBuildIndex(): Invalid argument");
+
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
+	jpeg_read_header(dinfo, TRUE);
+	if(dinfo->progressive_mode || dinfo->arith_code
+		|| dinfo->inputctl->has_multiple_scans)
+		_throw("tjBuildIndex(): Only single-scan Huffman-coded JPEG images can be indexed");
+	headerSize=dinfo->src->next_input_byte-jpegBuf;
+
+	/* Only the entropy-coded data is needed, so decompress at the smallest
+	   scale to minimize the cost of jpeg_start_decompress() and to allow the
+	   entropy decoder to skip the AC coefficients. */
+	dinfo->scale_num=1;  dinfo->scale_denom=8;
+	jpeg_start_decompress(dinfo);
+	totalRows=dinfo->total_iMCU_rows;
+	mcusPerIMCURow=dinfo->MCUs_per_row;
+	if(dinfo->comps_in_scan==1)
+		mcusPerIMCURow*=dinfo->cur_comp_info[0]->v_samp_factor;
+
+	if((buf=(unsigned char *)malloc(INDEX_HEADER_SIZE
+		+INDEX_ENTRY_SIZE*(totalRows/interval+1)))==NULL)
+		_throw("tjBuildIndex(): Memory allocation failure");
+
+	for(row=0; row+1<totalRows; row++)
+	{
+		for(mcu=0; mcu<mcusPerIMCURow; mcu++)
+			(*dinfo->entropy->decode_mcu)(dinfo, NULL);
+		if((row+1)%interval) continue;
+		/* No checkpoint can be taken once the entropy decoder has reached a
+		   marker (for instance, a restart marker at the end of the row.) */
+		if(!(*dinfo->entropy->save_checkpoint)(dinfo, &ckpt)) continue;
+		entry=&buf[INDEX_HEADER_SIZE+INDEX_ENTRY_SIZE*numCheckpoints];
+		MEMZERO(entry, INDEX_ENTRY_SIZE);
+		putIndexValue(&entry[0], row+1, 4);
+		putIndexValue(&entry[4], ckpt.offset, 8);
+		putIndexValue(&entry[12], ckpt.restarts_to_go, 4);
+		entry[16]=(unsigned char)ckpt.bits_left;
+		entry[17]=(unsigned char)ckpt.get_buffer;
+		entry[18]=(unsigned char)ckpt.next_restart_num;
+		for(c=0; c<dinfo->comps_in_scan; c++)
+			putIndexValue(&entry[20+c*4], (unsigned int)ckpt.last_dc_val[c], 4);
+		numCheckpoints++;
+	}
+	/* A checkpoint taken after corrupt data would be meaningless */
+	if(this->jerr.warning) goto bailout;
+
+	memcpy(buf, "TJI1", 4);
+	putIndexValue(&buf[4], jpegSize, 8);
+	putIndexValue(&buf[12], headerSize, 4);
+	putIndexValue(&buf[16], hashHeaders(jpegBuf, (unsigned int)headerSize), 4);
+	putIndexValue(&buf[20], totalRows, 4);
+	putIndexValue(&buf[24], dinfo->comps_in_scan, 4);
+	putIndexValue(&buf[28], numCheckpoints, 4);
+	*indexBuf=buf;  buf=NULL;
+	*indexSize=INDEX_HEADER_SIZE+INDEX_ENTRY_SIZE*numCheckpoints;
+
+	bailout:
+	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+	if(buf) free(buf);
+	if(this->jerr.warning) retval=-1;
+	return retval;
 }
 
-DLLEXPORT int DLLCALL tjDecompressHeader(tjhandle handle,
-	unsigned char *jpegBuf, unsigned long jpegSize, int *width, int *height)
+DLLEXPORT int DLLCALL tjSetIndex(tjhandle handle,
+	const unsigned char *indexBuf, unsigned long indexSize)
 {
-	int jpegSubsamp;
-	return tjDecompressHeader2(handle, jpegBuf, jpegSize, width, height,
-		&jpegSubsamp);
-}
+	int retval=0, numCheckpoints, i, c;
+	tjindex *index=NULL;
+	const unsigned char *entry;
+	jpeg_entropy_checkpoint *ckpt;
+	tjinstance *this=(tjinstance *)handle;
 
+	if(!this) _throw("Invalid handle");
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjSetIndex(): Instance has not been initialized for decompression");
 
-DLLEXPORT tjscalingfactor* DLLCALL tjGetScalingFactors(int *numscalingfactors)
-{
-	if(numscalingfactors==NULL)
+	if(this->index)
 	{
-		snprintf(errStr, JMSG_LENGTH_MAX,
-			"tjGetScalingFactors(): Invalid argument");
-		return NULL;
+		if(this->index->checkpoints) free(this->index->checkpoints);
+		free(this->index);
+		this->index=NULL;
+	}
+	if(indexBuf==NULL) return 0;
+
+	if(indexSize<INDEX_HEADER_SIZE || memcmp(indexBuf, "TJI1", 4))
+		_throw("tjSetIndex(): Invalid index");
+	numCheckpoints=(int)getIndexValue(&indexBuf[28], 4);
+	if(numCheckpoints<0 || (indexSize-INDEX_HEADER_SIZE)/INDEX_ENTRY_SIZE
+		!=(unsigned long)numCheckpoints
+		|| (indexSize-INDEX_HEADER_SIZE)%INDEX_ENTRY_SIZE)
+		_throw("tjSetIndex(): Invalid index");
+
+	if((index=(tjindex *)malloc(sizeof(tjindex)))==NULL)
+		_throw("tjSetIndex(): Memory allocation failure");
+	MEMZERO(index, sizeof(tjindex));
+	index->jpegSize=(unsigned long)getIndexValue(&indexBuf[4], 8);
+	index->headerSize=(unsigned int)getIndexValue(&indexBuf[12], 4);
+	index->headerHash=(unsigned int)getIndexValue(&indexBuf[16], 4);
+	index->totalIMCURows=(JDIMENSION)getIndexValue(&indexBuf[20], 4);
+	index->compsInScan=(int)getIndexValue(&indexBuf[24], 4);
+	index->numCheckpoints=numCheckpoints;
+	if(index->headerSize>=index->jpegSize || index->compsInScan<1
+		|| index->compsInScan>MAX_COMPS_IN_SCAN)
+		_throw("tjSetIndex(): Invalid index");
+	if(numCheckpoints>0 && (index->checkpoints=(jpeg_entropy_checkpoint *)
+		malloc(sizeof(jpeg_entropy_checkpoint)*numCheckpoints))==NULL)
+		_throw("tjSetIndex(): Memory allocation failure");
+
+	for(i=0; i<numCheckpoints; i++)
+	{
+		entry=&indexBuf[INDEX_HEADER_SIZE+INDEX_ENTRY_SIZE*i];
+		ckpt=&index->checkpoints[i];
+		MEMZERO(ckpt, sizeof(jpeg_entropy_checkpoint));
+		ckpt->iMCU_row=(JDIMENSION)getIndexValue(&entry[0], 4);
+		ckpt->offset=(size_t)getIndexValue(&entry[4], 8);
+		ckpt->restarts_to_go=(unsigned int)getIndexValue(&entry[12], 4);
+		ckpt->bits_left=entry[16];
+		ckpt->get_buffer=entry[17];
+		ckpt->next_restart_num=entry[18];
+		for(c=0; c<index->compsInScan; c++)
+			ckpt->last_dc_val[c]=(int)getIndexValue(&entry[20+c*4], 4);
+		if(ckpt->iMCU_row<1 || ckpt->iMCU_row>=index->totalIMCURows
+			|| (i>0 && ckpt->iMCU_row<=index->checkpoints[i-1].iMCU_row)
+			|| ckpt->offset>=index->jpegSize-index->headerSize
+			|| ckpt->bits_left>7 || ckpt->next_restart_num>7)
+			_throw("tjSetIndex(): Invalid index");
 	}
+	this->index=index;  index=NULL;
 
-	*numscalingfactors=NUMSF;
-	return (tjscalingfactor *)sf;
+	bailout:
+	if(index)
+	{
+		if(index->checkpoints) free(index->checkpoints);
+		free(index);
+	}
+	return retval;
 }
 
-
-DLLEXPORT int DLLCALL tjDecompress2(tjhandle handle,
+DLLEXPORT int DLLCALL tjDecompressBands(tjhandle handle,
 	const unsigned char *jpegBuf, unsigned long jpegSize, unsigned char *dstBuf,
-	int width, int pitch, int height, int pixelFormat, int flags)
+	int width, int pitch, int height, int bandHeight, int pixelFormat,
+	int flags, int (*bandCallback)(unsigned char *band, int y, int numRows,
+		void *data), void *callbackData)
 {
-	int i, retval=0;  JSAMPROW *row_pointer=NULL;
+	int i, retval=0, y, rows;  JSAMPROW *row_pointer=NULL;
 	int jpegwidth, jpegheight, scaledw, scaledh;
 	#ifndef JCS_EXTENSIONS
 	unsigned char *rgbBuf=NULL;
@@ -1391,11 +3871,12 @@ DLLEXPORT int DLLCALL tjDecompress2(tjhandle handle,
 
 	getdinstance(handle);
 	if((this->init&DECOMPRESS)==0)
-		_throw("tjDecompress2(): Instance has not been initialized for decompression");
+		_throw("tjDecompressBands(): Instance has not been initialized for decompression");
 
 	if(jpegBuf==NULL || jpegSize<=0 || dstBuf==NULL || width<0 || pitch<0
-		|| height<0 || pixelFormat<0 || pixelFormat>=TJ_NUMPF)
-		_throw("tjDecompress2(): Invalid argument");
+		|| height<0 || bandHeight<=0 || pixelFormat<0 || pixelFormat>=TJ_NUMPF
+		|| (flags&TJFLAG_BOTTOMUP) || bandCallback==NULL)
+		_throw("tjDecompressBands(): Invalid argument");
 
 	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
 	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
@@ -1428,8 +3909,8 @@ DLLEXPORT int DLLCALL tjDecompress2(tjhandle handle,
 			break;
 	}
 	if(i>=NUMSF)
-		_throw("tjDecompress2(): Could not scale down to desired image dimensions");
-	width=scaledw;  height=scaledh;
+		_throw("tjDecompressBands(): Could not scale down to desired image dimensions");
+	width=scaledw;
 	dinfo->scale_num=sf[i].num;
 	dinfo->scale_denom=sf[i].denom;
 
@@ -1443,49 +3924,350 @@ DLLEXPORT int DLLCALL tjDecompress2(tjhandle handle,
 			RGB_BLUE!=tjBlueOffset[pixelFormat] ||
 			RGB_PIXELSIZE!=tjPixelSize[pixelFormat]))
 	{
-		rgbBuf=(unsigned char *)malloc(width*height*3);
-		if(!rgbBuf) _throw("tjDecompress2(): Memory allocation failure");
+		rgbBuf=(unsigned char *)malloc(width*bandHeight*3);
+		if(!rgbBuf) _throw("tjDecompressBands(): Memory allocation failure");
 		_pitch=pitch;  pitch=width*3;
 		_dstBuf=dstBuf;  dstBuf=rgbBuf;
 	}
 	#endif
 
-	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)
-		*dinfo->output_height))==NULL)
-		_throw("tjDecompress2(): Memory allocation failure");
+	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)*bandHeight))==NULL)
+		_throw("tjDecompressBands(): Memory allocation failure");
+	for(i=0; i<bandHeight; i++) row_pointer[i]=&dstBuf[i*pitch];
+
+	for(y=0; y<(int)dinfo->output_height; y+=rows)
+	{
+		rows=min(bandHeight, (int)dinfo->output_height-y);
+		while(dinfo->output_scanline<(JDIMENSION)(y+rows))
+		{
+			jpeg_read_scanlines(dinfo, &row_pointer[dinfo->output_scanline-y],
+				y+rows-dinfo->output_scanline);
+		}
+		#ifndef JCS_EXTENSIONS
+		if(rgbBuf)
+		{
+			fromRGB(rgbBuf, _dstBuf, width, _pitch, rows, pixelFormat);
+			if(bandCallback(_dstBuf, y, rows, callbackData)==-1)
+				_throw("tjDecompressBands(): Error in band callback");
+			continue;
+		}
+		#endif
+		if(bandCallback(dstBuf, y, rows, callbackData)==-1)
+			_throw("tjDecompressBands(): Error in band callback");
+	}
+	jpeg_finish_decompress(dinfo);
+
+	bailout:
+	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+	#ifndef JCS_EXTENSIONS
+	if(rgbBuf) free(rgbBuf);
+	#endif
+	if(row_pointer) free(row_pointer);
+	if(this->jerr.warning) retval=-1;
+	return retval;
+}
+
+/* Streaming decompression */
+
+static void stream_init_source(j_decompress_ptr dinfo)
+{
+}
+
+/* Called when the decompressor has consumed all of the data that has been
+   fed.  Unless the end of the data has been signaled, suspend the decompressor
+   so that the caller can feed more data.  Otherwise, insert a fake EOI marker,
+   as the in-memory source manager does. */
+static boolean stream_fill_input_buffer(j_decompress_ptr dinfo)
+{
+	static const JOCTET eoi[2]={0xFF, JPEG_EOI};
+	tjstream *stream=(tjstream *)dinfo->src;
+
+	if(!stream->eof) return FALSE;
+	WARNMS(dinfo, JWRN_JPEG_EOF);
+	stream->pub.next_input_byte=eoi;
+	stream->pub.bytes_in_buffer=2;
+	return TRUE;
+}
+
+/* If the decompressor skips past the data that has been fed, then remember
+   how much more needs to be skipped, and skip it as it is fed. */
+static void stream_skip_input_data(j_decompress_ptr dinfo, long num_bytes)
+{
+	tjstream *stream=(tjstream *)dinfo->src;
+
+	if(num_bytes<=0) return;
+	if((size_t)num_bytes>stream->pub.bytes_in_buffer)
+	{
+		stream->skip+=(size_t)num_bytes-stream->pub.bytes_in_buffer;
+		stream->pub.next_input_byte+=stream->pub.bytes_in_buffer;
+		stream->pub.bytes_in_buffer=0;
+	}
+	else
+	{
+		stream->pub.next_input_byte+=num_bytes;
+		stream->pub.bytes_in_buffer-=num_bytes;
+	}
+}
+
+static void stream_term_source(j_decompress_ptr dinfo)
+{
+}
+
+DLLEXPORT int DLLCALL tjDecompressFeed(tjhandle handle,
+	const unsigned char *jpegBuf, unsigned long jpegSize)
+{
+	int retval=0;  tjstream *stream;  size_t n;
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompressFeed(): Instance has not been initialized for decompression");
+
+	if(jpegBuf==NULL && jpegSize>0)
+		_throw("tjDecompressFeed(): Invalid argument");
+
+	if(!this->stream)
+	{
+		if((this->stream=(tjstream *)calloc(1, sizeof(tjstream)))==NULL)
+			_throw("tjDecompressFeed(): Memory allocation failure");
+		this->stream->pub.init_source=stream_init_source;
+		this->stream->pub.fill_input_buffer=stream_fill_input_buffer;
+		this->stream->pub.skip_input_data=stream_skip_input_data;
+		this->stream->pub.resync_to_restart=jpeg_resync_to_restart;
+		this->stream->pub.term_source=stream_term_source;
+	}
+	stream=this->stream;
+
+	if(stream->state==STREAM_IDLE)
+	{
+		if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+		stream->pub.next_input_byte=stream->buf;
+		stream->pub.bytes_in_buffer=0;
+		stream->skip=0;  stream->eof=FALSE;
+		stream->state=STREAM_HEADER;
+	}
+	else if(stream->eof)
+		_throw("tjDecompressFeed(): The end of the JPEG data has already been signaled");
+
+	if(jpegSize==0)
+	{
+		stream->eof=TRUE;  goto bailout;
+	}
+
+	n=min(stream->skip, (size_t)jpegSize);
+	jpegBuf+=n;  jpegSize-=n;  stream->skip-=n;
+
+	/* Move the data that has not been consumed yet to the beginning of the
+	   buffer, and append the new data to it. */
+	n=stream->pub.bytes_in_buffer;
+	if(n+jpegSize>stream->bufSize)
+	{
+		size_t newSize=max(stream->bufSize*2, n+jpegSize);
+		JOCTET *newBuf=(JOCTET *)malloc(newSize);
+		if(!newBuf) _throw("tjDecompressFeed(): Memory allocation failure");
+		if(n) memcpy(newBuf, stream->pub.next_input_byte, n);
+		if(stream->buf) free(stream->buf);
+		stream->buf=newBuf;  stream->bufSize=newSize;
+	}
+	else if(n) memmove(stream->buf, stream->pub.next_input_byte, n);
+	if(jpegSize) memcpy(&stream->buf[n], jpegBuf, jpegSize);
+	stream->pub.next_input_byte=stream->buf;
+	stream->pub.bytes_in_buffer=n+jpegSize;
+
+	bailout:
+	return retval;
+}
+
+/* Read the header of the JPEG image being streamed, if it has not been read
+   already.  Returns 1 if more data must be fed before the header can be read,
+   or 0 otherwise. */
+static int streamHeader(tjinstance *this)
+{
+	if(this->stream->state!=STREAM_HEADER) return 0;
+	if(jpeg_read_header(&this->dinfo, TRUE)==JPEG_SUSPENDED) return 1;
+	this->stream->state=STREAM_START;
+	return 0;
+}
+
+DLLEXPORT int DLLCALL tjDecompressPullHeader(tjhandle handle, int *width,
+	int *height, int *jpegSubsamp, int *jpegColorspace)
+{
+	int retval=0;  struct jpeg_source_mgr *src=NULL;
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompressPullHeader(): Instance has not been initialized for decompression");
+
+	if(width==NULL || height==NULL || jpegSubsamp==NULL
+		|| jpegColorspace==NULL)
+		_throw("tjDecompressPullHeader(): Invalid argument");
+	if(!this->stream || this->stream->state==STREAM_IDLE)
+		_throw("tjDecompressPullHeader(): No JPEG data has been fed");
+
+	src=dinfo->src;
+	dinfo->src=&this->stream->pub;
 	if(setjmp(this->jerr.setjmp_buffer))
 	{
 		/* If we get here, the JPEG code has signaled an error. */
 		retval=-1;
 		goto bailout;
 	}
-	for(i=0; i<(int)dinfo->output_height; i++)
+
+	if((retval=streamHeader(this))!=0) goto bailout;
+
+	*width=dinfo->image_width;
+	*height=dinfo->image_height;
+	*jpegSubsamp=getSubsamp(dinfo);
+	switch(dinfo->jpeg_color_space)
 	{
-		if(flags&TJFLAG_BOTTOMUP)
-			row_pointer[i]=&dstBuf[(dinfo->output_height-i-1)*pitch];
-		else row_pointer[i]=&dstBuf[i*pitch];
+		case JCS_GRAYSCALE:  *jpegColorspace=TJCS_GRAY;  break;
+		case JCS_RGB:        *jpegColorspace=TJCS_RGB;  break;
+		case JCS_YCbCr:      *jpegColorspace=TJCS_YCbCr;  break;
+		case JCS_CMYK:       *jpegColorspace=TJCS_CMYK;  break;
+		case JCS_YCCK:       *jpegColorspace=TJCS_YCCK;  break;
+		default:             *jpegColorspace=-1;  break;
 	}
-	while(dinfo->output_scanline<dinfo->output_height)
+	if(*jpegSubsamp<0)
+		_throw("tjDecompressPullHeader(): Could not determine subsampling type for JPEG image");
+	if(*jpegColorspace<0)
+		_throw("tjDecompressPullHeader(): Could not determine colorspace of JPEG image");
+
+	bailout:
+	if(this->jerr.warning) retval=-1;
+	if(retval==-1 && this->stream)
 	{
-		jpeg_read_scanlines(dinfo, &row_pointer[dinfo->output_scanline],
-			dinfo->output_height-dinfo->output_scanline);
+		if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+		this->stream->state=STREAM_IDLE;
 	}
-	jpeg_finish_decompress(dinfo);
+	if(this->stream && dinfo->src==&this->stream->pub) dinfo->src=src;
+	return retval;
+}
 
+DLLEXPORT int DLLCALL tjDecompressPull(tjhandle handle, unsigned char *dstBuf,
+	int pitch, int numRows, int pixelFormat, int flags)
+{
+	int i, retval=0;  JSAMPROW *row_pointer=NULL;
+	struct jpeg_source_mgr *src=NULL;  tjstream *stream;
 	#ifndef JCS_EXTENSIONS
-	fromRGB(rgbBuf, _dstBuf, width, _pitch, height, pixelFormat);
+	unsigned char *rgbBuf=NULL;
+	unsigned char *_dstBuf=NULL;  int _pitch=0;
+	#endif
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompressPull(): Instance has not been initialized for decompression");
+
+	if(dstBuf==NULL || pitch<0 || numRows<=0 || pixelFormat<0
+		|| pixelFormat>=TJ_NUMPF || (flags&TJFLAG_BOTTOMUP))
+		_throw("tjDecompressPull(): Invalid argument");
+	if(!this->stream || this->stream->state==STREAM_IDLE)
+		_throw("tjDecompressPull(): No JPEG data has been fed");
+	stream=this->stream;
+	if(stream->state==STREAM_SCANNING && (pixelFormat!=stream->pixelFormat
+		|| flags!=stream->flags))
+		_throw("tjDecompressPull(): Pixel format and flags cannot change while an image is being decompressed");
+
+	if(flags&TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
+	else if(flags&TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
+	else if(flags&TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
+
+	src=dinfo->src;
+	dinfo->src=&stream->pub;
+	if(setjmp(this->jerr.setjmp_buffer))
+	{
+		/* If we get here, the JPEG code has signaled an error. */
+		retval=-1;
+		goto bailout;
+	}
+
+	if(streamHeader(this)) goto bailout;
+	if(stream->state==STREAM_START)
+	{
+		if(dinfo->global_state==DSTATE_READY)
+		{
+			if(setDecompDefaults(dinfo, pixelFormat, flags)==-1)
+			{
+				retval=-1;  goto bailout;
+			}
+			if(flags&TJFLAG_FASTUPSAMPLE) dinfo->do_fancy_upsampling=FALSE;
+			stream->pixelFormat=pixelFormat;  stream->flags=flags;
+		}
+		else if(pixelFormat!=stream->pixelFormat || flags!=stream->flags)
+			_throw("tjDecompressPull(): Pixel format and flags cannot change while an image is being decompressed");
+		if(!jpeg_start_decompress(dinfo)) goto bailout;
+		stream->state=STREAM_SCANNING;
+	}
+	if(pitch==0) pitch=dinfo->output_width*tjPixelSize[pixelFormat];
+	numRows=min((JDIMENSION)numRows,
+		dinfo->output_height-dinfo->output_scanline);
+
+	#ifndef JCS_EXTENSIONS
+	if(pixelFormat!=TJPF_GRAY && pixelFormat!=TJPF_CMYK &&
+		(RGB_RED!=tjRedOffset[pixelFormat] ||
+			RGB_GREEN!=tjGreenOffset[pixelFormat] ||
+			RGB_BLUE!=tjBlueOffset[pixelFormat] ||
+			RGB_PIXELSIZE!=tjPixelSize[pixelFormat]))
+	{
+		rgbBuf=(unsigned char *)malloc(dinfo->output_width*numRows*3);
+		if(!rgbBuf) _throw("tjDecompressPull(): Memory allocation failure");
+		_pitch=pitch;  pitch=dinfo->output_width*3;
+		_dstBuf=dstBuf;  dstBuf=rgbBuf;
+	}
+	#endif
+
+	if((row_pointer=(JSAMPROW *)malloc(sizeof(JSAMPROW)*numRows))==NULL)
+		_throw("tjDecompressPull(): Memory allocation failure");
+	for(i=0; i<numRows; i++) row_pointer[i]=&dstBuf[i*pitch];
+
+	/* jpeg_read_scanlines() returns 0 if the decompressor suspends */
+	while(retval<numRows)
+	{
+		i=jpeg_read_scanlines(dinfo, &row_pointer[retval], numRows-retval);
+		if(i==0) break;
+		retval+=i;
+	}
+
+	#ifndef JCS_EXTENSIONS
+	fromRGB(rgbBuf, _dstBuf, dinfo->output_width, _pitch, retval, pixelFormat);
 	#endif
 
+	/* The rest of the data, including the EOI marker, is not needed. */
+	if(dinfo->output_scanline>=dinfo->output_height)
+	{
+		jpeg_abort_decompress(dinfo);
+		stream->state=STREAM_IDLE;
+	}
+
 	bailout:
-	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+	if(this->jerr.warning) retval=-1;
+	if(retval==-1 && this->stream)
+	{
+		if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+		this->stream->state=STREAM_IDLE;
+	}
+	if(this->stream && dinfo->src==&this->stream->pub) dinfo->src=src;
 	#ifndef JCS_EXTENSIONS
 	if(rgbBuf) free(rgbBuf);
 	#endif
 	if(row_pointer) free(row_pointer);
-	if(this->jerr.warning) retval=-1;
 	return retval;
 }
 
+DLLEXPORT int DLLCALL tjDecompressAbort(tjhandle handle)
+{
+	int retval=0;
+
+	getdinstance(handle);
+	if((this->init&DECOMPRESS)==0)
+		_throw("tjDecompressAbort(): Instance has not been initialized for decompression");
+
+	if(this->stream) this->stream->state=STREAM_IDLE;
+	if(dinfo->global_state>DSTATE_START) jpeg_abort_decompress(dinfo);
+
+	bailout:
+	return retval;
+}
+
+
 DLLEXPORT int DLLCALL tjDecompress(tjhandle handle, unsigned char *jpegBuf,
 	unsigned long jpegSize, unsigned char *dstBuf, int width, int pitch,
 	int height, int pixelSize, int flags)
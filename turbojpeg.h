@@ -383,6 +383,43 @@ enum TJCS
  * when decompressing, because this has been shown to have a larger effect.
  */
 #define TJFLAG_ACCURATEDCT   4096
+/**
+ * When compressing with more than one thread (see #tjSetNumThreads()), divide
+ * the image into horizontal stripes whose heights are a multiple of the MCU
+ * height, compress the stripes concurrently, and join them with restart
+ * markers.  The result is a baseline JPEG image whose restart interval is equal
+ * to the height of one stripe, so it is not identical to the image that
+ * single-threaded compression would produce.  This flag has no effect if
+ * pre-trained Huffman tables have been requested (see #TJFLAG_PRETRAINED) or
+ * if Huffman table optimization, progressive entropy coding, arithmetic
+ * entropy coding, or a restart interval has been requested using the
+ * corresponding environment variables.
+ */
+#define TJFLAG_STRIPED       8192
+/**
+ * When decompressing with more than one thread (see #tjSetNumThreads()), allow
+ * baseline JPEG images that have no restart markers to be decompressed in
+ * parallel.  The entropy-coded data is divided into segments, which are
+ * scanned concurrently starting from guessed MCU boundaries.  A segment's scan
+ * is used only if it falls back into step with the scan of the preceding
+ * segment, so the output is identical to that of single-threaded
+ * decompression.  However, because the entropy-coded data is decoded twice,
+ * this is only beneficial with large images and a sufficient number of CPU
+ * cores.
+ */
+#define TJFLAG_SPECULATIVE   16384
+/**
+ * When compressing, code each scan with whichever of several built-in sets of
+ * pre-trained Huffman tables (or the standard Huffman tables) codes a sample
+ * from the beginning of the scan in the fewest bits.  This usually produces a
+ * smaller JPEG image than the standard Huffman tables, at the same speed and
+ * without the second pass that Huffman table optimization requires.  This
+ * flag has no effect on progressive or arithmetic-coded JPEG images or if
+ * Huffman table optimization has been requested.  Setting the
+ * <tt>TJ_PRETRAINED</tt> environment variable to <tt>1</tt> has the same
+ * effect as this flag.
+ */
+#define TJFLAG_PRETRAINED    32768
 
 
 /**
@@ -585,6 +622,108 @@ typedef struct tjtransform
 typedef void* tjhandle;
 
 
+/**
+ * Segment of a JPEG image that is stored in a list of non-contiguous buffers
+ * (see #tjCompressToSegments() and #tjDecompressFromSegments())
+ */
+typedef struct
+{
+  /**
+   * Pointer to the data in this segment
+   */
+  unsigned char *buf;
+  /**
+   * Size of the data in this segment (in bytes)
+   */
+  unsigned long size;
+} tjsegment;
+
+
+/**
+ * Batch operations for #tjBatch()
+ */
+enum TJOP
+{
+  /**
+   * Decompress a JPEG image (see #tjDecompress2())
+   */
+  TJOP_DECOMPRESS=0,
+  /**
+   * Compress an RGB, grayscale, or CMYK image (see #tjCompress2())
+   */
+  TJOP_COMPRESS,
+  /**
+   * Losslessly transform a JPEG image (see #tjTransform())
+   */
+  TJOP_TRANSFORM
+};
+
+/**
+ * The maximum length of the error message stored in a #tjjob structure,
+ * including the terminating null character
+ */
+#define TJ_ERRSTR_LENGTH 200
+
+/**
+ * Batch job
+ */
+typedef struct
+{
+  /**
+   * One of the @ref TJOP "batch operations"
+   */
+  int op;
+  /**
+   * JPEG image.  For #TJOP_DECOMPRESS and #TJOP_TRANSFORM, this is the source
+   * image.  For #TJOP_COMPRESS, this is the destination image buffer, which is
+   * allocated or reallocated as described for the <tt>jpegBuf</tt> argument of
+   * #tjCompress2().
+   */
+  unsigned char *jpegBuf;
+  /**
+   * Size of the JPEG image (in bytes.)  For #TJOP_COMPRESS, this receives the
+   * size of the compressed image.
+   */
+  unsigned long jpegSize;
+  /**
+   * Uncompressed image.  For #TJOP_COMPRESS, this is the source image.  For
+   * #TJOP_DECOMPRESS, this is the destination image.
+   */
+  unsigned char *buf;
+  /**
+   * Width, pitch, height, and pixel format of the uncompressed image, as
+   * passed to #tjCompress2() or #tjDecompress2()
+   */
+  int width, pitch, height, pixelFormat;
+  /**
+   * The level of chrominance subsampling and the image quality to be used
+   * when compressing (#TJOP_COMPRESS only)
+   */
+  int jpegSubsamp, jpegQual;
+  /**
+   * The number of transformed images to generate and the destination buffers,
+   * sizes, and transforms for each, as passed to #tjTransform()
+   * (#TJOP_TRANSFORM only)
+   */
+  int n;
+  unsigned char **dstBufs;
+  unsigned long *dstSizes;
+  tjtransform *transforms;
+  /**
+   * The bitwise OR of one or more of the @ref TJFLAG_ACCURATEDCT "flags"
+   */
+  int flags;
+  /**
+   * Receives 0 if the job was successful or -1 if an error occurred
+   */
+  int retval;
+  /**
+   * Receives a descriptive error message if an error occurred
+   */
+  char errStr[TJ_ERRSTR_LENGTH];
+} tjjob;
+
+
 /**
  * Pad the given width to the nearest 32-bit boundary
  */
@@ -812,6 +951,165 @@ DLLEXPORT int DLLCALL tjCompressFromYUVPlanes(tjhandle handle,
   int flags);
 
 
+/**
+ * Compress an RGB, grayscale, or CMYK image into a JPEG image that is stored
+ * in a list of fixed-size segments rather than in a single contiguous buffer.
+ * Each time a segment fills, a new one is allocated, so unlike
+ * #tjCompress2() with automatic buffer allocation, this function never copies
+ * the data that has already been written.  The segments can be passed
+ * directly to a scatter/gather output function such as <tt>writev()</tt>.
+ *
+ * @param handle a handle to a TurboJPEG compressor or transformer instance
+ *
+ * @param srcBuf pointer to an image buffer containing RGB, grayscale, or CMYK
+ * pixels to be compressed
+ *
+ * @param width width (in pixels) of the source image
+ *
+ * @param pitch bytes per line in the source image.  This parameter has the
+ * same meaning as in #tjCompress2().
+ *
+ * @param height height (in pixels) of the source image
+ *
+ * @param pixelFormat pixel format of the source image (see @ref TJPF
+ * "Pixel formats".)
+ *
+ * @param segments address of a pointer that will receive an array of
+ * #tjsegment structures describing the JPEG image, in order.  Every segment
+ * except the last contains exactly <tt>segmentSize</tt> bytes.  The array and
+ * the segments should be freed with #tjFreeSegments().
+ *
+ * @param numSegments pointer to an integer variable that will receive the
+ * number of segments in the array
+ *
+ * @param segmentSize size (in bytes) of each segment
+ *
+ * @param jpegSubsamp the level of chrominance subsampling to be used when
+ * generating the JPEG image (see @ref TJSAMP
+ * "Chrominance subsampling options".)
+ *
+ * @param jpegQual the image quality of the generated JPEG image (1 = worst,
+ * 100 = best)
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_BOTTOMUP
+ * "flags"
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjCompressToSegments(tjhandle handle,
+  const unsigned char *srcBuf, int width, int pitch, int height,
+  int pixelFormat, tjsegment **segments, int *numSegments,
+  unsigned long segmentSize, int jpegSubsamp, int jpegQual, int flags);
+
+
+/**
+ * Free a list of segments that was generated by #tjCompressToSegments().
+ *
+ * @param segments the array of segments to free
+ *
+ * @param numSegments the number of segments in the array
+ */
+DLLEXPORT void DLLCALL tjFreeSegments(tjsegment *segments, int numSegments);
+
+
+/**
+ * Start compressing an RGB, grayscale, or CMYK image whose rows will be
+ * supplied incrementally with #tjCompressPush().  Rather than being stored in
+ * a JPEG buffer, the compressed data is passed to a callback function in
+ * chunks of a fixed size as soon as each chunk fills, so neither the source
+ * image nor the JPEG image needs to be held in memory all at once.  While an
+ * image is being compressed, the instance should not be used with other
+ * compression functions, except for #tjCompressPush(), #tjCompressFinish(),
+ * and #tjCompressAbort().
+ *
+ * @param handle a handle to a TurboJPEG compressor or transformer instance
+ *
+ * @param width width (in pixels) of the source image
+ *
+ * @param height height (in pixels) of the source image
+ *
+ * @param pixelFormat pixel format of the source image (see @ref TJPF
+ * "Pixel formats".)
+ *
+ * @param jpegSubsamp the level of chrominance subsampling to be used when
+ * generating the JPEG image (see @ref TJSAMP
+ * "Chrominance subsampling options".)
+ *
+ * @param jpegQual the image quality of the generated JPEG image (1 = worst,
+ * 100 = best)
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_FASTDCT
+ * "flags", except for #TJFLAG_BOTTOMUP
+ *
+ * @param chunkSize size (in bytes) of the chunks that will be passed to the
+ * callback.  The last chunk may be smaller.
+ *
+ * @param chunkCallback a function that will be called with each chunk of
+ * compressed data.  <tt>chunk</tt> points to a buffer owned by TurboJPEG,
+ * which is overwritten once the callback returns, <tt>size</tt> is the size
+ * of the chunk (in bytes), and <tt>data</tt> is <tt>callbackData</tt>.  The
+ * callback should return 0 if successful, or -1 to abort compression.
+ *
+ * @param callbackData arbitrary data that will be passed to the callback
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjCompressStart(tjhandle handle, int width, int height,
+  int pixelFormat, int jpegSubsamp, int jpegQual, int flags,
+  unsigned long chunkSize, int (*chunkCallback)(const unsigned char *chunk,
+    unsigned long size, void *data), void *callbackData);
+
+
+/**
+ * Compress the next rows of the image being compressed with
+ * #tjCompressStart().  The rows must be supplied in top-down order, and any
+ * compressed data that becomes available is passed to the chunk callback
+ * before this function returns.
+ *
+ * @param handle a handle to a TurboJPEG compressor or transformer instance
+ *
+ * @param srcBuf pointer to a buffer containing the next rows of the source
+ * image, in the pixel format that was passed to #tjCompressStart()
+ *
+ * @param pitch bytes per line in the source buffer.  Setting this parameter
+ * to 0 is the equivalent of setting it to
+ * <tt>width * #tjPixelSize[pixelFormat]</tt>.
+ *
+ * @param numRows number of rows in the source buffer.  This cannot exceed the
+ * number of rows that have not yet been compressed.
+ *
+ * @return 0 if successful, or -1 if an error occurred or the callback aborted
+ * compression (see #tjGetErrorStr().)  If an error occurs, then the image is
+ * aborted.
+ */
+DLLEXPORT int DLLCALL tjCompressPush(tjhandle handle,
+  const unsigned char *srcBuf, int pitch, int numRows);
+
+
+/**
+ * Finish compressing the image being compressed with #tjCompressStart().  All
+ * of its rows must have been supplied with #tjCompressPush().  The remaining
+ * compressed data, including the EOI marker, is passed to the chunk callback
+ * before this function returns.
+ *
+ * @param handle a handle to a TurboJPEG compressor or transformer instance
+ *
+ * @return 0 if successful, or -1 if an error occurred or the callback aborted
+ * compression (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjCompressFinish(tjhandle handle);
+
+
+/**
+ * Abort the image being compressed with #tjCompressStart().
+ *
+ * @param handle a handle to a TurboJPEG compressor or transformer instance
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjCompressAbort(tjhandle handle);
+
+
 /**
  * The maximum size of the buffer (in bytes) required to hold a JPEG image with
  * the given parameters.  The number of bytes returned by this function is
@@ -1136,6 +1434,354 @@ DLLEXPORT int DLLCALL tjDecompress2(tjhandle handle,
   int width, int pitch, int height, int pixelFormat, int flags);
 
 
+/**
+ * Retrieve information about a JPEG image that is stored in a list of
+ * segments (such as the packets or pages in which it was received) rather
+ * than in a single contiguous buffer.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param segments pointer to an array of #tjsegment structures describing the
+ * JPEG image, in order
+ *
+ * @param numSegments number of segments in the array
+ *
+ * @param width pointer to an integer variable that will receive the width (in
+ * pixels) of the JPEG image
+ *
+ * @param height pointer to an integer variable that will receive the height
+ * (in pixels) of the JPEG image
+ *
+ * @param jpegSubsamp pointer to an integer variable that will receive the
+ * level of chrominance subsampling used when the JPEG image was compressed
+ * (see @ref TJSAMP "Chrominance subsampling options".)
+ *
+ * @param jpegColorspace pointer to an integer variable that will receive one
+ * of the JPEG colorspace constants, indicating the colorspace of the JPEG
+ * image (see @ref TJCS "JPEG colorspaces".)
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjDecompressHeaderFromSegments(tjhandle handle,
+  const tjsegment *segments, int numSegments, int *width, int *height,
+  int *jpegSubsamp, int *jpegColorspace);
+
+
+/**
+ * Decompress a JPEG image that is stored in a list of segments (such as the
+ * packets or pages in which it was received) rather than in a single
+ * contiguous buffer.  Large segments are read in place, and runs of small
+ * segments are gathered into a staging buffer, so the JPEG image never needs
+ * to be copied into one buffer.  This function does not use multithreading.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param segments pointer to an array of #tjsegment structures describing the
+ * JPEG image, in order
+ *
+ * @param numSegments number of segments in the array
+ *
+ * @param dstBuf pointer to an image buffer that will receive the decompressed
+ * image.  This parameter has the same meaning as in #tjDecompress2().
+ *
+ * @param width desired width (in pixels) of the destination image.  This
+ * parameter has the same meaning as in #tjDecompress2().
+ *
+ * @param pitch bytes per line in the destination image.  This parameter has
+ * the same meaning as in #tjDecompress2().
+ *
+ * @param height desired height (in pixels) of the destination image.  This
+ * parameter has the same meaning as in #tjDecompress2().
+ *
+ * @param pixelFormat pixel format of the destination image (see @ref
+ * TJPF "Pixel formats".)
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_BOTTOMUP
+ * "flags"
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjDecompressFromSegments(tjhandle handle,
+  const tjsegment *segments, int numSegments, unsigned char *dstBuf,
+  int width, int pitch, int height, int pixelFormat, int flags);
+
+
+/**
+ * Decompress a rectangular region of a JPEG image to an RGB, grayscale, or
+ * CMYK image.  Only the iMCU columns that intersect the region are
+ * inverse-DCT'ed, upsampled, and color-converted, and the rows above the
+ * region are skipped without being fully decoded, so this function is much
+ * faster than #tjDecompress2() when the region is small relative to the
+ * image.  The pixels in <tt>dstBuf</tt> are identical to the corresponding
+ * pixels produced by #tjDecompress2() with the same scaling factor and flags.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param jpegBuf pointer to a buffer containing the JPEG image to decompress
+ *
+ * @param jpegSize size of the JPEG image (in bytes)
+ *
+ * @param scalingFactor one of the scaling factors returned by
+ * #tjGetScalingFactors().  The JPEG image is decompressed as if it had been
+ * scaled by this factor, and the region is specified relative to the scaled
+ * image.
+ *
+ * @param region #tjregion structure specifying the position and size of the
+ * region (in pixels) relative to the scaled image.  The region must lie
+ * entirely within the scaled image, whose dimensions can be determined by
+ * calling #TJSCALED() with the JPEG image dimensions and
+ * <tt>scalingFactor</tt>.  If <tt>region.w</tt> or <tt>region.h</tt> is 0,
+ * then the region will extend to the right or bottom edge of the scaled
+ * image.
+ *
+ * @param dstBuf pointer to an image buffer that will receive the decompressed
+ * region.  This buffer should normally be <tt>pitch * region.h</tt> bytes in
+ * size.
+ *
+ * @param pitch bytes per line in the destination image.  Setting this
+ * parameter to 0 is the equivalent of setting it to
+ * <tt>region.w * #tjPixelSize[pixelFormat]</tt>.
+ *
+ * @param pixelFormat pixel format of the destination image (see @ref
+ * TJPF "Pixel formats".)
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_BOTTOMUP
+ * "flags"
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjDecompressRegion(tjhandle handle,
+  const unsigned char *jpegBuf, unsigned long jpegSize,
+  tjscalingfactor scalingFactor, tjregion region, unsigned char *dstBuf,
+  int pitch, int pixelFormat, int flags);
+
+
+/**
+ * Build a random-access index for a single-scan (baseline or extended
+ * sequential) Huffman-coded JPEG image.  The entropy-coded data is decoded
+ * once, without performing the inverse DCT, and a checkpoint of the Huffman
+ * decoder's state (the position in the entropy-coded data and the DC
+ * predictions for each component) is recorded every <tt>interval</tt> iMCU
+ * rows.  The index is a small, portable binary blob that can be stored
+ * alongside the JPEG image and later passed to #tjSetIndex(), which allows
+ * subsequent decompression operations to start entropy decoding at the
+ * nearest checkpoint rather than at the top of the image.  This is useful for
+ * images without restart markers, in which there is otherwise no way to find
+ * the start of an iMCU row without decoding all of the rows above it.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param jpegBuf pointer to a buffer containing the JPEG image to index
+ *
+ * @param jpegSize size of the JPEG image (in bytes)
+ *
+ * @param interval number of iMCU rows between checkpoints.  An iMCU row is
+ * 8 or 16 rows of pixels, depending on the level of chrominance subsampling,
+ * and each checkpoint occupies 36 bytes in the index.
+ *
+ * @param indexBuf address of a pointer that will receive a pointer to the
+ * index.  The index is allocated by TurboJPEG and should be freed by the
+ * caller using #tjFree().
+ *
+ * @param indexSize pointer to an unsigned long variable that will receive the
+ * size of the index (in bytes)
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjBuildIndex(tjhandle handle,
+  const unsigned char *jpegBuf, unsigned long jpegSize, int interval,
+  unsigned char **indexBuf, unsigned long *indexSize);
+
+
+/**
+ * Attach a random-access index, previously created by #tjBuildIndex(), to a
+ * TurboJPEG decompressor or transformer instance.  The index is copied, so
+ * <tt>indexBuf</tt> can be freed once this function returns.  Subsequent
+ * calls to #tjDecompressRegion() with the same JPEG image resume entropy
+ * decoding from the nearest checkpoint above the region, and subsequent calls
+ * to #tjDecompress2() with the same JPEG image use the checkpoints to divide
+ * the image among threads if multithreaded decompression is enabled (see
+ * #tjSetNumThreads().)  The index is ignored when decompressing any other JPEG
+ * image.  (An image is considered to be the same if it has the same size and
+ * the same headers as the image that was indexed.)
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param indexBuf pointer to a buffer containing the index, or NULL to detach
+ * the current index
+ *
+ * @param indexSize size of the index (in bytes)
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjSetIndex(tjhandle handle,
+  const unsigned char *indexBuf, unsigned long indexSize);
+
+
+/**
+ * Decompress a JPEG image to an RGB, grayscale, or CMYK image, one band of
+ * rows at a time.  Each band is decompressed into the same caller-supplied
+ * buffer and passed to a callback function before the next band is
+ * decompressed, so the size of the destination buffer is proportional to the
+ * width of the image rather than its area.  (NOTE: progressive and other
+ * multi-scan JPEG images still require the decompressor to buffer the DCT
+ * coefficients for the whole image.)
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param jpegBuf pointer to a buffer containing the JPEG image to decompress
+ *
+ * @param jpegSize size of the JPEG image (in bytes)
+ *
+ * @param dstBuf pointer to an image buffer that will receive each band of
+ * decompressed rows.  This buffer should be at least
+ * <tt>pitch * bandHeight</tt> bytes in size.
+ *
+ * @param width desired width (in pixels) of the destination image.  This
+ * parameter has the same meaning as in #tjDecompress2().
+ *
+ * @param pitch bytes per line in the destination buffer.  Setting this
+ * parameter to 0 is the equivalent of setting it to
+ * <tt>scaledWidth * #tjPixelSize[pixelFormat]</tt>.
+ *
+ * @param height desired height (in pixels) of the destination image.  This
+ * parameter has the same meaning as in #tjDecompress2().
+ *
+ * @param bandHeight number of rows in each band.  The last band may contain
+ * fewer rows.
+ *
+ * @param pixelFormat pixel format of the destination image (see @ref
+ * TJPF "Pixel formats".)
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_FASTUPSAMPLE
+ * "flags", except for #TJFLAG_BOTTOMUP
+ *
+ * @param bandCallback a function that will be called with each band of
+ * decompressed rows.  <tt>band</tt> points to <tt>dstBuf</tt>, <tt>y</tt> is
+ * the index of the first row in the band, <tt>numRows</tt> is the number of
+ * rows in the band, and <tt>data</tt> is <tt>callbackData</tt>.  The contents
+ * of the band are overwritten once the callback returns.  The callback should
+ * return 0 if successful, or -1 to abort decompression.
+ *
+ * @param callbackData arbitrary data that will be passed to the callback
+ *
+ * @return 0 if successful, or -1 if an error occurred or the callback aborted
+ * decompression (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjDecompressBands(tjhandle handle,
+  const unsigned char *jpegBuf, unsigned long jpegSize, unsigned char *dstBuf,
+  int width, int pitch, int height, int bandHeight, int pixelFormat,
+  int flags, int (*bandCallback)(unsigned char *band, int y, int numRows,
+    void *data), void *callbackData);
+
+
+/**
+ * Feed part of a JPEG image to a TurboJPEG decompressor for incremental
+ * (streaming) decompression.  This allows a JPEG image to be decompressed as
+ * it arrives (from a network socket, for instance) rather than after all of it
+ * has arrived.  The data is copied, so <tt>jpegBuf</tt> can be reused as soon
+ * as this function returns.  Feeding data to an instance that is not already
+ * decompressing a stream starts a new stream.  After all of the JPEG image has
+ * been fed, call this function with <tt>jpegSize</tt> set to 0 to signal the
+ * end of the data.  While a stream is in progress, the instance should not be
+ * used with other decompression functions, except for
+ * #tjDecompressPullHeader(), #tjDecompressPull(), and #tjDecompressAbort().
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param jpegBuf pointer to a buffer containing the next part of the JPEG
+ * image
+ *
+ * @param jpegSize size of the next part of the JPEG image (in bytes), or 0 to
+ * signal the end of the data
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjDecompressFeed(tjhandle handle,
+  const unsigned char *jpegBuf, unsigned long jpegSize);
+
+
+/**
+ * Retrieve information about the JPEG image being streamed, if enough of it has
+ * been fed with #tjDecompressFeed().
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param width pointer to an integer variable that will receive the width (in
+ * pixels) of the JPEG image
+ *
+ * @param height pointer to an integer variable that will receive the height
+ * (in pixels) of the JPEG image
+ *
+ * @param jpegSubsamp pointer to an integer variable that will receive the
+ * level of chrominance subsampling used when the JPEG image was compressed
+ * (see @ref TJSAMP "Chrominance subsampling options".)
+ *
+ * @param jpegColorspace pointer to an integer variable that will receive one
+ * of the JPEG colorspace constants, indicating the colorspace of the JPEG
+ * image (see @ref TJCS "JPEG colorspaces".)
+ *
+ * @return 0 if successful, 1 if more data must be fed before the header can be
+ * read, or -1 if an error occurred (see #tjGetErrorStr().)  If an error
+ * occurs, then the stream is aborted.
+ */
+DLLEXPORT int DLLCALL tjDecompressPullHeader(tjhandle handle, int *width,
+  int *height, int *jpegSubsamp, int *jpegColorspace);
+
+
+/**
+ * Decompress the next rows of the JPEG image being streamed to an RGB,
+ * grayscale, or CMYK image, using the data that has been fed with
+ * #tjDecompressFeed().  This function never waits for data.  It decompresses
+ * as many of the requested rows as the data fed so far allows, and if it runs
+ * out of data, it returns the number of rows that it decompressed, which may
+ * be 0.  Progressive JPEG images and other multi-scan JPEG images can be
+ * decompressed only after all of their data has been fed.  Once the last row of
+ * the image has been decompressed, the stream is finished, any data that
+ * remains (such as the EOI marker) is discarded, and the next call to
+ * #tjDecompressFeed() starts a new stream.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param dstBuf pointer to an image buffer that will receive the decompressed
+ * rows.  This buffer should be at least <tt>pitch * numRows</tt> bytes in
+ * size.  The rows are always stored in top-down order.
+ *
+ * @param pitch bytes per line in the destination image.  Setting this
+ * parameter to 0 is the equivalent of setting it to
+ * <tt>width * #tjPixelSize[pixelFormat]</tt>, where <tt>width</tt> is the
+ * width of the JPEG image.
+ *
+ * @param numRows maximum number of rows to decompress
+ *
+ * @param pixelFormat pixel format of the destination image (see @ref
+ * TJPF "Pixel formats".)  This must be the same for all calls that decompress
+ * the same image.
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_FASTUPSAMPLE
+ * "flags", except for #TJFLAG_BOTTOMUP.  This must be the same for all calls
+ * that decompress the same image.
+ *
+ * @return the number of rows that were decompressed, or -1 if an error
+ * occurred (see #tjGetErrorStr().)  If an error occurs, then the stream is
+ * aborted.
+ */
+DLLEXPORT int DLLCALL tjDecompressPull(tjhandle handle, unsigned char *dstBuf,
+  int pitch, int numRows, int pixelFormat, int flags);
+
+
+/**
+ * Abort the JPEG image being streamed to a TurboJPEG decompressor, discarding
+ * any data that has been fed but not decompressed.  The next call to
+ * #tjDecompressFeed() starts a new stream.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjDecompressAbort(tjhandle handle);
+
+
 /**
  * Decompress a JPEG image to a YUV planar image.  This function performs JPEG
  * decompression but leaves out the color conversion step, so a planar YUV
@@ -1437,6 +2083,61 @@ DLLEXPORT int DLLCALL tjTransform(tjhandle handle,
 DLLEXPORT int DLLCALL tjDestroy(tjhandle handle);
 
 
+/**
+ * Set the maximum number of threads that a TurboJPEG instance may use.  By
+ * default, each instance uses only the calling thread.  When more than one
+ * thread is allowed, #tjDecompress2() decodes single-scan Huffman-coded JPEG
+ * images that contain restart markers by splitting the image into horizontal
+ * bands at restart boundaries and decompressing the bands concurrently.  The
+ * output is identical to that of single-threaded decompression.  Other
+ * single-scan JPEG images (unless #TJFLAG_SPECULATIVE allows them to be split
+ * into bands as well) are decompressed using a two-stage pipeline: one thread
+ * performs entropy decoding, while the calling thread performs the inverse
+ * DCT, upsampling, and color conversion.  #tjCompress2() compresses
+ * single-scan JPEG images without Huffman table optimization using a similar
+ * pipeline: worker threads perform color conversion, downsampling, and the
+ * forward DCT, while the calling thread performs entropy encoding.  The output
+ * is identical to that of single-threaded compression.  If #TJFLAG_STRIPED is
+ * specified, then #tjCompress2() instead compresses horizontal stripes of the
+ * image concurrently.
+ *
+ * @param handle a handle to a TurboJPEG compressor, decompressor or
+ * transformer instance
+ *
+ * @param numThreads the maximum number of threads to use, including the
+ * calling thread, or 0 to use one thread per CPU core
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjSetNumThreads(tjhandle handle, int numThreads);
+
+
+/**
+ * Run a batch of independent compression, decompression, and transform jobs.
+ * The jobs are distributed among a pool of threads (the number of which is set
+ * with #tjSetNumThreads(), including the calling thread), and threads that
+ * run out of jobs take over the remaining jobs of other threads.  Each thread
+ * keeps its own TurboJPEG instance for the life of the pool, so the cost of
+ * creating an instance is not incurred for each job.  The pool is created by
+ * the first call to this function and is destroyed by #tjDestroy().  Each job
+ * is performed as if by a single-threaded instance, and the jobs may complete
+ * in any order.
+ *
+ * @param handle a handle to a TurboJPEG compressor, decompressor or
+ * transformer instance
+ *
+ * @param jobs an array of #tjjob structures, each of which specifies one job.
+ * The <tt>retval</tt> and <tt>errStr</tt> fields of each structure receive the
+ * status of the job.
+ *
+ * @param numJobs the number of jobs in the <tt>jobs</tt> array
+ *
+ * @return 0 if all jobs were successful, or -1 if any job failed or the
+ * pool could not be created (see #tjGetErrorStr().)
+ */
+DLLEXPORT int DLLCALL tjBatch(tjhandle handle, tjjob *jobs, int numJobs);
+
+
 /**
  * Allocate an image buffer for use with TurboJPEG.  You should always use
  * this function to allocate the JPEG destination buffer(s) for the compression
@@ -1468,6 +2169,8 @@ DLLEXPORT void DLLCALL tjFree(unsigned char *buffer);
 
 /**
  * Returns a descriptive error message explaining why the last command failed.
+ * The error message is stored separately for each thread, so it describes the
+ * last command that failed in the calling thread.
  *
  * @return a descriptive error message explaining why the last command failed.
  */